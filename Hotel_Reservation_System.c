@@ -1,268 +1,2161 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-
-#define MAX_NAME_LENGTH 50
-#define PRICE_PER_NIGHT 5000
-#define EXTRA_SERVICES_COST 1000
-
-// Define a structure for a room in the hotel
-struct Room {
-    int roomNumber; // Room number
-    int isReserved; // Reservation status (1 if reserved, 0 otherwise)
-    char guestName[MAX_NAME_LENGTH]; // Guest's name
-    int duration; // Duration of stay in days
-    int extraServices; // Extra services (1 if requested, 0 otherwise)
-    int occupancy; // Number of people staying in the room
-    struct tm reservationTime; // Time of reservation
-    struct tm cancellationTime; // Time of cancellation
-    struct Room* next; // Pointer to the next room in the list
+// Front ends of the hotel: the interactive menu, batch mode (--batch) and the HTTP server (--serve), all on the
+// reservation core in hotel_core.c
+#define _POSIX_C_SOURCE 200809L // Expose fileno, fsync and mmap under a strict -std=c99 build
+// Everything here goes through hotel_core.h except the batch prefetch hints in prefetchBatchCommand, which read
+// the room and guest index layout to warm the cache; that is what hotel_internal.h is included for, with the
+// date helpers and the file names and limits the core shares with its front ends
+#include "hotel_internal.h"
+#ifdef __linux__
+#include <signal.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#define HAVE_SERVER 1 // Build the --serve HTTP server (it needs epoll)
+#endif
+
+#define OUTPUT_BUFFER_SIZE (1 << 18) // Bytes of screen output formatted before one write()
+#define BATCH_CHUNK_SIZE (1 << 20) // Bytes of batch input read at a time
+#define BATCH_OUTPUT_SIZE 65536 // Bytes of batch results gathered per journal sync and write
+#define BATCH_LOOKAHEAD 16 // Batch commands parsed ahead of the running one so their rooms can be prefetched
+#define BATCH_MAX_PARTIES 256 // Parties in one group booking (batch mode and the menu)
+#define REPORT_PAGE_ROOMS 50 // Rooms shown per page of a report in the menu
+#define DASHBOARD_NIGHTS 7 // Nights from tonight shown on the dashboard
+#define DASHBOARD_FLOORS 20 // Floors shown on the dashboard, lowest first
+#define HISTORY_VIEW_THREADS 4 // Threads the menu's booking history scans with
+#define SERVER_DEFAULT_PORT 8080 // Port --serve listens on (127.0.0.1 only) unless one is given
+#define SERVER_MAX_CONNECTIONS 1024 // Connections the server keeps open at once; more are turned away
+#define SERVER_BUFFER_SIZE 16384 // Bytes of request and of response buffered per connection
+#define SERVER_MAX_RESPONSE 2048 // Largest single response; a connection stops parsing until it has this much room
+#define SERVER_MAX_EVENTS 256 // Socket events handled per round of the event loop
+#define SERVER_MAX_FIELDS 8 // Fields read from one JSON request body
+#define SERVER_MAX_LISTED_ROOMS 100 // Room numbers listed in one availability response
+#define SERVER_METRICS_PERIOD 10 // Seconds between rewrites of METRICS_FILE while serving
+
+// Define the commands understood in batch mode
+enum BatchCommandType {
+    BATCH_INVALID, // Unknown command or malformed arguments
+    BATCH_ADD, // add ROOM
+    BATCH_RESERVE, // reserve ROOM YYYY-MM-DD NIGHTS PEOPLE EXTRAS GUEST NAME
+    BATCH_CANCEL, // cancel ROOM YYYY-MM-DD GUEST NAME
+    BATCH_QUERY, // query YYYY-MM-DD NIGHTS PEOPLE
+    BATCH_GUEST, // guest GUEST NAME
+    BATCH_QUOTE, // quote ROOM YYYY-MM-DD NIGHTS PEOPLE EXTRAS
+    BATCH_IMPORT, // import FILE
+    BATCH_TOTALS, // totals
+    BATCH_HISTORY, // history YYYY-MM-DD YYYY-MM-DD
+    BATCH_GROUP // group YYYY-MM-DD NIGHTS EXTRAS PARTIES GUEST NAME
+};
+
+
+// Define one parsed batch command waiting for its turn to run
+struct BatchCommand {
+    int type; // enum BatchCommandType
+    int roomNumber; // Room the command touches (add, reserve, cancel)
+    int checkIn; // First night, as days since 1970-01-01 (reserve, cancel, query, group), or the first check-in day (history)
+    int lastDay; // Last check-in day (history)
+    int duration; // Number of nights (reserve, query, group)
+    int occupancy; // Number of people (reserve, query)
+    int extraServices; // Extra services requested (reserve, group)
+    int partyCount; // Parties in the group (group)
+    int parties[BATCH_MAX_PARTIES]; // People in each party (group)
+    int slot; // Room slot found while prefetching, -1 if not looked up yet
+    unsigned int guestSlot; // Guest index slot the name hashes to, found while prefetching
+    char guestName[MAX_NAME_LENGTH]; // Guest's name (reserve, cancel, guest), or the room file to import
+};
+
+
+// Define the buffer screen output is formatted into, so reports and receipts reach the
+// terminal in a few large write() calls instead of one stdio call per field
+struct OutputBuffer {
+    char data[OUTPUT_BUFFER_SIZE]; // Formatted text not yet written
+    size_t size; // Bytes used in data
+    int descriptor; // File descriptor flushOutput writes to
+};
+
+
+#ifdef HAVE_SERVER
+// Define one "key": value pair of a JSON request body (spans into the request, nothing copied)
+struct JsonField {
+    const char* key; // Key, without its quotes
+    size_t keyLength; // Length of key
+    const char* value; // Value, without quotes if it is a string (escapes still in place)
+    size_t valueLength; // Length of value
+    int isString; // 1 if the value was quoted
 };
 
+// Define one client connection of the server, with its buffers allocated once at startup
+struct Connection {
+    int descriptor; // Socket, -1 while the connection sits in the free list
+    char input[SERVER_BUFFER_SIZE]; // Received bytes not yet answered
+    size_t inputSize; // Bytes used in input
+    char output[SERVER_BUFFER_SIZE]; // Responses not yet sent
+    size_t outputSize; // Bytes used in output
+    size_t outputSent; // Bytes of output already sent
+    int closeAfterWrite; // 1 once a response said "Connection: close"
+    int peerClosed; // 1 once the client has shut down its side
+    int moreInput; // 1 if input filled up before the socket was drained
+    int queued; // 1 while the connection is in the pending list
+    struct Connection* nextFree; // Next connection in the free list
+};
+
+// Define the state of the HTTP server loop
+struct Server {
+    int listener; // Listening socket
+    int poll; // epoll instance
+    struct Connection* connections; // Pool of SERVER_MAX_CONNECTIONS connections
+    struct Connection* freeConnections; // Unused connections of the pool
+    struct Connection* pending[SERVER_MAX_CONNECTIONS]; // Connections with output to send this round
+    struct Connection* flushing[SERVER_MAX_CONNECTIONS]; // Copy of pending being sent
+    int pendingCount; // Number of entries in pending
+    struct Hotel* hotel; // Hotel being served
+    int roomNumbers[SERVER_MAX_LISTED_ROOMS]; // Scratch list for availability answers
+    long long requests; // Requests answered
+    int unsyncedChanges; // Changes logged to the journal since the last sync
+};
+
+static volatile sig_atomic_t serverStopping; // Set by SIGINT or SIGTERM
+#endif
+
+
 // Function prototypes
-struct Room* createRoom(int roomNumber);
-void addRoom(struct Room** head, int roomNumber);
-void makeReservation(struct Room* head, int roomNumber, const char* guestName, int duration, int extraServices, int occupancy);
-void cancelReservation(struct Room* head, int roomNumber, const char* guestName);
-void viewReservations(struct Room* head);
-void viewRoomDetails(struct Room* head);
-void freeRooms(struct Room* head);
+void addRoom(struct Hotel* hotel, int roomNumber);
+void makeReservation(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn, int duration, int extraServices, int occupancy);
+void makeGroupReservation(struct Hotel* hotel, const char* guestName, int checkIn, int duration, int extraServices,
+                          const int* parties, int partyCount);
+void cancelReservation(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn);
+void viewAvailableRooms(struct Hotel* hotel, int checkIn, int duration, int occupancy);
+int viewReservations(struct Hotel* hotel, struct HotelView* view, const struct HotelReportQuery* query, struct HotelCursor* cursor);
+int viewRoomDetails(struct Hotel* hotel, struct HotelView* view, const struct HotelReportQuery* query, struct HotelCursor* cursor);
+void viewGuest(struct Hotel* hotel, const char* text);
+void viewDashboard(struct Hotel* hotel);
+void viewHistory(struct Hotel* hotel, int firstDay, int lastDay);
 void displayMenu();
 void printHeader(const char* title);
 void printLine(char ch, int length);
+void printDate(int dayNumber);
+void flushOutput();
+void putText(const char* text);
+void putChars(char ch, int count);
+void putNumber(long long number);
+void putDigits(int number, int width);
+void putTime(int64_t when);
+void prompt(const char* question);
+
+static struct OutputBuffer output = {{0}, 0, 1}; // Screen output, written to standard output
 
-// Function to create a new room with given room number
-struct Room* createRoom(int roomNumber) {
-    struct Room* newRoom = (struct Room*)malloc(sizeof(struct Room)); // Allocate memory for a new room
-    newRoom->roomNumber = roomNumber; // Set the room number
-    newRoom->isReserved = 0; // Initialize reservation status to not reserved
-    newRoom->guestName[0] = '\0'; // Initialize guest name to empty string
-    newRoom->duration = 0; // Initialize duration to 0
-    newRoom->extraServices = 0; // Initialize extra services to not requested
-    newRoom->occupancy = 0; // Initialize occupancy to 0
-    newRoom->reservationTime = (struct tm){0}; // Initialize reservation time to zero
-    newRoom->cancellationTime = (struct tm){0}; // Initialize cancellation time to zero
-    newRoom->next = NULL; // Initialize next pointer to NULL
-    return newRoom; // Return the pointer to the new room
+// Function to make the changes logged so far durable before they are acknowledged
+// (returns 1 if they are on disk or the hotel is not journaled, and prints an error otherwise)
+static int commitChanges(struct Hotel* hotel) {
+    if (hotelSyncJournal(hotel)) {
+        return 1;
+    }
+    printHeader("Error");
+    putText("The change could not be written to " JOURNAL_FILE " and may be lost.\n");
+    printLine('-', 30);
+    return 0;
 }
 
 // Function to add a new room to the hotel
-void addRoom(struct Room** head, int roomNumber) {
-    struct Room* newRoom = createRoom(roomNumber); // Create a new room
-    newRoom->next = *head; // Link the new room to the existing list
-    *head = newRoom; // Make the new room the head of the list
-    printHeader("Add Room");
-    printf("Room %d added successfully.\n", roomNumber); // Print confirmation
+void addRoom(struct Hotel* hotel, int roomNumber) {
+    int status = hotelAddRoom(hotel, roomNumber);
+    if (status == HOTEL_OK && !commitChanges(hotel)) {
+        return;
+    }
+    printHeader(status == HOTEL_OK ? "Add Room" : "Error");
+    putText("Room "); // Print confirmation
+    putNumber(roomNumber);
+    putText(status == HOTEL_OK ? " added successfully.\n" : " already exists.\n");
     printLine('-', 30);
 }
 
 // Function to make a reservation
-void makeReservation(struct Room* head, int roomNumber, const char* guestName, int duration, int extraServices, int occupancy) {
-    struct Room* temp = head; // Temporary pointer to traverse the list
-    while (temp != NULL) { // Traverse the list
-        if (temp->roomNumber == roomNumber) { // Check if the room number matches
-            if (!temp->isReserved) { // Check if the room is not already reserved
-                temp->isReserved = 1; // Set the reservation status to reserved
-                strncpy(temp->guestName, guestName, MAX_NAME_LENGTH); // Set the guest name
-                temp->guestName[MAX_NAME_LENGTH - 1] = '\0'; // Ensure the guest name is null-terminated
-                temp->duration = duration; // Set the duration of stay
-                temp->extraServices = extraServices; // Set the extra services request
-                temp->occupancy = occupancy; // Set the number of people staying
-
-                time_t now = time(NULL);
-                temp->reservationTime = *localtime(&now); // Set the reservation time
-
-                int totalCost = PRICE_PER_NIGHT * duration; // Calculate the total cost
-                if (extraServices) {
-                    totalCost += EXTRA_SERVICES_COST * duration; // Add extra services cost if requested
-                }
+void makeReservation(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn, int duration, int extraServices, int occupancy) {
+    struct HotelBooking booking;
+    struct HotelRoom room;
+    int status = hotelReserve(hotel, roomNumber, guestName, checkIn, duration, extraServices, occupancy);
+    if (status == HOTEL_OK && !commitChanges(hotel)) {
+        return;
+    }
+    if (status == HOTEL_OK) {
+        int64_t reservationTime = hotelFindBooking(hotel, roomNumber, checkIn, &booking) == HOTEL_OK
+                                ? booking.reservationTime : (int64_t)time(NULL); // Unless cancelled meanwhile
 
-                // Print the receipt
-                printHeader("***** Receipt *****");
-                printf("* Guest Name          : %s\n", guestName);
-                printf("* Room Number         : %d\n", roomNumber);
-                printf("* Duration of Stay    : %d days\n", duration);
-                printf("* Number of People    : %d\n", occupancy);
-                printf("* Price per Night     : %d PKR\n", PRICE_PER_NIGHT);
-                if (extraServices) {
-                    printf("* Extra Services      : %d PKR per night\n", EXTRA_SERVICES_COST);
-                }
-                printf("* Total Cost          : %d PKR\n", totalCost);
-                printf("* Reservation Time    : %s", asctime(&temp->reservationTime));
-                printLine('*', 30);
-            } else {
-                printHeader("Error");
-                printf("Room %d is already reserved.\n", roomNumber); // Print error if room is already reserved
-                printLine('-', 30);
-            }
-            return; // Exit the function
+        struct HotelQuote quote; // Calculate the total cost
+        hotelQuoteDetails(hotel, roomNumber, checkIn, duration, occupancy, extraServices, &quote);
+
+        // Print the receipt
+        printHeader("***** Receipt *****");
+        putText("* Guest Name          : ");
+        putText(guestName);
+        putText("\n* Room Number         : ");
+        putNumber(roomNumber);
+        putText("\n* Check-in            : ");
+        printDate(checkIn);
+        putText("\n* Check-out           : ");
+        printDate(checkIn + duration);
+        putText("\n* Duration of Stay    : ");
+        putNumber(duration);
+        putText(" days\n* Number of People    : ");
+        putNumber(occupancy);
+        if (quote.roomCharges == quote.firstNight * duration) { // Every night at the same rate
+            putText("\n* Price per Night     : ");
+            putNumber(quote.firstNight);
+        } else {
+            putText("\n* Room Charges        : ");
+            putNumber(quote.roomCharges);
+        }
+        putText(" PKR\n");
+        if (extraServices) {
+            putText("* Extra Services      : ");
+            putNumber(quote.extrasRate);
+            putText(" PKR per night\n");
+        }
+        if (quote.surcharge != 0) {
+            putText("* Occupancy Surcharge : ");
+            putNumber(quote.surcharge);
+            putText(" PKR\n");
+        }
+        if (quote.discount != 0) {
+            putText("* Long Stay Discount  : -");
+            putNumber(quote.discount);
+            putText(" PKR\n");
         }
-        temp = temp->next; // Move to the next room
+        putText("* Total Cost          : ");
+        putNumber(quote.total);
+        putText(" PKR\n* Reservation Time    : ");
+        putTime(reservationTime);
+        printLine('*', 30);
+        return;
     }
+
     printHeader("Error");
-    printf("Room %d not found.\n", roomNumber); // Print error if room number not found
+    if (status == HOTEL_INVALID_STAY || status == HOTEL_INVALID_NAME) {
+        putText(status == HOTEL_INVALID_STAY ? "A stay needs at least one person, for 1 to 3660 nights between 1970 and 9999.\n"
+                                              : "Guest name is too long.\n");
+        printLine('-', 30);
+        return;
+    }
+    putText("Room ");
+    putNumber(roomNumber);
+    if (status == HOTEL_ROOM_NOT_FOUND) {
+        putText(" not found.\n"); // Print error if room number not found
+    } else if (status == HOTEL_ROOM_UNAVAILABLE) {
+        putText(" is already reserved for some of those nights.\n"); // Print error if the dates overlap a booking
+    } else {
+        putText(" holds at most ");
+        putNumber(hotelFindRoom(hotel, roomNumber, &room) ? room.capacity : 0);
+        putText(" people.\n");
+    }
     printLine('-', 30);
 }
 
+// Function to book rooms for a group, all of them or none
+void makeGroupReservation(struct Hotel* hotel, const char* guestName, int checkIn, int duration, int extraServices,
+                          const int* parties, int partyCount) {
+    struct HotelGroup group = {guestName, checkIn, duration, extraServices, parties, partyCount};
+    int partyRooms[BATCH_MAX_PARTIES];
+    int status = hotelReserveGroup(hotel, &group, partyRooms);
+    if (status == HOTEL_OK && !commitChanges(hotel)) {
+        return;
+    }
+    if (status != HOTEL_OK) {
+        printHeader("Error");
+        if (status == HOTEL_INVALID_STAY || status == HOTEL_INVALID_NAME) {
+            putText(status == HOTEL_INVALID_STAY ? "Every party needs someone in it, for at least one night.\n"
+                                                 : "Guest name is too long.\n");
+        } else if (status == HOTEL_ROOM_UNAVAILABLE) {
+            putText("Not enough rooms are free for those nights.\n");
+        } else {
+            putText("A party is larger than any free room holds.\n");
+        }
+        printLine('-', 30);
+        return;
+    }
+
+    int64_t total = 0;
+    int rooms = 0, people = 0;
+    printHeader("***** Group Receipt *****");
+    putText("* Guest Name          : ");
+    putText(guestName);
+    putText("\n* Check-in            : ");
+    printDate(checkIn);
+    putText("\n* Check-out           : ");
+    printDate(checkIn + duration);
+    putText("\n* Duration of Stay    : ");
+    putNumber(duration);
+    putText(" days\n");
+    for (int roomNumber = INT32_MIN;;) { // Each room once, by room number, with everyone packed into it
+        int next = INT32_MAX, occupancy = 0;
+        for (int p = 0; p < partyCount; ++p) {
+            next = partyRooms[p] > roomNumber && partyRooms[p] < next ? partyRooms[p] : next;
+        }
+        for (int p = 0; p < partyCount; ++p) {
+            occupancy += partyRooms[p] == next ? parties[p] : 0;
+        }
+        if (occupancy == 0) {
+            break;
+        }
+        roomNumber = next;
+        int64_t price = hotelQuote(hotel, roomNumber, checkIn, duration, occupancy, extraServices);
+        putText("* Room ");
+        putNumber(roomNumber);
+        putText("            : ");
+        putNumber(occupancy);
+        putText(occupancy == 1 ? " person, " : " people, ");
+        putNumber(price);
+        putText(" PKR\n");
+        total += price;
+        people += occupancy;
+        rooms++;
+    }
+    putText("* Rooms               : ");
+    putNumber(rooms);
+    putText("\n* Number of People    : ");
+    putNumber(people);
+    putText("\n* Total Cost          : ");
+    putNumber(total);
+    putText(" PKR\n");
+    printLine('*', 30);
+}
+
 // Function to cancel a reservation
-void cancelReservation(struct Room* head, int roomNumber, const char* guestName) {
-    struct Room* temp = head; // Temporary pointer to traverse the list
-    while (temp != NULL) { // Traverse the list
-        if (temp->roomNumber == roomNumber) { // Check if the room number matches
-            if (temp->isReserved && strcmp(temp->guestName, guestName) == 0) { // Check if the reservation matches
-                temp->isReserved = 0; // Set the reservation status to not reserved
-                temp->guestName[0] = '\0'; // Clear the guest name
-                temp->duration = 0; // Reset the duration
-                temp->extraServices = 0; // Reset the extra services
-                temp->occupancy = 0; // Reset the occupancy
-
-                time_t now = time(NULL);
-                temp->cancellationTime = *localtime(&now); // Set the cancellation time
-
-                printHeader("Cancel Reservation");
-                printf("Reservation for %s in room %d canceled.\n", guestName, roomNumber); // Print confirmation
-                printf("Cancellation Time: %s", asctime(&temp->cancellationTime));
-                printLine('-', 30);
-            } else {
-                printHeader("Error");
-                printf("Reservation not found for %s in room %d.\n", guestName, roomNumber); // Print error if reservation not found
-                printLine('-', 30);
+void cancelReservation(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn) {
+    struct HotelRoom room;
+    int status = hotelCancel(hotel, roomNumber, guestName, checkIn);
+    if (status == HOTEL_OK && !commitChanges(hotel)) {
+        return;
+    }
+    if (status == HOTEL_OK) {
+        int64_t cancellationTime = hotelFindRoom(hotel, roomNumber, &room) ? room.cancellationTime : (int64_t)time(NULL);
+        printHeader("Cancel Reservation");
+        putText("Reservation for "); // Print confirmation
+        putText(guestName);
+        putText(" in room ");
+        putNumber(roomNumber);
+        putText(" canceled.\nCancellation Time: ");
+        putTime(cancellationTime);
+        printLine('-', 30);
+        return;
+    }
+
+    printHeader("Error");
+    if (status == HOTEL_ROOM_NOT_FOUND) {
+        putText("Room "); // Print error if room number not found
+        putNumber(roomNumber);
+        putText(" not found.\n");
+    } else {
+        putText("Reservation not found for "); // Print error if reservation not found
+        putText(guestName);
+        putText(" in room ");
+        putNumber(roomNumber);
+        putText(".\n");
+    }
+    printLine('-', 30);
+}
+
+// Function to view the rooms free for a stay
+void viewAvailableRooms(struct Hotel* hotel, int checkIn, int duration, int occupancy) {
+    printHeader("Available Rooms");
+    if (!isValidStay(checkIn, duration)) {
+        putText("A stay must be for 1 to 3660 nights between 1970 and 9999.\n");
+        printLine('-', 30);
+        return;
+    }
+    int roomCount = hotelRoomCount(hotel); // Rooms added meanwhile are counted but not listed
+    int* roomNumbers = (int*)malloc((roomCount + 1) * sizeof(int));
+    int found = hotelFindFreeRooms(hotel, checkIn, duration, occupancy, roomNumbers, roomCount);
+    for (int i = 0; i < found && i < roomCount; ++i) {
+        putText("Room ");
+        putNumber(roomNumbers[i]);
+        putText(" is available.\n");
+    }
+    putNumber(found);
+    putText(" room(s) free from ");
+    printDate(checkIn);
+    putText(" to ");
+    printDate(checkIn + duration);
+    putText(" for ");
+    putNumber(occupancy);
+    putText(" people.\n");
+    free(roomNumbers);
+    printLine('-', 30);
+}
+
+// Function to look up a guest: their bookings if the name is exact, otherwise the guests whose
+// name starts with the text, otherwise the names within a couple of typos of it
+void viewGuest(struct Hotel* hotel, const char* text) {
+    struct GuestStay stays[GUEST_MAX_LISTED];
+    struct GuestMatch matches[GUEST_MAX_LISTED];
+    printHeader("Guest Search");
+    int count = hotelFindGuest(hotel, text, stays, GUEST_MAX_LISTED);
+    if (count > 0) {
+        for (int i = 0; i < count && i < GUEST_MAX_LISTED; ++i) {
+            struct HotelBooking booking;
+            if (hotelFindBooking(hotel, stays[i].roomNumber, stays[i].checkIn, &booking) == HOTEL_OK) { // Not cancelled meanwhile
+                putText("Room ");
+                putNumber(stays[i].roomNumber);
+                putText(" from ");
+                printDate(stays[i].checkIn);
+                putText(" to ");
+                printDate(booking.checkOut);
+                putText(" with ");
+                putNumber(booking.occupancy);
+                putText(" people.\n");
             }
-            return; // Exit the function
         }
-        temp = temp->next; // Move to the next room
+        putNumber(count);
+        putText(" booking(s) for ");
+        putText(text);
+        putText(count > GUEST_MAX_LISTED ? " (earliest shown).\n" : ".\n");
+        printLine('-', 30);
+        return;
+    }
+
+    int found = hotelSearchGuestPrefix(hotel, text, matches, GUEST_MAX_LISTED);
+    if (found > 0) {
+        putText("Guests starting with \"");
+    } else if ((found = hotelSearchGuestFuzzy(hotel, text, GUEST_MAX_DISTANCE, matches, GUEST_MAX_LISTED)) > 0) {
+        putText("No exact match. Did you mean one of these for \"");
+    } else {
+        putText("No guest found for \"");
+    }
+    putText(text);
+    putText(found > 0 ? "\":\n" : "\".\n");
+    for (int i = 0; i < found && i < GUEST_MAX_LISTED; ++i) {
+        putText(matches[i].guestName);
+        putText(" (");
+        putNumber(matches[i].bookingCount);
+        putText(" booking(s))\n");
+    }
+    if (found > GUEST_MAX_LISTED) {
+        putText("... and ");
+        putNumber(found - GUEST_MAX_LISTED);
+        putText(" more; type more of the name.\n");
     }
-    printHeader("Error");
-    printf("Room %d not found.\n", roomNumber); // Print error if room number not found
     printLine('-', 30);
 }
 
-// Function to view all reservations
-void viewReservations(struct Room* head) {
-    struct Room* temp = head; // Temporary pointer to traverse the list
-    printHeader("All Reservations");
-    while (temp != NULL) { // Traverse the list
-        if (temp->isReserved) { // Check if the room is reserved
-            printf("Room %d is reserved by %s for %d days with %d people.\n", temp->roomNumber, temp->guestName, temp->duration, temp->occupancy); // Print reservation details
-            printf("Reservation Time: %s", asctime(&temp->reservationTime));
-        } else {
-            printf("Room %d is not reserved.\n", temp->roomNumber); // Print that the room is not reserved
+// Function to print the bookings of one room of a report, or that it has none
+static void printRoomReservations(const struct HotelRoom* room, const struct HotelBooking* bookings) {
+    if (room->bookingCount > 0) { // Check if the room is reserved
+        for (int b = 0; b < room->bookingCount; ++b) { // Print every booking on the calendar
+            const struct HotelBooking* booking = &bookings[b];
+            putText("Room "); // Print reservation details
+            putNumber(room->roomNumber);
+            putText(" is reserved by ");
+            putText(booking->guestName);
+            putText(" from ");
+            printDate(booking->checkIn);
+            putText(" to ");
+            printDate(booking->checkOut);
+            putText(" with ");
+            putNumber(booking->occupancy);
+            putText(" people.\nReservation Time: ");
+            putTime(booking->reservationTime);
         }
-        temp = temp->next; // Move to the next room
+    } else {
+        putText("Room "); // Print that the room is not reserved
+        putNumber(room->roomNumber);
+        putText(" is not reserved.\n");
+    }
+}
+
+// Function to print every detail of one room of a report
+static void printRoomDetails(const struct HotelRoom* room, const struct HotelBooking* bookings) {
+    putText("Room Number     : ");
+    putNumber(room->roomNumber);
+    putText("\nCapacity        : ");
+    putNumber(room->capacity);
+    putText(room->bookingCount > 0 ? "\nReservation     : Reserved\n" : "\nReservation     : Not Reserved\n");
+    for (int b = 0; b < room->bookingCount; ++b) { // Print every booking on the calendar
+        const struct HotelBooking* booking = &bookings[b];
+        putText("Guest Name      : ");
+        putText(booking->guestName);
+        putText("\nCheck-in        : ");
+        printDate(booking->checkIn);
+        putText("\nCheck-out       : ");
+        printDate(booking->checkOut);
+        putText("\nDuration        : ");
+        putNumber(booking->checkOut - booking->checkIn);
+        putText(" days\nOccupancy       : ");
+        putNumber(booking->occupancy);
+        putText(booking->extraServices ? "\nExtra Services  : Yes\n" : "\nExtra Services  : No\n");
+        putText("Reservation Time: ");
+        putTime(booking->reservationTime);
+    }
+    if (room->cancellationTime != 0) {
+        putText("Last Cancellation Time: ");
+        putTime(room->cancellationTime);
     }
     printLine('-', 30);
 }
 
-// Function to view details of all rooms
-void viewRoomDetails(struct Room* head) {
-    struct Room* temp = head; // Temporary pointer to traverse the list
-    printHeader("All Room Details");
-    while (temp != NULL) { // Traverse the list
-        printf("Room Number     : %d\n", temp->roomNumber);
-        printf("Reservation     : %s\n", temp->isReserved ? "Reserved" : "Not Reserved");
-        if (temp->isReserved) {
-            printf("Guest Name      : %s\n", temp->guestName);
-            printf("Duration        : %d days\n", temp->duration);
-            printf("Occupancy       : %d\n", temp->occupancy);
-            printf("Extra Services  : %s\n", temp->extraServices ? "Yes" : "No");
-            printf("Reservation Time: %s", asctime(&temp->reservationTime));
-        } else if (temp->cancellationTime.tm_year > 0) {
-            printf("Last Cancellation Time: %s", asctime(&temp->cancellationTime));
+// Function to print the next page of a report, one room at a time, as the rooms stood when the view was opened
+// (returns 1 if more pages follow); the rooms are picked and read through the view, so every page of a report
+// comes from the same point in time and no lock is held while they are printed
+static int printReportPage(struct HotelView* view, const struct HotelReportQuery* query, struct HotelCursor* cursor,
+                           void (*printRoom)(const struct HotelRoom*, const struct HotelBooking*)) {
+    int roomNumbers[REPORT_PAGE_ROOMS], capacity = 0;
+    struct HotelBooking* bookings = NULL; // Grown to the room with the most bookings on the page
+    struct HotelRoom room;
+    int first = cursor->state == HOTEL_CURSOR_START;
+    int count = hotelViewReport(view, query, cursor, roomNumbers, REPORT_PAGE_ROOMS);
+    if (first && count <= 0) {
+        putText("No rooms to show.\n");
+    }
+    for (int i = 0; i < count; ++i) {
+        if (!hotelViewRoom(view, roomNumbers[i], &room)) { // Always there: the view listed it
+            continue;
         }
+        if (room.bookingCount > capacity) {
+            capacity = room.bookingCount * 2;
+            bookings = (struct HotelBooking*)realloc(bookings, capacity * sizeof(struct HotelBooking));
+        }
+        hotelViewBookings(view, room.roomNumber, bookings, capacity); // The same bookings: the view does not move
+        printRoom(&room, bookings);
+    }
+    free(bookings);
+    return cursor->state == HOTEL_CURSOR_MORE;
+}
+
+// Function to view the next page of reservations matching a query, as view has them (returns 1 if more pages follow)
+int viewReservations(struct Hotel* hotel, struct HotelView* view, const struct HotelReportQuery* query, struct HotelCursor* cursor) {
+    if (cursor->state == HOTEL_CURSOR_START) {
+        int tonight = hotelToday();
+        printHeader("Reservations");
+        int roomCount = hotelRoomCount(hotel);
+        if (roomCount > 0) { // Occupancy summary straight from the night bitmaps
+            int freeTonight = hotelFindFreeRooms(hotel, tonight, 1, 1, NULL, 0);
+            long long bookedMonth = hotelBookedNights(hotel, tonight, tonight + 30);
+            long long tenths = (bookedMonth * 1000 + 15LL * roomCount) / (30LL * roomCount); // Percent, rounded to one decimal
+            putText("Rooms free tonight   : ");
+            putNumber(freeTonight);
+            putText(" of ");
+            putNumber(roomCount);
+            putText("\nOccupancy, 30 nights : ");
+            putNumber(tenths / 10);
+            putChars('.', 1);
+            putNumber(tenths % 10);
+            putText("%\n");
+            printLine('-', 30);
+        }
+    }
+    int more = printReportPage(view, query, cursor, printRoomReservations);
+    printLine('-', 30);
+    return more;
+}
+
+// Function to view the details of the next page of rooms matching a query, as view has them (returns 1 if more
+// pages follow)
+int viewRoomDetails(struct Hotel* hotel, struct HotelView* view, const struct HotelReportQuery* query, struct HotelCursor* cursor) {
+    if (cursor->state == HOTEL_CURSOR_START) {
+        printHeader("Room Details");
+    }
+    return printReportPage(view, query, cursor, printRoomDetails);
+}
+
+// Function to view the running totals of the hotel, its next nights and its floors (none of it scans the rooms)
+void viewDashboard(struct Hotel* hotel) {
+    struct HotelTotals totals;
+    struct HotelNightTotals night;
+    int floors[DASHBOARD_FLOORS], tonight = hotelToday();
+    hotelTotals(hotel, &totals);
+    printHeader("Dashboard");
+    putText("Rooms            : ");
+    putNumber(totals.rooms);
+    putText("\nReserved Rooms   : ");
+    putNumber(totals.reservedRooms);
+    putText("\nBookings         : ");
+    putNumber(totals.bookings);
+    putText("\nGuests           : ");
+    putNumber(totals.guests);
+    putText("\nRoom Nights      : ");
+    putNumber(totals.roomNights);
+    putText("\nRevenue          : ");
+    putNumber(totals.revenue);
+    putText(" PKR\n");
+    printLine('-', 30);
+    for (int n = 0; n < DASHBOARD_NIGHTS && hotelNightTotals(hotel, tonight + n, &night); ++n) {
+        printDate(tonight + n);
+        putText(" : ");
+        putNumber(night.bookedRooms);
+        putText(" rooms, ");
+        putNumber(night.guests);
+        putText(" guests, ");
+        putNumber(night.arrivals);
+        putText(" arrivals\n");
+    }
+    int floorCount = hotelListFloors(hotel, floors, DASHBOARD_FLOORS);
+    if (floorCount > 0) {
         printLine('-', 30);
-        temp = temp->next; // Move to the next room
     }
+    for (int f = 0; f < floorCount && f < DASHBOARD_FLOORS; ++f) {
+        if (hotelFloorTotals(hotel, floors[f], &totals)) { // Floors only come and go with their rooms
+            putText("Floor ");
+            putNumber(floors[f]);
+            putText(" : ");
+            putNumber(totals.reservedRooms);
+            putText(" of ");
+            putNumber(totals.rooms);
+            putText(" rooms reserved, ");
+            putNumber(totals.revenue);
+            putText(" PKR\n");
+        }
+    }
+    if (floorCount > DASHBOARD_FLOORS) {
+        putText("... and ");
+        putNumber(floorCount - DASHBOARD_FLOORS);
+        putText(" more floors\n");
+    }
+    printLine('-', 30);
+}
+
+// Function to print one line of the booking history: bookings, the share cancelled and the average stay
+static void printHistoryLine(const struct HotelHistoryMonth* month) {
+    int64_t kept = month->bookings - month->cancellations;
+    putNumber(month->bookings);
+    putText(" bookings, ");
+    putNumber(month->cancellations);
+    putText(" cancelled (");
+    putNumber(month->bookings > 0 ? month->cancellations * 100 / month->bookings : 0);
+    putText("%), ");
+    int64_t tenths = kept > 0 ? (month->roomNights * 10 + kept / 2) / kept : 0; // Average nights, to one decimal
+    putNumber(tenths / 10);
+    putChars('.', 1);
+    putNumber(tenths % 10);
+    putText(" nights a stay, ");
+    putNumber(month->revenue);
+    putText(" PKR\n");
+}
+
+// Function to view the booking history month by month, by month of check-in (past guests included)
+void viewHistory(struct Hotel* hotel, int firstDay, int lastDay) {
+    struct HotelHistoryMonth* months = (struct HotelHistoryMonth*)malloc(HISTORY_MAX_MONTHS * sizeof(struct HotelHistoryMonth));
+    struct HotelHistoryMonth sum;
+    int count = hotelHistorySummary(hotel, firstDay, lastDay, HISTORY_VIEW_THREADS, months, HISTORY_MAX_MONTHS);
+    printHeader("Booking History");
+    if (count < 0) {
+        putText("The last day must not come before the first, nor more than 100 years after it.\n");
+        printLine('-', 30);
+        free(months);
+        return;
+    }
+    memset(&sum, 0, sizeof(sum));
+    for (int m = 0; m < count; ++m) {
+        putDigits(months[m].year, 4);
+        putChars('-', 1);
+        putDigits(months[m].month, 2);
+        putText(" : ");
+        printHistoryLine(&months[m]);
+        sum.bookings += months[m].bookings;
+        sum.cancellations += months[m].cancellations;
+        sum.roomNights += months[m].roomNights;
+        sum.revenue += months[m].revenue;
+    }
+    printLine('-', 30);
+    putText("Total   : ");
+    printHistoryLine(&sum);
+    printLine('-', 30);
+    free(months);
 }
 
-// Function to free all allocated memory for the rooms
-void freeRooms(struct Room* head) {
-    struct Room* temp;
-    while (head != NULL) {
-        temp = head;
-        head = head->next;
-        free(temp);
+// Function to show a report page by page, asking before each page after the first (every page is read through
+// one view, opened for the whole report, so bookings made while it is read do not move rooms between pages)
+static void pageReport(struct Hotel* hotel, const struct HotelReportQuery* query,
+                       int (*show)(struct Hotel*, struct HotelView*, const struct HotelReportQuery*, struct HotelCursor*)) {
+    struct HotelCursor cursor = {HOTEL_CURSOR_START, 0};
+    struct HotelView* view = hotelOpenView(hotel);
+    int answer = 1;
+    if (view == NULL) {
+        putText("Too many reports are running; try again later.\n");
+        return;
+    }
+    while (answer == 1 && show(hotel, view, query, &cursor)) {
+        prompt("Show the next page? (1 for yes, 0 for no): ");
+        if (scanf("%d", &answer) != 1) {
+            answer = 0;
+        }
     }
+    hotelCloseView(view);
 }
 
 // Function to display the menu
 void displayMenu() {
     printHeader("Hotel Management System Menu");
-    printf("1. Add Room\n");
-    printf("2. Make Reservation\n");
-    printf("3. Cancel Reservation\n");
-    printf("4. View All Reservations\n");
-    printf("5. View All Room Details\n");
-    printf("0. Exit\n");
+    putText("1. Add Room\n"
+            "2. Make Reservation\n"
+            "3. Cancel Reservation\n"
+            "4. View Reservations\n"
+            "5. View Room Details\n"
+            "6. Find Available Rooms\n"
+            "7. Find Guest\n"
+            "8. Report Rooms\n"
+            "9. Dashboard\n"
+            "10. Booking History\n"
+            "11. Group Booking\n"
+            "0. Exit\n");
     printLine('-', 30);
-    printf("Enter your choice: ");
+    prompt("Enter your choice: ");
 }
 
 // Function to print a header
 void printHeader(const char* title) {
     printLine('*', 30);
-    printf("%s\n", title);
+    putText(title);
+    putChars('\n', 1);
     printLine('*', 30);
 }
 
 // Function to print a line with a specified character and length
 void printLine(char ch, int length) {
-    for (int i = 0; i < length; ++i) {
-        printf("%c", ch);
+    putChars(ch, length);
+    putChars('\n', 1);
+}
+
+// Function to print a day number as YYYY-MM-DD
+void printDate(int dayNumber) {
+    int year, month, day;
+    dateFromDay(dayNumber, &year, &month, &day);
+    putDigits(year, 4);
+    putChars('-', 1);
+    putDigits(month, 2);
+    putChars('-', 1);
+    putDigits(day, 2);
+}
+
+// Function to write everything formatted so far to the screen in as few write() calls as possible
+void flushOutput() {
+    size_t done = 0;
+    while (done < output.size) {
+        ssize_t written = write(output.descriptor, output.data + done, output.size - done);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            break; // The screen is gone: drop the text rather than retry forever
+        }
+        done += (size_t)written;
+    }
+    output.size = 0;
+}
+
+// Function to add text to the output buffer
+void putText(const char* text) {
+    size_t length = strlen(text);
+    while (length > 0) { // Text longer than the free space goes out in several pieces
+        if (output.size == OUTPUT_BUFFER_SIZE) {
+            flushOutput();
+        }
+        size_t room = OUTPUT_BUFFER_SIZE - output.size;
+        size_t piece = length < room ? length : room;
+        memcpy(output.data + output.size, text, piece);
+        output.size += piece;
+        text += piece;
+        length -= piece;
+    }
+}
+
+// Function to add a character repeated count times to the output buffer
+void putChars(char ch, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (output.size == OUTPUT_BUFFER_SIZE) {
+            flushOutput();
+        }
+        output.data[output.size++] = ch;
+    }
+}
+
+// Function to add a number in decimal to the output buffer
+void putNumber(long long number) {
+    char digits[24];
+    int length = 0;
+    unsigned long long magnitude = number < 0 ? 0ULL - (unsigned long long)number : (unsigned long long)number;
+    do { // Least significant digit first
+        digits[length++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (number < 0) {
+        digits[length++] = '-';
+    }
+    if (output.size + length > OUTPUT_BUFFER_SIZE) {
+        flushOutput();
+    }
+    while (length > 0) {
+        output.data[output.size++] = digits[--length];
+    }
+}
+
+// Function to add a non-negative number padded with zeros to at least width digits to the output buffer
+void putDigits(int number, int width) {
+    int length = 1;
+    for (int scale = 10; scale <= number && length < 10; scale *= 10) {
+        length++;
+    }
+    putChars('0', width - length);
+    putNumber(number);
+}
+
+// Function to add a time, in local time and asctime() form ("Thu Jan  1 00:00:00 1970" and a newline), to the output buffer
+void putTime(int64_t when) {
+    static const char days[] = "ThuFriSatSunMonTueWed"; // 1970-01-01, day 0, was a Thursday
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char text[26];
+    int64_t local = localSeconds(when);
+    int dayNumber = (int)((local >= 0 ? local : local - 86399) / 86400);
+    int second = (int)(local - (int64_t)dayNumber * 86400);
+    int year, month, day;
+    dateFromDay(dayNumber, &year, &month, &day);
+    memcpy(text, days + (dayNumber % 7 + 7) % 7 * 3, 3);
+    text[3] = ' ';
+    memcpy(text + 4, months + (month - 1) * 3, 3);
+    text[7] = ' ';
+    text[8] = day >= 10 ? (char)('0' + day / 10) : ' ';
+    text[9] = (char)('0' + day % 10);
+    text[10] = ' ';
+    text[11] = (char)('0' + second / 36000);
+    text[12] = (char)('0' + second / 3600 % 10);
+    text[13] = ':';
+    text[14] = (char)('0' + second / 600 % 6);
+    text[15] = (char)('0' + second / 60 % 10);
+    text[16] = ':';
+    text[17] = (char)('0' + second % 60 / 10);
+    text[18] = (char)('0' + second % 10);
+    text[19] = ' ';
+    text[20] = '\0';
+    putText(text);
+    putNumber(year);
+    putChars('\n', 1);
+}
+
+// Function to show a question and flush the output so it is on screen before the answer is read
+void prompt(const char* question) {
+    putText(question);
+    flushOutput();
+}
+
+// Function to show a startup or shutdown message (a framed message in menu mode, a line on stderr in batch mode)
+static void reportStatus(int batch, const char* title, const char* message) {
+    if (batch) {
+        fprintf(stderr, "%s\n", message);
+        return;
+    }
+    printHeader(title);
+    putText(message);
+    putChars('\n', 1);
+    printLine('-', 30);
+}
+
+// Function to create the hotel, load it from its snapshot, replay the journal and start journaling
+static struct Hotel* openHotel(int batch) {
+    char message[160];
+    struct Hotel* hotel = hotelCreate(); // Start with an empty hotel
+    if (hotel == NULL) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    int loaded = hotelLoadSnapshot(hotel, SNAPSHOT_FILE); // Pick up where the last session left off
+    if (loaded > 0) {
+        snprintf(message, sizeof(message), "Loaded %d rooms from %s.", hotelRoomCount(hotel), SNAPSHOT_FILE);
+        reportStatus(batch, "Snapshot Loaded", message);
+    } else if (loaded < 0) {
+        snprintf(message, sizeof(message), "%s is not a snapshot of this version; starting with an empty hotel.", SNAPSHOT_FILE);
+        reportStatus(batch, "Error", message);
+    }
+    int history = hotelOpenHistory(hotel, HISTORY_FILE); // Past bookings, up to that snapshot
+    if (history == -1) {
+        snprintf(message, sizeof(message), "%s does not go with %s; starting a new booking history.", HISTORY_FILE, SNAPSHOT_FILE);
+        reportStatus(batch, "Error", message);
+    } else if (history == -2) {
+        snprintf(message, sizeof(message), "Could not open %s; the booking history will not be saved.", HISTORY_FILE);
+        reportStatus(batch, "Error", message);
+    }
+    int rates = hotelLoadRates(hotel, RATES_FILE); // Prices; the default plan if there is no rate file
+    if (rates < 0) {
+        snprintf(message, sizeof(message), "Line %d of %s is not understood; using the default rates.", -rates, RATES_FILE);
+        reportStatus(batch, "Error", message);
+    }
+    int replayed = hotelRecoverJournal(hotel, JOURNAL_FILE); // Redo the changes made after that snapshot
+    if (replayed > 0) {
+        snprintf(message, sizeof(message), "Recovered %d changes from %s.", replayed, JOURNAL_FILE);
+        reportStatus(batch, "Journal Replayed", message);
+    }
+    if (replayed >= 0 && hotelOpenJournal(hotel, JOURNAL_FILE)) { // From now on every change is durable before it is acknowledged
+        if (replayed > 0) {
+            hotelCheckpoint(hotel, SNAPSHOT_FILE); // Fold the recovered changes into the snapshot
+        }
+    } else {
+        snprintf(message, sizeof(message), "Could not open %s; changes will only be saved on exit.", JOURNAL_FILE);
+        reportStatus(batch, "Error", message);
+    }
+    return hotel;
+}
+
+// Function to save the hotel for the next session, close the journal and free everything
+// (returns 1 if the snapshot was saved)
+static int closeHotel(struct Hotel* hotel, int batch) {
+    char message[160];
+    int saved = hotelCheckpoint(hotel, SNAPSHOT_FILE); // Keep the hotel for the next session
+    if (!saved) {
+        snprintf(message, sizeof(message), "Could not save %s.", SNAPSHOT_FILE);
+        reportStatus(batch, "Error", message);
+    }
+    hotelDestroy(hotel); // Close the journal and free all allocated memory
+    if (!hotelWriteMetrics(METRICS_FILE)) { // What the session's operations cost, for the next scrape
+        snprintf(message, sizeof(message), "Could not write %s.", METRICS_FILE);
+        reportStatus(batch, "Error", message);
+    }
+    return saved;
+}
+
+// Function to skip spaces and tabs in a batch line
+static const char* skipBlanks(const char* cursor, const char* end) {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t')) {
+        cursor++;
+    }
+    return cursor;
+}
+
+// Function to parse a decimal number in a batch line (returns NULL if there is none, it does not fit in
+// an int, or it runs into other text)
+static const char* parseNumber(const char* cursor, const char* end, int* value) {
+    cursor = skipBlanks(cursor, end);
+    int negative = cursor < end && *cursor == '-';
+    cursor += negative;
+    if (cursor == end || *cursor < '0' || *cursor > '9') {
+        return NULL;
+    }
+    int number = 0;
+    while (cursor < end && *cursor >= '0' && *cursor <= '9') {
+        int digit = *cursor++ - '0';
+        if (number > (INT32_MAX - digit) / 10) {
+            return NULL; // Refused rather than cut short, which would act on another room or stay
+        }
+        number = number * 10 + digit;
+    }
+    if (cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != ',') {
+        return NULL; // A number run into other text, such as 101xyz, is no number
+    }
+    *value = negative ? -number : number;
+    return cursor;
+}
+
+// Function to parse a YYYY-MM-DD date in a batch line without sscanf (returns NULL if it is not a valid date)
+static const char* parseBatchDate(const char* cursor, const char* end, int* dayNumber) {
+    static const int daysInMonth[13] = {0, 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    cursor = skipBlanks(cursor, end);
+    if (end - cursor < 10 || cursor[4] != '-' || cursor[7] != '-') {
+        return NULL;
+    }
+    int digits[8] = {cursor[0], cursor[1], cursor[2], cursor[3], cursor[5], cursor[6], cursor[8], cursor[9]};
+    for (int i = 0; i < 8; ++i) {
+        if (digits[i] < '0' || digits[i] > '9') {
+            return NULL;
+        }
+        digits[i] -= '0';
+    }
+    int year = digits[0] * 1000 + digits[1] * 100 + digits[2] * 10 + digits[3];
+    int month = digits[4] * 10 + digits[5];
+    int day = digits[6] * 10 + digits[7];
+    int leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth[month] || (month == 2 && day == 29 && !leap)) {
+        return NULL;
+    }
+    *dayNumber = dayFromDate(year, month, day);
+    return cursor + 10;
+}
+
+// Function to copy the rest of a batch line as the guest name (returns 0 if it is empty or too long)
+static int parseGuestName(const char* cursor, const char* end, char* guestName) {
+    cursor = skipBlanks(cursor, end);
+    while (end > cursor && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+        end--; // Trailing blanks and Windows line endings are not part of the name
+    }
+    size_t length = (size_t)(end - cursor);
+    if (length >= MAX_NAME_LENGTH) {
+        return 0; // Refused rather than cut short, which could book or cancel under another guest's name
+    }
+    memcpy(guestName, cursor, length);
+    guestName[length] = '\0';
+    return length > 0;
+}
+
+// Function to parse a comma-separated list of party sizes, such as 4,2,3 (returns the end of the list, or NULL
+// if it is empty or longer than BATCH_MAX_PARTIES)
+static const char* parseParties(const char* cursor, const char* end, int* parties, int* partyCount) {
+    *partyCount = 0;
+    do {
+        if (*partyCount == BATCH_MAX_PARTIES || (cursor = parseNumber(cursor, end, &parties[*partyCount])) == NULL) {
+            return NULL;
+        }
+        ++*partyCount;
+    } while (cursor < end && *cursor == ',' && ++cursor);
+    return cursor;
+}
+
+// Function to parse one batch line into a command (an unparsable line becomes BATCH_INVALID)
+static void parseBatchCommand(const char* line, const char* end, struct BatchCommand* command) {
+    if (end > line && end[-1] == '\r') {
+        end--; // A Windows line ending is not part of the last field
+    }
+    const char* cursor = skipBlanks(line, end);
+    const char* word = cursor;
+    while (cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r') {
+        cursor++;
+    }
+    size_t wordLength = (size_t)(cursor - word);
+    int type = BATCH_INVALID;
+
+    if (wordLength == 3 && memcmp(word, "add", 3) == 0) {
+        if ((cursor = parseNumber(cursor, end, &command->roomNumber)) != NULL && skipBlanks(cursor, end) == end) {
+            type = BATCH_ADD;
+        }
+    } else if (wordLength == 7 && memcmp(word, "reserve", 7) == 0) {
+        if ((cursor = parseNumber(cursor, end, &command->roomNumber)) != NULL
+            && (cursor = parseBatchDate(cursor, end, &command->checkIn)) != NULL
+            && (cursor = parseNumber(cursor, end, &command->duration)) != NULL
+            && (cursor = parseNumber(cursor, end, &command->occupancy)) != NULL
+            && (cursor = parseNumber(cursor, end, &command->extraServices)) != NULL
+            && parseGuestName(cursor, end, command->guestName)) {
+            type = BATCH_RESERVE;
+        }
+    } else if (wordLength == 6 && memcmp(word, "cancel", 6) == 0) {
+        if ((cursor = parseNumber(cursor, end, &command->roomNumber)) != NULL
+            && (cursor = parseBatchDate(cursor, end, &command->checkIn)) != NULL
+            && parseGuestName(cursor, end, command->guestName)) {
+            type = BATCH_CANCEL;
+        }
+    } else if (wordLength == 5 && memcmp(word, "query", 5) == 0) {
+        if ((cursor = parseBatchDate(cursor, end, &command->checkIn)) != NULL
+            && (cursor = parseNumber(cursor, end, &command->duration)) != NULL
+            && (cursor = parseNumber(cursor, end, &command->occupancy)) != NULL && skipBlanks(cursor, end) == end
+            && command->duration > 0) {
+            type = BATCH_QUERY;
+        }
+    } else if (wordLength == 5 && memcmp(word, "guest", 5) == 0) {
+        if (parseGuestName(cursor, end, command->guestName)) {
+            type = BATCH_GUEST;
+        }
+    } else if (wordLength == 5 && memcmp(word, "quote", 5) == 0) {
+        if ((cursor = parseNumber(cursor, end, &command->roomNumber)) != NULL
+            && (cursor = parseBatchDate(cursor, end, &command->checkIn)) != NULL
+            && (cursor = parseNumber(cursor, end, &command->duration)) != NULL
+            && (cursor = parseNumber(cursor, end, &command->occupancy)) != NULL
+            && (cursor = parseNumber(cursor, end, &command->extraServices)) != NULL && skipBlanks(cursor, end) == end
+            && command->duration > 0) {
+            type = BATCH_QUOTE;
+        }
+    } else if (wordLength == 6 && memcmp(word, "import", 6) == 0) {
+        if (parseGuestName(cursor, end, command->guestName)) {
+            type = BATCH_IMPORT;
+        }
+    } else if (wordLength == 6 && memcmp(word, "totals", 6) == 0) {
+        if (skipBlanks(cursor, end) == end) {
+            type = BATCH_TOTALS;
+        }
+    } else if (wordLength == 7 && memcmp(word, "history", 7) == 0) {
+        if ((cursor = parseBatchDate(cursor, end, &command->checkIn)) != NULL
+            && (cursor = parseBatchDate(cursor, end, &command->lastDay)) != NULL && skipBlanks(cursor, end) == end) {
+            type = BATCH_HISTORY;
+        }
+    } else if (wordLength == 5 && memcmp(word, "group", 5) == 0) {
+        if ((cursor = parseBatchDate(cursor, end, &command->checkIn)) != NULL
+            && (cursor = parseNumber(cursor, end, &command->duration)) != NULL
+            && (cursor = parseNumber(cursor, end, &command->extraServices)) != NULL
+            && (cursor = parseParties(cursor, end, command->parties, &command->partyCount)) != NULL
+            && parseGuestName(cursor, end, command->guestName)) {
+            type = BATCH_GROUP;
+        }
+    }
+    command->type = type;
+}
+
+// Function to pull a queued command's room into cache before it runs (stage 0 touches the index slots
+// of the room and guest, stage 1 the room's table entries and night bitmap, stage 2 its calendar and
+// the guest's entry in the guest index); this is only a hint,
+// so a room added or moved in the meantime costs nothing but a wasted prefetch
+static void prefetchBatchCommand(struct Hotel* hotel, struct BatchCommand* command, int stage) {
+    if (command->type != BATCH_RESERVE && command->type != BATCH_CANCEL) {
+        return;
+    }
+    if (stage == 0) {
+        unsigned int mask = (unsigned int)hotel->index.capacity - 1;
+        __builtin_prefetch(&hotel->index.slots[hashRoomNumber(command->roomNumber) & mask]);
+        command->guestSlot = hashGuestName(command->guestName) & (unsigned int)(hotel->guests.slotCapacity - 1);
+        __builtin_prefetch(&hotel->guests.slots[command->guestSlot]);
+    } else if (stage == 1) {
+        command->slot = findRoom(hotel, command->roomNumber);
+        if (command->slot >= 0) {
+            int night = command->checkIn - hotel->calendarStart;
+            __builtin_prefetch(&hotel->rooms[command->slot]);
+            __builtin_prefetch(&hotel->details[command->slot]);
+            if (night >= 0 && night < NIGHT_HORIZON) {
+                __builtin_prefetch(&hotel->nights[(night / 64) * hotel->roomCapacity + command->slot]);
+            }
+        }
+    } else {
+        if (command->slot >= 0 && command->slot < hotel->roomCount) {
+            __builtin_prefetch(hotel->rooms[command->slot].stays);
+            __builtin_prefetch(hotel->details[command->slot].bookings);
+        }
+        if (command->guestSlot < (unsigned int)hotel->guests.slotCapacity) { // The index may have grown since stage 0
+            int guest = hotel->guests.slots[command->guestSlot].guest;
+            if (guest >= 0 && guest < hotel->guests.guestCount) {
+                __builtin_prefetch(&hotel->guests.guests[guest]); // The right guest unless the first probe missed
+            }
+        }
+    }
+}
+
+// Function to run one parsed batch command and add its one-line result to the output buffer (returns 1 if it failed)
+static int runBatchCommand(struct Hotel* hotel, const struct BatchCommand* command) {
+    int status = -1;
+    switch (command->type) {
+        case BATCH_ADD:
+            status = hotelAddRoom(hotel, command->roomNumber);
+            break;
+        case BATCH_RESERVE:
+            status = hotelReserve(hotel, command->roomNumber, command->guestName, command->checkIn, command->duration,
+                                  command->extraServices, command->occupancy);
+            break;
+        case BATCH_CANCEL:
+            status = hotelCancel(hotel, command->roomNumber, command->guestName, command->checkIn);
+            break;
+        case BATCH_QUERY:
+            putText("FREE ");
+            putNumber(hotelFindFreeRooms(hotel, command->checkIn, command->duration, command->occupancy, NULL, 0));
+            putChars('\n', 1);
+            return 0;
+        case BATCH_GUEST:
+            putText("BOOKINGS ");
+            putNumber(hotelFindGuest(hotel, command->guestName, NULL, 0));
+            putChars('\n', 1);
+            return 0;
+        case BATCH_QUOTE: // A price list, so the room need not exist
+            putText("PRICE ");
+            putNumber(hotelQuote(hotel, command->roomNumber, command->checkIn, command->duration, command->occupancy,
+                                 command->extraServices));
+            putChars('\n', 1);
+            return 0;
+        case BATCH_IMPORT: { // All the file's rooms in one pass, or none if a line is wrong
+            int listed = 0, added = 0;
+            if (hotelImportRooms(hotel, command->guestName, &listed, &added) <= 0) {
+                putText("ERR bad-room-file\n");
+                return 1;
+            }
+            putText("ADDED ");
+            putNumber(added);
+            putText(" EXISTING ");
+            putNumber(listed - added);
+            putChars('\n', 1);
+            return 0;
+        }
+        case BATCH_TOTALS: { // The running totals, however large the hotel
+            struct HotelTotals totals;
+            hotelTotals(hotel, &totals);
+            putText("ROOMS ");
+            putNumber(totals.rooms);
+            putText(" RESERVED ");
+            putNumber(totals.reservedRooms);
+            putText(" BOOKINGS ");
+            putNumber(totals.bookings);
+            putText(" GUESTS ");
+            putNumber(totals.guests);
+            putText(" NIGHTS ");
+            putNumber(totals.roomNights);
+            putText(" REVENUE ");
+            putNumber(totals.revenue);
+            putChars('\n', 1);
+            return 0;
+        }
+        case BATCH_HISTORY: { // Every reservation and cancellation for stays checking in between the two days
+            struct HotelHistoryMonth months[HISTORY_MAX_MONTHS], sum;
+            int count = hotelHistorySummary(hotel, command->checkIn, command->lastDay, 1, months, HISTORY_MAX_MONTHS);
+            if (count < 0) {
+                putText("ERR bad-range\n");
+                return 1;
+            }
+            memset(&sum, 0, sizeof(sum));
+            for (int m = 0; m < count; ++m) {
+                sum.bookings += months[m].bookings;
+                sum.cancellations += months[m].cancellations;
+                sum.roomNights += months[m].roomNights;
+                sum.revenue += months[m].revenue;
+            }
+            putText("BOOKINGS ");
+            putNumber(sum.bookings);
+            putText(" CANCELLED ");
+            putNumber(sum.cancellations);
+            putText(" NIGHTS ");
+            putNumber(sum.roomNights);
+            putText(" REVENUE ");
+            putNumber(sum.revenue);
+            putChars('\n', 1);
+            return 0;
+        }
+        case BATCH_GROUP: { // All the parties' rooms, or none
+            struct HotelGroup group = {command->guestName, command->checkIn, command->duration, command->extraServices,
+                                       command->parties, command->partyCount};
+            int partyRooms[BATCH_MAX_PARTIES];
+            status = hotelReserveGroup(hotel, &group, partyRooms);
+            if (status != HOTEL_OK) {
+                break;
+            }
+            putText("OK");
+            for (int p = 0; p < command->partyCount; ++p) {
+                putChars(' ', 1);
+                putNumber(partyRooms[p]);
+            }
+            putChars('\n', 1);
+            return 0;
+        }
+    }
+
+    if (status == HOTEL_OK) {
+        putText("OK\n");
+    } else {
+        putText("ERR ");
+        putText(status < 0 ? "bad-command" : hotelStatusName(status));
+        putChars('\n', 1);
+    }
+    return status != HOTEL_OK;
+}
+
+// Function to hand buffered batch results to the caller once the changes behind them are durable
+static int flushBatchOutput(struct Hotel* hotel) {
+    if (!hotelSyncJournal(hotel)) {
+        fprintf(stderr, "Could not write %s; stopping.\n", JOURNAL_FILE);
+        return 0;
+    }
+    flushOutput();
+    return 1;
+}
+
+// Function to run batch commands from input, one per line, writing one result line per command
+// (returns 1 if any command failed)
+//   add ROOM
+//   reserve ROOM YYYY-MM-DD NIGHTS PEOPLE EXTRAS GUEST NAME
+//   cancel ROOM YYYY-MM-DD GUEST NAME
+//   query YYYY-MM-DD NIGHTS PEOPLE
+//   guest GUEST NAME
+//   quote ROOM YYYY-MM-DD NIGHTS PEOPLE EXTRAS
+//   import FILE                     (a room file, see hotelImportRooms)
+//   totals                          (rooms, reserved rooms, bookings, guests, room-nights and revenue)
+//   history YYYY-MM-DD YYYY-MM-DD   (bookings, cancellations, room-nights and revenue of stays checking in then)
+//   group YYYY-MM-DD NIGHTS EXTRAS PARTIES GUEST NAME
+//                                   (PARTIES as 4,2,3: all booked or none; OK and the room of each party)
+// Blank lines and lines starting with '#' produce no result. Commands are parsed BATCH_LOOKAHEAD ahead
+// of the one running so the rooms they touch are already in cache when their turn comes.
+static int runBatch(struct Hotel* hotel, FILE* input) {
+    size_t capacity = BATCH_CHUNK_SIZE, used = 0;
+    char* buffer = (char*)malloc(capacity);
+    struct BatchCommand queue[BATCH_LOOKAHEAD];
+    long commands = 0, failures = 0, queued = 0;
+    int ok = 1, atEnd = 0;
+    struct timespec started, finished;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    while (ok && !(atEnd && queued == commands)) {
+        if (!atEnd) {
+            if (used == capacity) { // A single line longer than the buffer: make the buffer bigger
+                capacity *= 2;
+                buffer = (char*)realloc(buffer, capacity);
+            }
+            size_t got = fread(buffer + used, 1, capacity - used, input);
+            atEnd = got == 0;
+            used += got;
+        }
+        char* line = buffer;
+        char* limit = buffer + used;
+        while (ok) {
+            if (queued - commands == BATCH_LOOKAHEAD || (line == limit && atEnd && queued > commands)) {
+                struct BatchCommand* next = &queue[commands % BATCH_LOOKAHEAD]; // Run the oldest queued command
+                failures += runBatchCommand(hotel, next);
+                commands++;
+                if (output.size >= BATCH_OUTPUT_SIZE) { // Well short of OUTPUT_BUFFER_SIZE, so results never go out early
+                    ok = flushBatchOutput(hotel);
+                }
+                continue;
+            }
+            if (line == limit) {
+                break;
+            }
+            char* newline = (char*)memchr(line, '\n', (size_t)(limit - line));
+            if (newline == NULL && !atEnd) {
+                break; // Incomplete last line: keep it for the next chunk
+            }
+            char* end = newline != NULL ? newline : limit;
+            const char* first = skipBlanks(line, end);
+            if (first < end && *first != '#' && *first != '\r') {
+                struct BatchCommand* command = &queue[queued % BATCH_LOOKAHEAD];
+                parseBatchCommand(line, end, command);
+                command->slot = -1;
+                prefetchBatchCommand(hotel, command, 0);
+                if (queued - commands >= BATCH_LOOKAHEAD / 2) { // Halfway along: find the room itself
+                    prefetchBatchCommand(hotel, &queue[(queued - BATCH_LOOKAHEAD / 2) % BATCH_LOOKAHEAD], 1);
+                }
+                if (queued - commands >= BATCH_LOOKAHEAD - 2) { // About to run: fetch its calendar
+                    prefetchBatchCommand(hotel, &queue[(queued - BATCH_LOOKAHEAD + 2) % BATCH_LOOKAHEAD], 2);
+                }
+                queued++;
+            }
+            line = newline != NULL ? newline + 1 : limit;
+        }
+        used = (size_t)(limit - line);
+        memmove(buffer, line, used); // Move the incomplete line to the front
+    }
+    ok = ok && flushBatchOutput(hotel);
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    double seconds = (double)(finished.tv_sec - started.tv_sec) + (finished.tv_nsec - started.tv_nsec) / 1e9;
+    fprintf(stderr, "%ld commands, %ld failed, %.3f s (%.0f commands/s).\n", commands, failures, seconds,
+            seconds > 0 ? commands / seconds : 0.0);
+    free(buffer);
+    return failures > 0 || !ok;
+}
+
+#ifdef HAVE_SERVER
+// Function to stop the server loop from a signal handler
+static void stopServer(int signalNumber) {
+    (void)signalNumber;
+    serverStopping = 1;
+}
+
+// Function to add text to a connection's response buffer (the caller leaves room for it)
+static void appendText(struct Connection* connection, const char* text, size_t length) {
+    memcpy(connection->output + connection->outputSize, text, length);
+    connection->outputSize += length;
+}
+
+// Function to format a number into text (returns its length; text needs room for 12 characters)
+static size_t formatNumber(char* text, long long number) {
+    char digits[24];
+    size_t length = 0, written = 0;
+    unsigned long long magnitude = number < 0 ? 0ULL - (unsigned long long)number : (unsigned long long)number;
+    do { // Least significant digit first
+        digits[length++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (number < 0) {
+        text[written++] = '-';
+    }
+    while (length > 0) {
+        text[written++] = digits[--length];
+    }
+    return written;
+}
+
+// Function to add a JSON body to the connection as one complete HTTP/1.1 response
+static void sendResponse(struct Connection* connection, int code, const char* body, size_t bodyLength) {
+    static const char* reasons[] = {"200 OK", "201 Created", "400 Bad Request", "404 Not Found", "405 Method Not Allowed",
+                                    "409 Conflict", "413 Content Too Large", "422 Unprocessable Content"};
+    static const int codes[] = {200, 201, 400, 404, 405, 409, 413, 422};
+    const char* reason = reasons[0];
+    for (size_t i = 0; i < sizeof(codes) / sizeof(codes[0]); ++i) {
+        if (codes[i] == code) {
+            reason = reasons[i];
+        }
+    }
+    char number[24];
+    appendText(connection, "HTTP/1.1 ", 9);
+    appendText(connection, reason, strlen(reason));
+    appendText(connection, "\r\nContent-Type: application/json\r\nContent-Length: ", 50);
+    appendText(connection, number, formatNumber(number, (long long)bodyLength));
+    if (connection->closeAfterWrite) {
+        appendText(connection, "\r\nConnection: close", 19);
+    }
+    appendText(connection, "\r\n\r\n", 4);
+    appendText(connection, body, bodyLength);
+}
+
+// Function to answer with {"status":"error","error":name}
+static void sendError(struct Connection* connection, int code, const char* name) {
+    char body[96];
+    size_t length = 0;
+    memcpy(body, "{\"status\":\"error\",\"error\":\"", 27);
+    length = 27;
+    memcpy(body + length, name, strlen(name));
+    length += strlen(name);
+    memcpy(body + length, "\"}", 2);
+    sendResponse(connection, code, body, length + 2);
+}
+
+// Function to answer a change to the hotel (200 or 201 on success, a matching error code otherwise)
+static void sendStatus(struct Connection* connection, int status, int createdCode) {
+    static const int errorCodes[] = {200, 404, 409, 422, 404, 422, 422, 409}; // By enum HotelStatus
+    if (status == HOTEL_OK) {
+        sendResponse(connection, createdCode, "{\"status\":\"ok\"}", 15);
+    } else {
+        sendError(connection, errorCodes[status], hotelStatusName(status));
+    }
+}
+
+// Function to parse a flat JSON object into key/value spans (returns the number of fields, or -1 if it is not one)
+static int parseJsonObject(const char* text, const char* end, struct JsonField* fields, int maxFields) {
+    int count = 0;
+    text = skipBlanks(text, end);
+    if (text == end || *text++ != '{') {
+        return -1;
+    }
+    while (1) {
+        while (text < end && (*text == ' ' || *text == '\t' || *text == '\r' || *text == '\n')) {
+            text++;
+        }
+        if (text < end && *text == '}' && count == 0) {
+            return 0;
+        }
+        if (text == end || *text != '"' || count == maxFields) {
+            return -1;
+        }
+        struct JsonField* field = &fields[count++];
+        field->key = ++text;
+        while (text < end && *text != '"') {
+            text++;
+        }
+        if (text == end) {
+            return -1;
+        }
+        field->keyLength = (size_t)(text++ - field->key);
+        while (text < end && (*text == ' ' || *text == '\t' || *text == '\r' || *text == '\n' || *text == ':')) {
+            text++;
+        }
+        if (text == end) {
+            return -1;
+        }
+        field->isString = *text == '"';
+        if (field->isString) { // Keep the escapes; jsonString decodes them
+            field->value = ++text;
+            while (text < end && *text != '"') {
+                text += *text == '\\' ? 2 : 1;
+            }
+            if (text >= end) {
+                return -1;
+            }
+            field->valueLength = (size_t)(text++ - field->value);
+        } else {
+            field->value = text;
+            while (text < end && *text != ',' && *text != '}' && *text != ' ' && *text != '\r' && *text != '\n') {
+                text++;
+            }
+            field->valueLength = (size_t)(text - field->value);
+        }
+        while (text < end && (*text == ' ' || *text == '\t' || *text == '\r' || *text == '\n')) {
+            text++;
+        }
+        if (text < end && *text == ',') {
+            text++;
+        } else if (text < end && *text == '}') {
+            return count;
+        } else {
+            return -1;
+        }
+    }
+}
+
+// Function to find a field of a parsed JSON object by key (NULL if it is missing)
+static const struct JsonField* jsonFind(const struct JsonField* fields, int count, const char* key) {
+    size_t length = strlen(key);
+    for (int i = 0; i < count; ++i) {
+        if (fields[i].keyLength == length && memcmp(fields[i].key, key, length) == 0) {
+            return &fields[i];
+        }
+    }
+    return NULL;
+}
+
+// Function to read a JSON number (or true/false) field (returns 0 if it is missing or not a number)
+static int jsonNumber(const struct JsonField* field, int* value) {
+    if (field == NULL || field->isString) {
+        return 0;
+    }
+    if (field->valueLength == 4 && memcmp(field->value, "true", 4) == 0) {
+        *value = 1;
+        return 1;
+    }
+    if (field->valueLength == 5 && memcmp(field->value, "false", 5) == 0) {
+        *value = 0;
+        return 1;
+    }
+    const char* end = field->value + field->valueLength;
+    return parseNumber(field->value, end, value) == end;
+}
+
+// Function to decode a JSON string field into text of at most MAX_NAME_LENGTH - 1 characters (returns 0 if it is empty or longer)
+static int jsonString(const struct JsonField* field, char* text) {
+    if (field == NULL || !field->isString) {
+        return 0;
+    }
+    size_t length = 0;
+    for (size_t i = 0; i < field->valueLength; ++i) {
+        if (length == MAX_NAME_LENGTH - 1) {
+            return 0;
+        }
+        char ch = field->value[i];
+        if (ch == '\\' && i + 1 < field->valueLength) {
+            ch = field->value[++i];
+            if (ch == 'n' || ch == 'r' || ch == 't' || ch == 'b' || ch == 'f') {
+                ch = ' '; // Control characters have no place in a guest name
+            } else if (ch == 'u') { // Only ASCII escapes are kept as they are
+                int code = 0;
+                for (int k = 0; k < 4 && i + 1 < field->valueLength; ++k) {
+                    char digit = field->value[++i];
+                    code = code * 16 + (digit <= '9' ? digit - '0' : (digit | 0x20) - 'a' + 10);
+                }
+                ch = code >= 0x20 && code < 0x7f ? (char)code : '?';
+            }
+        }
+        text[length++] = ch;
+    }
+    text[length] = '\0';
+    return length > 0;
+}
+
+// Function to read a YYYY-MM-DD JSON string field as a day number (returns 0 if it is missing or invalid)
+static int jsonDate(const struct JsonField* field, int* dayNumber) {
+    return field != NULL && field->isString && field->valueLength == 10
+        && parseBatchDate(field->value, field->value + 10, dayNumber) != NULL;
+}
+
+// Function to find a query parameter in a request target such as /availability?checkIn=2026-11-01&nights=2
+// (returns the start of its value and stores its length, or NULL if it is missing)
+static const char* queryParameter(const char* target, const char* end, const char* name, size_t* length) {
+    size_t nameLength = strlen(name);
+    const char* cursor = memchr(target, '?', (size_t)(end - target));
+    while (cursor != NULL && cursor < end) {
+        cursor++;
+        const char* next = memchr(cursor, '&', (size_t)(end - cursor));
+        const char* stop = next != NULL ? next : end;
+        if ((size_t)(stop - cursor) > nameLength && memcmp(cursor, name, nameLength) == 0 && cursor[nameLength] == '=') {
+            *length = (size_t)(stop - cursor) - nameLength - 1;
+            return cursor + nameLength + 1;
+        }
+        cursor = next;
+    }
+    return NULL;
+}
+
+// Function to answer GET /availability?checkIn=YYYY-MM-DD&nights=N&people=N with the free rooms
+static void serveAvailability(struct Server* server, struct Connection* connection, const char* target, const char* end) {
+    size_t length;
+    int checkIn, nights, people;
+    const char* value = queryParameter(target, end, "checkIn", &length);
+    if (value == NULL || length != 10 || parseBatchDate(value, value + 10, &checkIn) == NULL) {
+        sendError(connection, 400, "bad-request");
+        return;
+    }
+    value = queryParameter(target, end, "nights", &length);
+    if (value == NULL || parseNumber(value, value + length, &nights) != value + length || nights <= 0) {
+        sendError(connection, 400, "bad-request");
+        return;
+    }
+    value = queryParameter(target, end, "people", &length);
+    if (value == NULL || parseNumber(value, value + length, &people) != value + length) {
+        people = 1;
+    }
+    int found = hotelFindFreeRooms(server->hotel, checkIn, nights, people, server->roomNumbers, SERVER_MAX_LISTED_ROOMS);
+    char body[SERVER_MAX_LISTED_ROOMS * 12 + 64];
+    size_t size = 0;
+    memcpy(body, "{\"status\":\"ok\",\"free\":", 22);
+    size = 22;
+    size += formatNumber(body + size, found);
+    memcpy(body + size, ",\"rooms\":[", 10);
+    size += 10;
+    for (int i = 0; i < found && i < SERVER_MAX_LISTED_ROOMS; ++i) { // The first rooms only; free says how many there are
+        if (i > 0) {
+            body[size++] = ',';
+        }
+        size += formatNumber(body + size, server->roomNumbers[i]);
+    }
+    memcpy(body + size, "]}", 2);
+    sendResponse(connection, 200, body, size + 2);
+}
+
+// Function to answer GET /totals with the running totals of the hotel
+static void serveTotals(struct Server* server, struct Connection* connection) {
+    static const char* const keys[] = {"{\"status\":\"ok\",\"rooms\":", ",\"reserved\":", ",\"bookings\":", ",\"guests\":",
+                                       ",\"roomNights\":", ",\"revenue\":"};
+    struct HotelTotals totals;
+    hotelTotals(server->hotel, &totals);
+    long long values[6] = {totals.rooms, totals.reservedRooms, totals.bookings, totals.guests, totals.roomNights, totals.revenue};
+    char body[256];
+    size_t size = 0;
+    for (int i = 0; i < 6; ++i) {
+        size_t length = strlen(keys[i]);
+        memcpy(body + size, keys[i], length);
+        size += length;
+        size += formatNumber(body + size, values[i]);
+    }
+    body[size++] = '}';
+    sendResponse(connection, 200, body, size);
+}
+
+// Function to answer one HTTP request; changes are logged to the journal but not yet synced
+static void serveRequest(struct Server* server, struct Connection* connection, const char* method, size_t methodLength,
+                         const char* target, size_t targetLength, const char* body, size_t bodyLength) {
+    struct JsonField fields[SERVER_MAX_FIELDS];
+    char guestName[MAX_NAME_LENGTH];
+    int roomNumber, checkIn, nights, people, extras, status;
+    const char* targetEnd = target + targetLength;
+    const char* pathEnd = memchr(target, '?', targetLength);
+    size_t pathLength = pathEnd != NULL ? (size_t)(pathEnd - target) : targetLength;
+    int isPost = methodLength == 4 && memcmp(method, "POST", 4) == 0;
+    int isGet = methodLength == 3 && memcmp(method, "GET", 3) == 0;
+    server->requests++;
+
+    if (pathLength == 13 && memcmp(target, "/availability", 13) == 0) {
+        if (!isGet) {
+            sendError(connection, 405, "method-not-allowed");
+        } else {
+            serveAvailability(server, connection, target, targetEnd);
+        }
+        return;
+    }
+    if (pathLength == 7 && memcmp(target, "/totals", 7) == 0) {
+        if (!isGet) {
+            sendError(connection, 405, "method-not-allowed");
+        } else {
+            serveTotals(server, connection);
+        }
+        return;
+    }
+    int isRooms = pathLength == 6 && memcmp(target, "/rooms", 6) == 0;
+    int isReservations = pathLength == 13 && memcmp(target, "/reservations", 13) == 0;
+    int isCancellations = pathLength == 14 && memcmp(target, "/cancellations", 14) == 0;
+    if (!isRooms && !isReservations && !isCancellations) {
+        sendError(connection, 404, "not-found");
+        return;
+    }
+    if (!isPost) {
+        sendError(connection, 405, "method-not-allowed");
+        return;
+    }
+    int count = parseJsonObject(body, body + bodyLength, fields, SERVER_MAX_FIELDS);
+    if (count < 0 || !jsonNumber(jsonFind(fields, count, "room"), &roomNumber)) {
+        sendError(connection, 400, "bad-request");
+        return;
+    }
+
+    if (isRooms) { // POST /rooms {"room": 101}
+        status = hotelAddRoom(server->hotel, roomNumber);
+        sendStatus(connection, status, 201);
+    } else if (isReservations) { // POST /reservations {"room": 101, "guest": "...", "checkIn": "YYYY-MM-DD", "nights": 3, ...}
+        if (!jsonString(jsonFind(fields, count, "guest"), guestName) || !jsonDate(jsonFind(fields, count, "checkIn"), &checkIn)
+            || !jsonNumber(jsonFind(fields, count, "nights"), &nights)) {
+            sendError(connection, 400, "bad-request");
+            return;
+        }
+        if (!jsonNumber(jsonFind(fields, count, "people"), &people)) {
+            people = 1;
+        }
+        if (!jsonNumber(jsonFind(fields, count, "extras"), &extras)) {
+            extras = 0;
+        }
+        status = hotelReserve(server->hotel, roomNumber, guestName, checkIn, nights, extras, people);
+        if (status != HOTEL_OK) {
+            sendStatus(connection, status, 201);
+        } else { // Same total as the receipt printed by makeReservation
+            char reply[128];
+            size_t size = 0;
+            long long totalCost = hotelQuote(server->hotel, roomNumber, checkIn, nights, people, extras);
+            memcpy(reply, "{\"status\":\"ok\",\"room\":", 22);
+            size = 22;
+            size += formatNumber(reply + size, roomNumber);
+            memcpy(reply + size, ",\"nights\":", 10);
+            size += 10;
+            size += formatNumber(reply + size, nights);
+            memcpy(reply + size, ",\"total\":", 9);
+            size += 9;
+            size += formatNumber(reply + size, totalCost);
+            reply[size++] = '}';
+            sendResponse(connection, 201, reply, size);
+        }
+    } else { // POST /cancellations {"room": 101, "guest": "...", "checkIn": "YYYY-MM-DD"}
+        if (!jsonString(jsonFind(fields, count, "guest"), guestName) || !jsonDate(jsonFind(fields, count, "checkIn"), &checkIn)) {
+            sendError(connection, 400, "bad-request");
+            return;
+        }
+        status = hotelCancel(server->hotel, roomNumber, guestName, checkIn);
+        sendStatus(connection, status, 200);
+    }
+    server->unsyncedChanges += status == HOTEL_OK;
+}
+
+// Function to queue a connection for the next flush (once per round)
+static void queueConnection(struct Server* server, struct Connection* connection) {
+    if (!connection->queued) {
+        connection->queued = 1;
+        server->pending[server->pendingCount++] = connection;
+    }
+}
+
+// Function to close a connection and put it back in the pool
+static void closeConnection(struct Server* server, struct Connection* connection) {
+    close(connection->descriptor); // Also removes it from the epoll set
+    connection->descriptor = -1;
+    connection->inputSize = 0;
+    connection->outputSize = 0;
+    connection->outputSent = 0;
+    connection->closeAfterWrite = 0;
+    connection->peerClosed = 0;
+    connection->nextFree = server->freeConnections;
+    server->freeConnections = connection;
+}
+
+// Function to answer every complete request in a connection's input, as long as its output has room
+static void processConnection(struct Server* server, struct Connection* connection) {
+    size_t consumed = 0;
+    while (!connection->closeAfterWrite && connection->outputSize + SERVER_MAX_RESPONSE <= SERVER_BUFFER_SIZE) {
+        const char* request = connection->input + consumed;
+        const char* end = connection->input + connection->inputSize;
+        const char* headersEnd = NULL;
+        for (const char* cursor = request; cursor + 3 < end; ++cursor) { // Find the blank line after the headers
+            if (cursor[0] == '\r' && cursor[1] == '\n' && cursor[2] == '\r' && cursor[3] == '\n') {
+                headersEnd = cursor + 4;
+                break;
+            }
+        }
+        if (headersEnd == NULL) {
+            if (consumed == 0 && connection->inputSize == SERVER_BUFFER_SIZE) { // Headers bigger than the whole buffer
+                connection->closeAfterWrite = 1;
+                sendError(connection, 413, "too-large");
+            }
+            break;
+        }
+
+        const char* method = request;
+        const char* space = memchr(method, ' ', (size_t)(headersEnd - method));
+        const char* target = space != NULL ? space + 1 : NULL;
+        const char* targetEnd = target != NULL ? memchr(target, ' ', (size_t)(headersEnd - target)) : NULL;
+        const char* lineEnd = memchr(request, '\r', (size_t)(headersEnd - request));
+        if (targetEnd == NULL || targetEnd > lineEnd) {
+            connection->closeAfterWrite = 1;
+            sendError(connection, 400, "bad-request");
+            break;
+        }
+        int keepAlive = lineEnd - targetEnd >= 9 && memcmp(targetEnd + 1, "HTTP/1.1", 8) == 0; // HTTP/1.0 closes by default
+        long contentLength = 0;
+        for (const char* line = lineEnd + 2; line < headersEnd - 2; ) { // Only two headers matter here
+            const char* next = memchr(line, '\r', (size_t)(headersEnd - line));
+            size_t length = (size_t)(next - line);
+            if (length > 15 && strncasecmp(line, "content-length:", 15) == 0) {
+                contentLength = strtol(line + 15, NULL, 10);
+            } else if (length > 11 && strncasecmp(line, "connection:", 11) == 0) {
+                const char* value = skipBlanks(line + 11, next);
+                keepAlive = (size_t)(next - value) >= 10 && strncasecmp(value, "keep-alive", 10) == 0 ? 1
+                          : (size_t)(next - value) >= 5 && strncasecmp(value, "close", 5) == 0 ? 0 : keepAlive;
+            }
+            line = next + 2;
+        }
+        if (contentLength < 0 || (size_t)contentLength > SERVER_BUFFER_SIZE - (size_t)(headersEnd - request)) {
+            connection->closeAfterWrite = 1;
+            sendError(connection, 413, "too-large");
+            break;
+        }
+        if ((size_t)(end - headersEnd) < (size_t)contentLength) {
+            break; // The rest of the body is still on its way
+        }
+        connection->closeAfterWrite = !keepAlive;
+        serveRequest(server, connection, method, (size_t)(space - method), target, (size_t)(targetEnd - target),
+                     headersEnd, (size_t)contentLength);
+        consumed = (size_t)(headersEnd + contentLength - connection->input);
+    }
+    if (connection->peerClosed && connection->outputSize + SERVER_MAX_RESPONSE <= SERVER_BUFFER_SIZE) {
+        connection->closeAfterWrite = 1; // Everything complete is answered; the rest will never arrive
+    }
+    if (consumed > 0) { // Keep only the unanswered bytes
+        memmove(connection->input, connection->input + consumed, connection->inputSize - consumed);
+        connection->inputSize -= consumed;
+    }
+    if (connection->outputSize > connection->outputSent || connection->closeAfterWrite || connection->peerClosed) {
+        queueConnection(server, connection);
+    }
+}
+
+// Function to read everything a connection has sent (edge-triggered: until the socket would block,
+// or until its requests fill both buffers; flushConnections reads the rest once the output drains)
+static void readConnection(struct Server* server, struct Connection* connection) {
+    int full;
+    do {
+        full = 0;
+        while (!connection->peerClosed) {
+            if (connection->inputSize == SERVER_BUFFER_SIZE) {
+                full = 1; // The socket may still hold data
+                break;
+            }
+            ssize_t received = recv(connection->descriptor, connection->input + connection->inputSize,
+                                    SERVER_BUFFER_SIZE - connection->inputSize, 0);
+            if (received > 0) {
+                connection->inputSize += (size_t)received;
+            } else if (received == 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                connection->peerClosed = 1; // Answer what has arrived, then close
+            } else if (errno != EINTR) {
+                break;
+            }
+        }
+        processConnection(server, connection);
+    } while (full && connection->inputSize < SERVER_BUFFER_SIZE && !connection->closeAfterWrite
+             && connection->outputSize + SERVER_MAX_RESPONSE <= SERVER_BUFFER_SIZE);
+    connection->moreInput = full && !connection->closeAfterWrite;
+}
+
+// Function to write out a connection's responses (returns 0 if the connection was closed)
+static int writeConnection(struct Server* server, struct Connection* connection) {
+    while (connection->outputSent < connection->outputSize) {
+        ssize_t sent = send(connection->descriptor, connection->output + connection->outputSent,
+                            connection->outputSize - connection->outputSent, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection->outputSent += (size_t)sent;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 1; // Finish on the next EPOLLOUT
+        } else {
+            closeConnection(server, connection);
+            return 0;
+        }
+    }
+    connection->outputSize = 0;
+    connection->outputSent = 0;
+    if (connection->closeAfterWrite) {
+        closeConnection(server, connection);
+        return 0;
+    }
+    return 1;
+}
+
+// Function to make this round's changes durable, then send every queued response
+// (responses to changes are only sent once their journal records are on disk)
+static void flushConnections(struct Server* server) {
+    while (server->pendingCount > 0) {
+        if (server->unsyncedChanges > 0) {
+            if (!hotelSyncJournal(server->hotel)) {
+                fprintf(stderr, "Could not write %s; stopping the server.\n", JOURNAL_FILE);
+                serverStopping = 1;
+                return; // Nothing written: no change is acknowledged
+            }
+            server->unsyncedChanges = 0;
+        }
+        int count = server->pendingCount;
+        memcpy(server->flushing, server->pending, count * sizeof(struct Connection*));
+        server->pendingCount = 0;
+        for (int i = 0; i < count; ++i) {
+            struct Connection* connection = server->flushing[i];
+            connection->queued = 0;
+            if (connection->descriptor < 0 || !writeConnection(server, connection)) {
+                continue;
+            }
+            if (connection->outputSize == 0) { // Drained: answer requests that waited for room
+                if (connection->moreInput) {
+                    connection->moreInput = 0;
+                    readConnection(server, connection);
+                } else if (connection->inputSize > 0 || connection->peerClosed) {
+                    processConnection(server, connection);
+                }
+            }
+        }
+    }
+}
+
+// Function to accept every waiting connection into the pool
+static void acceptConnections(struct Server* server) {
+    while (1) {
+        int descriptor = accept(server->listener, NULL, NULL);
+        if (descriptor < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return; // EAGAIN: nobody else is waiting
+        }
+        struct Connection* connection = server->freeConnections;
+        if (connection == NULL) { // Pool exhausted: turn the client away
+            close(descriptor);
+            continue;
+        }
+        server->freeConnections = connection->nextFree;
+        int enabled = 1;
+        fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL) | O_NONBLOCK);
+        setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled)); // Responses are small; send them now
+        connection->descriptor = descriptor;
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = connection;
+        epoll_ctl(server->poll, EPOLL_CTL_ADD, descriptor, &event);
     }
-    printf("\n");
 }
 
-int main() {
-    struct Room* head = NULL; // Initialize the head of the list
-    int choice, roomNumber, duration, extraServices, occupancy;
+// Function to serve the hotel over HTTP/1.1 on 127.0.0.1 until SIGINT or SIGTERM (returns 1 if the journal failed)
+//   POST /rooms          {"room": 101}
+//   POST /reservations   {"room": 101, "guest": "John Doe", "checkIn": "2026-11-01", "nights": 3, "people": 2, "extras": false}
+//   POST /cancellations  {"room": 101, "guest": "John Doe", "checkIn": "2026-11-01"}
+//   GET  /availability?checkIn=2026-11-01&nights=3&people=2
+//   GET  /totals
+// One thread runs an edge-triggered epoll loop over a fixed pool of connections with preallocated buffers,
+// so answering a request allocates nothing. The changes made in one round of events share one journal sync.
+// Every SERVER_METRICS_PERIOD seconds the metrics are rewritten to METRICS_FILE for a scraper to pick up.
+static int runServer(struct Hotel* hotel, int port) {
+    struct Server server;
+    struct sockaddr_in address;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    int enabled = 1;
+    memset(&server, 0, sizeof(server));
+    server.hotel = hotel;
+    server.connections = (struct Connection*)malloc(SERVER_MAX_CONNECTIONS * sizeof(struct Connection));
+    for (int i = SERVER_MAX_CONNECTIONS - 1; i >= 0; --i) { // Build the free list once
+        struct Connection* connection = &server.connections[i];
+        connection->descriptor = -1;
+        connection->inputSize = connection->outputSize = connection->outputSent = 0;
+        connection->closeAfterWrite = connection->peerClosed = connection->moreInput = connection->queued = 0;
+        connection->nextFree = server.freeConnections;
+        server.freeConnections = connection;
+    }
+
+    server.listener = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(server.listener, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled));
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // Local clients only
+    if (server.listener < 0 || bind(server.listener, (struct sockaddr*)&address, sizeof(address)) != 0
+        || listen(server.listener, SOMAXCONN) != 0) {
+        fprintf(stderr, "Cannot listen on 127.0.0.1:%d: %s\n", port, strerror(errno));
+        free(server.connections);
+        return 1;
+    }
+    fcntl(server.listener, F_SETFL, fcntl(server.listener, F_GETFL) | O_NONBLOCK);
+    server.poll = epoll_create1(0);
+    struct epoll_event listenEvent;
+    listenEvent.events = EPOLLIN | EPOLLET;
+    listenEvent.data.ptr = NULL; // NULL marks the listening socket
+    epoll_ctl(server.poll, EPOLL_CTL_ADD, server.listener, &listenEvent);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopServer; // No SA_RESTART: epoll_wait returns EINTR and the loop ends
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    fprintf(stderr, "Serving on http://127.0.0.1:%d/ (Ctrl+C to stop).\n", port);
+
+    time_t metricsDue = time(NULL) + SERVER_METRICS_PERIOD;
+    while (!serverStopping) {
+        int count = epoll_wait(server.poll, events, SERVER_MAX_EVENTS, SERVER_METRICS_PERIOD * 1000);
+        for (int i = 0; i < count; ++i) {
+            struct Connection* connection = (struct Connection*)events[i].data.ptr;
+            if (connection == NULL) {
+                acceptConnections(&server);
+                continue;
+            }
+            if (connection->descriptor < 0) {
+                continue; // Closed earlier in this round
+            }
+            if (events[i].events & EPOLLERR) {
+                closeConnection(&server, connection);
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) {
+                readConnection(&server, connection);
+            }
+            if (events[i].events & EPOLLOUT) {
+                queueConnection(&server, connection); // Room again in the socket buffer
+            }
+        }
+        flushConnections(&server);
+        if (time(NULL) >= metricsDue) { // Keep METRICS_FILE fresh for scrapers, busy or idle
+            hotelWriteMetrics(METRICS_FILE);
+            metricsDue = time(NULL) + SERVER_METRICS_PERIOD;
+        }
+    }
+
+    for (int i = 0; i < SERVER_MAX_CONNECTIONS; ++i) {
+        if (server.connections[i].descriptor >= 0) {
+            close(server.connections[i].descriptor);
+        }
+    }
+    close(server.poll);
+    close(server.listener);
+    fprintf(stderr, "Served %lld requests.\n", server.requests);
+    free(server.connections);
+    return !hotelSyncJournal(hotel);
+}
+#endif
+
+
+// Function to read a YYYY-MM-DD date, asking again until it is valid
+static int readDate(const char* question) {
+    char text[32];
+    int dayNumber = hotelToday(); // Fallback if the input ends
+    prompt(question);
+    while (scanf("%31s", text) == 1 && !hotelParseDate(text, &dayNumber)) {
+        prompt("Please enter the date as YYYY-MM-DD: ");
+    }
+    return dayNumber;
+}
+
+// Function to ask which rooms a report should list (guestName receives the guest's name, if one is given)
+static void readReportQuery(struct HotelReportQuery* query, char* guestName) {
+    char text[32];
+    hotelInitReport(query);
+    prompt("Show which rooms? (0 all, 1 reserved, 2 vacant): ");
+    if (scanf("%d", &query->filter) != 1 || query->filter < HOTEL_REPORT_ALL || query->filter > HOTEL_REPORT_VACANT) {
+        query->filter = HOTEL_REPORT_ALL;
+    }
+    if (query->filter != HOTEL_REPORT_ALL) {
+        prompt("On which night? (YYYY-MM-DD, or - for any): ");
+        while (scanf("%31s", text) == 1 && strcmp(text, "-") != 0 && !hotelParseDate(text, &query->night)) {
+            prompt("Please enter the date as YYYY-MM-DD, or -: ");
+        }
+    }
+    prompt("Lowest and highest room number (0 0 for all): ");
+    if (scanf("%d %d", &query->firstRoom, &query->lastRoom) != 2 || (query->firstRoom == 0 && query->lastRoom == 0)) {
+        query->firstRoom = INT32_MIN;
+        query->lastRoom = INT32_MAX;
+    }
+    prompt("Guest name (- for any guest): ");
+    scanf(" %255[^\n]%*[^\n]", guestName); // Read a line of input for the guest name (MAX_NAME_LENGTH - 1 at most)
+    query->guestName = strcmp(guestName, "-") != 0 ? guestName : NULL;
+    prompt("Highest room number first? (1 for yes, 0 for no): ");
+    if (scanf("%d", &query->descending) != 1) {
+        query->descending = 0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    struct Hotel* hotel;
+    int choice, roomNumber, checkIn, duration, extraServices, occupancy;
     char guestName[MAX_NAME_LENGTH];
+    struct HotelReportQuery query;
+
+    if (argc == 3 && strcmp(argv[1], "--batch") == 0) { // Non-interactive: stream commands from a file or stdin
+        FILE* input = strcmp(argv[2], "-") == 0 ? stdin : fopen(argv[2], "rb");
+        if (input == NULL) {
+            fprintf(stderr, "Cannot open %s.\n", argv[2]);
+            return 1;
+        }
+        hotel = openHotel(1);
+        int failed = runBatch(hotel, input);
+        if (input != stdin) {
+            fclose(input);
+        }
+        return closeHotel(hotel, 1) && !failed ? 0 : 1;
+    }
+#ifdef HAVE_SERVER
+    if ((argc == 2 || argc == 3) && strcmp(argv[1], "--serve") == 0) { // Local HTTP/JSON front end
+        int port = argc == 3 ? atoi(argv[2]) : SERVER_DEFAULT_PORT;
+        if (port <= 0 || port > 65535) {
+            fprintf(stderr, "Invalid port %s.\n", argv[2]);
+            return 1;
+        }
+        hotel = openHotel(1);
+        int failed = runServer(hotel, port);
+        return closeHotel(hotel, 1) && !failed ? 0 : 1;
+    }
+    if (argc > 1) {
+        fprintf(stderr, "Usage: %s [--batch FILE|- | --serve [PORT]]\n", argv[0]);
+        return 1;
+    }
+#endif
+    if (argc > 1) {
+        fprintf(stderr, "Usage: %s [--batch FILE|-]\n", argv[0]);
+        return 1;
+    }
 
+    hotel = openHotel(0);
     do {
         displayMenu(); // Display the menu
-        scanf("%d", &choice); // Get the user's choice
+        if (scanf("%d", &choice) == EOF) { // Get the user's choice
+            choice = 0; // End of input: save and exit instead of repeating the last choice forever
+        }
 
         switch (choice) {
             case 1:
-                printf("Enter room number to add: ");
+                prompt("Enter room number to add: ");
                 scanf("%d", &roomNumber);
-                addRoom(&head, roomNumber); // Add a new room
+                addRoom(hotel, roomNumber); // Add a new room
                 break;
             case 2:
-                printf("Enter room number to reserve: ");
+                prompt("Enter room number to reserve: ");
                 scanf("%d", &roomNumber);
-                printf("Enter guest name: ");
-                scanf(" %[^\n]", guestName); // Read a line of input for the guest name
-                printf("Enter duration of stay (in days): ");
+                prompt("Enter guest name: ");
+                scanf(" %255[^\n]%*[^\n]", guestName); // Read a line of input for the guest name (MAX_NAME_LENGTH - 1 at most)
+                checkIn = readDate("Enter check-in date (YYYY-MM-DD): ");
+                prompt("Enter duration of stay (in days): ");
                 scanf("%d", &duration);
-                printf("Enter number of people staying: ");
+                prompt("Enter number of people staying: ");
                 scanf("%d", &occupancy);
-                printf("Request extra services? (1 for yes, 0 for no): ");
+                prompt("Request extra services? (1 for yes, 0 for no): ");
                 scanf("%d", &extraServices);
-                makeReservation(head, roomNumber, guestName, duration, extraServices, occupancy); // Make a reservation
+                makeReservation(hotel, roomNumber, guestName, checkIn, duration, extraServices, occupancy); // Make a reservation
                 break;
             case 3:
-                printf("Enter room number to cancel reservation: ");
+                prompt("Enter room number to cancel reservation: ");
                 scanf("%d", &roomNumber);
-                printf("Enter guest name: ");
-                scanf(" %[^\n]", guestName); // Read a line of input for the guest name
-                cancelReservation(head, roomNumber, guestName); // Cancel a reservation
+                prompt("Enter guest name: ");
+                scanf(" %255[^\n]%*[^\n]", guestName); // Read a line of input for the guest name (MAX_NAME_LENGTH - 1 at most)
+                checkIn = readDate("Enter check-in date of the reservation (YYYY-MM-DD): ");
+                cancelReservation(hotel, roomNumber, guestName, checkIn); // Cancel a reservation
                 break;
             case 4:
-                viewReservations(head); // View all reservations
+                hotelInitReport(&query);
+                query.filter = HOTEL_REPORT_RESERVED;
+                pageReport(hotel, &query, viewReservations); // View the reserved rooms, a page at a time
                 break;
             case 5:
-                viewRoomDetails(head); // View details of all rooms
+                hotelInitReport(&query);
+                pageReport(hotel, &query, viewRoomDetails); // View details of all rooms, a page at a time
+                break;
+            case 6:
+                checkIn = readDate("Enter check-in date (YYYY-MM-DD): ");
+                prompt("Enter duration of stay (in days): ");
+                scanf("%d", &duration);
+                prompt("Enter number of people staying: ");
+                scanf("%d", &occupancy);
+                viewAvailableRooms(hotel, checkIn, duration, occupancy); // Find rooms free for the whole stay
+                break;
+            case 7:
+                prompt("Enter guest name, or the start of it: ");
+                scanf(" %255[^\n]%*[^\n]", guestName); // Read a line of input for the guest name (MAX_NAME_LENGTH - 1 at most)
+                viewGuest(hotel, guestName); // Exact, prefix or fuzzy match
+                break;
+            case 8:
+                readReportQuery(&query, guestName);
+                pageReport(hotel, &query, viewReservations); // Only the rooms asked for, a page at a time
+                break;
+            case 9:
+                viewDashboard(hotel); // Running totals, straight from the core
                 break;
+            case 10:
+                checkIn = readDate("Enter the first check-in date (YYYY-MM-DD): ");
+                duration = readDate("Enter the last check-in date (YYYY-MM-DD): ");
+                viewHistory(hotel, checkIn, duration); // Every stay ever booked, month by month
+                break;
+            case 11: {
+                int parties[BATCH_MAX_PARTIES], partyCount = 0;
+                char partyList[1024];
+                prompt("Enter group name: ");
+                scanf(" %255[^\n]%*[^\n]", guestName); // Read a line of input for the guest name (MAX_NAME_LENGTH - 1 at most)
+                checkIn = readDate("Enter check-in date (YYYY-MM-DD): ");
+                prompt("Enter duration of stay (in days): ");
+                scanf("%d", &duration);
+                prompt("Enter the people in each party, separated by commas (e.g. 4,2,3): ");
+                while (scanf("%1023s", partyList) == 1
+                       && parseParties(partyList, partyList + strlen(partyList), parties, &partyCount) == NULL) {
+                    prompt("Please enter up to 256 numbers separated by commas: ");
+                }
+                prompt("Request extra services? (1 for yes, 0 for no): ");
+                scanf("%d", &extraServices);
+                makeGroupReservation(hotel, guestName, checkIn, duration, extraServices, parties, partyCount); // Book the rooms
+                break;
+            }
             case 0:
-                freeRooms(head); // Free all allocated memory
+                closeHotel(hotel, 0); // Save the hotel and free all allocated memory
                 printHeader("Exiting");
-                printf("Goodbye!\n");
+                putText("Goodbye!\n");
                 printLine('*', 30);
+                flushOutput();
                 break;
             default:
                 printHeader("Invalid Choice");
-                printf("Please enter a valid option.\n");
+                putText("Please enter a valid option.\n");
                 printLine('-', 30);
                 break;
         }
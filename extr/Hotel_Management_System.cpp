@@ -1,42 +1,31 @@
 #include <iostream>
-#include <cstring>
+#include <string>
+#include "../hotel_core.hpp"
 
 using namespace std;
 
-const int MAX_ROOMS = 100;
-const int MAX_NAME_LENGTH = 50;
-const int PRICE_PER_NIGHT = 5000;
-const int EXTRA_SERVICES_COST = 1000;
-
-struct Room {
-    int roomNumber;
-    bool isReserved;
-    char guestName[MAX_NAME_LENGTH];
-    int duration; // Duration of stay in days
-    bool extraServices; // Extra services (food, gym, spa)
-};
-
-struct Hotel {
-    Room rooms[MAX_ROOMS];
-    int totalRooms;
-};
-
-void initializeHotel(Hotel* hotel);
-void addRoom(Hotel* hotel, int roomNumber);
-void makeReservation(Hotel* hotel, int roomNumber, const char* guestName, int duration, bool extraServices);
-void cancelReservation(Hotel* hotel, int roomNumber, const char* guestName);
-void viewReservations(Hotel* hotel);
-void viewRoomDetails(Hotel* hotel);
+const int PAGE_ROOMS = 50; // Rooms shown per page of a report
+
+void addRoom(HotelCore* hotel, int roomNumber);
+void makeReservation(HotelCore* hotel, int roomNumber, const string& guestName, int checkIn, int duration, bool extraServices, int occupancy);
+void cancelReservation(HotelCore* hotel, int roomNumber, const string& guestName, int checkIn);
+void viewReservations(HotelCore* hotel, const HotelCoreView& view, int roomNumber);
+void viewRoomDetails(HotelCore* hotel, const HotelCoreView& view, int roomNumber);
+void pageRooms(HotelCore* hotel, const HotelReportQuery& query, void (*view)(HotelCore*, const HotelCoreView&, int));
 void displayMenu();
+string formatDate(int dayNumber);
+int readDate(const char* question);
 
 int main() {
-    Hotel hotel;
-    initializeHotel(&hotel);
+    HotelCore hotel;
+    hotel.loadRates("hotel.rates"); // Same rate file as the C edition; without one every night costs the default rate
 
     int choice;
     do {
         displayMenu();
-        cin >> choice;
+        if (!(cin >> choice)) {
+            break;
+        }
 
         switch (choice) {
             case 1: {
@@ -48,38 +37,50 @@ int main() {
             }
             case 2: {
                 int roomNumber;
-                char guestName[MAX_NAME_LENGTH];
+                string guestName;
                 int duration;
+                int occupancy;
                 bool extraServices;
                 cout << "Enter room number to reserve: ";
                 cin >> roomNumber;
                 cout << "Enter guest name: ";
                 cin.ignore();
-                cin.getline(guestName, MAX_NAME_LENGTH);
+                getline(cin, guestName);
+                int checkIn = readDate("Enter check-in date (YYYY-MM-DD): ");
                 cout << "Enter duration of stay (in days): ";
                 cin >> duration;
-                cout << "Do you want extra services (food, gym, spa) for 1000 PKR per night? (1 for Yes, 0 for No): ";
+                cout << "Enter number of people: ";
+                cin >> occupancy;
+                cout << "Do you want extra services (food, gym, spa)? (1 for Yes, 0 for No): ";
                 cin >> extraServices;
-                makeReservation(&hotel, roomNumber, guestName, duration, extraServices);
+                makeReservation(&hotel, roomNumber, guestName, checkIn, duration, extraServices, occupancy);
                 break;
             }
             case 3: {
                 int roomNumber;
-                char guestName[MAX_NAME_LENGTH];
+                string guestName;
                 cout << "Enter room number to cancel reservation: ";
                 cin >> roomNumber;
                 cout << "Enter guest name: ";
                 cin.ignore();
-                cin.getline(guestName, MAX_NAME_LENGTH);
-                cancelReservation(&hotel, roomNumber, guestName);
+                getline(cin, guestName);
+                int checkIn = readDate("Enter check-in date (YYYY-MM-DD): ");
+                cancelReservation(&hotel, roomNumber, guestName, checkIn);
                 break;
             }
-            case 4:
-                viewReservations(&hotel);
+            case 4: {
+                HotelReportQuery query;
+                hotelInitReport(&query);
+                query.filter = HOTEL_REPORT_RESERVED;
+                pageRooms(&hotel, query, viewReservations);
                 break;
-            case 5:
-                viewRoomDetails(&hotel);
+            }
+            case 5: {
+                HotelReportQuery query;
+                hotelInitReport(&query);
+                pageRooms(&hotel, query, viewRoomDetails);
                 break;
+            }
             case 0:
                 cout << "Exiting...\n";
                 break;
@@ -91,99 +92,99 @@ int main() {
     return 0;
 }
 
-void initializeHotel(Hotel* hotel) {
-    hotel->totalRooms = 0;
-}
-
-void addRoom(Hotel* hotel, int roomNumber) {
-    if (hotel->totalRooms < MAX_ROOMS) {
-        hotel->rooms[hotel->totalRooms].roomNumber = roomNumber;
-        hotel->rooms[hotel->totalRooms].isReserved = false;
-        hotel->rooms[hotel->totalRooms].guestName[0] = '\0';
-        hotel->rooms[hotel->totalRooms].duration = 0;
-        hotel->rooms[hotel->totalRooms].extraServices = false;
-        hotel->totalRooms++;
+void addRoom(HotelCore* hotel, int roomNumber) {
+    if (hotel->addRoom(roomNumber) == HOTEL_OK) {
         cout << "Room " << roomNumber << " added successfully.\n";
     } else {
-        cout << "Cannot add more rooms. Hotel is full.\n";
+        cout << "Room " << roomNumber << " already exists.\n";
     }
 }
 
-void makeReservation(Hotel* hotel, int roomNumber, const char* guestName, int duration, bool extraServices) {
-    for (int i = 0; i < hotel->totalRooms; i++) {
-        if (hotel->rooms[i].roomNumber == roomNumber) {
-            if (!hotel->rooms[i].isReserved) {
-                hotel->rooms[i].isReserved = true;
-                strncpy(hotel->rooms[i].guestName, guestName, MAX_NAME_LENGTH);
-                hotel->rooms[i].guestName[MAX_NAME_LENGTH - 1] = '\0';
-                hotel->rooms[i].duration = duration;
-                hotel->rooms[i].extraServices = extraServices;
-
-                int totalCost = PRICE_PER_NIGHT * duration;
-                if (extraServices) {
-                    totalCost += EXTRA_SERVICES_COST * duration;
-                }
-                
-                cout << "\n************ Receipt ************\n";
-                cout << "* Guest Name: " << guestName << "\n";
-                cout << "* Room Number: " << roomNumber << "\n";
-                cout << "* Duration of Stay: " << duration << " days\n";
-                cout << "* Price per Night: " << PRICE_PER_NIGHT << " PKR\n";
-                if (extraServices) {
-                    cout << "* Extra Services (Food, Gym, Spa): " << EXTRA_SERVICES_COST << " PKR per night\n";
-                }
-                cout << "* Total Cost: " << totalCost << " PKR\n";
-                cout << "*********************************\n";
-
-            } else {
-                cout << "Room " << roomNumber << " is already reserved.\n";
-            }
-            return;
+void makeReservation(HotelCore* hotel, int roomNumber, const string& guestName, int checkIn, int duration, bool extraServices, int occupancy) {
+    HotelStatus status = hotel->reserve(roomNumber, guestName, checkIn, duration, extraServices, occupancy);
+    if (status == HOTEL_OK) {
+        cout << "\n************ Receipt ************\n";
+        cout << "* Guest Name: " << guestName << "\n";
+        cout << "* Room Number: " << roomNumber << "\n";
+        cout << "* Check-in: " << formatDate(checkIn) << "\n";
+        cout << "* Check-out: " << formatDate(checkIn + duration) << "\n";
+        cout << "* Duration of Stay: " << duration << " days\n";
+        cout << "* Number of People: " << occupancy << "\n";
+        if (extraServices) {
+            cout << "* Extra Services (Food, Gym, Spa): Yes\n";
         }
+        cout << "* Total Cost: " << hotel->quote(roomNumber, checkIn, duration, occupancy, extraServices) << " PKR\n";
+        cout << "*********************************\n";
+    } else if (status == HOTEL_ROOM_UNAVAILABLE) {
+        cout << "Room " << roomNumber << " is already reserved for some of those nights.\n";
+    } else if (status == HOTEL_OVER_CAPACITY) {
+        cout << "Room " << roomNumber << " does not hold " << occupancy << " people.\n";
+    } else if (status == HOTEL_INVALID_STAY) {
+        cout << "A stay must be at least one night.\n";
+    } else if (status == HOTEL_INVALID_NAME) {
+        cout << "Guest name is too long.\n";
+    } else {
+        cout << "Room " << roomNumber << " not found.\n";
     }
-    cout << "Room " << roomNumber << " not found.\n";
 }
 
-void cancelReservation(Hotel* hotel, int roomNumber, const char* guestName) {
-    for (int i = 0; i < hotel->totalRooms; i++) {
-        if (hotel->rooms[i].roomNumber == roomNumber) {
-            if (hotel->rooms[i].isReserved && strcmp(hotel->rooms[i].guestName, guestName) == 0) {
-                hotel->rooms[i].isReserved = false;
-                hotel->rooms[i].guestName[0] = '\0';
-                hotel->rooms[i].duration = 0;
-                hotel->rooms[i].extraServices = false;
-                cout << "Reservation for " << guestName << " in room " << roomNumber << " canceled.\n";
-            } else {
-                cout << "Reservation not found for " << guestName << " in room " << roomNumber << ".\n";
-            }
-            return;
-        }
+void cancelReservation(HotelCore* hotel, int roomNumber, const string& guestName, int checkIn) {
+    HotelStatus status = hotel->cancel(roomNumber, guestName, checkIn);
+    if (status == HOTEL_OK) {
+        cout << "Reservation for " << guestName << " in room " << roomNumber << " canceled.\n";
+    } else if (status == HOTEL_BOOKING_NOT_FOUND) {
+        cout << "Reservation not found for " << guestName << " in room " << roomNumber << " from " << formatDate(checkIn) << ".\n";
+    } else {
+        cout << "Room " << roomNumber << " not found.\n";
     }
-    cout << "Room " << roomNumber << " not found.\n";
 }
 
-void viewReservations(Hotel* hotel) {
-    for (int i = 0; i < hotel->totalRooms; i++) {
-        if (hotel->rooms[i].isReserved) {
-            cout << "Room " << hotel->rooms[i].roomNumber << " is reserved by " << hotel->rooms[i].guestName 
-                 << " for " << hotel->rooms[i].duration << " days.\n";
-        } else {
-            cout << "Room " << hotel->rooms[i].roomNumber << " is not reserved.\n";
-        }
+void viewReservations(HotelCore*, const HotelCoreView& view, int roomNumber) {
+    vector<CoreBooking> bookings = view.bookings(roomNumber);
+    if (bookings.empty()) {
+        cout << "Room " << roomNumber << " is not reserved.\n";
+    }
+    for (const CoreBooking& booking : bookings) {
+        cout << "Room " << roomNumber << " is reserved by " << booking.guestName << " from " << formatDate(booking.checkIn)
+             << " for " << booking.checkOut - booking.checkIn << " days.\n";
     }
 }
 
-void viewRoomDetails(Hotel* hotel) {
-    for (int i = 0; i < hotel->totalRooms; i++) {
-        cout << "Room Number: " << hotel->rooms[i].roomNumber << "\n";
-        cout << "Reservation Status: " << (hotel->rooms[i].isReserved ? "Reserved" : "Not Reserved") << "\n";
-        if (hotel->rooms[i].isReserved) {
-            cout << "Guest Name: " << hotel->rooms[i].guestName << "\n";
-            cout << "Duration of Stay: " << hotel->rooms[i].duration << " days\n";
-            cout << "Total Cost: " << PRICE_PER_NIGHT * hotel->rooms[i].duration + 
-                    (hotel->rooms[i].extraServices ? EXTRA_SERVICES_COST * hotel->rooms[i].duration : 0) << " PKR\n";
+void viewRoomDetails(HotelCore* hotel, const HotelCoreView& view, int roomNumber) {
+    vector<CoreBooking> bookings = view.bookings(roomNumber);
+    cout << "Room Number: " << roomNumber << "\n";
+    cout << "Reservation Status: " << (bookings.empty() ? "Not Reserved" : "Reserved") << "\n";
+    for (const CoreBooking& booking : bookings) {
+        int duration = booking.checkOut - booking.checkIn;
+        cout << "Guest Name: " << booking.guestName << "\n";
+        cout << "Check-in: " << formatDate(booking.checkIn) << "\n";
+        cout << "Duration of Stay: " << duration << " days\n";
+        cout << "Number of People: " << booking.occupancy << "\n";
+        cout << "Total Cost: " << hotel->quote(roomNumber, booking.checkIn, duration, booking.occupancy, booking.extraServices) << " PKR\n";
+    }
+    cout << "-----------------------------\n";
+}
+
+// Show the rooms of a report a page at a time, asking before each page after the first
+void pageRooms(HotelCore* hotel, const HotelReportQuery& query, void (*view)(HotelCore*, const HotelCoreView&, int)) {
+    HotelCursor cursor = {HOTEL_CURSOR_START, 0};
+    HotelCoreView snapshot(*hotel); // Every page as the rooms stood when the report began
+    for (;;) {
+        vector<int> page = snapshot.report(query, cursor, PAGE_ROOMS);
+        if (page.empty() && cursor.state == HOTEL_CURSOR_DONE) {
+            cout << "No rooms to show.\n";
+        }
+        for (int roomNumber : page) {
+            view(hotel, snapshot, roomNumber);
+        }
+        if (cursor.state != HOTEL_CURSOR_MORE) {
+            return;
+        }
+        int more = 0;
+        cout << "Show the next page? (1 for Yes, 0 for No): ";
+        if (!(cin >> more) || more != 1) {
+            return;
         }
-        cout << "-----------------------------\n";
     }
 }
 
@@ -192,8 +193,30 @@ void displayMenu() {
     cout << "1. Add Room\n";
     cout << "2. Make Reservation\n";
     cout << "3. Cancel Reservation\n";
-    cout << "4. View All Reservations\n";
+    cout << "4. View Reservations\n";
     cout << "5. View Room Details\n";
     cout << "0. Exit\n";
     cout << "Enter your choice: ";
 }
+
+string formatDate(int dayNumber) {
+    char text[11];
+    hotelFormatDate(dayNumber, text);
+    return text;
+}
+
+// Ask for a date until a valid one is given (today if the input runs out)
+int readDate(const char* question) {
+    string text;
+    int dayNumber;
+    for (;;) {
+        cout << question;
+        if (!(cin >> text)) {
+            return hotelToday();
+        }
+        if (hotelParseDate(text.c_str(), &dayNumber)) {
+            return dayNumber;
+        }
+        cout << "Invalid date. Please try again.\n";
+    }
+}
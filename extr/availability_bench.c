@@ -0,0 +1,97 @@
+// Availability benchmark for the room calendars in hotel_core.c, with a long booking history
+// Build: gcc -std=c99 -O2 -pthread -o availability_bench extr/availability_bench.c hotel_core.c
+// Run:   ./availability_bench [rooms] [past bookings per room] [queries]
+// Fills a hotel (10k rooms unless given) with a history of past stays (200 a room unless given, so 2M in all)
+// and a few future ones, then asks for the rooms free for random stays (2000 unless given) inside the nights
+// the bitmaps track and beyond them, where each calendar is searched, and for a few of them checks every stay
+// of every room the plain way. Prints the queries a second and their p50 and p99 latency each way, and PASS if
+// every query found the same rooms as the plain check.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define BENCH_FUTURE 6 // Future stays booked in each room
+#define BENCH_FUTURE_NIGHTS 700 // Nights from tomorrow the future stays and the queries fall in
+#define BENCH_CHECKED 20 // Queries of each kind also answered by checking every stay
+
+// Function to count the rooms free for [checkIn, checkOut) that hold occupancy people by checking every stay
+// of every room, past ones included, as a list of bookings without a sorted calendar would have to
+static int countFreePlainly(const struct Hotel* hotel, int checkIn, int checkOut, int occupancy) {
+    int found = 0;
+    for (int slot = 0; slot < hotel->roomCount; ++slot) {
+        const struct Room* room = &hotel->rooms[slot];
+        int isFree = room->capacity >= occupancy;
+        for (int b = 0; b < room->bookingCount && isFree; ++b) {
+            isFree = room->stays[b].checkOut <= checkIn || room->stays[b].checkIn >= checkOut;
+        }
+        found += isFree;
+    }
+    return found;
+}
+
+// Function to time random queries for stays starting between firstDay and lastDay (exclusive), checking the first
+// BENCH_CHECKED of them the plain way (returns the queries that disagreed)
+static int runQueries(struct Hotel* hotel, const char* name, int firstDay, int lastDay, int queries, unsigned int* seed) {
+    long long* latencies = (long long*)malloc(queries * sizeof(long long));
+    long long plain = 0, total = 0, found = 0;
+    int wrong = 0;
+    for (int q = 0; q < queries; ++q) {
+        int nights = 1 + (int)(nextRandom(seed) % 7);
+        int checkIn = firstDay + (int)(nextRandom(seed) % (unsigned int)(lastDay - firstDay - nights));
+        int occupancy = 1 + (int)(nextRandom(seed) % 2);
+        long long started = nowNanoseconds();
+        int freeRooms = hotelFindFreeRooms(hotel, checkIn, nights, occupancy, NULL, 0);
+        latencies[q] = nowNanoseconds() - started;
+        total += latencies[q];
+        found += freeRooms;
+        if (q < BENCH_CHECKED) {
+            started = nowNanoseconds();
+            wrong += countFreePlainly(hotel, checkIn, checkIn + nights, occupancy) != freeRooms;
+            plain += nowNanoseconds() - started;
+        }
+    }
+    sortLatencies(latencies, queries);
+    printf("%-16s %10.0f queries/s  p50 %9.1f us  p99 %9.1f us  (%.0f free rooms a query; every stay checked: %.1f us)\n",
+           name, queries / (total / 1e9), sortedQuantile(latencies, queries, 500) / 1e3,
+           sortedQuantile(latencies, queries, 990) / 1e3, (double)found / queries,
+           plain / 1e3 / (queries < BENCH_CHECKED ? queries : BENCH_CHECKED));
+    free(latencies);
+    return wrong;
+}
+
+int main(int argc, char* argv[]) {
+    int rooms = argc > 1 ? atoi(argv[1]) : 10000;
+    int past = argc > 2 ? atoi(argv[2]) : 200;
+    int queries = argc > 3 ? atoi(argv[3]) : 2000;
+    unsigned int seed = 2463534242u;
+    char guestName[32];
+    rooms = rooms < 1 ? 1 : rooms;
+    past = past < 0 ? 0 : past;
+    queries = queries < 1 ? 1 : queries;
+
+    struct Hotel* hotel = hotelCreate();
+    int today = hotelToday();
+    long long bookings = 0;
+    double started = nowSeconds();
+    for (int r = 0; r < rooms; ++r) {
+        hotelAddRoom(hotel, r);
+        for (int b = past; b >= 1; --b) { // Oldest first, so each lands at the end of the calendar
+            snprintf(guestName, sizeof(guestName), "Guest %d", (r * 7 + b) % 1000);
+            bookings += hotelReserve(hotel, r, guestName, today - 3 * b, 2, 0, 1 + b % 2) == HOTEL_OK;
+        }
+        for (int b = 0; b < BENCH_FUTURE; ++b) { // Some may overlap and be turned down
+            snprintf(guestName, sizeof(guestName), "Guest %d", (r * 11 + b) % 1000);
+            int checkIn = today + 1 + (int)(nextRandom(&seed) % BENCH_FUTURE_NIGHTS);
+            bookings += hotelReserve(hotel, r, guestName, checkIn, 1 + (int)(nextRandom(&seed) % 5), 0, 1) == HOTEL_OK;
+        }
+    }
+    printf("%d rooms, %lld bookings (%lld of them past) made in %.2f s\n", rooms, bookings, (long long)rooms * past,
+           nowSeconds() - started);
+
+    int wrong = runQueries(hotel, "inside horizon", today + 1, today + NIGHT_HORIZON, queries, &seed);
+    wrong += runQueries(hotel, "beyond horizon", today + NIGHT_HORIZON, today + BENCH_FUTURE_NIGHTS, queries, &seed);
+    wrong += runQueries(hotel, "in the past", today - 3 * past, today, queries / 10 + 1, &seed);
+    int problems = wrong + !checkTotals(hotel);
+    hotelDestroy(hotel);
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
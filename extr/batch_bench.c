@@ -0,0 +1,198 @@
+// Replay benchmark for the batch mode of Hotel_Reservation_System (--batch)
+// Build: gcc -std=c99 -O2 -o batch_bench extr/batch_bench.c
+// Run:   ./batch_bench PROGRAM [rooms] [commands] [workload file]
+// Writes a workload (100k rooms unless given) of add commands for every room, then random reserve and cancel
+// commands (810k unless given) at random rooms: a room not booked yet is reserved for a few nights in 2030 and a
+// booked one is cancelled, so each should succeed. Then replays it with PROGRAM --batch in an empty temporary
+// directory, once in the order written and once sorted by room, as a nightly import from a channel manager
+// might come. Prints the commands replayed a second each time, by the wall clock (start-up and the final
+// checkpoint included) and by the summary the program prints itself. PASS if every command of both replays
+// came back OK. The workload is kept if a file is given.
+#define _XOPEN_SOURCE 700 // Expose mkdtemp, realpath, fork and waitpid under a strict -std=c99 build
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "bench_util.h"
+
+#define BENCH_NIGHTS 300 // Nights from 2030-01-01 the stays check in on
+#define BENCH_GUESTS 5000 // Distinct guest names
+
+// Define one reserve or cancel command of the workload
+struct BenchCommand {
+    int roomNumber; // Room it is for
+    int order; // Position in the workload as written, so the sorted replay keeps each room's commands in order
+    int cancels; // 1 for a cancellation of the room's booking, 0 for a reservation
+    int day; // Days after 2030-01-01 the stay checks in
+    int nights; // Nights of the stay
+    int guest; // Guest name number
+};
+
+// Function to compare two commands by room, then by their place in the workload, for qsort
+static int compareCommands(const void* a, const void* b) {
+    const struct BenchCommand* x = (const struct BenchCommand*)a;
+    const struct BenchCommand* y = (const struct BenchCommand*)b;
+    return x->roomNumber != y->roomNumber ? (x->roomNumber > y->roomNumber) - (x->roomNumber < y->roomNumber)
+                                          : (x->order > y->order) - (x->order < y->order);
+}
+
+// Function to write the add commands and then the reserve and cancel commands to a workload file (returns 1 on success)
+static int writeWorkload(const char* path, int rooms, const struct BenchCommand* commands, int count) {
+    static const int monthDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        return 0;
+    }
+    for (int r = 0; r < rooms; ++r) {
+        fprintf(file, "add %d\n", 100 + r);
+    }
+    for (int i = 0; i < count; ++i) {
+        const struct BenchCommand* command = &commands[i];
+        int month = 0, day = command->day;
+        while (day >= monthDays[month]) { // BENCH_NIGHTS keeps the stays in 2030
+            day -= monthDays[month++];
+        }
+        if (command->cancels) {
+            fprintf(file, "cancel %d 2030-%02d-%02d Guest %d\n", command->roomNumber, month + 1, day + 1, command->guest);
+        } else {
+            fprintf(file, "reserve %d 2030-%02d-%02d %d 1 0 Guest %d\n", command->roomNumber, month + 1, day + 1, command->nights,
+                    command->guest);
+        }
+    }
+    return fclose(file) == 0;
+}
+
+// Function to run PROGRAM --batch on a workload in a directory, its results and its summary to two files (returns
+// the exit status, or -1 if it could not be run)
+static int replay(const char* program, const char* workload, const char* directory, const char* results, const char* summary) {
+    pid_t child = fork();
+    if (child == 0) {
+        int output = open(results, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int errors = open(summary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (output < 0 || errors < 0 || chdir(directory) != 0) {
+            _exit(127);
+        }
+        dup2(output, STDOUT_FILENO);
+        dup2(errors, STDERR_FILENO);
+        execl(program, program, "--batch", workload, (char*)NULL);
+        _exit(127);
+    }
+    int status = 0;
+    if (child < 0 || waitpid(child, &status, 0) != child) {
+        return -1;
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Function to count the results that are not OK in a results file (returns -1 if there are not expected of them)
+static long countFailures(const char* results, long expected) {
+    char line[128];
+    long lines = 0, failures = 0;
+    FILE* file = fopen(results, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        lines++;
+        failures += strcmp(line, "OK\n") != 0;
+    }
+    fclose(file);
+    return lines == expected ? failures : -1;
+}
+
+// Function to replay a workload in a fresh directory and print the rate (returns 1 if every command came back OK)
+static int timeReplay(const char* name, const char* program, const char* workload, const char* scratch, long total) {
+    char directory[512], results[512], summary[512], line[256] = "";
+    static int run = 0;
+    snprintf(directory, sizeof(directory), "%s/run%d", scratch, ++run);
+    snprintf(results, sizeof(results), "%s/results.txt", scratch);
+    snprintf(summary, sizeof(summary), "%s/summary.txt", scratch);
+    if (mkdir(directory, 0755) != 0) {
+        return 0;
+    }
+    long long started = nowNanoseconds();
+    int status = replay(program, workload, directory, results, summary);
+    double seconds = (nowNanoseconds() - started) / 1e9;
+    long failures = countFailures(results, total);
+    FILE* file = fopen(summary, "r");
+    while (file != NULL && fgets(line, sizeof(line), file) != NULL && strstr(line, "commands/s") == NULL) {
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+    printf("%-16s %8.3f s  %10.0f commands/s  (%ld not OK, exit %d); its own count: %s", name, seconds, total / seconds,
+           failures, status, strstr(line, "commands/s") != NULL ? line : "none\n");
+    return status == 0 && failures == 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s PROGRAM [rooms] [commands] [workload file]\n", argv[0]);
+        return 1;
+    }
+    char absolute[4096], program[4096];
+    snprintf(program, sizeof(program), "%s", realpath(argv[1], absolute) != NULL ? absolute : argv[1]); // The replays run elsewhere
+    int rooms = argc > 2 ? atoi(argv[2]) : 100000;
+    int count = argc > 3 ? atoi(argv[3]) : 810000;
+    unsigned int seed = 2463534242u;
+    char scratch[] = "/tmp/batch_bench.XXXXXX", workload[4096], sorted[512];
+    int problems = 0;
+    rooms = rooms < 1 ? 1 : rooms;
+    count = count < 0 ? 0 : count;
+    if (mkdtemp(scratch) == NULL) {
+        fprintf(stderr, "Cannot make a scratch directory.\n");
+        return 1;
+    }
+    snprintf(workload, sizeof(workload), "%s", argc > 4 ? argv[4] : "");
+    if (argc <= 4) {
+        snprintf(workload, sizeof(workload), "%s/workload.txt", scratch);
+    }
+    snprintf(sorted, sizeof(sorted), "%s/sorted.txt", scratch);
+
+    struct BenchCommand* commands = (struct BenchCommand*)malloc((count > 0 ? count : 1) * sizeof(struct BenchCommand));
+    struct BenchCommand* booked = (struct BenchCommand*)calloc(rooms, sizeof(struct BenchCommand)); // Each room's booking
+    for (int i = 0; i < count; ++i) {
+        int r = (int)(nextRandom(&seed) % (unsigned int)rooms);
+        struct BenchCommand* command = &commands[i];
+        if (booked[r].nights > 0) { // Cancel the room's booking
+            *command = booked[r];
+            command->cancels = 1;
+            booked[r].nights = 0;
+        } else {
+            command->roomNumber = 100 + r;
+            command->cancels = 0;
+            command->day = (int)(nextRandom(&seed) % BENCH_NIGHTS);
+            command->nights = 1 + (int)(nextRandom(&seed) % 5);
+            command->guest = (int)(nextRandom(&seed) % BENCH_GUESTS);
+            booked[r] = *command;
+        }
+        command->order = i;
+    }
+    long total = (long)rooms + count;
+    if (!writeWorkload(workload, rooms, commands, count)) {
+        fprintf(stderr, "Cannot write %s.\n", workload);
+        return 1;
+    }
+    if (realpath(workload, absolute) != NULL) { // The replays run in directories of their own
+        snprintf(workload, sizeof(workload), "%s", absolute);
+    }
+    qsort(commands, count, sizeof(struct BenchCommand), compareCommands);
+    if (!writeWorkload(sorted, rooms, commands, count)) {
+        fprintf(stderr, "Cannot write %s.\n", sorted);
+        return 1;
+    }
+    printf("%d rooms, %d reserve and cancel commands (%ld in all)\n", rooms, count, total);
+
+    problems += !timeReplay("as written", program, workload, scratch, total);
+    problems += !timeReplay("sorted by room", program, sorted, scratch, total);
+    char command[1100];
+    snprintf(command, sizeof(command), "rm -rf '%s'", scratch); // The replays' snapshots, journals and results
+    problems += system(command) != 0;
+    free(commands);
+    free(booked);
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+# Runs Hotel_Reservation_System --batch - in an empty directory, with INPUT on stdin, and fails unless its results
+# match EXPECTED line for line: cmake -DPROGRAM=<exe> -DINPUT=<file> -DEXPECTED=<file> -DWORK=<dir> -P batch_test.cmake
+# (the directory is emptied first, so no snapshot, journal or rate plan from an earlier run is picked up)
+file(REMOVE_RECURSE ${WORK})
+file(MAKE_DIRECTORY ${WORK})
+execute_process(COMMAND ${PROGRAM} --batch -
+    INPUT_FILE ${INPUT}
+    OUTPUT_FILE ${WORK}/results.txt
+    ERROR_VARIABLE summary
+    RESULT_VARIABLE status
+    WORKING_DIRECTORY ${WORK})
+if(NOT status MATCHES "^[01]$") # 1 only says some command failed, which the input means to happen
+    message(FATAL_ERROR "--batch did not finish: ${status}\n${summary}")
+endif()
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK}/results.txt ${EXPECTED} RESULT_VARIABLE different)
+if(different)
+    file(READ ${WORK}/results.txt results)
+    message(FATAL_ERROR "--batch results differ from ${EXPECTED}:\n${results}")
+endif()
@@ -0,0 +1,48 @@
+// Helpers shared by the benchmarks in extr/: a monotonic clock, the xorshift generator every benchmark draws
+// its synthetic requests from, and latency quantiles. Header only, so each benchmark still builds from its own
+// .c file and hotel_core.c alone.
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <stdlib.h>
+#include <time.h>
+
+// Function to get the time in nanoseconds from a monotonic clock
+static inline long long nowNanoseconds() {
+    struct timespec clock;
+    clock_gettime(CLOCK_MONOTONIC, &clock);
+    return clock.tv_sec * 1000000000LL + clock.tv_nsec;
+}
+
+// Function to get the time in seconds from a monotonic clock
+static inline double nowSeconds() {
+    return nowNanoseconds() / 1e9;
+}
+
+// Function to get the next pseudo-random number of a generator (xorshift; the state must not be 0)
+static inline unsigned int nextRandom(unsigned int* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+// Function to compare two latencies for qsort
+static inline int compareLatencies(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+// Function to sort latencies into ascending order, for sortedQuantile
+static inline void sortLatencies(long long* latencies, long long count) {
+    qsort(latencies, (size_t)count, sizeof(long long), compareLatencies);
+}
+
+// Function to read a quantile, in thousandths (500 for p50, 990 for p99, 1000 for the largest), off sorted
+// latencies (0 if there are none)
+static inline long long sortedQuantile(const long long* sorted, long long count, int perMille) {
+    long long position = count * perMille / 1000;
+    return count > 0 ? sorted[position < count ? position : count - 1] : 0;
+}
+
+#endif
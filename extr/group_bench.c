@@ -0,0 +1,161 @@
+// Group booking benchmark for reserveGroup in hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o group_bench extr/group_bench.c hotel_core.c
+// Run:   ./group_bench [groups]
+// Fills the next three months of a 10k-room hotel (50 floors of 200) to about 60%, then books groups (2000
+// unless given) of 30 to 200 guests in parties of 1 to 4, each for a few nights somewhere in those months,
+// and cancels each group again so the hotel stays as full. Every group is booked twice: by reserveGroup, and
+// the way it was done by hand, each party in the first room, walking the room list, that takes it (and the
+// group undone if one does not fit). Prints the latency quantiles and the rooms and floors each used, and
+// PASS if every group booked by reserveGroup took no more rooms, the hotel came out as it went in, and the
+// slowest group of a hundred took under BENCH_BUDGET_MS.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define BENCH_FLOORS 50
+#define BENCH_FLOOR_ROOMS 200
+#define BENCH_NIGHTS 90 // Nights from the first check-in that are filled, and that groups check in over
+#define BENCH_BUDGET_MS 10 // Most a group may take at p99
+
+// Define one synthetic group request
+struct BenchGroup {
+    int checkIn; // First night
+    int nights; // Nights of the stay
+    int partyCount; // Parties in the group
+    int parties[200]; // People in each party (a group has at most 200 people)
+};
+
+// Define the outcome of booking every group one way
+struct BenchResult {
+    long long* latencies; // Nanoseconds each group took
+    long long rooms; // Rooms booked over every group that was booked
+    long long floors; // Floors those groups were spread over
+    int booked; // Groups booked
+};
+
+// Function to count the different rooms and floors among the rooms of a group's parties
+static void countRooms(const int* partyRooms, int partyCount, long long* rooms, long long* floors) {
+    for (int p = 0; p < partyCount; ++p) {
+        int newRoom = 1, newFloor = 1;
+        for (int q = 0; q < p; ++q) {
+            newRoom = newRoom && partyRooms[q] != partyRooms[p];
+            newFloor = newFloor && partyRooms[q] / 1000 != partyRooms[p] / 1000; // Room 7 of floor 12 is 12007
+        }
+        *rooms += newRoom;
+        *floors += newFloor;
+    }
+}
+
+// Function to book a group by hand: each party in the first room in the list that takes it, all undone if one
+// fits nowhere (returns 1 if booked; partyRooms receives the room of each party)
+static int bookByHand(struct Hotel* hotel, const int* roomNumbers, int roomCount, const struct BenchGroup* group, int* partyRooms) {
+    for (int p = 0; p < group->partyCount; ++p) {
+        int r = 0;
+        while (r < roomCount && reserveRoom(hotel, roomNumbers[r], "Tour By Hand", group->checkIn, group->nights, 0,
+                                            group->parties[p]) != HOTEL_OK) {
+            r++;
+        }
+        if (r == roomCount) {
+            for (int q = 0; q < p; ++q) {
+                releaseRoom(hotel, partyRooms[q], "Tour By Hand", group->checkIn);
+            }
+            return 0;
+        }
+        partyRooms[p] = roomNumbers[r];
+    }
+    return 1;
+}
+
+// Function to book and cancel every group one way (byHand = 0 for reserveGroup) and time each booking
+static void runGroups(struct Hotel* hotel, const int* roomNumbers, int roomCount, const struct BenchGroup* groups, int groupCount,
+                      int byHand, struct BenchResult* result) {
+    int partyRooms[200];
+    const char* guestName = byHand ? "Tour By Hand" : "Tour Group";
+    memset(result, 0, sizeof(*result));
+    result->latencies = (long long*)malloc(groupCount * sizeof(long long));
+    for (int g = 0; g < groupCount; ++g) {
+        const struct BenchGroup* group = &groups[g];
+        struct HotelGroup request = {guestName, group->checkIn, group->nights, 0, group->parties, group->partyCount};
+        long long started = nowNanoseconds();
+        int booked = byHand ? bookByHand(hotel, roomNumbers, roomCount, group, partyRooms)
+                            : reserveGroup(hotel, &request, partyRooms) == HOTEL_OK;
+        result->latencies[g] = nowNanoseconds() - started;
+        if (!booked) {
+            continue;
+        }
+        result->booked++;
+        countRooms(partyRooms, group->partyCount, &result->rooms, &result->floors);
+        for (int p = 0; p < group->partyCount; ++p) { // Rooms shared by parties are cancelled once
+            releaseRoom(hotel, partyRooms[p], guestName, group->checkIn);
+        }
+    }
+    sortLatencies(result->latencies, groupCount);
+}
+
+// Function to print one way's quantiles and rooms
+static void printResult(const char* name, const struct BenchResult* result, int groupCount) {
+    printf("%-14s %5d booked  p50 %8.3f ms  p99 %8.3f ms  max %8.3f ms  %6.1f rooms  %5.2f floors a group\n", name,
+           result->booked, sortedQuantile(result->latencies, groupCount, 500) / 1e6, sortedQuantile(result->latencies, groupCount, 990) / 1e6,
+           sortedQuantile(result->latencies, groupCount, 1000) / 1e6, (double)result->rooms / (result->booked > 0 ? result->booked : 1),
+           (double)result->floors / (result->booked > 0 ? result->booked : 1));
+}
+
+int main(int argc, char* argv[]) {
+    int groupCount = argc > 1 ? atoi(argv[1]) : 2000;
+    struct Hotel* hotel = hotelCreate();
+    unsigned int seed = 2463534242u;
+    int first = hotelToday() + 1, problems = 0;
+    groupCount = groupCount < 1 ? 1 : groupCount;
+
+    hotelAddRoomRange(hotel, 1, BENCH_FLOORS, 1, BENCH_FLOOR_ROOMS);
+    int roomCount = hotelRoomCount(hotel);
+    int* roomNumbers = (int*)malloc(roomCount * sizeof(int));
+    hotelListRooms(hotel, 0, roomNumbers, roomCount);
+    for (int r = 0; r < roomCount; ++r) { // Stays of 1 to 7 nights with 0 to 5 free between: about 60% full
+        for (int night = first + (int)(nextRandom(&seed) % 4); night < first + BENCH_NIGHTS;) {
+            int nights = 1 + (int)(nextRandom(&seed) % 7);
+            reserveRoom(hotel, roomNumbers[r], "Regular Guest", night, nights, 0, 1 + (int)(nextRandom(&seed) % 4));
+            night += nights + (int)(nextRandom(&seed) % 6);
+        }
+    }
+    long long bookedNights = countBookedNights(hotel, first, first + BENCH_NIGHTS);
+    printf("%d rooms, %.1f%% of the next %d nights booked\n", roomCount, 100.0 * bookedNights / ((double)roomCount * BENCH_NIGHTS),
+           BENCH_NIGHTS);
+
+    struct BenchGroup* groups = (struct BenchGroup*)malloc(groupCount * sizeof(struct BenchGroup));
+    long long guests = 0;
+    for (int g = 0; g < groupCount; ++g) {
+        struct BenchGroup* group = &groups[g];
+        int size = 30 + (int)(nextRandom(&seed) % 171);
+        group->nights = 1 + (int)(nextRandom(&seed) % 4);
+        group->checkIn = first + (int)(nextRandom(&seed) % (BENCH_NIGHTS - group->nights));
+        group->partyCount = 0;
+        for (int people = 0; people < size;) {
+            int party = 1 + (int)(nextRandom(&seed) % 4);
+            party = party > size - people ? size - people : party;
+            group->parties[group->partyCount++] = party;
+            people += party;
+        }
+        guests += size;
+    }
+    printf("%d groups of %.1f guests on average\n", groupCount, (double)guests / groupCount);
+
+    struct BenchResult grouped, byHand;
+    runGroups(hotel, roomNumbers, roomCount, groups, groupCount, 0, &grouped);
+    runGroups(hotel, roomNumbers, roomCount, groups, groupCount, 1, &byHand);
+    printResult("reserveGroup", &grouped, groupCount);
+    printResult("room by room", &byHand, groupCount);
+    printf("p50 %.1fx faster\n", (double)sortedQuantile(byHand.latencies, groupCount, 500) / sortedQuantile(grouped.latencies, groupCount, 500));
+
+    problems += grouped.booked < byHand.booked; // Whatever fits by hand fits packed
+    problems += grouped.rooms * byHand.booked > byHand.rooms * grouped.booked; // No more rooms a group
+    problems += countBookedNights(hotel, first, first + BENCH_NIGHTS) != bookedNights || !checkTotals(hotel);
+    problems += sortedQuantile(grouped.latencies, groupCount, 990) > BENCH_BUDGET_MS * 1000000LL;
+
+    hotelDestroy(hotel);
+    free(grouped.latencies);
+    free(byHand.latencies);
+    free(groups);
+    free(roomNumbers);
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
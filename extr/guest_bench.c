@@ -0,0 +1,129 @@
+// Query latency benchmark for the guest index in hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o guest_bench extr/guest_bench.c hotel_core.c
+// Run:   ./guest_bench [bookings]
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define BENCH_QUERIES 2000 // Queries timed per kind of search
+#define BENCH_ROOMS 20000 // Rooms the bookings are spread over
+
+static const char* firstNames[] = {"John", "Jane", "Alice", "Bob", "Carlos", "Fatima", "Ahmed", "Mei", "Olga", "Ravi",
+                                   "Sara", "Tom", "Yuki", "Zainab", "Ali", "Hina", "Omar", "Ayesha", "Bilal", "Sana"};
+static const char* lastNames[] = {"Smith", "Khan", "Brown", "Garcia", "Chen", "Ivanova", "Patel", "Tanaka", "Ahmed", "Malik",
+                                  "Qureshi", "Siddiqui", "Lee", "Nguyen", "Martin", "Rossi", "Haddad", "Kowalski", "Okafor", "Silva"};
+
+// Function to make the name of guest number n (400 name pairs times a family number, so names repeat a little)
+static void guestFor(int n, char* guestName) {
+    snprintf(guestName, MAX_NAME_LENGTH, "%s %s %d", firstNames[n % 20], lastNames[(n / 20) % 20], n / 400);
+}
+
+// Function to print the median, 99th percentile and maximum of a set of latencies
+static void printLatencies(const char* label, long long* latencies, int count, long long results) {
+    sortLatencies(latencies, count);
+    printf("%-28s p50 %9.2f us  p99 %9.2f us  max %9.2f us  (%lld results)\n", label, sortedQuantile(latencies, count, 500) / 1e3,
+           sortedQuantile(latencies, count, 990) / 1e3, sortedQuantile(latencies, count, 1000) / 1e3, results);
+}
+
+// Function to count a guest's bookings the way the tree did before the index: by scanning every calendar
+static int scanGuestBookings(struct Hotel* hotel, const char* guestName) {
+    int count = 0;
+    for (int i = 0; i < hotel->roomCount; ++i) {
+        for (int b = 0; b < hotel->rooms[i].bookingCount; ++b) {
+            count += strcmp(poolString(&hotel->guests.names, hotel->details[i].bookings[b].guestName), guestName) == 0;
+        }
+    }
+    return count;
+}
+
+int main(int argc, char* argv[]) {
+    int bookings = argc > 1 ? atoi(argv[1]) : 100000;
+    int guests = bookings / 2 > 1 ? bookings / 2 : 1; // About two bookings per guest
+    static long long latencies[BENCH_QUERIES];
+    static struct GuestMatch matches[GUEST_MAX_LISTED];
+    static struct GuestStay stays[GUEST_MAX_LISTED];
+    char guestName[MAX_NAME_LENGTH], text[MAX_NAME_LENGTH];
+    unsigned int seed = 2463534242u;
+    struct Hotel hotel;
+    int problems = 0;
+
+    initHotel(&hotel);
+    for (int r = 0; r < BENCH_ROOMS; ++r) {
+        insertRoom(&hotel, r);
+    }
+    long long started = nowNanoseconds();
+    int made = 0;
+    while (made < bookings) {
+        guestFor((int)(nextRandom(&seed) % (unsigned int)guests), guestName);
+        int roomNumber = (int)(nextRandom(&seed) % BENCH_ROOMS);
+        int checkIn = hotel.calendarStart + (int)(nextRandom(&seed) % 700);
+        made += reserveRoom(&hotel, roomNumber, guestName, checkIn, 1 + (int)(nextRandom(&seed) % 5), 0, 1) == HOTEL_OK;
+    }
+    printf("%d bookings by %d interned guests, made in %.3f s (index kept up to date on every booking)\n", bookings,
+           hotel.guests.guestCount, (nowNanoseconds() - started) / 1e9);
+
+    long long results = 0;
+    for (int q = 0; q < BENCH_QUERIES; ++q) { // Exact name: all bookings of one guest
+        guestFor((int)(nextRandom(&seed) % (unsigned int)guests), guestName);
+        long long t = nowNanoseconds();
+        int count = findGuestBookings(&hotel, guestName, stays, GUEST_MAX_LISTED);
+        latencies[q] = nowNanoseconds() - t;
+        results += count;
+        if (q < 20 && count != scanGuestBookings(&hotel, guestName)) { // Spot-check against a full scan
+            fprintf(stderr, "Index and calendars disagree on %s.\n", guestName);
+            problems++;
+        }
+    }
+    printLatencies("exact name (index)", latencies, BENCH_QUERIES, results);
+
+    results = 0;
+    for (int q = 0; q < BENCH_QUERIES / 20; ++q) { // The same lookup without the index, for comparison
+        guestFor((int)(nextRandom(&seed) % (unsigned int)guests), guestName);
+        long long t = nowNanoseconds();
+        results += scanGuestBookings(&hotel, guestName);
+        latencies[q] = nowNanoseconds() - t;
+    }
+    printLatencies("exact name (calendar scan)", latencies, BENCH_QUERIES / 20, results);
+
+    for (int length = 1; length <= 8; length *= 2) { // Type-ahead on the first characters of a name
+        results = 0;
+        for (int q = 0; q < BENCH_QUERIES; ++q) {
+            guestFor((int)(nextRandom(&seed) % (unsigned int)guests), guestName);
+            memcpy(text, guestName, length);
+            text[length] = '\0';
+            text[0] = (char)(text[0] | 0x20); // Typed in lower case
+            long long t = nowNanoseconds();
+            results += searchGuestPrefix(&hotel, text, matches, GUEST_MAX_LISTED);
+            latencies[q] = nowNanoseconds() - t;
+        }
+        char label[40];
+        snprintf(label, sizeof(label), "prefix, %d character(s)", length);
+        printLatencies(label, latencies, BENCH_QUERIES, results);
+    }
+
+    int missed = 0;
+    results = 0;
+    for (int q = 0; q < BENCH_QUERIES; ++q) { // Typo tolerance: one letter of the name mistyped
+        guestFor((int)(nextRandom(&seed) % (unsigned int)guests), guestName);
+        strcpy(text, guestName);
+        size_t at = nextRandom(&seed) % strcspn(text, "0123456789"); // Somewhere in the letters
+        text[at] = text[at] == 'z' || text[at] == ' ' ? 'q' : (char)(text[at] + 1);
+        long long t = nowNanoseconds();
+        int found = searchGuestFuzzy(&hotel, text, GUEST_MAX_DISTANCE, matches, GUEST_MAX_LISTED);
+        latencies[q] = nowNanoseconds() - t;
+        results += found;
+        int hit = 0;
+        for (int m = 0; m < found; ++m) {
+            hit |= strcmp(matches[m].guestName, guestName) == 0;
+        }
+        missed += !hit && findGuestBookings(&hotel, guestName, NULL, 0) > 0;
+    }
+    printLatencies("fuzzy, 1 letter mistyped", latencies, BENCH_QUERIES, results);
+    if (missed > 0) {
+        fprintf(stderr, "Fuzzy search missed %d guests with bookings.\n", missed);
+        problems++;
+    }
+
+    freeHotel(&hotel);
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
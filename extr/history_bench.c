@@ -0,0 +1,109 @@
+// Booking history scan benchmark for summarizeHistory in hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o history_bench extr/history_bench.c hotel_core.c
+// Run:   ./history_bench [events] [threads]
+// Records events reservations and cancellations (10 million unless given) straight into the history of an
+// empty hotel, over ten years of check-ins, 200k rooms and 50k guests, adding up by month what a summary
+// should find on the way. Then times a summary of all ten years and of one year, on one thread and on threads
+// threads (the processors online unless given), unpacking with AVX2 where the CPU has it. Prints how long
+// recordHistory took, apart for the calls that filled a block and handed it to the sealer thread (the stall a
+// booking under its room lock would see), the packed size, the events scanned per second and PASS if every
+// summary found the right sums.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define BENCH_YEARS 10 // Years of check-ins, from 2030
+#define BENCH_ROUNDS 5 // Each summary is timed this many times and the best counts
+#define BENCH_SAMPLE 16 // One in this many recordHistory calls is timed, besides every one that fills a block
+
+// Function to time one summary and check it against the expected sums (returns 1 if they agree)
+static int benchSummary(struct Hotel* hotel, const char* name, int firstDay, int lastDay, int threads, int64_t events,
+                        const struct HotelHistoryMonth* expected) {
+    struct HotelHistoryMonth months[BENCH_YEARS * 12];
+    long long best = 0;
+    int count = 0, agree = 1;
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        long long started = nowNanoseconds();
+        count = summarizeHistory(hotel, firstDay, lastDay, threads, months, BENCH_YEARS * 12);
+        long long took = nowNanoseconds() - started;
+        best = round == 0 || took < best ? took : best;
+    }
+    for (int m = 0; m < count; ++m) {
+        agree = agree && months[m].bookings == expected[m].bookings && months[m].cancellations == expected[m].cancellations
+                && months[m].roomNights == expected[m].roomNights && months[m].guests == expected[m].guests
+                && months[m].revenue == expected[m].revenue && months[m].cancelledRevenue == expected[m].cancelledRevenue;
+    }
+    printf("%-30s %2d threads  %8.1f ms  %7.1f M events/s  %s\n", name, threads, best / 1e6, events / (best / 1e3),
+           agree && count > 0 ? "ok" : "MISMATCH");
+    return agree && count > 0;
+}
+
+int main(int argc, char* argv[]) {
+    int64_t events = argc > 1 ? atoll(argv[1]) : 10000000;
+    int threads = argc > 2 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    struct HotelHistoryMonth* expected = (struct HotelHistoryMonth*)calloc(BENCH_YEARS * 12, sizeof(struct HotelHistoryMonth));
+    struct Hotel* hotel = hotelCreate();
+    int firstDay = dayFromDate(2030, 1, 1), lastDay = dayFromDate(2030 + BENCH_YEARS, 1, 1) - 1, problems = 0;
+    unsigned int seed = 2463534242u;
+    char guestName[32];
+    events = events < 1 ? 1 : events;
+    threads = threads < 1 ? 1 : threads;
+    long long* latencies = (long long*)malloc((events / BENCH_SAMPLE + 1) * sizeof(long long));
+    long long* fillLatencies = (long long*)malloc((events / HISTORY_BLOCK_EVENTS + 1) * sizeof(long long));
+    long long sampled = 0, filled = 0;
+
+    long long started = nowNanoseconds();
+    for (int64_t i = 0; i < events; ++i) {
+        int kind = nextRandom(&seed) % 8 == 0 ? HISTORY_CANCELLED : HISTORY_RESERVED; // One in eight cancelled
+        int checkIn = firstDay + (int)(nextRandom(&seed) % (unsigned int)(lastDay - firstDay + 1));
+        int nights = 1 + nextRandom(&seed) % 14, occupancy = 1 + nextRandom(&seed) % 4, extras = nextRandom(&seed) % 3 == 0;
+        int64_t amount = (int64_t)nights * (5000 + nextRandom(&seed) % 20000) + extras * 1500;
+        snprintf(guestName, sizeof(guestName), "Guest %u", nextRandom(&seed) % 50000);
+        int fills = (i + 1) % HISTORY_BLOCK_EVENTS == 0, timed = fills || i % BENCH_SAMPLE == 0;
+        long long recordStarted = timed ? nowNanoseconds() : 0;
+        recordHistory(&hotel->history, kind, 1900000000LL + i, 100 + (int)(nextRandom(&seed) % 200000), guestName, checkIn,
+                      nights, occupancy, extras, amount);
+        if (fills) {
+            fillLatencies[filled++] = nowNanoseconds() - recordStarted;
+        } else if (timed) {
+            latencies[sampled++] = nowNanoseconds() - recordStarted;
+        }
+        int year, month, day, sign = kind == HISTORY_CANCELLED ? -1 : 1;
+        dateFromDay(checkIn, &year, &month, &day);
+        struct HotelHistoryMonth* row = &expected[(year - 2030) * 12 + month - 1];
+        row->bookings += kind == HISTORY_RESERVED;
+        row->cancellations += kind == HISTORY_CANCELLED;
+        row->roomNights += sign * nights;
+        row->guests += sign * occupancy;
+        row->revenue += sign * amount;
+        row->cancelledRevenue += kind == HISTORY_CANCELLED ? amount : 0;
+    }
+    settleHistory(&hotel->history); // The sealer may still be packing the last full block
+    uint64_t packed = 0; // Each summary packs the events after the last full block on its own
+    for (int b = 0; b < hotel->history.blockCount; ++b) {
+        packed += hotel->history.blocks[b].size;
+    }
+    printf("%lld events recorded in %.1f s; %d blocks, %.1f bytes an event packed (%d unpacked)\n", (long long)events,
+           (nowNanoseconds() - started) / 1e9, hotel->history.blockCount,
+           hotel->history.blockCount > 0 ? (double)packed / ((int64_t)hotel->history.blockCount * HISTORY_BLOCK_EVENTS) : 0.0,
+           (int)(HISTORY_COLUMNS * sizeof(int64_t)));
+    sortLatencies(latencies, sampled);
+    sortLatencies(fillLatencies, filled);
+    printf("recordHistory: p50 %.0f ns, p99 %.0f ns; filling a block: p50 %.1f us, max %.1f us (%lld blocks)\n",
+           (double)sortedQuantile(latencies, sampled, 500), (double)sortedQuantile(latencies, sampled, 990),
+           sortedQuantile(fillLatencies, filled, 500) / 1e3, sortedQuantile(fillLatencies, filled, 1000) / 1e3, filled);
+    free(latencies);
+    free(fillLatencies);
+
+    printf("kernels: %s\n", __builtin_cpu_supports("avx2") ? "avx2" : "scalar");
+    problems += !benchSummary(hotel, "ten years by month", firstDay, lastDay, 1, events, expected);
+    problems += !benchSummary(hotel, "ten years by month", firstDay, lastDay, threads, events, expected);
+    problems += !benchSummary(hotel, "one year by month (2035)", dayFromDate(2035, 1, 1), dayFromDate(2036, 1, 1) - 1, 1,
+                              events, expected + 5 * 12);
+    problems += !benchSummary(hotel, "one year by month (2035)", dayFromDate(2035, 1, 1), dayFromDate(2036, 1, 1) - 1, threads,
+                              events, expected + 5 * 12);
+
+    hotelDestroy(hotel);
+    free(expected);
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// Group commit benchmark for the journal (journalAppend and journalSync) in hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o journal_bench extr/journal_bench.c hotel_core.c
+// Run:   ./journal_bench [writers] [seconds a run]
+// Has writer threads (8 unless given) append a booking record and wait for it to be durable, again and again, for
+// a while (half a second unless given) on a temporary journal in the current directory, once for each of a few
+// group commit delays (maxLatencyMicros). Prints the commits and data syncs made a second, the writers a sync
+// served, and the p50 and p99 journalSync latency each time. PASS if every journalSync succeeded and each journal
+// holds exactly the records appended to it.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define BENCH_MAX_WRITERS 64
+#define BENCH_MAX_SAMPLES (1 << 18) // Latencies a writer keeps in one run
+#define BENCH_GUEST "Writer" // Name logged with every record
+
+// Define what one writer thread works on
+struct BenchWriter {
+    struct Journal* journal; // Journal shared by the threads
+    const int* stop; // Set when the run is over
+    int roomNumber; // Room the writer's records are for
+    long long commits; // Records appended and made durable
+    int failures; // journalSync calls that failed
+    long long* latencies; // Nanoseconds of the first BENCH_MAX_SAMPLES journalSync calls
+    int sampled; // Latencies kept
+};
+
+// Function run by each writer thread: append a record and wait for it to be durable, until the run is over
+static void* runWriter(void* argument) {
+    struct BenchWriter* writer = (struct BenchWriter*)argument;
+    struct JournalRecord record;
+    while (!__atomic_load_n(writer->stop, __ATOMIC_RELAXED)) {
+        memset(&record, 0, sizeof(record));
+        record.type = JOURNAL_RESERVE;
+        record.time = (int64_t)time(NULL);
+        record.roomNumber = writer->roomNumber;
+        record.checkIn = hotelToday() + 1 + (int)(writer->commits % 300);
+        record.duration = 1;
+        record.occupancy = 1;
+        journalAppend(writer->journal, &record, BENCH_GUEST);
+        long long started = nowNanoseconds();
+        writer->failures += !journalSync(writer->journal);
+        if (writer->sampled < BENCH_MAX_SAMPLES) {
+            writer->latencies[writer->sampled++] = nowNanoseconds() - started;
+        }
+        writer->commits++;
+    }
+    return NULL;
+}
+
+// Function to run the writers on a fresh journal with one group commit delay, and print how they did
+// (returns the problems found)
+static int runJournal(int writers, double seconds, long maxLatencyMicros) {
+    pthread_t handles[BENCH_MAX_WRITERS];
+    struct BenchWriter work[BENCH_MAX_WRITERS];
+    struct Journal journal;
+    char path[] = "journal_bench.XXXXXX";
+    int stop = 0, sampled = 0, problems = 0;
+    long long commits = 0;
+
+    int descriptor = mkstemp(path);
+    if (descriptor < 0 || !openJournal(&journal, path, 1, maxLatencyMicros)) {
+        fprintf(stderr, "Cannot open a journal in the current directory.\n");
+        if (descriptor >= 0) {
+            close(descriptor);
+            remove(path);
+        }
+        return 1;
+    }
+    close(descriptor);
+    long long started = nowNanoseconds();
+    for (int w = 0; w < writers; ++w) {
+        work[w].journal = &journal;
+        work[w].stop = &stop;
+        work[w].roomNumber = w;
+        work[w].commits = 0;
+        work[w].failures = 0;
+        work[w].latencies = (long long*)malloc(BENCH_MAX_SAMPLES * sizeof(long long));
+        work[w].sampled = 0;
+        pthread_create(&handles[w], NULL, runWriter, &work[w]);
+    }
+    struct timespec pause = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+    nanosleep(&pause, NULL);
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+    for (int w = 0; w < writers; ++w) {
+        pthread_join(handles[w], NULL);
+        commits += work[w].commits;
+        sampled += work[w].sampled;
+        problems += work[w].failures;
+    }
+    double elapsed = (nowNanoseconds() - started) / 1e9;
+    long long syncs = journal.syncCount;
+    problems += journal.durableSequence != (uint64_t)commits; // Sequences start at 1
+    closeJournal(&journal);
+
+    long long size = 0;
+    FILE* file = fopen(path, "rb");
+    if (file != NULL && fseek(file, 0, SEEK_END) == 0) {
+        size = ftell(file);
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+    remove(path);
+    problems += size != (long long)sizeof(struct JournalHeader) + commits * (long long)(sizeof(struct JournalRecord) + 8);
+
+    long long* latencies = (long long*)malloc((sampled > 0 ? sampled : 1) * sizeof(long long));
+    int count = 0;
+    for (int w = 0; w < writers; ++w) {
+        memcpy(&latencies[count], work[w].latencies, work[w].sampled * sizeof(long long));
+        count += work[w].sampled;
+        free(work[w].latencies);
+    }
+    sortLatencies(latencies, count);
+    printf("maxLatencyMicros %5ld  %9.0f commits/s  %8.0f syncs/s  %5.1f writers a sync  p50 %8.1f us  p99 %8.1f us\n",
+           maxLatencyMicros, commits / elapsed, syncs / elapsed, syncs > 0 ? (double)commits / syncs : 0.0,
+           sortedQuantile(latencies, count, 500) / 1e3, sortedQuantile(latencies, count, 990) / 1e3);
+    free(latencies);
+    return problems;
+}
+
+int main(int argc, char* argv[]) {
+    static const long delays[] = {0, 50, 200, 1000};
+    int writers = argc > 1 ? atoi(argv[1]) : 8;
+    double seconds = argc > 2 ? atof(argv[2]) : 0.5;
+    int problems = 0;
+    writers = writers < 1 ? 1 : writers > BENCH_MAX_WRITERS ? BENCH_MAX_WRITERS : writers;
+    seconds = seconds < 0.1 ? 0.1 : seconds;
+
+    printf("%d writers, %.1f s a run\n", writers, seconds);
+    for (int d = 0; d < (int)(sizeof(delays) / sizeof(delays[0])); ++d) {
+        problems += runJournal(writers, seconds, delays[d]);
+    }
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+// Night bitmap kernel benchmark for the availability scans in hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o kernel_bench extr/kernel_bench.c hotel_core.c
+// Run:   ./kernel_bench [rooms] [queries]
+// Fills a hotel (100k rooms unless given) with random stays inside the night horizon, then answers random
+// "which rooms are free for [checkIn, checkOut)" queries (500 unless given) three ways side by side: the scalar
+// bitmap kernel, the AVX2 one (if the CPU has AVX2), and a binary search of every room's calendar, and counts
+// the booked room-nights of each range with both kernels and by adding up the calendars. Prints the rooms a
+// second each way and their p50 and p99 query latency. PASS if all three ways found the same free rooms and
+// the same booked nights for every query.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define BENCH_STAYS 4 // Stays booked in each room
+#define BENCH_WAYS 3 // Scalar kernel, AVX2 kernel, calendar search
+
+// Define what a way of answering a query took, over every query
+struct BenchWay {
+    const char* name; // Printed name
+    long long* latencies; // Nanoseconds of each query
+    long long total; // Nanoseconds of all queries
+};
+
+// Function to mark the free rooms with a kernel, a chunk at a time as findAvailableRooms does, and count the booked
+// nights (returns the free rooms)
+static int scanKernel(const struct Hotel* hotel, const struct NightKernels* kernels, const uint64_t* masks, int firstWord,
+                      int lastWord, uint64_t* freeBits, long long* booked) {
+    int found = 0;
+    for (int start = 0; start < hotel->roomCount; start += SCAN_CHUNK_ROOMS) {
+        int count = hotel->roomCount - start < SCAN_CHUNK_ROOMS ? hotel->roomCount - start : SCAN_CHUNK_ROOMS;
+        kernels->freeRooms(hotel->nights + start, hotel->roomCapacity, masks, firstWord, lastWord, count, freeBits + start / 64);
+        for (int block = 0; block * 64 < count; ++block) {
+            found += __builtin_popcountll(freeBits[start / 64 + block]);
+        }
+    }
+    *booked = kernels->bookedNights(hotel->nights, hotel->roomCapacity, masks, firstWord, lastWord, hotel->roomCount);
+    return found;
+}
+
+// Function to mark the free rooms by a binary search of each calendar, and count the booked nights from the stays
+// (returns the free rooms)
+static int searchCalendars(const struct Hotel* hotel, int checkIn, int checkOut, uint64_t* freeBits, long long* booked) {
+    int found = 0;
+    memset(freeBits, 0, (hotel->roomCount + 63) / 64 * sizeof(uint64_t));
+    *booked = 0;
+    for (int slot = 0; slot < hotel->roomCount; ++slot) {
+        const struct Room* room = &hotel->rooms[slot];
+        if (isRoomFree(room, checkIn, checkOut)) {
+            freeBits[slot / 64] |= (uint64_t)1 << (slot % 64);
+            found++;
+        }
+        for (int b = findStay(room, checkIn); b < room->bookingCount && room->stays[b].checkIn < checkOut; ++b) {
+            int first = room->stays[b].checkIn > checkIn ? room->stays[b].checkIn : checkIn;
+            int last = room->stays[b].checkOut < checkOut ? room->stays[b].checkOut : checkOut;
+            *booked += last - first;
+        }
+    }
+    return found;
+}
+
+int main(int argc, char* argv[]) {
+    int rooms = argc > 1 ? atoi(argv[1]) : 100000;
+    int queries = argc > 2 ? atoi(argv[2]) : 500;
+    unsigned int seed = 2463534242u;
+    int problems = 0;
+    rooms = rooms < 1 ? 1 : rooms;
+    queries = queries < 1 ? 1 : queries;
+
+    struct Hotel* hotel = hotelCreate();
+    int today = hotelToday();
+    for (int r = 0; r < rooms; ++r) {
+        hotelAddRoom(hotel, r);
+        for (int b = 0; b < BENCH_STAYS; ++b) { // Some overlap and are turned down
+            int checkIn = today + (int)(nextRandom(&seed) % (NIGHT_HORIZON - 14));
+            hotelReserve(hotel, r, "Resident", checkIn, 1 + (int)(nextRandom(&seed) % 7), 0, 1);
+        }
+    }
+
+    const struct NightKernels* kernels[BENCH_WAYS - 1] = {scalarNightKernels(), nightKernels()};
+    int hasAvx2 = kernels[1] != kernels[0];
+    struct BenchWay ways[BENCH_WAYS] = {{"scalar kernel", NULL, 0}, {"AVX2 kernel", NULL, 0}, {"calendar search", NULL, 0}};
+    uint64_t* freeBits[BENCH_WAYS];
+    uint64_t masks[NIGHT_WORDS];
+    for (int way = 0; way < BENCH_WAYS; ++way) {
+        ways[way].latencies = (long long*)malloc(queries * sizeof(long long));
+        freeBits[way] = (uint64_t*)calloc((rooms + SCAN_CHUNK_ROOMS) / 64, sizeof(uint64_t));
+    }
+    printf("%d rooms, %d queries; %s\n", rooms, queries, hasAvx2 ? "the CPU has AVX2" : "no AVX2 on this CPU, so it is not timed");
+
+    for (int q = 0; q < queries; ++q) {
+        int nights = 1 + (int)(nextRandom(&seed) % 14);
+        int checkIn = hotel->calendarStart + (int)(nextRandom(&seed) % (unsigned int)(NIGHT_HORIZON - nights));
+        int firstWord, lastWord, found[BENCH_WAYS];
+        long long booked[BENCH_WAYS];
+        if (!buildNightMasks(hotel, checkIn, checkIn + nights, masks, &firstWord, &lastWord)) {
+            printf("query %d ([%d, %d)): not inside the horizon\n", q, checkIn, checkIn + nights);
+            problems++;
+            continue;
+        }
+        for (int way = 0; way < BENCH_WAYS; ++way) {
+            if (way == 1 && !hasAvx2) {
+                found[way] = found[0];
+                booked[way] = booked[0];
+                memcpy(freeBits[way], freeBits[0], (rooms + 63) / 64 * sizeof(uint64_t));
+                continue;
+            }
+            long long started = nowNanoseconds();
+            found[way] = way < BENCH_WAYS - 1 ? scanKernel(hotel, kernels[way], masks, firstWord, lastWord, freeBits[way], &booked[way])
+                                              : searchCalendars(hotel, checkIn, checkIn + nights, freeBits[way], &booked[way]);
+            ways[way].latencies[q] = nowNanoseconds() - started;
+            ways[way].total += ways[way].latencies[q];
+        }
+        for (int way = 1; way < BENCH_WAYS; ++way) {
+            int disagrees = found[way] != found[0] || booked[way] != booked[0];
+            disagrees |= memcmp(freeBits[way], freeBits[0], (rooms + 63) / 64 * sizeof(uint64_t)) != 0;
+            if (disagrees) {
+                printf("query %d ([%d, %d)): %s found %d free rooms and %lld booked nights, %s %d and %lld\n", q, checkIn,
+                       checkIn + nights, ways[way].name, found[way], booked[way], ways[0].name, found[0], booked[0]);
+            }
+            problems += disagrees;
+        }
+    }
+
+    for (int way = 0; way < BENCH_WAYS; ++way) {
+        if (way != 1 || hasAvx2) {
+            sortLatencies(ways[way].latencies, queries);
+            printf("%-16s %8.1f M rooms/s  p50 %8.1f us  p99 %8.1f us  (%.1fx the calendar search)\n", ways[way].name,
+                   (double)rooms * queries / (ways[way].total / 1e9) / 1e6, sortedQuantile(ways[way].latencies, queries, 500) / 1e3,
+                   sortedQuantile(ways[way].latencies, queries, 990) / 1e3, (double)ways[BENCH_WAYS - 1].total / ways[way].total);
+        }
+        free(ways[way].latencies);
+        free(freeBits[way]);
+    }
+    problems += !checkTotals(hotel);
+    hotelDestroy(hotel);
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
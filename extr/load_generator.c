@@ -0,0 +1,226 @@
+// Load generator for the HTTP server started by Hotel_Reservation_System --serve
+// Build: gcc -std=c99 -O2 -pthread -o load_generator extr/load_generator.c
+// Run:   ./load_generator [port] [connections] [requests per connection] [rooms to add first, 0 for none]
+// Each connection is one thread with one keep-alive socket: 60% reservations, 30% cancellations of its own
+// bookings, 10% availability queries. Prints requests per second, latency percentiles and status counts.
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "bench_util.h"
+
+#define MAX_CONNECTIONS 512
+#define BUFFER_SIZE 8192
+#define DATE_RANGE 300 // Check-in dates are spread over this many days from today
+
+// Define one booking a client made and may cancel
+struct Held {
+    int roomNumber; // Room booked
+    int date; // Index of the check-in date in dates
+};
+
+// Define the work and results of one client connection
+struct Client {
+    int id; // Client number, part of its guest name
+    int requests; // Requests to send
+    int rooms; // Rooms are numbered 1 to rooms
+    unsigned int seed; // Random number state
+    long long* latencies; // Nanoseconds per request, preallocated
+    long long counts[6]; // Responses by first digit of the status code (index 0: failed to connect or read)
+    struct Held* held; // Bookings made and not cancelled
+    int heldCount; // Number of entries in held
+};
+
+static int port = 8080;
+static char dates[DATE_RANGE][11]; // YYYY-MM-DD from today on
+
+// Function to open a keep-alive connection to the server on 127.0.0.1 (returns -1 on failure)
+static int connectServer() {
+    struct sockaddr_in address;
+    int enabled = 1;
+    int descriptor = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (descriptor < 0 || connect(descriptor, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        if (descriptor >= 0) {
+            close(descriptor);
+        }
+        return -1;
+    }
+    setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+    return descriptor;
+}
+
+// Function to send one request and read its whole response (returns the status code, or 0 on a broken connection)
+static int exchange(int descriptor, const char* request, size_t length, char* response) {
+    size_t sent = 0, received = 0;
+    while (sent < length) {
+        ssize_t n = send(descriptor, request + sent, length - sent, MSG_NOSIGNAL);
+        if (n <= 0 && errno != EINTR) {
+            return 0;
+        }
+        sent += n > 0 ? (size_t)n : 0;
+    }
+    while (1) { // One response at a time, so everything read belongs to it
+        ssize_t n = recv(descriptor, response + received, BUFFER_SIZE - 1 - received, 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+        received += (size_t)n;
+        response[received] = '\0';
+        char* body = strstr(response, "\r\n\r\n");
+        char* lengthHeader = strstr(response, "Content-Length: ");
+        if (body != NULL && lengthHeader != NULL && lengthHeader < body
+            && received >= (size_t)(body + 4 - response) + (size_t)atol(lengthHeader + 16)) {
+            return atoi(response + 9); // "HTTP/1.1 201 ..."
+        }
+        if (received == BUFFER_SIZE - 1) {
+            return 0;
+        }
+    }
+}
+
+// Function to build a POST request with a JSON body (returns its length)
+static size_t formatPost(char* request, const char* path, const char* body) {
+    return (size_t)snprintf(request, BUFFER_SIZE, "POST %s HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: application/json\r\n"
+                            "Content-Length: %zu\r\n\r\n%s", path, strlen(body), body);
+}
+
+// Function to run one client: a keep-alive connection sending the request mix
+static void* runClient(void* argument) {
+    struct Client* client = (struct Client*)argument;
+    char request[BUFFER_SIZE], response[BUFFER_SIZE], body[256];
+    int descriptor = connectServer();
+    for (int i = 0; i < client->requests; ++i) {
+        unsigned int pick = nextRandom(&client->seed) % 10;
+        size_t length;
+        int cancelled = -1, reserving = 0;
+        if (pick == 0) { // Availability
+            int date = (int)(nextRandom(&client->seed) % DATE_RANGE);
+            length = (size_t)snprintf(request, BUFFER_SIZE, "GET /availability?checkIn=%s&nights=%u&people=2 HTTP/1.1\r\n"
+                                      "Host: 127.0.0.1\r\n\r\n", dates[date], 1 + nextRandom(&client->seed) % 7);
+        } else if (pick <= 3 && client->heldCount > 0) { // Cancel one of ours
+            cancelled = (int)(nextRandom(&client->seed) % (unsigned int)client->heldCount);
+            struct Held* held = &client->held[cancelled];
+            snprintf(body, sizeof(body), "{\"room\":%d,\"guest\":\"Client %d\",\"checkIn\":\"%s\"}", held->roomNumber,
+                     client->id, dates[held->date]);
+            length = formatPost(request, "/cancellations", body);
+        } else { // Reserve
+            int roomNumber = 1 + (int)(nextRandom(&client->seed) % (unsigned int)client->rooms);
+            int date = (int)(nextRandom(&client->seed) % (DATE_RANGE - 7));
+            snprintf(body, sizeof(body), "{\"room\":%d,\"guest\":\"Client %d\",\"checkIn\":\"%s\",\"nights\":%u,"
+                     "\"people\":2,\"extras\":%s}", roomNumber, client->id, dates[date], 1 + nextRandom(&client->seed) % 7,
+                     nextRandom(&client->seed) % 2 ? "true" : "false");
+            length = formatPost(request, "/reservations", body);
+            client->held[client->heldCount].roomNumber = roomNumber; // Kept only if the server says 201
+            client->held[client->heldCount].date = date;
+            reserving = 1;
+        }
+        long long started = nowNanoseconds();
+        int code = descriptor >= 0 ? exchange(descriptor, request, length, response) : 0;
+        client->latencies[i] = nowNanoseconds() - started;
+        client->counts[code / 100 < 6 ? code / 100 : 0]++;
+        if (code == 0 && descriptor >= 0) { // Broken: reconnect for the next request
+            close(descriptor);
+            descriptor = connectServer();
+        }
+        if (code == 201 && reserving) {
+            client->heldCount++;
+        } else if (code == 200 && cancelled >= 0) {
+            client->held[cancelled] = client->held[--client->heldCount];
+        }
+    }
+    if (descriptor >= 0) {
+        close(descriptor);
+    }
+    return NULL;
+}
+
+int main(int argc, char* argv[]) {
+    int connections = argc > 2 ? atoi(argv[2]) : 16;
+    int requests = argc > 3 ? atoi(argv[3]) : 20000;
+    int rooms = argc > 4 ? atoi(argv[4]) : 1000;
+    static struct Client clients[MAX_CONNECTIONS];
+    pthread_t handles[MAX_CONNECTIONS];
+    char request[BUFFER_SIZE], response[BUFFER_SIZE], body[64];
+    port = argc > 1 ? atoi(argv[1]) : 8080;
+    connections = connections < 1 ? 1 : (connections > MAX_CONNECTIONS ? MAX_CONNECTIONS : connections);
+    requests = requests < 1 ? 1 : requests;
+
+    time_t today = time(NULL);
+    for (int d = 0; d < DATE_RANGE; ++d) {
+        time_t day = today + (time_t)d * 86400;
+        struct tm date;
+        gmtime_r(&day, &date);
+        strftime(dates[d], sizeof(dates[d]), "%Y-%m-%d", &date);
+    }
+
+    if (rooms > 0) { // Set up the hotel over one connection
+        int descriptor = connectServer();
+        if (descriptor < 0) {
+            fprintf(stderr, "Cannot connect to 127.0.0.1:%d.\n", port);
+            return 1;
+        }
+        for (int r = 1; r <= rooms; ++r) {
+            snprintf(body, sizeof(body), "{\"room\":%d}", r);
+            if (exchange(descriptor, request, formatPost(request, "/rooms", body), response) != 201) {
+                fprintf(stderr, "Could not add room %d.\n", r);
+                return 1;
+            }
+        }
+        close(descriptor);
+    } else {
+        rooms = 1000; // Assume the hotel already has rooms 1 to 1000
+    }
+
+    for (int c = 0; c < connections; ++c) {
+        clients[c].id = c;
+        clients[c].requests = requests;
+        clients[c].rooms = rooms;
+        clients[c].seed = 2463534242u + 7919u * (unsigned int)c;
+        clients[c].latencies = (long long*)malloc(requests * sizeof(long long));
+        clients[c].held = (struct Held*)malloc((requests + 1) * sizeof(struct Held));
+        clients[c].heldCount = 0;
+        memset(clients[c].counts, 0, sizeof(clients[c].counts));
+    }
+    long long started = nowNanoseconds();
+    for (int c = 0; c < connections; ++c) {
+        pthread_create(&handles[c], NULL, runClient, &clients[c]);
+    }
+    for (int c = 0; c < connections; ++c) {
+        pthread_join(handles[c], NULL);
+    }
+    double seconds = (nowNanoseconds() - started) / 1e9;
+
+    long long total = (long long)connections * requests, counts[6] = {0};
+    long long* latencies = (long long*)malloc(total * sizeof(long long));
+    for (int c = 0; c < connections; ++c) {
+        memcpy(latencies + (long long)c * requests, clients[c].latencies, requests * sizeof(long long));
+        for (int k = 0; k < 6; ++k) {
+            counts[k] += clients[c].counts[k];
+        }
+        free(clients[c].latencies);
+        free(clients[c].held);
+    }
+    sortLatencies(latencies, total);
+    printf("%lld requests over %d connections in %.3f s: %.0f requests/s\n", total, connections, seconds, total / seconds);
+    printf("latency us  p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n", sortedQuantile(latencies, total, 500) / 1e3,
+           sortedQuantile(latencies, total, 900) / 1e3, sortedQuantile(latencies, total, 990) / 1e3,
+           sortedQuantile(latencies, total, 999) / 1e3, sortedQuantile(latencies, total, 1000) / 1e3);
+    printf("responses   2xx %lld  4xx %lld  5xx %lld  failed %lld\n", counts[2], counts[4], counts[5], counts[0] + counts[1] + counts[3]);
+    free(latencies);
+    return counts[0] + counts[5] > 0 ? 1 : 0;
+}
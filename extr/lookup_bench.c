@@ -0,0 +1,125 @@
+// Room lookup benchmark for the room index in hotel_core.c, against the room list it replaced
+// Build: gcc -std=c99 -O2 -pthread -o lookup_bench extr/lookup_bench.c hotel_core.c
+// Run:   ./lookup_bench [reserve and cancel pairs]
+// For hotels of 1k, 10k and 100k rooms, books and cancels random rooms (20000 pairs unless given) two ways: the
+// way makeReservation and cancelReservation did before the index, walking a linked list of room nodes from the
+// head to the room number each time, and through hotelReserve and hotelCancel, which find the room through the
+// hash index. Also times the bare lookups: the list walk against findRoom. Prints the time per operation of each
+// and how much faster the index is, and PASS if every booking and cancellation succeeded both ways.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define LIST_NAME_LENGTH 50 // Guest name length of the old room nodes
+
+// Define a room as the menu kept it before the index: a node of its own, found by walking the list
+struct ListRoom {
+    int roomNumber; // Room number
+    int isReserved; // Reservation status (1 if reserved, 0 otherwise)
+    char guestName[LIST_NAME_LENGTH]; // Guest's name
+    int duration; // Duration of stay in days
+    int occupancy; // Number of people staying in the room
+    struct ListRoom* next; // Next room in the list
+};
+
+// Function to find a room on the list by walking it from the head (NULL if there is no such room)
+static struct ListRoom* walkList(struct ListRoom* head, int roomNumber) {
+    for (struct ListRoom* room = head; room != NULL; room = room->next) {
+        if (room->roomNumber == roomNumber) {
+            return room;
+        }
+    }
+    return NULL;
+}
+
+// Function to book and cancel random rooms on the list, as the menu did (returns the pairs that failed)
+static int runList(struct ListRoom* head, const int* roomNumbers, int pairs, long long* elapsed) {
+    int failed = 0;
+    long long started = nowNanoseconds();
+    for (int i = 0; i < pairs; ++i) {
+        struct ListRoom* room = walkList(head, roomNumbers[i]);
+        int booked = room != NULL && !room->isReserved;
+        if (booked) {
+            room->isReserved = 1;
+            snprintf(room->guestName, sizeof(room->guestName), "Guest %d", i % 1000);
+            room->duration = 1 + i % 5;
+            room->occupancy = 1;
+        }
+        room = walkList(head, roomNumbers[i]);
+        failed += !booked || room == NULL || !room->isReserved;
+        if (room != NULL) {
+            room->isReserved = 0;
+        }
+    }
+    *elapsed = nowNanoseconds() - started;
+    return failed;
+}
+
+// Function to book and cancel random rooms of the hotel through its index (returns the pairs that failed)
+static int runHotel(struct Hotel* hotel, const int* roomNumbers, int pairs, long long* elapsed) {
+    char guestName[32];
+    int failed = 0, checkIn = hotelToday() + 1;
+    long long started = nowNanoseconds();
+    for (int i = 0; i < pairs; ++i) {
+        snprintf(guestName, sizeof(guestName), "Guest %d", i % 1000);
+        int status = hotelReserve(hotel, roomNumbers[i], guestName, checkIn, 1 + i % 5, 0, 1);
+        failed += status != HOTEL_OK || hotelCancel(hotel, roomNumbers[i], guestName, checkIn) != HOTEL_OK;
+    }
+    *elapsed = nowNanoseconds() - started;
+    return failed;
+}
+
+int main(int argc, char* argv[]) {
+    static const int sizes[] = {1000, 10000, 100000};
+    int pairs = argc > 1 ? atoi(argv[1]) : 20000;
+    unsigned int seed = 2463534242u;
+    int problems = 0;
+    pairs = pairs < 1 ? 1 : pairs;
+    int* roomNumbers = (int*)malloc(pairs * sizeof(int));
+
+    printf("%d reserve and cancel pairs at random rooms\n", pairs);
+    printf("%8s  %14s %14s %8s  %14s %14s %8s\n", "rooms", "list pair", "index pair", "faster", "list lookup",
+           "index lookup", "faster");
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); ++s) {
+        int rooms = sizes[s];
+        struct Hotel* hotel = hotelCreate();
+        struct ListRoom* head = NULL;
+        for (int r = rooms - 1; r >= 0; --r) { // Pushed on the front, so the list runs in room order
+            struct ListRoom* room = (struct ListRoom*)calloc(1, sizeof(struct ListRoom));
+            room->roomNumber = 100 + r;
+            room->next = head;
+            head = room;
+            hotelAddRoom(hotel, 100 + r);
+        }
+        for (int i = 0; i < pairs; ++i) {
+            roomNumbers[i] = 100 + (int)(nextRandom(&seed) % (unsigned int)rooms);
+        }
+
+        long long listPairs, hotelPairs, listLookups, hotelLookups;
+        problems += runList(head, roomNumbers, pairs, &listPairs);
+        problems += runHotel(hotel, roomNumbers, pairs, &hotelPairs);
+        long long found = 0, started = nowNanoseconds();
+        for (int i = 0; i < pairs; ++i) {
+            found += walkList(head, roomNumbers[i]) != NULL;
+        }
+        listLookups = nowNanoseconds() - started;
+        started = nowNanoseconds();
+        for (int i = 0; i < pairs; ++i) {
+            found += findRoom(hotel, roomNumbers[i]) >= 0;
+        }
+        hotelLookups = nowNanoseconds() - started;
+        problems += found != 2LL * pairs;
+
+        printf("%8d  %11.3f us %11.3f us %7.1fx  %11.1f ns %11.1f ns %7.1fx\n", rooms, listPairs / 1e3 / pairs,
+               hotelPairs / 1e3 / pairs, (double)listPairs / hotelPairs, (double)listLookups / pairs,
+               (double)hotelLookups / pairs, (double)listLookups / hotelLookups);
+        while (head != NULL) {
+            struct ListRoom* next = head->next;
+            free(head);
+            head = next;
+        }
+        hotelDestroy(hotel);
+    }
+    free(roomNumbers);
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
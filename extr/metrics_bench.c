@@ -0,0 +1,147 @@
+// Metrics overhead benchmark for the instrumented operations of hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o metrics_bench extr/metrics_bench.c hotel_core.c
+// Run:   ./metrics_bench [operations per thread] [threads]
+// Books and cancels random stays in a 100k-room hotel, with guest lookups and booking lists in between, from
+// one thread and then from several, first with the metrics off, then timing one operation in
+// METRICS_SAMPLE_INTERVAL, then timing every one. The settings take turns over several rounds and the best
+// round of each counts, so the machine's noise hits them alike. Prints the throughput and the overhead of
+// each setting against none, the latency quantiles the metrics saw, and PASS if every operation was counted.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define BENCH_ROOMS 100000 // Rooms in the hotel
+#define BENCH_ROUNDS 51 // Rounds of each setting; short rounds, so the best of them has escaped the noise
+#define MAX_THREADS 64
+
+// Define what one thread of a round works on
+struct BenchThread {
+    struct Hotel* hotel; // Hotel shared by the threads
+    int id; // Thread number, part of the guest name
+    int operations; // Operations to run
+    unsigned int seed; // Random number state
+    long long counted; // Operations run that the metrics should count
+};
+
+// Function run by each thread: book a random stay, look it up, cancel it, with a booking list now and then
+static void* runBench(void* argument) {
+    struct BenchThread* thread = (struct BenchThread*)argument;
+    struct Hotel* hotel = thread->hotel;
+    struct HotelBooking bookings[8];
+    char guestName[32];
+    snprintf(guestName, sizeof(guestName), "Bench %d", thread->id);
+    for (int i = 0; i < thread->operations; i += 4) {
+        int roomNumber = (int)(nextRandom(&thread->seed) % BENCH_ROOMS);
+        int checkIn = hotel->calendarStart + (int)(nextRandom(&thread->seed) % NIGHT_HORIZON);
+        int status = reserveRoom(hotel, roomNumber, guestName, checkIn, 1 + i % 5, 0, 1);
+        findGuestBookings(hotel, guestName, NULL, 0);
+        hotelListBookings(hotel, roomNumber, bookings, 8);
+        if (status == HOTEL_OK) {
+            releaseRoom(hotel, roomNumber, guestName, checkIn);
+        } else {
+            reserveRoom(hotel, -1, guestName, checkIn, 1, 0, 1); // Counted as room-not-found
+        }
+        thread->counted += 4;
+    }
+    return NULL;
+}
+
+// Function to run one round on threads threads and return the operations per second
+static double runRound(struct Hotel* hotel, int threads, int operations, long long* counted) {
+    pthread_t handles[MAX_THREADS];
+    struct BenchThread work[MAX_THREADS];
+    long long started = nowNanoseconds();
+    for (int t = 0; t < threads; ++t) {
+        work[t].hotel = hotel;
+        work[t].id = t;
+        work[t].operations = operations;
+        work[t].seed = 2463534242u + 977u * (unsigned int)t;
+        work[t].counted = 0;
+        pthread_create(&handles[t], NULL, runBench, &work[t]);
+    }
+    for (int t = 0; t < threads; ++t) {
+        pthread_join(handles[t], NULL);
+        *counted += work[t].counted;
+    }
+    return (double)threads * operations / ((nowNanoseconds() - started) / 1e9);
+}
+
+// Function to count the operations the metrics have recorded so far
+static long long countedOperations(struct ThreadMetrics* total) {
+    long long operations = 0;
+    collectMetrics(total);
+    for (int op = 0; op < METRIC_OPERATIONS; ++op) {
+        for (int s = 0; s < METRICS_STATUSES; ++s) {
+            operations += (long long)total->operations[op].results[s];
+        }
+    }
+    return operations;
+}
+
+// Function to find a latency quantile of an operation in the collected metrics, in nanoseconds
+static uint64_t quantile(const struct OperationMetrics* operation, double fraction) {
+    uint64_t timed = 0, seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+        timed += operation->latency[b];
+    }
+    for (int b = 0; b < LATENCY_BUCKETS && timed > 0; ++b) {
+        seen += operation->latency[b];
+        if (seen >= (uint64_t)(fraction * timed + 0.5)) {
+            return latencyBucketLimit(b);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int operations = argc > 1 ? atoi(argv[1]) : 20000;
+    int threadCount = argc > 2 ? atoi(argv[2]) : 4;
+    static const int intervals[] = {0, METRICS_SAMPLE_INTERVAL, 1};
+    struct ThreadMetrics* total = (struct ThreadMetrics*)malloc(sizeof(struct ThreadMetrics));
+    struct Hotel* hotel = hotelCreate();
+    int problems = 0;
+    threadCount = threadCount < 1 ? 1 : threadCount > MAX_THREADS ? MAX_THREADS : threadCount;
+    operations = operations < 4 ? 4 : operations - operations % 4;
+
+    int* numbers = (int*)malloc(BENCH_ROOMS * sizeof(int));
+    for (int i = 0; i < BENCH_ROOMS; ++i) {
+        numbers[i] = i;
+    }
+    hotelAddRooms(hotel, numbers, BENCH_ROOMS);
+    free(numbers);
+
+    printf("%d operations per thread, best of %d rounds\n", operations, BENCH_ROUNDS);
+    printf("threads  metrics         operations/s  overhead\n");
+    for (int threads = 1; threads <= threadCount; threads = threads < threadCount ? threadCount : threadCount + 1) {
+        double best[3] = {0, 0, 0};
+        for (int round = 0; round < BENCH_ROUNDS; ++round) {
+            for (int setting = 0; setting < 3; ++setting) {
+                long long counted = 0;
+                hotelSetMetricsSampling(intervals[setting]);
+                long long before = countedOperations(total);
+                double rate = runRound(hotel, threads, operations, &counted);
+                long long recorded = countedOperations(total) - before;
+                problems += recorded != (intervals[setting] > 0 ? counted : 0); // Every operation, or none when off
+                best[setting] = rate > best[setting] ? rate : best[setting];
+            }
+        }
+        for (int setting = 0; setting < 3; ++setting) {
+            char name[32];
+            snprintf(name, sizeof(name), intervals[setting] == 0 ? "off" : "1 in %d timed", intervals[setting]);
+            printf("%7d  %-14s %13.0f  %+7.2f%%\n", threads, name, best[setting], (best[0] / best[setting] - 1) * 100);
+        }
+    }
+
+    collectMetrics(total);
+    static const char* names[] = {"reserve", "cancel", "view"};
+    static const int kinds[] = {METRIC_RESERVE, METRIC_CANCEL, METRIC_VIEW};
+    for (int k = 0; k < 3; ++k) {
+        const struct OperationMetrics* operation = &total->operations[kinds[k]];
+        printf("%-8s p50 %6llu ns  p99 %6llu ns  p99.9 %7llu ns\n", names[k], (unsigned long long)quantile(operation, 0.5),
+               (unsigned long long)quantile(operation, 0.99), (unsigned long long)quantile(operation, 0.999));
+    }
+    hotelSetMetricsSampling(METRICS_SAMPLE_INTERVAL);
+    hotelDestroy(hotel);
+    free(total);
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+// Mixed read/write benchmark for the read views (openView and viewRoom) in hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o mvcc_bench extr/mvcc_bench.c hotel_core.c
+// Run:   ./mvcc_bench [rooms] [seconds a run] [writers]
+// Fills a hotel (100k rooms unless given) with two bookings a room, then has writer threads (one fewer than the
+// processors online, at least one, unless given) book and cancel random stays for a while (one second unless
+// given) three times: with no reports, with a thread running consistent full-table reports the way they could
+// be had before views (every room lock held for the whole report), and with that thread reading every room
+// through a view instead. Prints the bookings and cancellations made a second and their p99 and slowest
+// latency each time, and the reports made. PASS if every view read the whole table the same twice over while
+// the writers went on, and no room version outlived the views.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define BENCH_MAX_WRITERS 16
+#define BENCH_SAMPLE 8 // Each writer times one in this many changes
+#define BENCH_MAX_SAMPLES (1 << 20) // Latencies a writer keeps in one run
+#define BENCH_NIGHTS 300 // Nights from tomorrow the random stays fall in
+
+// Kinds of report run alongside the writers
+enum BenchReports {
+    REPORTS_NONE = 0, // Writers alone
+    REPORTS_LOCKED, // Every room lock held while the whole table is read
+    REPORTS_VIEW // The whole table read through a view
+};
+
+// Define what one writer thread works on
+struct BenchWriter {
+    struct Hotel* hotel; // Hotel shared by the threads
+    const int* stop; // Set when the run is over
+    unsigned int seed; // Random number state
+    long long changes; // Bookings and cancellations made
+    long long* latencies; // Nanoseconds of the timed changes
+    int sampled; // Latencies kept
+};
+
+// Define what the report thread works on
+struct BenchReader {
+    struct Hotel* hotel; // Hotel shared by the threads
+    const int* stop; // Set when the run is over
+    int kind; // enum BenchReports
+    long long reports; // Full-table reports made
+    uint64_t checksum; // Of every report, so none is optimized away
+    int inconsistent; // Views that read the table differently the second time
+};
+
+// Function to add a room's calendar to a running checksum
+static uint64_t addCalendar(uint64_t sum, int roomNumber, int count, const struct Stay* stays, const struct Booking* bookings) {
+    sum = sum * 1099511628211ULL + (uint64_t)roomNumber;
+    for (int b = 0; b < count; ++b) {
+        sum = sum * 1099511628211ULL + (uint64_t)stays[b].checkIn * 31 + (uint64_t)stays[b].checkOut;
+        sum = sum * 1099511628211ULL + bookings[b].guestName + (uint64_t)bookings[b].occupancy;
+    }
+    return sum;
+}
+
+// Function run by each writer thread: book a random stay, cancel it, and again, until the run is over
+static void* runWriter(void* argument) {
+    struct BenchWriter* writer = (struct BenchWriter*)argument;
+    int roomCount = hotelRoomCount(writer->hotel), first = hotelToday() + 1;
+    while (!__atomic_load_n(writer->stop, __ATOMIC_RELAXED)) {
+        int roomNumber = (int)(nextRandom(&writer->seed) % (unsigned int)roomCount);
+        int checkIn = first + (int)(nextRandom(&writer->seed) % BENCH_NIGHTS);
+        int timed = writer->changes % BENCH_SAMPLE == 0 && writer->sampled < BENCH_MAX_SAMPLES;
+        long long started = timed ? nowNanoseconds() : 0;
+        int booked = reserveRoom(writer->hotel, roomNumber, "Writer", checkIn, 1 + (int)(checkIn % 3), 0, 1) == HOTEL_OK;
+        if (booked) {
+            releaseRoom(writer->hotel, roomNumber, "Writer", checkIn);
+        }
+        if (timed) {
+            writer->latencies[writer->sampled++] = (nowNanoseconds() - started) / (booked ? 2 : 1);
+        }
+        writer->changes += booked ? 2 : 1;
+    }
+    return NULL;
+}
+
+// Function to read every room with every room lock held, as a consistent report had to (returns the checksum)
+static uint64_t reportLocked(struct Hotel* hotel) {
+    uint64_t sum = 0;
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    for (int i = 0; i < ROOM_LOCK_STRIPES; ++i) {
+        pthread_mutex_lock(&hotel->roomLocks[i].mutex);
+    }
+    for (int slot = 0; slot < hotel->roomCount; ++slot) {
+        const struct Room* room = &hotel->rooms[slot];
+        sum = addCalendar(sum, room->roomNumber, room->bookingCount, room->stays, hotel->details[slot].bookings);
+    }
+    for (int i = ROOM_LOCK_STRIPES - 1; i >= 0; --i) {
+        pthread_mutex_unlock(&hotel->roomLocks[i].mutex);
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return sum;
+}
+
+// Function to read every room through a view (returns the checksum)
+static uint64_t reportView(struct HotelView* view, int roomCount, struct RoomCopy* copy) {
+    uint64_t sum = 0;
+    for (int roomNumber = 0; roomNumber < roomCount; ++roomNumber) {
+        if (viewRoom(view, roomNumber, copy)) {
+            sum = addCalendar(sum, roomNumber, copy->bookingCount, copy->stays, copy->bookings);
+        }
+    }
+    return sum;
+}
+
+// Function run by the report thread: full-table reports of one kind, one after the other, until the run is over
+static void* runReader(void* argument) {
+    struct BenchReader* reader = (struct BenchReader*)argument;
+    struct RoomCopy copy;
+    int roomCount = hotelRoomCount(reader->hotel);
+    memset(&copy, 0, sizeof(copy));
+    while (!__atomic_load_n(reader->stop, __ATOMIC_RELAXED)) {
+        if (reader->kind == REPORTS_LOCKED) {
+            reader->checksum ^= reportLocked(reader->hotel);
+        } else {
+            struct HotelView* view = openView(reader->hotel);
+            uint64_t sum = reportView(view, roomCount, &copy);
+            reader->inconsistent += reportView(view, roomCount, &copy) != sum; // Read again, while the writers went on
+            reader->checksum ^= sum;
+            closeView(view);
+        }
+        reader->reports++;
+    }
+    freeRoomCopy(&copy);
+    return NULL;
+}
+
+// Function to run the writers for a while alongside one kind of report, and print how they did (returns the
+// views that were not consistent)
+static int runMixed(struct Hotel* hotel, int writers, double seconds, int kind, double* rate) {
+    static const char* names[] = {"no reports", "locked reports", "view reports"};
+    pthread_t handles[BENCH_MAX_WRITERS], readerHandle;
+    struct BenchWriter work[BENCH_MAX_WRITERS];
+    struct BenchReader reader = {hotel, NULL, kind, 0, 0, 0};
+    int stop = 0, sampled = 0;
+    long long changes = 0;
+    reader.stop = &stop;
+    long long started = nowNanoseconds();
+    for (int w = 0; w < writers; ++w) {
+        work[w].hotel = hotel;
+        work[w].stop = &stop;
+        work[w].seed = 2463534242u + 977u * (unsigned int)w;
+        work[w].changes = 0;
+        work[w].latencies = (long long*)malloc(BENCH_MAX_SAMPLES * sizeof(long long));
+        work[w].sampled = 0;
+        pthread_create(&handles[w], NULL, runWriter, &work[w]);
+    }
+    if (kind != REPORTS_NONE) {
+        pthread_create(&readerHandle, NULL, runReader, &reader);
+    }
+    struct timespec pause = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+    nanosleep(&pause, NULL);
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+    for (int w = 0; w < writers; ++w) {
+        pthread_join(handles[w], NULL);
+        changes += work[w].changes;
+        sampled += work[w].sampled;
+    }
+    if (kind != REPORTS_NONE) {
+        pthread_join(readerHandle, NULL);
+    }
+    double elapsed = (nowNanoseconds() - started) / 1e9;
+
+    long long* latencies = (long long*)malloc((sampled > 0 ? sampled : 1) * sizeof(long long));
+    int count = 0;
+    for (int w = 0; w < writers; ++w) {
+        memcpy(&latencies[count], work[w].latencies, work[w].sampled * sizeof(long long));
+        count += work[w].sampled;
+        free(work[w].latencies);
+    }
+    sortLatencies(latencies, count);
+    *rate = changes / elapsed;
+    printf("%-15s %10.0f changes/s  p99 %8.1f us  max %9.1f us  %6lld reports\n", names[kind], *rate,
+           sortedQuantile(latencies, count, 990) / 1e3, sortedQuantile(latencies, count, 1000) / 1e3, reader.reports);
+    free(latencies);
+    return reader.inconsistent;
+}
+
+int main(int argc, char* argv[]) {
+    int processors = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int rooms = argc > 1 ? atoi(argv[1]) : 100000;
+    double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+    int writers = argc > 3 ? atoi(argv[3]) : processors - 1;
+    unsigned int seed = 88172645u;
+    int problems = 0;
+    double none, locked, viewed;
+    rooms = rooms < 1 ? 1 : rooms;
+    seconds = seconds < 0.1 ? 0.1 : seconds;
+    writers = writers < 1 ? 1 : writers > BENCH_MAX_WRITERS ? BENCH_MAX_WRITERS : writers;
+
+    struct Hotel* hotel = hotelCreate();
+    for (int r = 0; r < rooms; ++r) {
+        insertRoom(hotel, r);
+        for (int b = 0; b < 2; ++b) {
+            reserveRoom(hotel, r, "Resident", hotelToday() + 1 + (int)(nextRandom(&seed) % BENCH_NIGHTS), 3, 0, 2);
+        }
+    }
+    printf("%d processors; %d rooms, %d writers, %.1f s a run\n", processors, rooms, writers, seconds);
+    if (processors < writers + 1) {
+        printf("(fewer processors than writers and the report thread: the reports take their share of them)\n");
+    }
+    problems += runMixed(hotel, writers, seconds, REPORTS_NONE, &none);
+    problems += runMixed(hotel, writers, seconds, REPORTS_LOCKED, &locked);
+    problems += runMixed(hotel, writers, seconds, REPORTS_VIEW, &viewed);
+    printf("writers keep %.0f%% of their rate beside locked reports, %.0f%% beside view reports\n", 100 * locked / none,
+           100 * viewed / none);
+
+    closeView(openView(hotel)); // Sweeps up after a change that raced the last close
+    problems += hotel->views.kept != 0 || hotel->views.open != 0;
+    problems += !checkTotals(hotel);
+    hotelDestroy(hotel);
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
@@ -0,0 +1,344 @@
+// Benchmark harness for the reservation core, through its C interface (hotel_core.h)
+// Build: gcc -std=c99 -O2 -pthread -o perf_harness extr/perf_harness.c hotel_core.c
+// Run:   ./perf_harness [--rooms 1000,10000,100000,1000000] [--ops N] [--out FILE] [--baseline FILE] [--tolerance PCT]
+// Builds a synthetic hotel of each size (in a child process of its own, so peak RSS is per hotel) and times:
+//   add        adding every room
+//   reserve    N bookings of random rooms: mostly short stays in the next ten months, some long or far out
+//   cancel     cancelling half of the bookings made
+//   mixed      N operations, 60% bookings, 30% cancellations of earlier bookings, 10% guest lookups
+//   available  N / 200 availability searches
+//   guest      N lookups of bookings by guest name
+//   quote      N price quotes
+// Each operation is timed on its own, so latencies include about 20 ns of clock reads. One JSON object
+// per hotel size and operation is written to FILE (perf_results.jsonl unless given) with ops_per_sec,
+// p50_ns, p99_ns and peak_rss_kb. With --baseline, operations more than PCT percent (25 unless given)
+// slower than in an earlier results file are listed and the harness exits with 1.
+#define _POSIX_C_SOURCE 200809L // Expose clock_gettime and fork under a strict -std=c99 build
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "../hotel_core.h"
+#include "bench_util.h"
+
+#define PERF_MAX_SIZES 16 // Hotel sizes one run can list
+#define PERF_GUEST_NAMES 65536 // Distinct guest names bookings are made under
+#define PERF_NAME_LENGTH 16 // Bytes per synthetic guest name
+#define PERF_LISTED_ROOMS 100 // Room numbers copied out per availability search
+#define PERF_MAX_RESULTS 256 // Result lines read back from a results file
+
+// Define one synthetic operation, generated before the clock starts
+struct PerfRequest {
+    int kind; // What the mixed phase does with it (PERF_RESERVE, PERF_CANCEL or PERF_GUEST)
+    int roomNumber;
+    int checkIn;
+    int nights;
+    int occupancy;
+    int extraServices;
+    int guest; // Index into the guest names
+};
+
+enum PerfKind {
+    PERF_RESERVE,
+    PERF_CANCEL,
+    PERF_GUEST
+};
+
+// Define a booking that was made, so it can be cancelled later
+struct PerfBooking {
+    int roomNumber;
+    int checkIn;
+    int guest;
+};
+
+// Define one line of a results file
+struct PerfResult {
+    int rooms;
+    char operation[16];
+    double opsPerSecond;
+};
+
+static char (*guestNames)[PERF_NAME_LENGTH]; // Synthetic guest names
+
+// Function to get the largest resident set size so far, in kilobytes
+static long peakRssKilobytes() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Function to number rooms the way a property does: floor times 1000 plus the room on the floor
+static int roomNumberFor(int i) {
+    return (i / 500 + 1) * 1000 + i % 500;
+}
+
+// Function to make up a stay: mostly one to three nights within ten months, some long, a few far out
+static void randomStay(struct PerfRequest* request, int rooms, int start, unsigned int* seed) {
+    unsigned int shape = nextRandom(seed) % 100;
+    request->roomNumber = roomNumberFor((int)(nextRandom(seed) % (unsigned int)rooms));
+    request->checkIn = start + (int)(nextRandom(seed) % (shape < 97 ? 300u : 1500u));
+    request->nights = 1 + (int)(nextRandom(seed) % (shape < 70 ? 3u : 14u));
+    request->occupancy = 1 + (int)(nextRandom(seed) % 4);
+    request->extraServices = nextRandom(seed) % 10 < 3;
+    request->guest = (int)(nextRandom(seed) % PERF_GUEST_NAMES);
+}
+
+// Function to write one result line and its row of the table
+static void reportPhase(FILE* out, int rooms, const char* operation, long long* latencies, int count, long long elapsed, int succeeded) {
+    sortLatencies(latencies, count);
+    double opsPerSecond = elapsed > 0 ? count * 1e9 / elapsed : 0.0;
+    long long p50 = sortedQuantile(latencies, count, 500);
+    long long p99 = sortedQuantile(latencies, count, 990);
+    long rss = peakRssKilobytes();
+    fprintf(out, "{\"rooms\":%d,\"operation\":\"%s\",\"ops\":%d,\"ok\":%d,\"ops_per_sec\":%.0f,\"p50_ns\":%lld,\"p99_ns\":%lld,\"peak_rss_kb\":%ld}\n",
+            rooms, operation, count, succeeded, opsPerSecond, p50, p99, rss);
+    printf("%8d  %-9s %8d %8d %12.0f %9lld %9lld %10ld\n", rooms, operation, count, succeeded, opsPerSecond, p50, p99, rss);
+}
+
+// Function to run every phase on a hotel of the given size (returns 0, or 1 if the hotel could not be made)
+static int runHotel(FILE* out, int rooms, int ops) {
+    struct Hotel* hotel = hotelCreate();
+    int largest = rooms > ops ? rooms : ops;
+    long long* latencies = (long long*)malloc(largest * sizeof(long long));
+    struct PerfRequest* requests = (struct PerfRequest*)malloc(ops * sizeof(struct PerfRequest));
+    struct PerfBooking* bookings = (struct PerfBooking*)malloc(2 * (size_t)ops * sizeof(struct PerfBooking));
+    struct GuestStay stays[16];
+    int numbers[PERF_LISTED_ROOMS];
+    unsigned int seed = 2463534242u ^ (unsigned int)rooms;
+    int start = hotelToday(), bookingCount = 0, succeeded;
+    long long started, elapsed, before;
+    if (hotel == NULL || latencies == NULL || requests == NULL || bookings == NULL) {
+        fprintf(stderr, "Out of memory for %d rooms.\n", rooms);
+        return 1;
+    }
+
+    succeeded = 0;
+    started = nowNanoseconds();
+    for (int i = 0; i < rooms; ++i) {
+        before = nowNanoseconds();
+        succeeded += hotelAddRoom(hotel, roomNumberFor(i)) == HOTEL_OK;
+        latencies[i] = nowNanoseconds() - before;
+    }
+    elapsed = nowNanoseconds() - started;
+    reportPhase(out, rooms, "add", latencies, rooms, elapsed, succeeded);
+
+    for (int i = 0; i < ops; ++i) {
+        randomStay(&requests[i], rooms, start, &seed);
+    }
+    succeeded = 0;
+    started = nowNanoseconds();
+    for (int i = 0; i < ops; ++i) {
+        const struct PerfRequest* r = &requests[i];
+        before = nowNanoseconds();
+        int status = hotelReserve(hotel, r->roomNumber, guestNames[r->guest], r->checkIn, r->nights, r->extraServices, r->occupancy);
+        latencies[i] = nowNanoseconds() - before;
+        if (status == HOTEL_OK) {
+            struct PerfBooking booking = {r->roomNumber, r->checkIn, r->guest};
+            bookings[bookingCount++] = booking;
+            succeeded++;
+        }
+    }
+    elapsed = nowNanoseconds() - started;
+    reportPhase(out, rooms, "reserve", latencies, ops, elapsed, succeeded);
+
+    int cancels = bookingCount / 2;
+    for (int i = bookingCount - 1; i > 0; --i) { // Cancel in random order
+        int j = (int)(nextRandom(&seed) % (unsigned int)(i + 1));
+        struct PerfBooking swap = bookings[i];
+        bookings[i] = bookings[j];
+        bookings[j] = swap;
+    }
+    succeeded = 0;
+    started = nowNanoseconds();
+    for (int i = 0; i < cancels; ++i) {
+        const struct PerfBooking* b = &bookings[bookingCount - 1 - i];
+        before = nowNanoseconds();
+        succeeded += hotelCancel(hotel, b->roomNumber, guestNames[b->guest], b->checkIn) == HOTEL_OK;
+        latencies[i] = nowNanoseconds() - before;
+    }
+    elapsed = nowNanoseconds() - started;
+    bookingCount -= cancels;
+    reportPhase(out, rooms, "cancel", latencies, cancels, elapsed, succeeded);
+
+    for (int i = 0; i < ops; ++i) {
+        unsigned int pick = nextRandom(&seed) % 10;
+        randomStay(&requests[i], rooms, start, &seed);
+        requests[i].kind = pick < 6 ? PERF_RESERVE : pick < 9 ? PERF_CANCEL : PERF_GUEST;
+    }
+    succeeded = 0;
+    started = nowNanoseconds();
+    for (int i = 0; i < ops; ++i) {
+        const struct PerfRequest* r = &requests[i];
+        int status = HOTEL_BOOKING_NOT_FOUND;
+        before = nowNanoseconds();
+        if (r->kind == PERF_RESERVE) {
+            status = hotelReserve(hotel, r->roomNumber, guestNames[r->guest], r->checkIn, r->nights, r->extraServices, r->occupancy);
+        } else if (r->kind == PERF_CANCEL && bookingCount > 0) {
+            const struct PerfBooking* b = &bookings[bookingCount - 1];
+            status = hotelCancel(hotel, b->roomNumber, guestNames[b->guest], b->checkIn);
+        } else if (r->kind == PERF_GUEST) {
+            status = hotelFindGuest(hotel, guestNames[r->guest], stays, 16) >= 0 ? HOTEL_OK : HOTEL_BOOKING_NOT_FOUND;
+        }
+        latencies[i] = nowNanoseconds() - before;
+        if (status == HOTEL_OK && r->kind == PERF_RESERVE) {
+            struct PerfBooking booking = {r->roomNumber, r->checkIn, r->guest};
+            bookings[bookingCount++] = booking;
+        } else if (status == HOTEL_OK && r->kind == PERF_CANCEL) {
+            bookingCount--;
+        }
+        succeeded += status == HOTEL_OK;
+    }
+    elapsed = nowNanoseconds() - started;
+    reportPhase(out, rooms, "mixed", latencies, ops, elapsed, succeeded);
+
+    int searches = ops / 200 > 10 ? ops / 200 : 10;
+    searches = searches < ops ? searches : ops;
+    succeeded = 0;
+    started = nowNanoseconds();
+    for (int i = 0; i < searches; ++i) {
+        const struct PerfRequest* r = &requests[i];
+        before = nowNanoseconds();
+        succeeded += hotelFindFreeRooms(hotel, r->checkIn, r->nights, r->occupancy, numbers, PERF_LISTED_ROOMS) > 0;
+        latencies[i] = nowNanoseconds() - before;
+    }
+    elapsed = nowNanoseconds() - started;
+    reportPhase(out, rooms, "available", latencies, searches, elapsed, succeeded);
+
+    succeeded = 0;
+    started = nowNanoseconds();
+    for (int i = 0; i < ops; ++i) {
+        before = nowNanoseconds();
+        succeeded += hotelFindGuest(hotel, guestNames[requests[i].guest], stays, 16) > 0;
+        latencies[i] = nowNanoseconds() - before;
+    }
+    elapsed = nowNanoseconds() - started;
+    reportPhase(out, rooms, "guest", latencies, ops, elapsed, succeeded);
+
+    volatile int64_t sink = 0; // Keeps the quotes from being optimized away
+    started = nowNanoseconds();
+    for (int i = 0; i < ops; ++i) {
+        const struct PerfRequest* r = &requests[i];
+        before = nowNanoseconds();
+        sink += hotelQuote(hotel, r->roomNumber, r->checkIn, r->nights, r->occupancy, r->extraServices);
+        latencies[i] = nowNanoseconds() - before;
+    }
+    elapsed = nowNanoseconds() - started;
+    (void)sink;
+    reportPhase(out, rooms, "quote", latencies, ops, elapsed, ops);
+
+    hotelDestroy(hotel);
+    free(latencies);
+    free(requests);
+    free(bookings);
+    return 0;
+}
+
+// Function to read the results in a file (returns how many were read, or -1 if it cannot be opened)
+static int readResults(const char* path, struct PerfResult* results, int maxResults) {
+    char line[512];
+    int count = 0;
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    while (count < maxResults && fgets(line, sizeof(line), file) != NULL) {
+        struct PerfResult* r = &results[count];
+        int ops, ok;
+        if (sscanf(line, "{\"rooms\":%d,\"operation\":\"%15[^\"]\",\"ops\":%d,\"ok\":%d,\"ops_per_sec\":%lf",
+                   &r->rooms, r->operation, &ops, &ok, &r->opsPerSecond) == 5) {
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+// Function to list operations that got slower than in the baseline (returns how many did)
+static int compareResults(const char* path, const char* baselinePath, double tolerance) {
+    static struct PerfResult current[PERF_MAX_RESULTS], baseline[PERF_MAX_RESULTS];
+    int currentCount = readResults(path, current, PERF_MAX_RESULTS);
+    int baselineCount = readResults(baselinePath, baseline, PERF_MAX_RESULTS);
+    int regressions = 0;
+    if (baselineCount < 0) {
+        fprintf(stderr, "Cannot open the baseline %s.\n", baselinePath);
+        return 1;
+    }
+    for (int i = 0; i < currentCount; ++i) {
+        for (int j = 0; j < baselineCount; ++j) {
+            if (current[i].rooms == baseline[j].rooms && strcmp(current[i].operation, baseline[j].operation) == 0
+                && current[i].opsPerSecond < baseline[j].opsPerSecond * (1.0 - tolerance / 100.0)) {
+                printf("REGRESSION %d rooms %s: %.0f ops/s, baseline %.0f ops/s\n", current[i].rooms, current[i].operation,
+                       current[i].opsPerSecond, baseline[j].opsPerSecond);
+                regressions++;
+            }
+        }
+    }
+    return regressions;
+}
+
+int main(int argc, char* argv[]) {
+    int sizes[PERF_MAX_SIZES] = {1000, 10000, 100000, 1000000};
+    int sizeCount = 4, ops = 200000, failed = 0;
+    const char* path = "perf_results.jsonl";
+    const char* baselinePath = NULL;
+    double tolerance = 25.0;
+    for (int a = 1; a + 1 < argc; a += 2) {
+        if (strcmp(argv[a], "--rooms") == 0) {
+            sizeCount = 0;
+            for (char* item = strtok(argv[a + 1], ","); item != NULL && sizeCount < PERF_MAX_SIZES; item = strtok(NULL, ",")) {
+                sizes[sizeCount] = atoi(item);
+                sizeCount += sizes[sizeCount] > 0;
+            }
+        } else if (strcmp(argv[a], "--ops") == 0) {
+            ops = atoi(argv[a + 1]);
+        } else if (strcmp(argv[a], "--out") == 0) {
+            path = argv[a + 1];
+        } else if (strcmp(argv[a], "--baseline") == 0) {
+            baselinePath = argv[a + 1];
+        } else if (strcmp(argv[a], "--tolerance") == 0) {
+            tolerance = atof(argv[a + 1]);
+        } else {
+            fprintf(stderr, "Unknown option %s.\n", argv[a]);
+            return 2;
+        }
+    }
+    ops = ops < 100 ? 100 : ops;
+
+    guestNames = (char (*)[PERF_NAME_LENGTH])malloc(PERF_GUEST_NAMES * sizeof(*guestNames));
+    for (int g = 0; g < PERF_GUEST_NAMES; ++g) {
+        snprintf(guestNames[g], PERF_NAME_LENGTH, "Guest %05d", g);
+    }
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        fprintf(stderr, "Cannot write %s.\n", path);
+        return 2;
+    }
+    printf("   rooms  operation      ops       ok      ops/sec    p50 ns    p99 ns   peak KB\n");
+    for (int s = 0; s < sizeCount; ++s) {
+        fflush(stdout); // The child inherits the buffers; empty them so nothing is written twice
+        fflush(out);
+        pid_t child = fork();
+        if (child == 0) {
+            int result = runHotel(out, sizes[s], ops);
+            fclose(out);
+            fflush(stdout);
+            _exit(result);
+        }
+        int status = 1;
+        if (child < 0 || waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "The run with %d rooms failed.\n", sizes[s]);
+            failed = 1;
+        }
+    }
+    fclose(out);
+    free(guestNames);
+    printf("Results written to %s\n", path);
+    if (!failed && baselinePath != NULL) {
+        failed = compareResults(path, baselinePath, tolerance) > 0;
+        printf("%s\n", failed ? "Slower than the baseline." : "No regressions against the baseline.");
+    }
+    return failed;
+}
@@ -0,0 +1,95 @@
+// Pricing benchmark for the rate plans in hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o quote_bench extr/quote_bench.c hotel_core.c
+// Run:   ./quote_bench [rate file] [stays]
+// Prices the same random stays three ways: night by night from the rules, one stay at a time with quoteStay,
+// and all at once with quoteStays. Prints the time per quote of each and PASS if all three agree.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define BENCH_ROUNDS 5 // Each way of pricing is timed this many times; the best run is printed
+
+// Function to price a stay the slow way: every night from the rules, then the same extras, surcharge and discount
+static int64_t naiveQuote(const struct RatePlan* plan, const struct QuoteRequest* stay) {
+    int64_t nights = stay->nights > 0 ? stay->nights : 0;
+    int64_t people = (int64_t)stay->occupancy - plan->surchargeFrom + 1;
+    int64_t subtotal = 0;
+    int type = roomType(plan, stay->roomNumber);
+    for (int n = 0; n < nights; ++n) {
+        subtotal += nightRate(plan, type, stay->checkIn + n);
+    }
+    subtotal += nights * (stay->extraServices != 0) * plan->extrasRate + nights * (people > 0 ? people : 0) * plan->surchargeRate;
+    return subtotal - subtotal * plan->discounts[nights < RATE_MAX_DISCOUNT_NIGHTS ? nights : RATE_MAX_DISCOUNT_NIGHTS] / 100;
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = argc > 1 ? argv[1] : "extr/sample_rates.txt";
+    int count = argc > 2 ? atoi(argv[2]) : 1000000;
+    struct RatePlan plan;
+    unsigned int seed = 2463534242u;
+    int problems = 0;
+    count = count < 1 ? 1 : count;
+
+    initRatePlan(&plan);
+    int loaded = loadRatePlan(&plan, path);
+    if (loaded <= 0) {
+        fprintf(stderr, loaded == 0 ? "Cannot open %s; using the default rates.\n" : "%s has a bad line; using the default rates.\n", path);
+    }
+    struct QuoteRequest* stays = (struct QuoteRequest*)malloc(count * sizeof(struct QuoteRequest));
+    int64_t* expected = (int64_t*)malloc(count * sizeof(int64_t));
+    int64_t* totals = (int64_t*)malloc(count * sizeof(int64_t));
+    int start = today();
+    for (int i = 0; i < count; ++i) { // Mostly stays of up to two weeks in the next two years; a few far out or very long
+        unsigned int r = nextRandom(&seed);
+        stays[i].roomNumber = 100 + (int)(nextRandom(&seed) % 300);
+        stays[i].checkIn = start + (r % 100 == 0 ? 1500 + (int)(nextRandom(&seed) % 3000) : (int)(nextRandom(&seed) % 730));
+        stays[i].nights = r % 97 == 0 ? 30 + (int)(nextRandom(&seed) % 400) : 1 + (int)(nextRandom(&seed) % 14);
+        stays[i].occupancy = 1 + (int)(nextRandom(&seed) % 5);
+        stays[i].extraServices = (int)(nextRandom(&seed) % 2);
+    }
+
+    long long best[3] = {INT64_MAX, INT64_MAX, INT64_MAX};
+    volatile int64_t sink = 0; // Keeps the one-at-a-time loops from being optimized away
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        long long started = nowNanoseconds();
+        for (int i = 0; i < count; ++i) {
+            expected[i] = naiveQuote(&plan, &stays[i]);
+        }
+        long long elapsed = nowNanoseconds() - started;
+        best[0] = elapsed < best[0] ? elapsed : best[0];
+
+        started = nowNanoseconds();
+        for (int i = 0; i < count; ++i) {
+            int64_t total = quoteStay(&plan, stays[i].roomNumber, stays[i].checkIn, stays[i].nights, stays[i].occupancy,
+                                      stays[i].extraServices, NULL);
+            sink += total;
+            if (round == 0 && total != expected[i]) {
+                problems++;
+            }
+        }
+        elapsed = nowNanoseconds() - started;
+        best[1] = elapsed < best[1] ? elapsed : best[1];
+
+        started = nowNanoseconds();
+        quoteStays(&plan, stays, count, totals);
+        elapsed = nowNanoseconds() - started;
+        best[2] = elapsed < best[2] ? elapsed : best[2];
+        for (int i = 0; round == 0 && i < count; ++i) {
+            problems += totals[i] != expected[i];
+        }
+    }
+    (void)sink;
+
+    printf("%d stays, %d room types, %d seasons\n", count, plan.typeCount, plan.seasonCount);
+    printf("night by night   %8.1f ns per quote\n", (double)best[0] / count);
+    printf("quoteStay        %8.1f ns per quote\n", (double)best[1] / count);
+    printf("quoteStays       %8.1f ns per quote\n", (double)best[2] / count);
+    if (problems > 0) {
+        fprintf(stderr, "%d quotes differ from the night-by-night price.\n", problems);
+    }
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    freeRatePlan(&plan);
+    free(stays);
+    free(expected);
+    free(totals);
+    return problems == 0 ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+// Paged report benchmark for hotelReport in hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o report_bench extr/report_bench.c hotel_core.c
+// Run:   ./report_bench [rooms...]
+// Builds a hotel of each size (10k and 1M rooms unless given, 1000 to a floor) with every tenth room booked,
+// some of them tonight, and times page fetches of 50 rooms under each filter: the first page, a page from
+// the middle of the hotel and a walk through the first hundred pages. For comparison, times the table scan
+// the old reports made to find the same rooms. Prints the time per page and PASS if paging through each
+// report lists exactly the rooms the scan finds.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define PAGE_ROOMS 50 // Rooms per page, as the menu shows them
+#define WALK_PAGES 100 // Pages fetched one after the other from the start
+#define PAGE_ROUNDS 200 // First and middle pages are timed this many times and averaged
+
+// Function to check whether a room matches a query the slow way, room by room (the table lock is not needed here)
+static int scanMatches(struct Hotel* hotel, int slot, const struct HotelReportQuery* query) {
+    const struct Room* room = &hotel->rooms[slot];
+    if (room->roomNumber < query->firstRoom || room->roomNumber > query->lastRoom) {
+        return 0;
+    }
+    if (query->guestName != NULL) {
+        int mine = 0;
+        for (int b = 0; b < room->bookingCount && !mine; ++b) {
+            mine = strcmp(poolString(&hotel->guests.names, hotel->details[slot].bookings[b].guestName), query->guestName) == 0;
+        }
+        if (!mine) {
+            return 0;
+        }
+    }
+    if (query->filter == HOTEL_REPORT_ALL) {
+        return 1;
+    }
+    int booked = query->night == HOTEL_ANY_NIGHT ? room->bookingCount > 0 : !isRoomFree(room, query->night, query->night + 1);
+    return booked == (query->filter == HOTEL_REPORT_RESERVED);
+}
+
+// Function to time one report and check it against a full table scan (returns 1 if they agree)
+static int benchReport(struct Hotel* hotel, const char* name, const struct HotelReportQuery* query) {
+    int page[PAGE_ROOMS];
+    struct HotelCursor cursor;
+    long long started, first, middle, walk, scan;
+    int pages = 0;
+
+    started = nowNanoseconds();
+    for (int round = 0; round < PAGE_ROUNDS; ++round) {
+        cursor.state = HOTEL_CURSOR_START;
+        hotelReport(hotel, query, &cursor, page, PAGE_ROOMS);
+    }
+    first = (nowNanoseconds() - started) / PAGE_ROUNDS;
+
+    started = nowNanoseconds();
+    for (int round = 0; round < PAGE_ROUNDS; ++round) { // Resume from the middle room, as a later page would
+        cursor.state = HOTEL_CURSOR_MORE;
+        cursor.roomNumber = hotel->rooms[hotel->roomCount / 2].roomNumber;
+        hotelReport(hotel, query, &cursor, page, PAGE_ROOMS);
+    }
+    middle = (nowNanoseconds() - started) / PAGE_ROUNDS;
+
+    cursor.state = HOTEL_CURSOR_START;
+    started = nowNanoseconds();
+    while (pages < WALK_PAGES && cursor.state != HOTEL_CURSOR_DONE) {
+        hotelReport(hotel, query, &cursor, page, PAGE_ROOMS);
+        pages++;
+    }
+    walk = (nowNanoseconds() - started) / pages;
+
+    started = nowNanoseconds();
+    int matching = 0;
+    for (int slot = 0; slot < hotel->roomCount; ++slot) { // What a report without the room order has to do
+        matching += scanMatches(hotel, slot, query);
+    }
+    scan = nowNanoseconds() - started;
+
+    // Page through the whole report and compare it with the scan, room by room
+    int* expected = (int*)malloc((matching + 1) * sizeof(int));
+    int count = 0, listed = 0, agree = 1;
+    for (int slot = 0; slot < hotel->roomCount; ++slot) { // Rooms were added in number order
+        if (scanMatches(hotel, slot, query)) {
+            expected[count++] = hotel->rooms[slot].roomNumber;
+        }
+    }
+    cursor.state = HOTEL_CURSOR_START;
+    while (cursor.state != HOTEL_CURSOR_DONE && agree) {
+        int found = hotelReport(hotel, query, &cursor, page, PAGE_ROOMS);
+        for (int i = 0; i < found && agree; ++i, ++listed) {
+            int want = query->descending ? expected[matching - 1 - listed] : expected[listed];
+            agree = listed < matching && page[i] == want;
+        }
+    }
+    agree = agree && listed == matching;
+    free(expected);
+
+    printf("%-22s %8d rooms  first page %7.1f us  middle page %7.1f us  next page %7.1f us  full scan %8.1f us  %s\n",
+           name, matching, first / 1e3, middle / 1e3, walk / 1e3, scan / 1e3, agree ? "ok" : "MISMATCH");
+    return agree;
+}
+
+// Function to build a hotel of the given size and time every kind of report on it (returns the number of problems)
+static int benchHotel(int rooms) {
+    struct Hotel* hotel = hotelCreate();
+    struct HotelReportQuery query;
+    char guestName[32];
+    int floors = rooms / 1000, tonight = hotelToday(), problems = 0;
+
+    hotelAddRoomRange(hotel, 1, floors, 1, 1000);
+    for (int i = 0; i < rooms; i += 10) { // Every tenth room booked; a third of those tonight
+        int roomNumber = (i / 1000 + 1) * 10000 + i % 1000 + 1;
+        snprintf(guestName, sizeof(guestName), "Guest %d", i / 10 % 1000);
+        hotelReserve(hotel, roomNumber, guestName, tonight + (i / 10 % 3 == 0 ? 0 : 5), 2, 0, 1);
+    }
+    printf("%d rooms, %d booked\n", rooms, (rooms + 9) / 10);
+
+    hotelInitReport(&query);
+    problems += !benchReport(hotel, "all", &query);
+    query.filter = HOTEL_REPORT_RESERVED;
+    problems += !benchReport(hotel, "reserved", &query);
+    query.descending = 1;
+    problems += !benchReport(hotel, "reserved, descending", &query);
+    query.descending = 0;
+    query.night = tonight;
+    problems += !benchReport(hotel, "reserved tonight", &query);
+    query.filter = HOTEL_REPORT_VACANT;
+    problems += !benchReport(hotel, "vacant tonight", &query);
+    query.night = HOTEL_ANY_NIGHT;
+    problems += !benchReport(hotel, "vacant", &query);
+    query.filter = HOTEL_REPORT_ALL;
+    query.firstRoom = (floors / 2) * 10000;
+    query.lastRoom = (floors / 2 + 1) * 10000 - 1;
+    problems += !benchReport(hotel, "one floor", &query);
+    hotelInitReport(&query);
+    query.guestName = "Guest 7";
+    problems += !benchReport(hotel, "guest", &query);
+
+    hotelDestroy(hotel);
+    return problems;
+}
+
+int main(int argc, char* argv[]) {
+    int problems = 0;
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            int rooms = atoi(argv[i]);
+            problems += benchHotel(rooms < 1000 ? 1000 : rooms - rooms % 1000);
+        }
+    } else {
+        problems += benchHotel(10000);
+        problems += benchHotel(1000000);
+    }
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
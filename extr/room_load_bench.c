@@ -0,0 +1,105 @@
+// Room loading benchmark for the room table in hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o room_load_bench extr/room_load_bench.c hotel_core.c
+// Run:   ./room_load_bench [rooms]
+// Loads the same rooms (1M unless given, numbered floor by floor, 1000 to a floor) into an empty hotel
+// one at a time, as one list, as a floor range and from a room file, then the list again into the full
+// hotel, where every room is a duplicate. For comparison, times a duplicate check that walks the room
+// table on a small hotel. Prints the time per room of each and PASS if every load added what it should.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define LINEAR_ROOMS 20000 // Rooms loaded with the table-walking duplicate check (it is quadratic)
+
+// Function to print one timing line
+static void report(const char* name, long long elapsed, int rooms) {
+    printf("%-24s %8.3f s  (%6.1f ns per room)\n", name, elapsed / 1e9, (double)elapsed / rooms);
+}
+
+// Function to add a room after looking for its number the old way, room by room through the table
+static int insertRoomLinear(struct Hotel* hotel, int roomNumber) {
+    for (int i = 0; i < hotel->roomCount; ++i) {
+        if (hotel->rooms[i].roomNumber == roomNumber) {
+            return HOTEL_ROOM_EXISTS;
+        }
+    }
+    return insertRoom(hotel, roomNumber);
+}
+
+int main(int argc, char* argv[]) {
+    int rooms = argc > 1 ? atoi(argv[1]) : 1000000;
+    rooms = rooms < 1000 ? 1000 : rooms - rooms % 1000;
+    int floors = rooms / 1000, problems = 0;
+    int* numbers = NULL;
+    char path[] = "/tmp/room_load_bench.XXXXXX";
+    long long started;
+
+    if (expandRoomRange(1, floors, 1, 1000, &numbers) != rooms) {
+        fprintf(stderr, "Cannot number %d rooms.\n", rooms);
+        return 1;
+    }
+    int descriptor = mkstemp(path);
+    FILE* file = descriptor >= 0 ? fdopen(descriptor, "w") : NULL;
+    if (file == NULL) {
+        fprintf(stderr, "Cannot write a room file.\n");
+        return 1;
+    }
+    for (int i = 0; i < rooms; ++i) {
+        fprintf(file, "room %d\n", numbers[i]);
+    }
+    fclose(file);
+    printf("%d rooms, %d floors\n", rooms, floors);
+
+    struct Hotel* hotel = hotelCreate();
+    started = nowNanoseconds();
+    int added = 0;
+    for (int i = 0; i < rooms; ++i) {
+        added += hotelAddRoom(hotel, numbers[i]) == HOTEL_OK;
+    }
+    report("hotelAddRoom each", nowNanoseconds() - started, rooms);
+    problems += added != rooms;
+    hotelDestroy(hotel);
+
+    hotel = hotelCreate();
+    started = nowNanoseconds();
+    added = hotelAddRooms(hotel, numbers, rooms);
+    report("hotelAddRooms", nowNanoseconds() - started, rooms);
+    problems += added != rooms;
+    started = nowNanoseconds();
+    added = hotelAddRooms(hotel, numbers, rooms);
+    report("hotelAddRooms, all taken", nowNanoseconds() - started, rooms);
+    problems += added != 0 || hotelRoomCount(hotel) != rooms;
+    hotelDestroy(hotel);
+
+    hotel = hotelCreate();
+    started = nowNanoseconds();
+    added = hotelAddRoomRange(hotel, 1, floors, 1, 1000);
+    report("hotelAddRoomRange", nowNanoseconds() - started, rooms);
+    problems += added != rooms;
+    hotelDestroy(hotel);
+
+    hotel = hotelCreate();
+    int listed = 0;
+    started = nowNanoseconds();
+    problems += hotelImportRooms(hotel, path, &listed, &added) != 1 || listed != rooms || added != rooms;
+    report("hotelImportRooms", nowNanoseconds() - started, rooms);
+    hotelDestroy(hotel);
+    remove(path);
+
+    int linearRooms = rooms < LINEAR_ROOMS ? rooms : LINEAR_ROOMS;
+    struct Hotel linear;
+    initHotel(&linear);
+    started = nowNanoseconds();
+    added = 0;
+    for (int i = 0; i < linearRooms; ++i) {
+        added += insertRoomLinear(&linear, numbers[i]) == HOTEL_OK;
+    }
+    long long elapsed = nowNanoseconds() - started;
+    printf("table walk, %d rooms    %8.3f s  (%6.1f ns per room; about %.0f s for all %d)\n", linearRooms, elapsed / 1e9,
+           (double)elapsed / linearRooms, elapsed / 1e9 * ((double)rooms / linearRooms) * ((double)rooms / linearRooms), rooms);
+    problems += added != linearRooms;
+    freeHotel(&linear);
+
+    free(numbers);
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
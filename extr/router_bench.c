@@ -0,0 +1,178 @@
+// Sharded property router benchmark for hotelRouterRun in hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o router_bench extr/router_bench.c hotel_core.c
+// Run:   ./router_bench [most shards] [requests per client]
+// For 1, 2, 4, ... up to the most shards (half the processors online unless given), runs a router with that
+// many shards of BENCH_SHARD_PROPERTIES properties of BENCH_ROOMS rooms, and as many client threads, each
+// booking random stays at random properties in runs of BENCH_RUN requests and cancelling them in the next
+// run (200k requests a client unless given). Prints the requests answered per second, the speedup over one
+// shard and how close it is to linear, then the same requests made straight on one hotel by one thread, for
+// the router's own cost, and PASS if every request was answered as it should be and every stay came off again.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define BENCH_SHARD_PROPERTIES 8 // Properties each shard owns
+#define BENCH_ROOMS 1000 // Rooms of each property
+#define BENCH_RUN 256 // Requests a client hands the router at once
+#define MAX_THREADS HOTEL_ROUTER_MAX_SHARDS
+
+// Define what one client thread works on
+struct BenchThread {
+    struct HotelRouter* router; // Router shared by the threads
+    int properties; // Properties behind the router, numbered from 0
+    int requests; // Requests to run, half bookings and half cancellations
+    unsigned int seed; // Random number state
+    long long answered; // Requests answered
+    int wrong; // Requests answered with a status they could not have had
+};
+
+// Function to fill a run with random bookings, each of one person for one to three nights
+static void fillBookings(struct HotelRequest* run, int properties, unsigned int* seed) {
+    for (int i = 0; i < BENCH_RUN; ++i) {
+        memset(&run[i], 0, sizeof(run[i]));
+        run[i].type = HOTEL_REQUEST_RESERVE;
+        run[i].propertyId = (int)(nextRandom(seed) % (unsigned int)properties);
+        run[i].roomNumber = (int)(nextRandom(seed) % BENCH_ROOMS);
+        run[i].checkIn = hotelToday() + (int)(nextRandom(seed) % 300);
+        run[i].nights = 1 + (int)(nextRandom(seed) % 3);
+        run[i].occupancy = 1;
+        run[i].guestName = "Bench Guest";
+    }
+}
+
+// Function run by each client thread: book a run of stays, then cancel the same run, until its requests are done
+static void* runClient(void* argument) {
+    struct BenchThread* thread = (struct BenchThread*)argument;
+    struct HotelRouterClient* client = hotelRouterConnect(thread->router);
+    struct HotelRequest run[BENCH_RUN];
+    for (int i = 0; i + 2 * BENCH_RUN <= thread->requests; i += 2 * BENCH_RUN) {
+        fillBookings(run, thread->properties, &thread->seed);
+        hotelRouterRun(client, run, BENCH_RUN);
+        for (int r = 0; r < BENCH_RUN; ++r) {
+            thread->wrong += run[r].status != HOTEL_OK && run[r].status != HOTEL_ROOM_UNAVAILABLE;
+            run[r].type = HOTEL_REQUEST_CANCEL; // Refused bookings are not found: just as much work for the shard
+        }
+        hotelRouterRun(client, run, BENCH_RUN);
+        for (int r = 0; r < BENCH_RUN; ++r) {
+            thread->wrong += run[r].status != HOTEL_OK && run[r].status != HOTEL_BOOKING_NOT_FOUND;
+        }
+        thread->answered += 2 * BENCH_RUN;
+    }
+    hotelRouterDisconnect(client);
+    return NULL;
+}
+
+// Function to add every property and its rooms through a router (returns the requests answered wrongly)
+static int addProperties(struct HotelRouter* router, int properties) {
+    struct HotelRouterClient* client = hotelRouterConnect(router);
+    struct HotelRequest* requests = (struct HotelRequest*)calloc((size_t)properties * (BENCH_ROOMS + 1), sizeof(struct HotelRequest));
+    int count = 0, wrong = 0;
+    for (int p = 0; p < properties; ++p) {
+        requests[count].type = HOTEL_REQUEST_ADD_PROPERTY;
+        requests[count++].propertyId = p;
+        for (int r = 0; r < BENCH_ROOMS; ++r) {
+            requests[count].type = HOTEL_REQUEST_ADD_ROOM;
+            requests[count].propertyId = p;
+            requests[count++].roomNumber = r;
+        }
+    }
+    hotelRouterRun(client, requests, count);
+    for (int i = 0; i < count; ++i) {
+        wrong += requests[i].status != HOTEL_OK;
+    }
+    free(requests);
+    hotelRouterDisconnect(client);
+    return wrong;
+}
+
+// Function to count the properties that still have a room booked some night of the next year
+static int countBusyProperties(struct HotelRouter* router, int properties) {
+    struct HotelRouterClient* client = hotelRouterConnect(router);
+    struct HotelRequest* requests = (struct HotelRequest*)calloc(properties, sizeof(struct HotelRequest));
+    int busy = 0;
+    for (int p = 0; p < properties; ++p) {
+        requests[p].type = HOTEL_REQUEST_FREE_ROOMS;
+        requests[p].propertyId = p;
+        requests[p].checkIn = hotelToday();
+        requests[p].nights = 310;
+    }
+    hotelRouterRun(client, requests, properties);
+    for (int p = 0; p < properties; ++p) {
+        busy += requests[p].status != HOTEL_OK || requests[p].freeRooms != BENCH_ROOMS;
+    }
+    free(requests);
+    hotelRouterDisconnect(client);
+    return busy;
+}
+
+// Function to run the same requests as one client, straight on one hotel from one thread (returns requests per second)
+static double runDirect(int requests) {
+    struct Hotel* hotel = hotelCreate();
+    struct HotelRequest run[BENCH_RUN];
+    unsigned int seed = 2463534242u;
+    for (int r = 0; r < BENCH_ROOMS; ++r) {
+        insertRoom(hotel, r);
+    }
+    long long started = nowNanoseconds();
+    for (int i = 0; i + 2 * BENCH_RUN <= requests; i += 2 * BENCH_RUN) {
+        fillBookings(run, 1, &seed);
+        for (int r = 0; r < BENCH_RUN; ++r) {
+            run[r].status = reserveRoom(hotel, run[r].roomNumber, run[r].guestName, run[r].checkIn, run[r].nights, 0, 1);
+        }
+        for (int r = 0; r < BENCH_RUN; ++r) {
+            run[r].status = releaseRoom(hotel, run[r].roomNumber, run[r].guestName, run[r].checkIn);
+        }
+    }
+    double rate = (requests - requests % (2 * BENCH_RUN)) / ((nowNanoseconds() - started) / 1e9);
+    hotelDestroy(hotel);
+    return rate;
+}
+
+int main(int argc, char* argv[]) {
+    int processors = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int mostShards = argc > 1 ? atoi(argv[1]) : processors / 2;
+    int requests = argc > 2 ? atoi(argv[2]) : 200000;
+    int problems = 0;
+    double single = 0;
+    mostShards = mostShards < 1 ? 1 : mostShards > MAX_THREADS ? MAX_THREADS : mostShards;
+    requests = requests < 2 * BENCH_RUN ? 2 * BENCH_RUN : requests;
+
+    printf("%d processors; %d properties of %d rooms a shard, one client a shard, %d requests a client\n", processors,
+           BENCH_SHARD_PROPERTIES, BENCH_ROOMS, requests);
+    if (processors < 2 * mostShards) {
+        printf("(fewer processors than workers and clients: the larger runs share them and cannot scale)\n");
+    }
+    printf("shards  requests/s  speedup  of linear\n");
+    for (int shards = 1; shards <= mostShards; shards = shards < mostShards && shards * 2 > mostShards ? mostShards : shards * 2) {
+        pthread_t handles[MAX_THREADS];
+        struct BenchThread work[MAX_THREADS];
+        struct HotelRouter* router = hotelRouterCreate(shards);
+        int properties = shards * BENCH_SHARD_PROPERTIES;
+        long long answered = 0;
+        problems += addProperties(router, properties);
+
+        long long started = nowNanoseconds();
+        for (int t = 0; t < shards; ++t) {
+            work[t].router = router;
+            work[t].properties = properties;
+            work[t].requests = requests;
+            work[t].seed = 2463534242u + 977u * (unsigned int)t;
+            work[t].answered = 0;
+            work[t].wrong = 0;
+            pthread_create(&handles[t], NULL, runClient, &work[t]);
+        }
+        for (int t = 0; t < shards; ++t) {
+            pthread_join(handles[t], NULL);
+            answered += work[t].answered;
+            problems += work[t].wrong;
+        }
+        double rate = answered / ((nowNanoseconds() - started) / 1e9);
+        single = shards == 1 ? rate : single;
+        printf("%6d  %10.0f  %6.2fx  %8.0f%%\n", shards, rate, rate / single, 100 * rate / single / shards);
+        problems += countBusyProperties(router, properties);
+        hotelRouterDestroy(router);
+    }
+
+    printf("one hotel, no router: %.0f requests/s\n", runDirect(requests));
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
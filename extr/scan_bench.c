@@ -0,0 +1,173 @@
+// Scan and memory benchmark for the contiguous room table in hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o scan_bench extr/scan_bench.c hotel_core.c
+// Run:   ./scan_bench [rooms]
+// Fills a hotel with rooms (100k unless given), every other one booked, then builds the same rooms the way the
+// menu kept them before the room table: one malloc'd node a room, holding the guest name and two struct tm, on
+// a linked list. Prints how much resident memory each took (the hotel's share includes the calendars, night
+// bitmaps and indexes, which the list has nothing like) and how many rooms a second a scan for the reserved rooms
+// gets through, over the hot room table alone, over it and the calendars, and over the list (the best of a few
+// runs each). PASS if every scan finds the same rooms.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define BENCH_ROUNDS 5 // Each scan is timed this many times; the best run is printed
+#define LIST_NAME_LENGTH 50 // Guest name length of the old room nodes
+
+// Define a room as the menu kept it before the room table: a node of its own, found by walking the list
+struct ListRoom {
+    int roomNumber; // Room number
+    int isReserved; // Reservation status (1 if reserved, 0 otherwise)
+    char guestName[LIST_NAME_LENGTH]; // Guest's name
+    int duration; // Duration of stay in days
+    int extraServices; // Extra services (1 if requested, 0 otherwise)
+    int occupancy; // Number of people staying in the room
+    struct tm reservationTime; // Time of reservation
+    struct tm cancellationTime; // Time of cancellation
+    struct ListRoom* next; // Next room in the list
+};
+
+// Function to read the resident set size of the process, in kilobytes (0 if /proc is not there)
+static long residentKilobytes() {
+    long pages = 0, resident = 0;
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (file != NULL) {
+        if (fscanf(file, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(file);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Function to sum the numbers of the reserved rooms in the hot room table (returns how many there are)
+static long long scanTable(const void* rooms, long long* sum) {
+    const struct Hotel* hotel = (const struct Hotel*)rooms;
+    long long count = 0;
+    for (int slot = 0; slot < hotel->roomCount; ++slot) {
+        if (hotel->rooms[slot].bookingCount > 0) {
+            count++;
+            *sum += hotel->rooms[slot].roomNumber;
+        }
+    }
+    return count;
+}
+
+// Function to sum the numbers and nights of the reserved rooms, reading each one's calendar as a report does
+// (returns how many there are)
+static long long scanCalendars(const void* rooms, long long* sum) {
+    const struct Hotel* hotel = (const struct Hotel*)rooms;
+    long long count = 0;
+    for (int slot = 0; slot < hotel->roomCount; ++slot) {
+        const struct Room* room = &hotel->rooms[slot];
+        for (int b = 0; b < room->bookingCount; ++b) {
+            *sum += room->stays[b].checkOut - room->stays[b].checkIn;
+        }
+        if (room->bookingCount > 0) {
+            count++;
+            *sum += room->roomNumber;
+        }
+    }
+    return count;
+}
+
+// Function to sum the numbers of the reserved rooms on the list (returns how many there are)
+static long long scanList(const void* rooms, long long* sum) {
+    const struct ListRoom* head = (const struct ListRoom*)rooms;
+    long long count = 0;
+    for (const struct ListRoom* room = head; room != NULL; room = room->next) {
+        if (room->isReserved) {
+            count++;
+            *sum += room->roomNumber;
+        }
+    }
+    return count;
+}
+
+// Function to sum the numbers and nights of the reserved rooms on the list (returns how many there are)
+static long long scanListStays(const void* rooms, long long* sum) {
+    const struct ListRoom* head = (const struct ListRoom*)rooms;
+    long long count = 0;
+    for (const struct ListRoom* room = head; room != NULL; room = room->next) {
+        if (room->isReserved) {
+            count++;
+            *sum += room->roomNumber + room->duration;
+        }
+    }
+    return count;
+}
+
+// Function to print the best of BENCH_ROUNDS timed scans (returns the reserved rooms the scan found)
+static long long timeScan(const char* name, long long (*scan)(const void*, long long*), const void* rooms, int roomCount,
+                          long long* sum) {
+    long long best = 0, found = 0;
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        *sum = 0;
+        long long started = nowNanoseconds();
+        found = scan(rooms, sum);
+        long long elapsed = nowNanoseconds() - started;
+        best = round == 0 || elapsed < best ? elapsed : best;
+    }
+    printf("%-22s %9.3f ms  %8.1f M rooms/s  (%lld reserved)\n", name, best / 1e6, roomCount / (best / 1e9) / 1e6, found);
+    return found;
+}
+
+int main(int argc, char* argv[]) {
+    int rooms = argc > 1 ? atoi(argv[1]) : 100000;
+    char guestName[32];
+    long long tableSum, calendarSum, listSum, listStaySum;
+    rooms = rooms < 2 ? 2 : rooms;
+
+    long long started = nowNanoseconds();
+    long before = residentKilobytes();
+    struct Hotel* hotel = hotelCreate();
+    for (int r = 0; r < rooms; ++r) {
+        hotelAddRoom(hotel, r);
+        if (r % 2 == 0) {
+            snprintf(guestName, sizeof(guestName), "Guest %d", r % 5000);
+            hotelReserve(hotel, r, guestName, hotelToday() + 1 + r % 30, 1 + r % 5, r % 3 == 0, 1 + r % 2);
+        }
+    }
+    long tableKilobytes = residentKilobytes() - before;
+    double tableSeconds = (nowNanoseconds() - started) / 1e9;
+
+    started = nowNanoseconds();
+    before = residentKilobytes();
+    struct ListRoom* head = NULL;
+    for (int r = rooms - 1; r >= 0; --r) { // Pushed on the front, so the list runs in room order
+        struct ListRoom* room = (struct ListRoom*)calloc(1, sizeof(struct ListRoom));
+        room->roomNumber = r;
+        room->isReserved = r % 2 == 0;
+        if (room->isReserved) {
+            snprintf(room->guestName, sizeof(room->guestName), "Guest %d", r % 5000);
+            room->duration = 1 + r % 5;
+            room->extraServices = r % 3 == 0;
+            room->occupancy = 1 + r % 2;
+        }
+        room->next = head;
+        head = room;
+    }
+    long listKilobytes = residentKilobytes() - before;
+    double listSeconds = (nowNanoseconds() - started) / 1e9;
+
+    printf("%d rooms, %d booked; sizeof(struct Room) %zu + sizeof(struct RoomDetails) %zu, sizeof(struct ListRoom) %zu\n",
+           rooms, (rooms + 1) / 2, sizeof(struct Room), sizeof(struct RoomDetails), sizeof(struct ListRoom));
+    printf("hotel     : %8ld KB resident (%.0f bytes a room), built in %.3f s\n", tableKilobytes, tableKilobytes * 1024.0 / rooms,
+           tableSeconds);
+    printf("room list : %8ld KB resident (%.0f bytes a room), built in %.3f s\n", listKilobytes, listKilobytes * 1024.0 / rooms,
+           listSeconds);
+    long long reserved = timeScan("table, hot fields", scanTable, hotel, rooms, &tableSum);
+    long long withStays = timeScan("table and calendars", scanCalendars, hotel, rooms, &calendarSum);
+    long long listed = timeScan("list", scanList, head, rooms, &listSum);
+    long long listedStays = timeScan("list, with durations", scanListStays, head, rooms, &listStaySum);
+
+    int problems = reserved != (rooms + 1) / 2 || withStays != reserved || listed != reserved || listedStays != reserved;
+    problems += tableSum != listSum || calendarSum != listStaySum;
+    while (head != NULL) {
+        struct ListRoom* next = head->next;
+        free(head);
+        head = next;
+    }
+    hotelDestroy(hotel);
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
@@ -0,0 +1,273 @@
+// End-to-end test of the HTTP server started by Hotel_Reservation_System --serve
+// Build: gcc -std=c99 -O2 -o server_test extr/server_test.c
+// Run:   ./server_test PROGRAM LOAD_GENERATOR [connections] [requests per connection]
+// Starts PROGRAM --serve on a free port of 127.0.0.1 in an empty temporary directory, then runs LOAD_GENERATOR
+// against it (4 connections of 100 requests unless given, on 50 rooms) and reads its status counts: every
+// request must be answered, none with a 5xx, and most with a 2xx. Then speaks HTTP to the server itself:
+// malformed JSON bodies get 400 and leave the connection open, a Content-Length larger than the server's buffer
+// gets 413 and the connection closed, and requests pipelined on one keep-alive connection in a single write are
+// answered in order. Finally stops the server with SIGTERM. PASS if every check held and the server exited 0.
+#define _XOPEN_SOURCE 700 // Expose mkdtemp, realpath, kill and the socket calls under a strict -std=c99 build
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define TEST_BUFFER_SIZE 16384 // Bytes of responses read at once
+#define TEST_STARTS 3 // Ports tried, in case another process takes the free one first
+#define TEST_ROOMS 50 // Rooms the load generator adds
+
+static int problems = 0; // Checks that failed
+
+// Function to report a check that failed
+static void check(int holds, const char* what) {
+    if (!holds) {
+        printf("FAILED: %s\n", what);
+        problems++;
+    }
+}
+
+// Function to find a port nobody listens on, by binding port 0 (returns 0 if there is none)
+static int findFreePort(void) {
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    int descriptor = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int port = descriptor >= 0 && bind(descriptor, (struct sockaddr*)&address, sizeof(address)) == 0
+               && getsockname(descriptor, (struct sockaddr*)&address, &length) == 0 ? ntohs(address.sin_port) : 0;
+    if (descriptor >= 0) {
+        close(descriptor);
+    }
+    return port;
+}
+
+// Function to connect to the server, with reads timing out after five seconds (returns -1 if it does not answer)
+static int connectServer(int port) {
+    struct sockaddr_in address;
+    struct timeval timeout = {5, 0};
+    int descriptor = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (descriptor < 0 || connect(descriptor, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        if (descriptor >= 0) {
+            close(descriptor);
+        }
+        return -1;
+    }
+    setsockopt(descriptor, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)); // A missing response fails, not hangs
+    return descriptor;
+}
+
+// Function to start PROGRAM --serve in a directory and wait until it accepts connections (returns its pid, or -1)
+static pid_t startServer(const char* program, const char* directory, int* port) {
+    char number[16];
+    for (int attempt = 0; attempt < TEST_STARTS; ++attempt) {
+        *port = findFreePort();
+        snprintf(number, sizeof(number), "%d", *port);
+        pid_t child = fork();
+        if (child == 0) {
+            if (chdir(directory) != 0) {
+                _exit(127);
+            }
+            execl(program, program, "--serve", number, (char*)NULL);
+            _exit(127);
+        }
+        if (child < 0 || *port == 0) {
+            return -1;
+        }
+        for (int wait = 0; wait < 100; ++wait) { // Up to ten seconds for the snapshot and journal to open
+            int status, descriptor = connectServer(*port);
+            if (descriptor >= 0) {
+                close(descriptor);
+                return child;
+            }
+            if (waitpid(child, &status, WNOHANG) == child) { // Could not listen: the port went to someone else
+                break;
+            }
+            struct timespec pause = {0, 100000000};
+            nanosleep(&pause, NULL);
+        }
+        kill(child, SIGKILL);
+        waitpid(child, NULL, 0);
+    }
+    return -1;
+}
+
+// Function to send a whole request (returns 1 on success)
+static int sendText(int descriptor, const char* text) {
+    size_t length = strlen(text), sent = 0;
+    while (sent < length) {
+        ssize_t n = send(descriptor, text + sent, length - sent, MSG_NOSIGNAL);
+        if (n <= 0 && errno != EINTR) {
+            return 0;
+        }
+        sent += n > 0 ? (size_t)n : 0;
+    }
+    return 1;
+}
+
+// Function to read up to count responses into codes, in the order they arrive (returns the number read; fewer
+// if the server closed the connection or stopped answering)
+static int readResponses(int descriptor, int* codes, int count, int* closed) {
+    static char buffer[TEST_BUFFER_SIZE + 1];
+    size_t received = 0;
+    int found = 0;
+    *closed = 0;
+    while (found < count) {
+        buffer[received] = '\0';
+        char* body = strstr(buffer, "\r\n\r\n");
+        char* lengthHeader = strstr(buffer, "Content-Length: ");
+        if (body != NULL && lengthHeader != NULL && lengthHeader < body
+            && received >= (size_t)(body + 4 - buffer) + (size_t)atol(lengthHeader + 16)) {
+            size_t used = (size_t)(body + 4 - buffer) + (size_t)atol(lengthHeader + 16);
+            codes[found++] = strncmp(buffer, "HTTP/1.1 ", 9) == 0 ? atoi(buffer + 9) : 0;
+            memmove(buffer, buffer + used, received - used);
+            received -= used;
+            continue;
+        }
+        if (received == TEST_BUFFER_SIZE) {
+            break;
+        }
+        ssize_t n = recv(descriptor, buffer + received, TEST_BUFFER_SIZE - received, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            *closed = n == 0;
+            break;
+        }
+        received += (size_t)n;
+    }
+    return found;
+}
+
+// Function to run LOAD_GENERATOR against the server and check its status counts
+static void runLoad(const char* generator, int port, int connections, int requests) {
+    char command[4200], line[256];
+    long long total = -1, success = -1, rejected = -1, errors = -1, failed = -1;
+    snprintf(command, sizeof(command), "'%s' %d %d %d %d", generator, port, connections, requests, TEST_ROOMS);
+    FILE* output = popen(command, "r");
+    if (output == NULL) {
+        check(0, "the load generator could not be run");
+        return;
+    }
+    while (fgets(line, sizeof(line), output) != NULL) {
+        fputs(line, stdout);
+        sscanf(line, "%lld requests over", &total);
+        sscanf(line, "responses 2xx %lld 4xx %lld 5xx %lld failed %lld", &success, &rejected, &errors, &failed);
+    }
+    int status = pclose(output);
+    long long expected = (long long)connections * requests;
+    check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "the load generator reported failures");
+    check(total == expected, "the load generator did not send every request");
+    check(errors == 0 && failed == 0, "some load requests got a 5xx or no answer");
+    check(success + rejected == expected, "the status counts do not add up to the requests sent");
+    check(success * 2 >= expected, "fewer than half the load requests succeeded"); // 4xx are only double bookings
+}
+
+// Function to send requests in one write and check the status codes they are answered with
+static void expectCodes(int port, const char* name, const char* requests, const int* expected, int count, int closes) {
+    int codes[16], closed = 0, found = 0;
+    char what[160];
+    int descriptor = connectServer(port);
+    if (descriptor >= 0 && sendText(descriptor, requests)) {
+        found = readResponses(descriptor, codes, closes ? count + 1 : count, &closed); // One more sees it close
+    }
+    int matches = descriptor >= 0 && found == count;
+    for (int i = 0; matches && i < count; ++i) {
+        matches = codes[i] == expected[i];
+    }
+    printf("%-24s", name);
+    for (int i = 0; i < found; ++i) {
+        printf(" %d", codes[i]);
+    }
+    printf("%s\n", closed ? " (closed)" : "");
+    snprintf(what, sizeof(what), "%s: the responses differ from the expected ones", name);
+    check(matches, what);
+    snprintf(what, sizeof(what), "%s: the connection %s", name, closes ? "stayed open" : "was closed");
+    check(closes == closed, what);
+    if (descriptor >= 0) {
+        close(descriptor);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s PROGRAM LOAD_GENERATOR [connections] [requests per connection]\n", argv[0]);
+        return 1;
+    }
+    char absolute[4096], program[4096], generator[4096], scratch[] = "/tmp/server_test.XXXXXX", checkIn[16];
+    char requests[4096], command[1100];
+    snprintf(program, sizeof(program), "%s", realpath(argv[1], absolute) != NULL ? absolute : argv[1]); // It serves elsewhere
+    snprintf(generator, sizeof(generator), "%s", argv[2]);
+    int connections = argc > 3 ? atoi(argv[3]) : 4;
+    int perConnection = argc > 4 ? atoi(argv[4]) : 100;
+    int port = 0, status = 0;
+    connections = connections < 1 ? 1 : connections;
+    perConnection = perConnection < 1 ? 1 : perConnection;
+    if (mkdtemp(scratch) == NULL) {
+        fprintf(stderr, "Cannot make a scratch directory.\n");
+        return 1;
+    }
+    pid_t server = startServer(program, scratch, &port);
+    if (server < 0) {
+        fprintf(stderr, "%s --serve did not start.\n", program);
+        return 1;
+    }
+    printf("serving on port %d\n", port);
+
+    runLoad(generator, port, connections, perConnection);
+
+    static const int malformed[] = {400, 400, 400, 200};
+    expectCodes(port, "malformed JSON", // Cut short, not an object, a missing value, then a good request
+                "POST /reservations HTTP/1.1\r\nContent-Length: 22\r\n\r\n{\"room\":1,\"guest\":\"Ann"
+                "POST /rooms HTTP/1.1\r\nContent-Length: 8\r\n\r\nnot json"
+                "POST /rooms HTTP/1.1\r\nContent-Length: 9\r\n\r\n{\"room\":}"
+                "GET /totals HTTP/1.1\r\n\r\n",
+                malformed, 4, 0);
+
+    static const int tooLarge[] = {413};
+    expectCodes(port, "oversized Content-Length",
+                "POST /rooms HTTP/1.1\r\nContent-Length: 1000000\r\n\r\n{\"room\":9000}", tooLarge, 1, 1);
+
+    time_t day = time(NULL) + 10 * 86400;
+    struct tm date;
+    gmtime_r(&day, &date); // As the load generator dates its stays
+    strftime(checkIn, sizeof(checkIn), "%Y-%m-%d", &date);
+    char reservation[128], cancellation[128];
+    int reservationLength = snprintf(reservation, sizeof(reservation),
+                                     "{\"room\":9001,\"guest\":\"Pipelined\",\"checkIn\":\"%s\",\"nights\":2}", checkIn);
+    int cancellationLength = snprintf(cancellation, sizeof(cancellation),
+                                      "{\"room\":9001,\"guest\":\"Pipelined\",\"checkIn\":\"%s\"}", checkIn);
+    snprintf(requests, sizeof(requests),
+             "POST /rooms HTTP/1.1\r\nContent-Length: 13\r\n\r\n{\"room\":9001}"
+             "POST /reservations HTTP/1.1\r\nContent-Length: %d\r\n\r\n%s"
+             "POST /reservations HTTP/1.1\r\nContent-Length: %d\r\n\r\n%s"
+             "GET /availability?checkIn=%s&nights=2&people=1 HTTP/1.1\r\n\r\n"
+             "POST /cancellations HTTP/1.1\r\nContent-Length: %d\r\n\r\n%s"
+             "POST /cancellations HTTP/1.1\r\nConnection: close\r\nContent-Length: %d\r\n\r\n%s",
+             reservationLength, reservation, reservationLength, reservation, checkIn, cancellationLength, cancellation,
+             cancellationLength, cancellation);
+    static const int pipelined[] = {201, 201, 409, 200, 200, 404}; // The second booking and cancellation find it taken, then gone
+    expectCodes(port, "pipelined keep-alive", requests, pipelined, 6, 1);
+
+    kill(server, SIGTERM);
+    check(waitpid(server, &status, 0) == server && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+          "the server did not stop cleanly on SIGTERM");
+    snprintf(command, sizeof(command), "rm -rf '%s'", scratch); // Its snapshot, journal and metrics
+    problems += system(command) != 0;
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
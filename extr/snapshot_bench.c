@@ -0,0 +1,101 @@
+// Snapshot benchmark for saveSnapshot and loadSnapshot in hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o snapshot_bench extr/snapshot_bench.c hotel_core.c
+// Run:   ./snapshot_bench [rooms] [bookings per room]
+// Fills a hotel (100k rooms unless given, with three bookings a room unless given), then saves it to a temporary
+// snapshot and loads it back into an empty hotel a few times, timing each and, for comparison, building the same
+// hotel again booking by booking as a restart without a snapshot would have to. Prints the snapshot size and the
+// best save, load and rebuild times. PASS if every loaded hotel holds the same rooms and bookings as the saved one
+// and answers a free-room search the same way.
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define BENCH_ROUNDS 5 // Saves and loads timed; the best of each is printed
+#define BENCH_NIGHTS 300 // Nights from tomorrow the bookings fall in
+#define BENCH_GUESTS 5000 // Distinct guest names
+
+// Function to book the bench's stays into a hotel with its rooms (returns the bookings made)
+static long long bookRooms(struct Hotel* hotel, int rooms, int perRoom) {
+    unsigned int seed = 2463534242u;
+    char guestName[32];
+    long long bookings = 0;
+    for (int r = 0; r < rooms; ++r) {
+        for (int b = 0; b < perRoom; ++b) {
+            snprintf(guestName, sizeof(guestName), "Guest %d", (int)(nextRandom(&seed) % BENCH_GUESTS));
+            int checkIn = hotelToday() + 1 + (int)(nextRandom(&seed) % BENCH_NIGHTS);
+            bookings += hotelReserve(hotel, r, guestName, checkIn, 1 + (int)(nextRandom(&seed) % 5), b % 2, 1 + b % 3) == HOTEL_OK;
+        }
+    }
+    return bookings;
+}
+
+// Function to check that a loaded hotel holds what the saved one did (returns the differences found)
+static int compareHotels(struct Hotel* saved, struct Hotel* loaded) {
+    int differences = hotelRoomCount(loaded) != hotelRoomCount(saved);
+    for (int slot = 0; slot < saved->roomCount && !differences; ++slot) {
+        const struct Room* room = &saved->rooms[slot];
+        int other = findRoom(loaded, room->roomNumber);
+        differences += other < 0 || loaded->rooms[other].bookingCount != room->bookingCount
+                       || memcmp(loaded->rooms[other].stays, room->stays, room->bookingCount * sizeof(struct Stay)) != 0;
+    }
+    differences += hotelFindGuest(loaded, "Guest 17", NULL, 0) != hotelFindGuest(saved, "Guest 17", NULL, 0);
+    differences += hotelFindFreeRooms(loaded, hotelToday() + 10, 3, 1, NULL, 0) != hotelFindFreeRooms(saved, hotelToday() + 10, 3, 1, NULL, 0);
+    differences += !checkTotals(loaded);
+    return differences;
+}
+
+int main(int argc, char* argv[]) {
+    int rooms = argc > 1 ? atoi(argv[1]) : 100000;
+    int perRoom = argc > 2 ? atoi(argv[2]) : 3;
+    char path[] = "/tmp/snapshot_bench.XXXXXX";
+    long long bestSave = 0, bestLoad = 0, started;
+    int problems = 0;
+    rooms = rooms < 1 ? 1 : rooms;
+    perRoom = perRoom < 0 ? 0 : perRoom;
+
+    int descriptor = mkstemp(path);
+    if (descriptor < 0) {
+        fprintf(stderr, "Cannot make a snapshot file.\n");
+        return 1;
+    }
+    close(descriptor);
+
+    started = nowNanoseconds();
+    struct Hotel* hotel = hotelCreate();
+    for (int r = 0; r < rooms; ++r) {
+        hotelAddRoom(hotel, r);
+    }
+    long long bookings = bookRooms(hotel, rooms, perRoom);
+    long long rebuild = nowNanoseconds() - started;
+
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        started = nowNanoseconds();
+        problems += saveSnapshot(hotel, path) != 1;
+        long long elapsed = nowNanoseconds() - started;
+        bestSave = round == 0 || elapsed < bestSave ? elapsed : bestSave;
+
+        started = nowNanoseconds();
+        struct Hotel* loaded = hotelCreate();
+        problems += loadSnapshot(loaded, path) != 1;
+        elapsed = nowNanoseconds() - started;
+        bestLoad = round == 0 || elapsed < bestLoad ? elapsed : bestLoad;
+        problems += compareHotels(hotel, loaded);
+        hotelDestroy(loaded);
+    }
+    long long size = 0;
+    FILE* file = fopen(path, "rb");
+    if (file != NULL && fseek(file, 0, SEEK_END) == 0) {
+        size = ftell(file);
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+    remove(path);
+
+    printf("%d rooms, %lld bookings; snapshot of %.1f MB\n", rooms, bookings, size / 1e6);
+    printf("%-14s %10.3f ms  (%6.0f MB/s)\n", "saveSnapshot", bestSave / 1e6, size / 1e6 / (bestSave / 1e9));
+    printf("%-14s %10.3f ms  (%6.0f MB/s)\n", "loadSnapshot", bestLoad / 1e6, size / 1e6 / (bestLoad / 1e9));
+    printf("%-14s %10.3f ms  (%.0fx the load, booking by booking)\n", "rebuild", rebuild / 1e6, (double)rebuild / bestLoad);
+    hotelDestroy(hotel);
+    printf("%s\n", problems == 0 ? "PASS" : "FAIL");
+    return problems == 0 ? 0 : 1;
+}
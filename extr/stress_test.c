@@ -0,0 +1,212 @@
+// Stress test and thread-scaling benchmark for the reservation engine in hotel_core.c
+// Build: gcc -std=c99 -O2 -pthread -o stress_test extr/stress_test.c hotel_core.c
+// Run:   ./stress_test [threads] [operations per thread]
+#include "../hotel_internal.h"
+#include "bench_util.h"
+
+#define STRESS_ROOMS 64 // Few rooms, so the threads keep fighting over the same ones
+#define STRESS_ADDED_ROOMS 4096 // Rooms added while the others book, so the table grows under them
+#define BENCH_ROOMS 100000 // Rooms in the throughput benchmark
+#define MAX_THREADS 64
+
+// Define a booking a worker thread holds
+struct Held {
+    int roomNumber; // Room booked
+    int checkIn; // First night
+    int checkOut; // Night after the last one
+};
+
+// Define the work and results of one worker thread
+struct Worker {
+    struct Hotel* hotel; // Shared hotel
+    int id; // Thread number, part of every guest name
+    int operations; // Reservations and cancellations to attempt
+    int roomCount; // Rooms are numbered 0 to roomCount - 1
+    int journaled; // 1 to wait for the journal after each change, like the front desk does
+    unsigned int seed; // Random number state
+    struct Held* held; // Bookings this thread made and has not cancelled
+    int heldCount; // Number of entries in held
+    long long succeeded; // Changes that went through
+};
+
+static int stopWatching; // Set when the workers are done, to stop the watcher thread
+
+// Function to format the guest name used by a thread for its bookings
+static void guestFor(int id, char* guestName) {
+    snprintf(guestName, MAX_NAME_LENGTH, "Worker %d", id);
+}
+
+// Function to run one worker: random reservations, and cancellations of its own bookings
+static void* runWorker(void* argument) {
+    struct Worker* worker = (struct Worker*)argument;
+    struct Hotel* hotel = worker->hotel;
+    char guestName[MAX_NAME_LENGTH];
+    guestFor(worker->id, guestName);
+    for (int i = 0; i < worker->operations; ++i) {
+        unsigned int r = nextRandom(&worker->seed);
+        if (worker->heldCount > 0 && r % 3 == 0) { // Cancel one of ours
+            int pick = (int)(nextRandom(&worker->seed) % (unsigned int)worker->heldCount);
+            struct Held booking = worker->held[pick];
+            if (releaseRoom(hotel, booking.roomNumber, guestName, booking.checkIn) != HOTEL_OK) {
+                fprintf(stderr, "Worker %d could not cancel its own booking of room %d.\n", worker->id, booking.roomNumber);
+                exit(1);
+            }
+            worker->held[pick] = worker->held[--worker->heldCount];
+            worker->succeeded++;
+        } else {
+            int roomNumber = (int)(nextRandom(&worker->seed) % (unsigned int)worker->roomCount);
+            int checkIn = hotel->calendarStart + (int)(nextRandom(&worker->seed) % (NIGHT_HORIZON + 60)); // Some past the horizon
+            int duration = 1 + (int)(nextRandom(&worker->seed) % 7);
+            if (reserveRoom(hotel, roomNumber, guestName, checkIn, duration, 0, 1) == HOTEL_OK) {
+                worker->held[worker->heldCount].roomNumber = roomNumber;
+                worker->held[worker->heldCount].checkIn = checkIn;
+                worker->held[worker->heldCount].checkOut = checkIn + duration;
+                worker->heldCount++;
+                worker->succeeded++;
+            } else {
+                continue;
+            }
+        }
+        if (worker->journaled && !journalSync(hotel->journal)) {
+            fprintf(stderr, "Journal sync failed.\n");
+            exit(1);
+        }
+    }
+    return NULL;
+}
+
+// Function to keep adding rooms and running queries while the workers book
+static void* runWatcher(void* argument) {
+    struct Hotel* hotel = (struct Hotel*)argument;
+    int added = 0;
+    long long checksum = 0;
+    while (!__atomic_load_n(&stopWatching, __ATOMIC_RELAXED)) {
+        if (added < STRESS_ADDED_ROOMS) {
+            insertRoom(hotel, 1000000 + added++); // Grows the table and index now and then
+        }
+        checksum += countFreeRooms(hotel, hotel->calendarStart, hotel->calendarStart + 3);
+        checksum += countFreeRooms(hotel, hotel->calendarStart + NIGHT_HORIZON, hotel->calendarStart + NIGHT_HORIZON + 2);
+        checksum += countBookedNights(hotel, hotel->calendarStart, hotel->calendarStart + 30);
+    }
+    return (void*)(intptr_t)(checksum & 1);
+}
+
+// Function to check that no night is booked twice and that every calendar, bitmap and worker agree
+// (returns the number of problems found)
+static int checkHotel(struct Hotel* hotel, struct Worker* workers, int threads) {
+    int problems = 0;
+    long long heldTotal = 0, bookedTotal = 0;
+    for (int i = 0; i < hotel->roomCount; ++i) {
+        const struct Room* room = &hotel->rooms[i];
+        for (int b = 0; b < room->bookingCount; ++b) {
+            if (room->stays[b].checkIn >= room->stays[b].checkOut || (b > 0 && room->stays[b - 1].checkOut > room->stays[b].checkIn)) {
+                fprintf(stderr, "Room %d has overlapping stays.\n", room->roomNumber);
+                problems++;
+            }
+        }
+        for (int night = 0; night < NIGHT_HORIZON; ++night) { // The bitmap must match the calendar
+            int day = hotel->calendarStart + night;
+            int onCalendar = !isRoomFree(room, day, day + 1);
+            int inBitmap = (int)((hotel->nights[(night / 64) * hotel->roomCapacity + i] >> (night % 64)) & 1);
+            if (onCalendar != inBitmap) {
+                fprintf(stderr, "Room %d night %d: calendar and bitmap disagree.\n", room->roomNumber, night);
+                problems++;
+            }
+        }
+        bookedTotal += room->bookingCount;
+    }
+    for (int t = 0; t < threads; ++t) { // Every booking a worker holds must be on the calendar, under its name
+        char guestName[MAX_NAME_LENGTH];
+        guestFor(workers[t].id, guestName);
+        for (int h = 0; h < workers[t].heldCount; ++h) {
+            const struct Held* held = &workers[t].held[h];
+            int slot = findRoom(hotel, held->roomNumber);
+            const struct Room* room = &hotel->rooms[slot];
+            int position = findStay(room, held->checkIn);
+            if (position == room->bookingCount || room->stays[position].checkIn != held->checkIn
+                || room->stays[position].checkOut != held->checkOut
+                || strcmp(poolString(&hotel->guests.names, hotel->details[slot].bookings[position].guestName), guestName) != 0) {
+                fprintf(stderr, "Worker %d lost its booking of room %d.\n", workers[t].id, held->roomNumber);
+                problems++;
+            }
+        }
+        heldTotal += workers[t].heldCount;
+    }
+    if (heldTotal != bookedTotal) { // Nothing on the calendars that no worker holds
+        fprintf(stderr, "%lld bookings on the calendars, but the workers hold %lld.\n", bookedTotal, heldTotal);
+        problems++;
+    }
+    return problems;
+}
+
+// Function to run workers on a fresh hotel (returns the changes per second; problems are added to *problems)
+static double runRound(int threads, int operations, int roomCount, int journaled, int stress, int* problems) {
+    struct Hotel hotel;
+    struct Journal journal;
+    struct Worker workers[MAX_THREADS];
+    pthread_t handles[MAX_THREADS], watcher;
+    initHotel(&hotel);
+    for (int r = 0; r < roomCount; ++r) {
+        insertRoom(&hotel, r);
+    }
+    if (journaled) {
+        remove("stress.journal");
+        if (!openJournal(&journal, "stress.journal", 1, JOURNAL_MAX_LATENCY_US)) {
+            fprintf(stderr, "Cannot open stress.journal.\n");
+            exit(1);
+        }
+        hotel.journal = &journal;
+    }
+    for (int t = 0; t < threads; ++t) {
+        workers[t] = (struct Worker){ &hotel, t, operations, roomCount, journaled, 2463534242u + 7919u * t, NULL, 0, 0 };
+        workers[t].held = (struct Held*)malloc((operations + 1) * sizeof(struct Held));
+    }
+    __atomic_store_n(&stopWatching, 0, __ATOMIC_RELAXED);
+    if (stress) {
+        pthread_create(&watcher, NULL, runWatcher, &hotel);
+    }
+    double started = nowSeconds();
+    for (int t = 0; t < threads; ++t) {
+        pthread_create(&handles[t], NULL, runWorker, &workers[t]);
+    }
+    long long succeeded = 0;
+    for (int t = 0; t < threads; ++t) {
+        pthread_join(handles[t], NULL);
+        succeeded += workers[t].succeeded;
+    }
+    double elapsed = nowSeconds() - started;
+    __atomic_store_n(&stopWatching, 1, __ATOMIC_RELAXED);
+    if (stress) {
+        pthread_join(watcher, NULL);
+        *problems += checkHotel(&hotel, workers, threads);
+    }
+    for (int t = 0; t < threads; ++t) {
+        free(workers[t].held);
+    }
+    if (journaled) {
+        closeJournal(&journal);
+        remove("stress.journal");
+    }
+    freeHotel(&hotel);
+    return succeeded / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    int maxThreads = argc > 1 ? atoi(argv[1]) : 8;
+    int operations = argc > 2 ? atoi(argv[2]) : 200000;
+    int problems = 0;
+    maxThreads = maxThreads < 1 ? 1 : (maxThreads > MAX_THREADS ? MAX_THREADS : maxThreads);
+
+    for (int round = 0; round < 5; ++round) {
+        runRound(maxThreads, operations, STRESS_ROOMS, 0, 1, &problems);
+    }
+    printf("%s: %d threads on %d rooms, 5 rounds, %d problems\n", problems == 0 ? "PASS" : "FAIL", maxThreads, STRESS_ROOMS, problems);
+
+    printf("threads  changes/s  journaled changes/s\n");
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        double plain = runRound(threads, operations, BENCH_ROOMS, 0, 0, &problems);
+        double journaled = runRound(threads, operations / 20, BENCH_ROOMS, 1, 0, &problems);
+        printf("%7d  %9.0f  %19.0f\n", threads, plain, journaled);
+    }
+    return problems == 0 ? 0 : 1;
+}
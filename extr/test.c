@@ -1,237 +1,1323 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-#define MAX_NAME_LENGTH 50
-#define PRICE_PER_NIGHT 5000
-#define EXTRA_SERVICES_COST 1000
-
-// Define a structure for a room in the hotel
-struct Room {
-    int roomNumber; // Room number
-    int isReserved; // Reservation status (1 if reserved, 0 otherwise)
-    char guestName[MAX_NAME_LENGTH]; // Guest's name
-    int duration; // Duration of stay in days
-    int extraServices; // Extra services (1 if requested, 0 otherwise)
-    int occupancy; // Number of people staying in the room
-    struct Room* next; // Pointer to the next room in the list
-};
+// Tests for the reservation core in hotel_core.c, run by ctest (or by hand: ./hotel_test [extr directory])
+// Build: gcc -std=c99 -O2 -pthread -o hotel_test extr/test.c hotel_core.c
+// Each check that fails prints its line; the program exits with 1 if any did. Snapshot and journal files
+// are written to a fresh directory under /tmp and removed afterwards.
+#include "../hotel_internal.h"
+#include <sys/stat.h>
 
-// Function prototypes
-struct Room* createRoom(int roomNumber);
-void addRoom(struct Room** head, int roomNumber);
-void makeReservation(struct Room* head, int roomNumber, const char* guestName, int duration, int extraServices, int occupancy);
-void cancelReservation(struct Room* head, int roomNumber, const char* guestName);
-void viewReservations(struct Room* head);
-void viewRoomDetails(struct Room* head);
-void freeRooms(struct Room* head);
-void displayMenu();
-void printHeader(const char* title);
-void printLine(char ch, int length);
-
-// Function to create a new room with given room number
-struct Room* createRoom(int roomNumber) {
-    struct Room* newRoom = (struct Room*)malloc(sizeof(struct Room)); // Allocate memory for a new room
-    newRoom->roomNumber = roomNumber; // Set the room number
-    newRoom->isReserved = 0; // Initialize reservation status to not reserved
-    newRoom->guestName[0] = '\0'; // Initialize guest name to empty string
-    newRoom->duration = 0; // Initialize duration to 0
-    newRoom->extraServices = 0; // Initialize extra services to not requested
-    newRoom->occupancy = 0; // Initialize occupancy to 0
-    newRoom->next = NULL; // Initialize next pointer to NULL
-    return newRoom; // Return the pointer to the new room
-}
-
-// Function to add a new room to the hotel
-void addRoom(struct Room** head, int roomNumber) {
-    struct Room* newRoom = createRoom(roomNumber); // Create a new room
-    newRoom->next = *head; // Link the new room to the existing list
-    *head = newRoom; // Make the new room the head of the list
-    printHeader("Add Room");
-    printf("Room %d added successfully.\n", roomNumber); // Print confirmation
-    printLine('-', 30);
-}
-
-// Function to make a reservation
-void makeReservation(struct Room* head, int roomNumber, const char* guestName, int duration, int extraServices, int occupancy) {
-    struct Room* temp = head; // Temporary pointer to traverse the list
-    while (temp != NULL) { // Traverse the list
-        if (temp->roomNumber == roomNumber) { // Check if the room number matches
-            if (!temp->isReserved) { // Check if the room is not already reserved
-                temp->isReserved = 1; // Set the reservation status to reserved
-                strncpy(temp->guestName, guestName, MAX_NAME_LENGTH); // Set the guest name
-                temp->guestName[MAX_NAME_LENGTH - 1] = '\0'; // Ensure the guest name is null-terminated
-                temp->duration = duration; // Set the duration of stay
-                temp->extraServices = extraServices; // Set the extra services request
-                temp->occupancy = occupancy; // Set the number of people staying
-
-                int totalCost = PRICE_PER_NIGHT * duration; // Calculate the total cost
-                if (extraServices) {
-                    totalCost += EXTRA_SERVICES_COST * duration; // Add extra services cost if requested
-                }
-
-                // Print the receipt
-                printHeader("***** Receipt *****");
-                printf("* Guest Name          : %s\n", guestName);
-                printf("* Room Number         : %d\n", roomNumber);
-                printf("* Duration of Stay    : %d days\n", duration);
-                printf("* Number of People    : %d\n", occupancy);
-                printf("* Price per Night     : %d PKR\n", PRICE_PER_NIGHT);
-                if (extraServices) {
-                    printf("* Extra Services      : %d PKR per night\n", EXTRA_SERVICES_COST);
-                }
-                printf("* Total Cost          : %d PKR\n", totalCost);
-                printLine('*', 30);
-            } else {
-                printHeader("Error");
-                printf("Room %d is already reserved.\n", roomNumber); // Print error if room is already reserved
-                printLine('-', 30);
-            }
-            return; // Exit the function
+#define TEST_THREADS 4 // Threads booking at once in testConcurrentBookings
+#define TEST_THREAD_ROOMS 256 // Rooms each of those threads books
+#define TEST_PROPERTIES 300 // Properties behind the router in testRouter, each with rooms 101 to 108
+
+#define CHECK(condition) check((condition) != 0, #condition, __FILE__, __LINE__)
+
+static int checks = 0; // Checks made
+static int failures = 0; // Checks that failed
+static const char* extrDirectory = "extr"; // Where sample_rates.txt is
+static char workDirectory[64]; // Scratch directory for snapshots and journals
+
+// Function to record the outcome of one check
+static void check(int passed, const char* condition, const char* file, int line) {
+    checks++;
+    if (!passed) {
+        failures++;
+        fprintf(stderr, "%s:%d: check failed: %s\n", file, line, condition);
+    }
+}
+
+// Function to build the path of a scratch file
+static const char* workPath(const char* name, char* path, size_t size) {
+    snprintf(path, size, "%s/%s", workDirectory, name);
+    return path;
+}
+
+// Function to find a booking of a room through the C interface (returns its position, or -1)
+static int findBooking(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn) {
+    struct HotelBooking bookings[64];
+    int count = hotelListBookings(hotel, roomNumber, bookings, 64);
+    for (int b = 0; b < count && b < 64; ++b) {
+        if (bookings[b].checkIn == checkIn && strcmp(bookings[b].guestName, guestName) == 0) {
+            return b;
         }
-        temp = temp->next; // Move to the next room
-    }
-    printHeader("Error");
-    printf("Room %d not found.\n", roomNumber); // Print error if room number not found
-    printLine('-', 30);
-}
-
-// Function to cancel a reservation
-void cancelReservation(struct Room* head, int roomNumber, const char* guestName) {
-    struct Room* temp = head; // Temporary pointer to traverse the list
-    while (temp != NULL) { // Traverse the list
-        if (temp->roomNumber == roomNumber) { // Check if the room number matches
-            if (temp->isReserved && strcmp(temp->guestName, guestName) == 0) { // Check if the reservation matches
-                temp->isReserved = 0; // Set the reservation status to not reserved
-                temp->guestName[0] = '\0'; // Clear the guest name
-                temp->duration = 0; // Reset the duration
-                temp->extraServices = 0; // Reset the extra services
-                temp->occupancy = 0; // Reset the occupancy
-                printHeader("Cancel Reservation");
-                printf("Reservation for %s in room %d canceled.\n", guestName, roomNumber); // Print confirmation
-                printLine('-', 30);
-            } else {
-                printHeader("Error");
-                printf("Reservation not found for %s in room %d.\n", guestName, roomNumber); // Print error if reservation not found
-                printLine('-', 30);
+    }
+    return -1;
+}
+
+// Function to test date conversion and parsing
+static void testDates() {
+    int day, year, month, dayOfMonth;
+    char text[11];
+    CHECK(dayFromDate(1970, 1, 1) == 0);
+    CHECK(dayFromDate(2000, 3, 1) - dayFromDate(2000, 2, 28) == 2); // 2000 was a leap year
+    CHECK(dayFromDate(2100, 3, 1) - dayFromDate(2100, 2, 28) == 1); // 2100 will not be
+    dateFromDay(dayFromDate(2026, 12, 31), &year, &month, &dayOfMonth);
+    CHECK(year == 2026 && month == 12 && dayOfMonth == 31);
+    CHECK(parseDate("2026-07-01", &day) && day == dayFromDate(2026, 7, 1));
+    CHECK(!parseDate("2026-02-30", &day));
+    CHECK(!parseDate("2026-13-01", &day));
+    CHECK(!parseDate("tomorrow", &day));
+    hotelFormatDate(dayFromDate(2026, 3, 9), text);
+    CHECK(strcmp(text, "2026-03-09") == 0);
+}
+
+// Function to test adding rooms
+static void testRooms() {
+    struct Hotel* hotel = hotelCreate();
+    int numbers[8];
+
+    // Test Case 1: Add a room
+    CHECK(hotelAddRoom(hotel, 101) == HOTEL_OK);
+    CHECK(hotelRoomCount(hotel) == 1);
+
+    // Test Case 2: Attempt to add the same room number
+    CHECK(hotelReserve(hotel, 101, "John Doe", hotelToday(), 1, 0, 1) == HOTEL_OK);
+    CHECK(hotelAddRoom(hotel, 101) == HOTEL_ROOM_EXISTS);
+    CHECK(hotelRoomCount(hotel) == 1);
+    CHECK(hotelListBookings(hotel, 101, NULL, 0) == 1); // The first room, booking and all, is untouched
+
+    CHECK(hotelListBookings(hotel, 102, NULL, 0) == -1);
+    for (int room = 200; room < 205; ++room) {
+        CHECK(hotelAddRoom(hotel, room) == HOTEL_OK);
+    }
+    int listed = hotelListRooms(hotel, hotelRoomCount(hotel) - 5, numbers, 8);
+    CHECK(listed == 5 && numbers[0] == 200 && numbers[4] == 204);
+    CHECK(hotelListRooms(hotel, hotelRoomCount(hotel), numbers, 8) == 0);
+    hotelDestroy(hotel);
+}
+
+// Function to write a scratch file (returns its path in path)
+static const char* writeFile(const char* name, const char* text, char* path, size_t size) {
+    FILE* file = fopen(workPath(name, path, size), "w");
+    fputs(text, file);
+    fclose(file);
+    return path;
+}
+
+// Function to test loading many rooms at once from lists, floor ranges and room files
+static void testBulkRooms() {
+    struct Hotel* hotel = hotelCreate();
+    int numbers[] = {7, 8, 7, 9, 8}, listed = 0, added = 0;
+    char path[128];
+    CHECK(hotelAddRooms(hotel, numbers, 5) == 3); // Duplicates within the list are skipped too
+    CHECK(hotelAddRooms(hotel, numbers, 5) == 0);
+    CHECK(hotelAddRooms(hotel, numbers, 0) == 0);
+    CHECK(hotelRoomCount(hotel) == 3);
+
+    CHECK(hotelAddRoomRange(hotel, 1, 40, 1, 60) == 2400); // Floors 1-40, rooms 01-60
+    CHECK(hotelListBookings(hotel, 101, NULL, 0) == 0 && hotelListBookings(hotel, 4060, NULL, 0) == 0);
+    CHECK(hotelListBookings(hotel, 161, NULL, 0) == -1);
+    CHECK(hotelAddRoomRange(hotel, 41, 42, 1, 150) == 300); // 100 or more rooms a floor: 41001-41150, 42001-42150
+    CHECK(hotelListBookings(hotel, 42150, NULL, 0) == 0);
+    CHECK(hotelAddRoomRange(hotel, 1, 40, 1, 60) == 0);
+    CHECK(hotelAddRoomRange(hotel, 5, 4, 1, 60) == -1);
+    CHECK(hotelAddRoomRange(hotel, 1, 100000, 1, 1000) == -1);
+    CHECK(hotelRoomCount(hotel) == 2703);
+
+    writeFile("hotel.rooms", "# Annex\nfloors 50 51 rooms 1 10\nrooms 9000 9004 # Cabins\n\nroom 101\nroom 9000\n", path, sizeof(path));
+    CHECK(hotelImportRooms(hotel, path, &listed, &added) == 1);
+    CHECK(listed == 27 && added == 25);
+    CHECK(hotelListBookings(hotel, 5110, NULL, 0) == 0 && hotelListBookings(hotel, 9004, NULL, 0) == 0);
+    writeFile("bad.rooms", "room 1\nroom 2\nrooms 9 3\n", path, sizeof(path));
+    CHECK(hotelImportRooms(hotel, path, &listed, &added) == -3);
+    CHECK(hotelListBookings(hotel, 1, NULL, 0) == -1); // A bad file adds nothing
+    remove(path);
+    workPath("hotel.rooms", path, sizeof(path));
+    remove(path);
+    CHECK(hotelImportRooms(hotel, path, &listed, &added) == 0);
+    CHECK(hotelRoomCount(hotel) == 2728);
+    hotelDestroy(hotel);
+}
+
+// Function to test making and cancelling reservations
+static void testReservations() {
+    struct Hotel* hotel = hotelCreate();
+    int start = hotelToday() + 10;
+    char longName[HOTEL_MAX_NAME_LENGTH + 1];
+    memset(longName, 'x', HOTEL_MAX_NAME_LENGTH);
+    longName[HOTEL_MAX_NAME_LENGTH] = '\0';
+    hotelAddRoom(hotel, 101);
+
+    // Test Case 3: Make a reservation
+    CHECK(hotelReserve(hotel, 101, "John Doe", start, 3, 0, 2) == HOTEL_OK);
+    CHECK(findBooking(hotel, 101, "John Doe", start) == 0);
+
+    // Test Case 4: Make a reservation for a non-existing room
+    CHECK(hotelReserve(hotel, 102, "Jane Smith", start, 5, 1, 3) == HOTEL_ROOM_NOT_FOUND);
+
+    // Test Case 5: Make a reservation for an already reserved room (any overlapping night)
+    CHECK(hotelReserve(hotel, 101, "Alice Brown", start, 4, 1, 1) == HOTEL_ROOM_UNAVAILABLE);
+    CHECK(hotelReserve(hotel, 101, "Alice Brown", start - 1, 2, 1, 1) == HOTEL_ROOM_UNAVAILABLE);
+    CHECK(hotelReserve(hotel, 101, "Alice Brown", start + 2, 1, 1, 1) == HOTEL_ROOM_UNAVAILABLE);
+    CHECK(hotelReserve(hotel, 101, "Alice Brown", start + 3, 2, 1, 1) == HOTEL_OK); // Arrives the day John leaves
+    CHECK(hotelReserve(hotel, 101, "Carol White", start - 2, 2, 0, 1) == HOTEL_OK); // Leaves the day John arrives
+    CHECK(hotelListBookings(hotel, 101, NULL, 0) == 3);
+
+    CHECK(hotelReserve(hotel, 101, "Dan Green", start + 30, 1, 0, DEFAULT_ROOM_CAPACITY + 1) == HOTEL_OVER_CAPACITY);
+    CHECK(hotelReserve(hotel, 101, "Dan Green", start + 30, 0, 0, 1) == HOTEL_INVALID_STAY);
+    CHECK(hotelReserve(hotel, 101, longName, start + 30, 1, 0, 1) == HOTEL_INVALID_NAME);
+
+    // Parties of no one, nights past the end of the dates, and stays that would overflow book nothing
+    struct HotelTotals totals;
+    CHECK(hotelReserve(hotel, 101, "Dan Green", start + 30, 2, 0, 0) == HOTEL_INVALID_STAY);
+    CHECK(hotelReserve(hotel, 101, "Dan Green", start + 30, 2, 0, -5) == HOTEL_INVALID_STAY);
+    CHECK(hotelReserve(hotel, 101, "Dan Green", start + 30, -3, 0, 1) == HOTEL_INVALID_STAY);
+    CHECK(hotelReserve(hotel, 101, "Dan Green", start + 30, STAY_MAX_NIGHTS + 1, 0, 1) == HOTEL_INVALID_STAY);
+    CHECK(hotelReserve(hotel, 101, "Dan Green", INT32_MAX - 1, 5, 0, 1) == HOTEL_INVALID_STAY);
+    CHECK(hotelReserve(hotel, 101, "Dan Green", -10, 2, 0, 1) == HOTEL_INVALID_STAY);
+    CHECK(hotelReserve(hotel, 101, "Dan Green", STAY_LAST_DAY, 2, 0, 1) == HOTEL_INVALID_STAY);
+    CHECK(hotelReserve(hotel, 101, "Dan Green", STAY_LAST_DAY, 1, 0, 1) == HOTEL_OK); // The last night there is
+    CHECK(hotelCancel(hotel, 101, "Dan Green", STAY_LAST_DAY) == HOTEL_OK);
+    CHECK(hotelFindFreeRooms(hotel, INT32_MAX - 1, 5, 1, NULL, 0) == 0);
+    hotelTotals(hotel, &totals);
+    CHECK(totals.bookings == 3 && totals.guests == 4 && checkTotals(hotel));
+
+    // Test Case 6: Cancel a reservation
+    CHECK(hotelCancel(hotel, 101, "John Doe", start) == HOTEL_OK);
+    CHECK(findBooking(hotel, 101, "John Doe", start) < 0);
+    CHECK(hotelReserve(hotel, 101, "Eve Black", start, 3, 0, 1) == HOTEL_OK); // The nights are free again
+
+    // Test Case 7: Cancel a reservation for a non-existing room
+    CHECK(hotelCancel(hotel, 102, "Jane Smith", start) == HOTEL_ROOM_NOT_FOUND);
+
+    // Test Case 8: Cancel a reservation with a mismatched guest name or check-in date
+    CHECK(hotelCancel(hotel, 101, "John Doe", start) == HOTEL_BOOKING_NOT_FOUND);
+    CHECK(hotelCancel(hotel, 101, "Eve Black", start + 1) == HOTEL_BOOKING_NOT_FOUND);
+
+    // Test Case 9: View all reservations (in check-in order, with what was booked)
+    struct HotelBooking bookings[8];
+    int count = hotelListBookings(hotel, 101, bookings, 8);
+    CHECK(count == 3);
+    CHECK(bookings[0].checkIn == start - 2 && strcmp(bookings[0].guestName, "Carol White") == 0);
+    CHECK(bookings[1].checkIn == start && bookings[1].checkOut == start + 3 && bookings[1].occupancy == 1);
+    CHECK(bookings[2].checkIn == start + 3 && bookings[2].extraServices == 1);
+    CHECK(bookings[1].reservationTime > 0);
+    CHECK(hotelListBookings(hotel, 101, bookings, 1) == 3); // Tells how many there are even if fewer fit
+
+    // Test Case 10: Look up one booking and one room, as the receipts do
+    struct HotelBooking booking;
+    struct HotelRoom room;
+    CHECK(hotelFindBooking(hotel, 101, start, &booking) == HOTEL_OK && strcmp(booking.guestName, "Eve Black") == 0);
+    CHECK(booking.checkOut == start + 3 && booking.reservationTime == bookings[1].reservationTime);
+    CHECK(hotelFindBooking(hotel, 101, start + 1, &booking) == HOTEL_BOOKING_NOT_FOUND);
+    CHECK(hotelFindBooking(hotel, 102, start, &booking) == HOTEL_ROOM_NOT_FOUND);
+    CHECK(hotelFindRoom(hotel, 101, &room) == 1 && room.roomNumber == 101 && room.bookingCount == 3);
+    CHECK(room.capacity == DEFAULT_ROOM_CAPACITY && room.cancellationTime > 0);
+    CHECK(hotelFindRoom(hotel, 102, &room) == 0);
+    hotelDestroy(hotel);
+}
+
+// Function to test the availability searches and night counts
+static void testAvailability() {
+    struct Hotel* hotel = hotelCreate();
+    int start = hotelToday() + 5, numbers[64];
+    for (int room = 1; room <= 50; ++room) {
+        hotelAddRoom(hotel, room);
+    }
+    for (int room = 1; room <= 20; ++room) {
+        CHECK(hotelReserve(hotel, room, "Group", start, 2, 0, 1) == HOTEL_OK);
+    }
+    CHECK(hotelFindFreeRooms(hotel, start, 1, 1, numbers, 64) == 30);
+    CHECK(hotelFindFreeRooms(hotel, start + 2, 1, 1, numbers, 64) == 50);
+    CHECK(hotelFindFreeRooms(hotel, start, 1, DEFAULT_ROOM_CAPACITY + 1, numbers, 64) == 0);
+    CHECK(hotelFindFreeRooms(hotel, start, 0, 1, numbers, 64) == 0);
+    CHECK(hotelFindFreeRooms(hotel, start, 1, 1, numbers, 4) == 30); // Counts them all, copies only four
+    int booked = 0;
+    for (int r = 0; r < 4; ++r) {
+        booked += numbers[r] <= 20;
+    }
+    CHECK(booked == 0);
+    CHECK(countFreeRooms(hotel, start, start + 2) == 30);
+    CHECK(countBookedNights(hotel, start, start + 10) == 40);
+    hotelDestroy(hotel);
+}
+
+// Function to page through a report pageSize rooms at a time (returns the number of rooms listed; at most
+// maxRooms are stored in roomNumbers)
+static int collectReport(struct Hotel* hotel, const struct HotelReportQuery* query, int pageSize, int* roomNumbers, int maxRooms) {
+    struct HotelCursor cursor = {HOTEL_CURSOR_START, 0};
+    int page[64], listed = 0;
+    while (cursor.state != HOTEL_CURSOR_DONE) {
+        int found = hotelReport(hotel, query, &cursor, page, pageSize);
+        CHECK(found >= 0 && found <= pageSize);
+        CHECK(found == pageSize || cursor.state == HOTEL_CURSOR_DONE); // Only the last page is short
+        for (int i = 0; i < found; ++i, ++listed) {
+            if (listed < maxRooms) {
+                roomNumbers[listed] = page[i];
             }
-            return; // Exit the function
         }
-        temp = temp->next; // Move to the next room
-    }
-    printHeader("Error");
-    printf("Room %d not found.\n", roomNumber); // Print error if room number not found
-    printLine('-', 30);
-}
-
-// Function to view all reservations
-void viewReservations(struct Room* head) {
-    struct Room* temp = head; // Temporary pointer to traverse the list
-    printHeader("All Reservations");
-    while (temp != NULL) { // Traverse the list
-        if (temp->isReserved) { // Check if the room is reserved
-            printf("Room %d is reserved by %s for %d days with %d people.\n", temp->roomNumber, temp->guestName, temp->duration, temp->occupancy); // Print reservation details
-        } else {
-            printf("Room %d is not reserved.\n", temp->roomNumber); // Print that the room is not reserved
+    }
+    CHECK(hotelReport(hotel, query, &cursor, page, pageSize) == 0); // Nothing after the last page
+    return listed;
+}
+
+// Function to test filtered, paged reports
+static void testReports() {
+    struct Hotel* hotel = hotelCreate();
+    struct HotelReportQuery query;
+    struct HotelCursor cursor = {HOTEL_CURSOR_START, 0};
+    int numbers[400], start = hotelToday() + 2, sorted = 1;
+    for (int i = 0; i < 300; ++i) { // Rooms 1-300, added out of order
+        hotelAddRoom(hotel, i * 37 % 300 + 1);
+    }
+    for (int room = 3; room <= 300; room += 3) {
+        CHECK(hotelReserve(hotel, room, room < 150 ? "Guest A" : "Guest B", start, 2, 0, 1) == HOTEL_OK);
+    }
+    for (int room = 5; room <= 300; room += 5) {
+        CHECK(hotelReserve(hotel, room, "Guest C", start + 10, 1, 0, 1) == HOTEL_OK);
+    }
+
+    hotelInitReport(&query);
+    CHECK(collectReport(hotel, &query, 7, numbers, 400) == 300);
+    for (int i = 0; i < 300; ++i) {
+        sorted = sorted && numbers[i] == i + 1;
+    }
+    CHECK(sorted);
+    query.filter = HOTEL_REPORT_RESERVED;
+    CHECK(collectReport(hotel, &query, 64, numbers, 400) == 140); // Multiples of 3 or 5
+    CHECK(numbers[0] == 3 && numbers[1] == 5 && numbers[139] == 300);
+    query.descending = 1;
+    CHECK(collectReport(hotel, &query, 9, numbers, 400) == 140);
+    CHECK(numbers[0] == 300 && numbers[1] == 297 && numbers[139] == 3);
+    query.descending = 0;
+    query.night = start + 1;
+    CHECK(collectReport(hotel, &query, 10, numbers, 400) == 100);
+    query.night = start + 2; // Check-out day: free again
+    CHECK(collectReport(hotel, &query, 10, numbers, 400) == 0);
+    query.filter = HOTEL_REPORT_VACANT;
+    query.night = start + 10;
+    CHECK(collectReport(hotel, &query, 10, numbers, 400) == 240);
+    query.night = HOTEL_ANY_NIGHT;
+    CHECK(collectReport(hotel, &query, 10, numbers, 400) == 160);
+    CHECK(numbers[0] == 1 && numbers[1] == 2 && numbers[2] == 4);
+
+    hotelInitReport(&query);
+    query.firstRoom = 50;
+    query.lastRoom = 59;
+    CHECK(collectReport(hotel, &query, 4, numbers, 400) == 10 && numbers[0] == 50 && numbers[9] == 59);
+    query.filter = HOTEL_REPORT_RESERVED;
+    query.descending = 1;
+    CHECK(collectReport(hotel, &query, 4, numbers, 400) == 5 && numbers[0] == 57 && numbers[4] == 50);
+    hotelInitReport(&query);
+    query.guestName = "Guest A";
+    CHECK(collectReport(hotel, &query, 8, numbers, 400) == 49 && numbers[0] == 3 && numbers[48] == 147);
+    query.filter = HOTEL_REPORT_RESERVED;
+    query.night = start + 10;
+    CHECK(collectReport(hotel, &query, 8, numbers, 400) == 9); // Guest A's rooms that are multiples of 15
+    query.guestName = "Nobody";
+    CHECK(collectReport(hotel, &query, 8, numbers, 400) == 0);
+
+    // Bookings, cancellations and new rooms show up in the next report
+    hotelInitReport(&query);
+    query.filter = HOTEL_REPORT_RESERVED;
+    CHECK(hotelCancel(hotel, 3, "Guest A", start) == HOTEL_OK);
+    CHECK(hotelReserve(hotel, 1, "Far Guest", start + 1000, 1, 0, 1) == HOTEL_OK); // Beyond the night bitmaps
+    CHECK(collectReport(hotel, &query, 64, numbers, 400) == 140 && numbers[0] == 1 && numbers[1] == 5);
+    query.night = start + 1000;
+    CHECK(collectReport(hotel, &query, 64, numbers, 400) == 1 && numbers[0] == 1);
+    CHECK(hotelAddRoom(hotel, -5) == HOTEL_OK && hotelAddRoom(hotel, 1000) == HOTEL_OK);
+    CHECK(hotelReserve(hotel, -5, "Guest D", start, 1, 0, 1) == HOTEL_OK);
+    query.night = HOTEL_ANY_NIGHT;
+    CHECK(collectReport(hotel, &query, 64, numbers, 400) == 141 && numbers[0] == -5);
+    hotelInitReport(&query);
+    CHECK(hotelReport(hotel, &query, &cursor, numbers, 2) == 2 && numbers[0] == -5 && numbers[1] == 1);
+    CHECK(cursor.state == HOTEL_CURSOR_MORE && cursor.roomNumber == 1);
+    CHECK(hotelAddRoom(hotel, 0) == HOTEL_OK && hotelAddRoom(hotel, 400) == HOTEL_OK); // Behind and ahead of the cursor
+    CHECK(collectReport(hotel, &query, 64, numbers, 400) == 304);
+    CHECK(hotelReport(hotel, &query, &cursor, numbers, 400) == 301 && numbers[0] == 2 && numbers[300] == 1000);
+
+    query.filter = 7;
+    CHECK(hotelReport(hotel, &query, &cursor, numbers, 10) == -1);
+    query.filter = HOTEL_REPORT_ALL;
+    CHECK(hotelReport(hotel, &query, &cursor, numbers, 0) == -1);
+    hotelDestroy(hotel);
+}
+
+// Function to test finding bookings by guest name
+static void testGuestIndex() {
+    struct Hotel* hotel = hotelCreate();
+    struct GuestStay stays[8];
+    struct GuestMatch matches[8];
+    int start = hotelToday() + 1;
+    for (int room = 1; room <= 3; ++room) {
+        hotelAddRoom(hotel, room);
+    }
+    hotelReserve(hotel, 3, "Maria Lopez", start + 7, 1, 0, 1);
+    hotelReserve(hotel, 1, "Maria Lopez", start, 2, 0, 1);
+    hotelReserve(hotel, 2, "Mario Rossi", start, 2, 0, 1);
+    CHECK(hotelFindGuest(hotel, "Maria Lopez", stays, 8) == 2);
+    CHECK(stays[0].roomNumber == 1 && stays[0].checkIn == start);
+    CHECK(stays[1].roomNumber == 3 && stays[1].checkIn == start + 7);
+    CHECK(hotelFindGuest(hotel, "maria lopez", stays, 8) == 0); // Exact lookups are exact
+    CHECK(hotelFindGuest(hotel, "Maria Lopez", stays, -1) == 2 && stays[0].roomNumber == 1); // Counted, nothing copied
+    CHECK(searchGuestPrefix(hotel, "mari", matches, 8) == 2); // Prefix searches ignore case
+    CHECK(searchGuestFuzzy(hotel, "Maria Lopes", 1, matches, 8) == 1 && strcmp(matches[0].guestName, "Maria Lopez") == 0);
+    CHECK(hotelSearchGuestPrefix(hotel, "MARIO", matches, 8) == 1 && matches[0].bookingCount == 1);
+    CHECK(hotelSearchGuestFuzzy(hotel, "Mario Rosi", 1, matches, 8) == 1 && matches[0].distance == 1);
+    hotelCancel(hotel, 1, "Maria Lopez", start);
+    CHECK(hotelFindGuest(hotel, "Maria Lopez", stays, 8) == 1);
+    hotelDestroy(hotel);
+}
+
+// Function to test pricing by the default and the sample rate plans
+static void testQuotes() {
+    struct Hotel* hotel = hotelCreate();
+    char path[512];
+    int start = hotelToday() + 20;
+    CHECK(hotelQuote(hotel, 101, start, 3, 2, 0) == 3 * PRICE_PER_NIGHT);
+    CHECK(hotelQuote(hotel, 101, start, 3, 2, 1) == 3 * (PRICE_PER_NIGHT + EXTRA_SERVICES_COST));
+    CHECK(hotelQuote(hotel, 101, start, 0, 2, 1) == 0);
+    struct HotelQuote details;
+    CHECK(hotelQuoteDetails(hotel, 101, start, 3, 2, 1, &details) == 3 * (PRICE_PER_NIGHT + EXTRA_SERVICES_COST));
+    CHECK(details.firstNight == PRICE_PER_NIGHT && details.extrasRate == EXTRA_SERVICES_COST);
+    CHECK(details.total == details.roomCharges + details.extras + details.surcharge - details.discount);
+
+    snprintf(path, sizeof(path), "%s/sample_rates.txt", extrDirectory);
+    CHECK(hotelLoadRates(hotel, path) == 1);
+    CHECK(hotelLoadRates(hotel, "no such file") == 0);
+    struct QuoteRequest requests[64];
+    int64_t totals[64];
+    for (int i = 0; i < 64; ++i) { // Short and long stays, inside and past the compiled tables
+        requests[i].roomNumber = 100 + 7 * i;
+        requests[i].checkIn = start + (i % 2 ? 40 * i : 3 * i);
+        requests[i].nights = i % 5 == 0 ? 90 : 1 + i % 9;
+        requests[i].occupancy = 1 + i % 4;
+        requests[i].extraServices = i % 3 == 0;
+    }
+    quoteStays(&hotel->rates, requests, 64, totals);
+    for (int i = 0; i < 64; ++i) {
+        const struct QuoteRequest* stay = &requests[i];
+        int64_t nightly = 0;
+        for (int n = 0; n < stay->nights; ++n) {
+            nightly += nightRate(&hotel->rates, roomType(&hotel->rates, stay->roomNumber), stay->checkIn + n);
         }
-        temp = temp->next; // Move to the next room
-    }
-    printLine('-', 30);
-}
-
-// Function to view details of all rooms
-void viewRoomDetails(struct Room* head) {
-    struct Room* temp = head; // Temporary pointer to traverse the list
-    printHeader("All Room Details");
-    while (temp != NULL) { // Traverse the list
-        printf("Room Number     : %d\n", temp->roomNumber);
-        printf("Reservation     : %s\n", temp->isReserved ? "Reserved" : "Not Reserved");
-        if (temp->isReserved) {
-            printf("Guest Name      : %s\n", temp->guestName);
-            printf("Duration        : %d days\n", temp->duration);
-            printf("Occupancy       : %d\n", temp->occupancy);
-            printf("Extra Services  : %s\n", temp->extraServices ? "Yes" : "No");
+        struct Quote quote;
+        CHECK(quoteStay(&hotel->rates, stay->roomNumber, stay->checkIn, stay->nights, stay->occupancy, stay->extraServices, &quote) == totals[i]);
+        CHECK(quote.roomCharges == nightly);
+        CHECK(quote.total == quote.roomCharges + quote.extras + quote.surcharge - quote.discount);
+    }
+    hotelDestroy(hotel);
+}
+
+// Function to test the running totals against hand counts and a full scan
+static void testTotals() {
+    struct Hotel* hotel = hotelCreate();
+    struct HotelTotals totals;
+    struct HotelNightTotals night;
+    int floors[8], start = hotelToday() + 2;
+    char path[512];
+    hotelTotals(hotel, &totals);
+    CHECK(totals.rooms == 0 && totals.bookings == 0 && hotelListFloors(hotel, floors, 8) == 0);
+    CHECK(checkTotals(hotel));
+
+    CHECK(hotelAddRoomRange(hotel, 1, 2, 1, 150) == 300); // Floors 1 and 2, numbered 1001-1150 and 2001-2150
+    CHECK(hotelAddRoom(hotel, 305) == HOTEL_OK); // Floor 3 by its number
+    CHECK(hotelListFloors(hotel, floors, 8) == 3 && floors[0] == 1 && floors[1] == 2 && floors[2] == 3);
+    CHECK(hotelFloorTotals(hotel, 2, &totals) && totals.rooms == 150 && totals.bookings == 0);
+    CHECK(!hotelFloorTotals(hotel, 20, &totals)); // Room 2001 is not on floor 20
+
+    CHECK(hotelReserve(hotel, 1001, "Ada", start, 3, 0, 2) == HOTEL_OK);
+    CHECK(hotelReserve(hotel, 1001, "Ada", start + 5, 1, 1, 1) == HOTEL_OK);
+    CHECK(hotelReserve(hotel, 2001, "Bo", start + 1, 2, 0, 4) == HOTEL_OK);
+    CHECK(hotelReserve(hotel, 305, "Cy", start, 1, 0, 1) == HOTEL_OK);
+    CHECK(hotelReserve(hotel, 305, "Cy", start, 1, 0, 1) == HOTEL_ROOM_UNAVAILABLE); // Refused bookings count for nothing
+    hotelTotals(hotel, &totals);
+    CHECK(totals.rooms == 301 && totals.reservedRooms == 3 && totals.bookings == 4);
+    CHECK(totals.guests == 8 && totals.roomNights == 7);
+    CHECK(totals.revenue == hotelQuote(hotel, 1001, start, 3, 2, 0) + hotelQuote(hotel, 1001, start + 5, 1, 1, 1)
+                            + hotelQuote(hotel, 2001, start + 1, 2, 4, 0) + hotelQuote(hotel, 305, start, 1, 1, 0));
+    CHECK(hotelFloorTotals(hotel, 1, &totals) && totals.reservedRooms == 1 && totals.bookings == 2 && totals.roomNights == 4);
+    CHECK(hotelNightTotals(hotel, start + 1, &night) && night.bookedRooms == 2 && night.guests == 6 && night.arrivals == 1);
+    CHECK(hotelNightTotals(hotel, start, &night) && night.bookedRooms == 2 && night.arrivals == 2);
+    CHECK(!hotelNightTotals(hotel, start - 10, &night) && night.bookedRooms == 0); // Before the hotel opened
+    CHECK(checkTotals(hotel));
+
+    CHECK(hotelCancel(hotel, 1001, "Ada", start) == HOTEL_OK);
+    CHECK(hotelCancel(hotel, 305, "Cy", start) == HOTEL_OK);
+    hotelTotals(hotel, &totals);
+    CHECK(totals.reservedRooms == 2 && totals.bookings == 2 && totals.guests == 5 && totals.roomNights == 3);
+    CHECK(hotelFloorTotals(hotel, 3, &totals) && totals.rooms == 1 && totals.reservedRooms == 0 && totals.revenue == 0);
+    CHECK(hotelNightTotals(hotel, start, &night) && night.bookedRooms == 0 && night.arrivals == 0);
+    CHECK(checkTotals(hotel));
+
+    snprintf(path, sizeof(path), "%s/sample_rates.txt", extrDirectory);
+    CHECK(hotelLoadRates(hotel, path) == 1); // The bookings are repriced by the new plan
+    hotelTotals(hotel, &totals);
+    CHECK(totals.revenue == hotelQuote(hotel, 1001, start + 5, 1, 1, 1) + hotelQuote(hotel, 2001, start + 1, 2, 4, 0));
+    CHECK(checkTotals(hotel));
+
+    for (int i = 0; i < 300; ++i) { // Enough bookings and cancellations to touch every stripe
+        int roomNumber = (i % 2 ? 2001 : 1001) + i % 150;
+        hotelReserve(hotel, roomNumber, "Many", start + 10 + i % 40, 1 + i % 6, i % 3 == 0, 1 + i % 2);
+        if (i % 4 == 0) {
+            hotelCancel(hotel, roomNumber, "Many", start + 10 + i % 40);
         }
-        printLine('-', 30);
-        temp = temp->next; // Move to the next room
     }
+    CHECK(checkTotals(hotel));
+    hotel->stripeTotals[7].sums.guests++; // A total out of step is caught
+    CHECK(!checkTotals(hotel));
+    hotel->stripeTotals[7].sums.guests--;
+    hotel->nightTotals[12].arrivals++;
+    CHECK(!checkTotals(hotel));
+    hotel->nightTotals[12].arrivals--;
+    hotel->nights[NIGHT_WORDS / 2 * hotel->roomCapacity + 3] ^= 1; // So is a night bitmap
+    CHECK(!checkTotals(hotel));
+    hotel->nights[NIGHT_WORDS / 2 * hotel->roomCapacity + 3] ^= 1;
+    CHECK(hotelCheckTotals(hotel));
+    hotelDestroy(hotel);
 }
 
-// Function to free all allocated memory for the rooms
-void freeRooms(struct Room* head) {
-    struct Room* temp;
-    while (head != NULL) {
-        temp = head;
-        head = head->next;
-        free(temp);
+// Function to check that two hotels hold the same rooms and bookings
+static void checkSameHotel(struct Hotel* expected, struct Hotel* actual) {
+    struct HotelBooking want[16], got[16];
+    CHECK(hotelRoomCount(expected) == hotelRoomCount(actual));
+    for (int i = 0; i < expected->roomCount; ++i) {
+        int roomNumber = expected->rooms[i].roomNumber;
+        int count = hotelListBookings(expected, roomNumber, want, 16);
+        CHECK(hotelListBookings(actual, roomNumber, got, 16) == count);
+        for (int b = 0; b < count && b < 16; ++b) {
+            CHECK(got[b].checkIn == want[b].checkIn && got[b].checkOut == want[b].checkOut);
+            CHECK(got[b].occupancy == want[b].occupancy && got[b].extraServices == want[b].extraServices);
+            CHECK(got[b].reservationTime == want[b].reservationTime);
+            CHECK(strcmp(got[b].guestName, want[b].guestName) == 0);
+        }
     }
 }
 
-// Function to display the menu
-void displayMenu() {
-    printHeader("Hotel Management System Menu");
-    printf("1. Add Room\n");
-    printf("2. Make Reservation\n");
-    printf("3. Cancel Reservation\n");
-    printf("4. View All Reservations\n");
-    printf("5. View All Room Details\n");
-    printf("0. Exit\n");
-    printLine('-', 30);
-    printf("Enter your choice: ");
+// Function to test saving and loading snapshots, and replaying the journal after a crash
+static void testPersistence() {
+    struct Hotel* hotel = hotelCreate();
+    struct Journal journal;
+    char snapshotPath[128], journalPath[128];
+    int start = hotelToday() + 3;
+    workPath("hotel.snapshot", snapshotPath, sizeof(snapshotPath));
+    workPath("hotel.journal", journalPath, sizeof(journalPath));
+    for (int room = 1; room <= 100; ++room) {
+        hotelAddRoom(hotel, room);
+        hotelReserve(hotel, room, room % 2 ? "Odd Guest" : "Even Guest", start + room % 7, 1 + room % 4, room % 3 == 0, 1 + room % 4);
+    }
+    CHECK(saveSnapshot(hotel, snapshotPath) == 1);
+
+    struct Hotel* loaded = hotelCreate();
+    CHECK(loadSnapshot(loaded, snapshotPath) == 1);
+    checkSameHotel(hotel, loaded);
+    CHECK(hotelReserve(loaded, 1, "After Load", start + 40, 2, 0, 1) == HOTEL_OK); // Mapped calendars can still change
+    CHECK(hotelFindGuest(loaded, "Odd Guest", NULL, 0) == 50);
+    struct HotelReportQuery query;
+    int reserved[128];
+    hotelInitReport(&query);
+    query.filter = HOTEL_REPORT_RESERVED;
+    CHECK(collectReport(loaded, &query, 30, reserved, 128) == 100 && reserved[99] == 100); // Sorted in from the snapshot
+    CHECK(checkTotals(loaded)); // Recounted from the snapshot
+    hotelDestroy(loaded);
+
+    // Journal the next changes, then "crash": drop the hotel without a checkpoint
+    CHECK(openJournal(&journal, journalPath, hotel->journalSequence + 1, 0) == 1);
+    hotel->journal = &journal;
+    hotelAddRoom(hotel, 500);
+    hotelReserve(hotel, 500, "Late Guest", start, 3, 1, 2);
+    hotelCancel(hotel, 2, "Even Guest", start + 2);
+    CHECK(journalSync(&journal) == 1);
+
+    struct Hotel* recovered = hotelCreate();
+    CHECK(loadSnapshot(recovered, snapshotPath) == 1);
+    CHECK(recoverJournal(recovered, journalPath) == 3);
+    checkSameHotel(hotel, recovered);
+    CHECK(checkTotals(recovered));
+    hotelDestroy(recovered);
+
+    CHECK(checkpointHotel(hotel, snapshotPath) == 1); // The journal is folded into the snapshot and emptied
+    recovered = hotelCreate();
+    CHECK(loadSnapshot(recovered, snapshotPath) == 1);
+    CHECK(recoverJournal(recovered, journalPath) == 0);
+    checkSameHotel(hotel, recovered);
+    hotelDestroy(recovered);
+
+    hotel->journal = NULL;
+    closeJournal(&journal);
+
+    // The same again through the public calls the front ends use
+    CHECK(hotelOpenJournal(hotel, journalPath) == 1);
+    CHECK(hotelOpenJournal(hotel, journalPath) == 0); // One journal at a time
+    hotelReserve(hotel, 500, "Later Guest", start + 10, 2, 0, 1);
+    CHECK(hotelSyncJournal(hotel) == 1);
+    recovered = hotelCreate();
+    CHECK(hotelLoadSnapshot(recovered, snapshotPath) == 1);
+    CHECK(hotelRecoverJournal(recovered, journalPath) == 1);
+    checkSameHotel(hotel, recovered);
+    hotelDestroy(recovered);
+    CHECK(hotelCheckpoint(hotel, snapshotPath) == 1);
+    hotelCloseJournal(hotel);
+    CHECK(hotelSyncJournal(hotel) == 1); // Nothing journaled, nothing to wait for
+    hotelDestroy(hotel);
+    remove(snapshotPath);
+    remove(journalPath);
 }
 
-// Function to print a header
-void printHeader(const char* title) {
-    printLine('*', 30);
-    printf("%s\n", title);
-    printLine('*', 30);
+// Function to make a hotel whose night bitmaps start daysAgo, as one last loaded or checkpointed then would
+static struct Hotel* createStaleHotel(int daysAgo) {
+    struct Hotel* hotel = hotelCreate();
+    int today = hotelToday();
+    hotel->calendarStart = today - daysAgo;
+    for (int room = 1; room <= 20; ++room) {
+        hotelAddRoom(hotel, room);
+        CHECK(hotelReserve(hotel, room, "Past", today - daysAgo + room, 3, 0, 1) == HOTEL_OK);
+        CHECK(hotelReserve(hotel, room, "Across", today - 2 + room % 3, 5, 0, 2) == HOTEL_OK); // Every room tonight
+        CHECK(hotelReserve(hotel, room, "Soon", today + 30 + room, 2, 1, 1 + room % 3) == HOTEL_OK);
+        CHECK(hotelReserve(hotel, room, "Late", today + 350 + room, 4, 0, 1) == HOTEL_OK); // Rooms 7 to 10 on night 360
+    }
+    return hotel;
 }
 
-// Function to print a line with a specified character and length
-void printLine(char ch, int length) {
-    for (int i = 0; i < length; ++i) {
-        printf("%c", ch);
+// Function to test that the nights the bitmaps track move up to today when a stale hotel is loaded or
+// checkpointed, a few weeks on (the rows shift within and across words) or more than a year on (all new)
+static void testSlidingHorizon() {
+    static const int daysAgo[] = {70, 400};
+    struct HotelNightTotals night;
+    char snapshotPath[128];
+    int today = hotelToday();
+    workPath("hotel.snapshot", snapshotPath, sizeof(snapshotPath));
+    for (int i = 0; i < 2; ++i) {
+        struct Hotel* hotel = createStaleHotel(daysAgo[i]);
+        CHECK(checkTotals(hotel));
+        CHECK(hotelNightTotals(hotel, today + 360, &night) == 0); // Past the end of the stale horizon
+        CHECK(saveSnapshot(hotel, snapshotPath) == 1);
+
+        struct Hotel* loaded = hotelCreate();
+        CHECK(loadSnapshot(loaded, snapshotPath) == 1);
+        CHECK(loaded->calendarStart == today);
+        CHECK(checkTotals(loaded)); // Every bitmap row and night total agrees with the calendars
+        CHECK(hotelNightTotals(loaded, today, &night) == 1 && night.bookedRooms == 20 && night.guests == 40);
+        CHECK(hotelNightTotals(loaded, today + 360, &night) == 1 && night.bookedRooms == 4);
+        CHECK(countFreeRooms(loaded, today, today + 1) == 0);
+        CHECK(countFreeRooms(loaded, today + 360, today + 361) == 16);
+        CHECK(hotelFindFreeRooms(loaded, today + 31, 1, 1, NULL, 0) == 19);
+        CHECK(hotelNightTotals(loaded, today - 1, &night) == 0); // Gone by: only on the calendars now
+        CHECK(hotelReserve(loaded, 1, "Next Year", today + 365, 1, 0, 1) == HOTEL_OK && checkTotals(loaded));
+
+        CHECK(checkpointHotel(hotel, snapshotPath) == 1); // Slides the hotel in memory too
+        CHECK(hotel->calendarStart == today && checkTotals(hotel));
+        CHECK(countFreeRooms(hotel, today + 360, today + 361) == 16);
+        CHECK(hotelCancel(loaded, 1, "Next Year", today + 365) == HOTEL_OK);
+        checkSameHotel(hotel, loaded);
+        hotelDestroy(loaded);
+        hotelDestroy(hotel);
     }
-    printf("\n");
+    remove(snapshotPath);
 }
 
-int main() {
-    struct Room* head = NULL; // Initialize the head of the list
-    int choice, roomNumber, duration, extraServices, occupancy;
-    char guestName[MAX_NAME_LENGTH];
+// Function to add an event to expected history sums, as summarizeHistory should (months counted from firstYear-firstMonth)
+static void expectHistory(struct HotelHistoryMonth* months, int firstYear, int firstMonth, int kind, int checkIn, int nights, int occupancy, int64_t amount) {
+    int year, month, day;
+    dateFromDay(checkIn, &year, &month, &day);
+    struct HotelHistoryMonth* row = &months[(year * 12 + month) - (firstYear * 12 + firstMonth)];
+    int sign = kind == HISTORY_CANCELLED ? -1 : 1;
+    row->bookings += kind == HISTORY_RESERVED;
+    row->cancellations += kind == HISTORY_CANCELLED;
+    row->roomNights += sign * nights;
+    row->guests += sign * occupancy;
+    row->revenue += sign * amount;
+    row->cancelledRevenue += kind == HISTORY_CANCELLED ? amount : 0;
+}
 
-    // Test Case 1: Add a room
-    addRoom(&head, 101);
+// Function to check a history summary against the expected sums (returns 1 if every month agrees)
+static int sameHistory(const struct HotelHistoryMonth* expected, const struct HotelHistoryMonth* actual, int count) {
+    int same = 1;
+    for (int m = 0; m < count; ++m) {
+        same = same && expected[m].bookings == actual[m].bookings && expected[m].cancellations == actual[m].cancellations
+               && expected[m].roomNights == actual[m].roomNights && expected[m].guests == actual[m].guests
+               && expected[m].revenue == actual[m].revenue && expected[m].cancelledRevenue == actual[m].cancelledRevenue;
+    }
+    return same;
+}
 
-    // Test Case 2: Attempt to add the same room number
-    addRoom(&head, 101); // Should fail
+// Function to copy a scratch file (returns 1 on success)
+static int copyFile(const char* from, const char* to) {
+    char buffer[4096];
+    size_t size;
+    FILE* source = fopen(from, "rb");
+    FILE* target = source != NULL ? fopen(to, "wb") : NULL;
+    int ok = target != NULL;
+    while (ok && (size = fread(buffer, 1, sizeof(buffer), source)) > 0) {
+        ok = fwrite(buffer, 1, size, target) == size;
+    }
+    if (source != NULL) {
+        fclose(source);
+    }
+    if (target != NULL) {
+        ok = fclose(target) == 0 && ok;
+    }
+    return ok;
+}
 
-    // Test Case 3: Make a reservation
-    makeReservation(head, 101, "John Doe", 3, 0, 2);
+// Function to test the booking history: its sums by month, its packed blocks and their scan, and its file
+static void testHistory() {
+    struct Hotel* hotel = hotelCreate();
+    struct HotelHistoryMonth expected[80], months[80];
+    int start = hotelToday() + 2, year, month, day;
+    char snapshotPath[128], historyPath[128], oldSnapshotPath[128];
 
-    // Test Case 4: Make a reservation for a non-existing room
-    makeReservation(head, 102, "Jane Smith", 5, 1, 3); // Should fail
+    // Through the interface: a month of bookings, one cancelled, one refused
+    dateFromDay(start, &year, &month, &day);
+    memset(expected, 0, sizeof(expected));
+    hotelAddRoomRange(hotel, 1, 1, 1, 20);
+    for (int i = 0; i < 20; ++i) {
+        int checkIn = start + i * 3;
+        CHECK(hotelReserve(hotel, 101 + i, i % 2 ? "Odd Guest" : "Even Guest", checkIn, 1 + i % 4, i % 3 == 0, 1 + i % 2) == HOTEL_OK);
+        expectHistory(expected, year, month, HISTORY_RESERVED, checkIn, 1 + i % 4, 1 + i % 2, hotelQuote(hotel, 101 + i, checkIn, 1 + i % 4, 1 + i % 2, i % 3 == 0));
+    }
+    CHECK(hotelReserve(hotel, 101, "Late Guest", start, 1, 0, 1) == HOTEL_ROOM_UNAVAILABLE); // Refused: not history
+    CHECK(hotelCancel(hotel, 104, "Odd Guest", start + 9) == HOTEL_OK);
+    expectHistory(expected, year, month, HISTORY_CANCELLED, start + 9, 4, 2, hotelQuote(hotel, 104, start + 9, 4, 2, 1));
+    CHECK(hotelHistoryEvents(hotel) == 21);
+    int count = hotelHistorySummary(hotel, start, start + 60, 2, months, 80);
+    CHECK(count >= 2 && count <= 3 && sameHistory(expected, months, count));
+    CHECK(months[0].year == year && months[0].month == month && months[0].cancellations == 1);
+    CHECK(hotelHistorySummary(hotel, start + 61, start + 90, 1, months, 80) >= 1 && months[0].bookings == 0); // Later check-ins only
+    CHECK(hotelHistorySummary(hotel, start, start - 1, 1, months, 80) == -1);
+    CHECK(hotelHistorySummary(hotel, start, start + 366 * 101, 1, months, 80) == -1); // Over HISTORY_MAX_MONTHS
+
+    // Straight into the history: three full blocks and some, over five years of check-ins
+    struct Hotel* bulk = hotelCreate();
+    int first = dayFromDate(2030, 1, 1), events = 3 * HISTORY_BLOCK_EVENTS + 1000;
+    memset(expected, 0, sizeof(expected));
+    for (int i = 0; i < events; ++i) {
+        int kind = i % 5 == 0 ? HISTORY_CANCELLED : HISTORY_RESERVED, checkIn = first + (int)((i * 7919LL) % 1800);
+        int64_t amount = i == 77 ? ((int64_t)1 << 61) : i == 78 ? -((int64_t)1 << 61) : 1000 + i % 50000; // Two too wide to pack
+        recordHistory(&bulk->history, kind, 1900000000LL + i, 1 + i % 3000, i % 2 ? "Bulk A" : "Bulk B", checkIn, 1 + i % 9, 1 + i % 4, i % 2, amount);
+        expectHistory(expected, 2030, 1, kind, checkIn, 1 + i % 9, 1 + i % 4, amount);
+    }
+    settleHistory(&bulk->history); // The sealer thread packs the last full block
+    CHECK(bulk->history.blockCount == 3 && bulk->history.tailCount == 1000 && bulk->history.guestCount == 2);
+    CHECK(bulk->history.blocks[0].widths[HISTORY_AMOUNT] == 64 && bulk->history.blocks[1].widths[HISTORY_AMOUNT] == 16);
+    CHECK(bulk->history.blocks[1].widths[HISTORY_KIND] == 1 && bulk->history.blocks[1].widths[HISTORY_CHECK_IN] == 11);
+    CHECK(hotelHistorySummary(bulk, first, first + 1799, 1, months, 80) == 60 && sameHistory(expected, months, 60));
+    CHECK(hotelHistorySummary(bulk, first, first + 1799, 4, months, 80) == 60 && sameHistory(expected, months, 60));
+    CHECK(hotelHistorySummary(bulk, first, first + 1799, 64, months, 80) == 60 && sameHistory(expected, months, 60));
+    CHECK(hotelHistorySummary(bulk, first + 365, first + 729, 3, months, 80) == 12 && sameHistory(expected + 12, months, 12));
 
-    // Test Case 5: Make a reservation for an already reserved room
-    makeReservation(head, 101, "Alice Brown", 4, 1, 1); // Should fail
+    // The unpacking kernel this CPU uses (AVX2 where there is one) gives back every value, from any position
+    const struct HistoryBlock* block = &bulk->history.blocks[1];
+    int64_t values[HISTORY_SCAN_CHUNK];
+    int unpacked = 1;
+    for (int from = 0; from < 3000; from += 333) {
+        historyKernels()->unpack(block->data + block->offsets[HISTORY_CHECK_IN], block->widths[HISTORY_CHECK_IN],
+                                 block->lows[HISTORY_CHECK_IN], from, 301, values);
+        for (int i = 0; i < 301; ++i) {
+            unpacked = unpacked && values[i] == first + ((HISTORY_BLOCK_EVENTS + from + i) * 7919LL) % 1800;
+        }
+    }
+    CHECK(unpacked);
+    hotelDestroy(bulk);
 
-    // Test Case 6: Cancel a reservation
-    cancelReservation(head, 101, "John Doe");
+    // The history file: each checkpoint appends, and loading an older snapshot cuts off what came after it
+    workPath("hotel.snapshot", snapshotPath, sizeof(snapshotPath));
+    workPath("hotel.history", historyPath, sizeof(historyPath));
+    workPath("old.snapshot", oldSnapshotPath, sizeof(oldSnapshotPath));
+    CHECK(openHistory(hotel, historyPath) == 0 && hotel->history.file >= 0); // No snapshot: a new history
+    CHECK(checkpointHotel(hotel, snapshotPath) == 1);
+    CHECK(copyFile(snapshotPath, oldSnapshotPath));
+    struct stat file;
+    off_t oldSize = stat(historyPath, &file) == 0 ? file.st_size : 0;
+    CHECK(hotelCancel(hotel, 102, "Odd Guest", start + 3) == HOTEL_OK);
+    CHECK(hotelReserve(hotel, 102, "New Guest", start + 3, 2, 0, 1) == HOTEL_OK);
+    CHECK(checkpointHotel(hotel, snapshotPath) == 1);
+    CHECK(checkpointHotel(hotel, snapshotPath) == 1); // Nothing new: nothing appended
 
-    // Test Case 7: Cancel a reservation for a non-existing room
-    cancelReservation(head, 102, "Jane Smith"); // Should fail
+    struct Hotel* loaded = hotelCreate();
+    CHECK(loadSnapshot(loaded, snapshotPath) == 1 && openHistory(loaded, historyPath) == 1);
+    CHECK(hotelHistoryEvents(loaded) == 23);
+    count = hotelHistorySummary(hotel, start, start + 60, 1, expected, 80);
+    CHECK(hotelHistorySummary(loaded, start, start + 60, 3, months, 80) == count && sameHistory(expected, months, count));
+    CHECK(hotelReserve(loaded, 102, "New Guest", start + 30, 1, 0, 1) == HOTEL_OK); // Recorded after the loaded blocks
+    CHECK(checkpointHotel(loaded, snapshotPath) == 1);
+    hotelDestroy(loaded);
+    loaded = hotelCreate();
+    CHECK(loadSnapshot(loaded, snapshotPath) == 1 && openHistory(loaded, historyPath) == 1 && hotelHistoryEvents(loaded) == 24);
+    hotelDestroy(loaded);
+
+    loaded = hotelCreate();
+    CHECK(loadSnapshot(loaded, oldSnapshotPath) == 1 && openHistory(loaded, historyPath) == 1);
+    CHECK(hotelHistoryEvents(loaded) == 21 && loaded->history.guestCount == 2); // New Guest came later
+    hotelDestroy(loaded);
+    CHECK(stat(historyPath, &file) == 0 && file.st_size == oldSize && oldSize > (off_t)sizeof(struct HistoryHeader));
+
+    FILE* damaged = fopen(historyPath, "r+b"); // A history that does not go with the snapshot is started again
+    if (damaged != NULL) {
+        fseek(damaged, sizeof(struct HistoryHeader) + 8, SEEK_SET);
+        fputc(0x5a, damaged);
+        fclose(damaged);
+    }
+    loaded = hotelCreate();
+    CHECK(loadSnapshot(loaded, oldSnapshotPath) == 1 && openHistory(loaded, historyPath) == -1);
+    CHECK(hotelHistoryEvents(loaded) == 0 && loaded->history.file >= 0);
+    hotelDestroy(loaded);
+
+    hotelDestroy(hotel);
+    remove(snapshotPath);
+    remove(historyPath);
+    remove(oldSnapshotPath);
+}
+
+// Define what one booking thread of testConcurrentBookings works on
+struct BookingThread {
+    struct Hotel* hotel; // Hotel shared by all the threads
+    int firstRoom; // First of the TEST_THREAD_ROOMS rooms this thread adds and books
+    int booked; // Bookings that succeeded
+};
+
+// Function run by each booking thread: add its rooms, then book and cancel them, racing the others
+static void* bookRooms(void* argument) {
+    struct BookingThread* thread = (struct BookingThread*)argument;
+    int start = hotelToday();
+    for (int r = 0; r < TEST_THREAD_ROOMS; ++r) {
+        hotelAddRoom(thread->hotel, thread->firstRoom + r);
+    }
+    for (int r = 0; r < TEST_THREAD_ROOMS; ++r) {
+        int roomNumber = thread->firstRoom + r;
+        thread->booked += hotelReserve(thread->hotel, roomNumber, "Thread Guest", start + 1, 2, 0, 1) == HOTEL_OK;
+        thread->booked += hotelReserve(thread->hotel, roomNumber, "Thread Guest", start + 5, 2, 0, 1) == HOTEL_OK;
+        thread->booked -= hotelCancel(thread->hotel, roomNumber, "Thread Guest", start + 1) == HOTEL_OK;
+    }
+    return NULL;
+}
+
+// Function to run a few threads that each book and cancel their own rooms (see bookRooms)
+static void runBookingThreads(struct Hotel* hotel, int firstRoom, int* booked) {
+    pthread_t threads[TEST_THREADS];
+    struct BookingThread work[TEST_THREADS];
+    for (int t = 0; t < TEST_THREADS; ++t) {
+        work[t].hotel = hotel;
+        work[t].firstRoom = firstRoom + 10000 * t;
+        work[t].booked = 0;
+        pthread_create(&threads[t], NULL, bookRooms, &work[t]);
+    }
+    *booked = 0;
+    for (int t = 0; t < TEST_THREADS; ++t) {
+        pthread_join(threads[t], NULL);
+        *booked += work[t].booked;
+    }
+}
+
+// Function to test that bookings made from many threads at once all land
+static void testConcurrentBookings() {
+    struct Hotel* hotel = hotelCreate();
+    int booked;
+    runBookingThreads(hotel, 10000, &booked);
+    CHECK(hotelRoomCount(hotel) == TEST_THREADS * TEST_THREAD_ROOMS);
+    CHECK(booked == TEST_THREADS * TEST_THREAD_ROOMS);
+    CHECK(hotelFindGuest(hotel, "Thread Guest", NULL, 0) == TEST_THREADS * TEST_THREAD_ROOMS);
+    CHECK(countBookedNights(hotel, hotelToday(), hotelToday() + 10) == 2LL * TEST_THREADS * TEST_THREAD_ROOMS);
+    CHECK(checkTotals(hotel));
+    hotelDestroy(hotel);
+}
+
+// Define what one group-booking thread of testGroupBookings works on
+struct GroupThread {
+    struct Hotel* hotel; // Hotel shared by all the threads
+    int id; // Thread number, part of the group name
+    int booked; // Groups booked
+};
+
+// Function run by each group-booking thread: book ten groups of four pairs, racing the others for the same nights
+static void* bookGroups(void* argument) {
+    struct GroupThread* thread = (struct GroupThread*)argument;
+    static const int parties[] = {2, 2, 2, 2};
+    char guestName[32];
+    snprintf(guestName, sizeof(guestName), "Group Thread %d", thread->id);
+    struct HotelGroup group = {guestName, hotelToday() + 1, 2, 0, parties, 4};
+    for (int g = 0; g < 10; ++g) {
+        thread->booked += hotelReserveGroup(thread->hotel, &group, NULL) == HOTEL_OK;
+    }
+    return NULL;
+}
+
+// Function to test group bookings: the packing, the choice of rooms, all or none, the journal and racing threads
+static void testGroupBookings() {
+    struct Hotel* hotel = hotelCreate();
+    struct Journal journal;
+    struct HotelBooking bookings[4];
+    static const int parties[] = {4, 3, 2, 2, 1, 1, 4, 3}, sixFull[] = {4, 4, 4, 4, 4, 4}, tooLarge[] = {2, 5}, empty[] = {2, 0};
+    int start = hotelToday() + 5, partyRooms[64], people[6] = {0}, fits = 1;
+    char snapshotPath[128], journalPath[128];
+    hotelAddRoomRange(hotel, 1, 2, 1, 20); // Rooms 101 to 120 and 201 to 220
+
+    // Twenty people in the fewest rooms of four, side by side
+    struct HotelGroup group = {"Tour Group", start, 3, 1, parties, 8};
+    CHECK(hotelReserveGroup(hotel, &group, partyRooms) == HOTEL_OK);
+    for (int p = 0; p < 8; ++p) {
+        fits = fits && partyRooms[p] >= 101 && partyRooms[p] <= 105;
+        people[fits ? partyRooms[p] - 101 : 5] += parties[p];
+    }
+    CHECK(fits && people[0] == 4 && people[1] == 4 && people[2] == 4 && people[3] == 4 && people[4] == 4);
+    CHECK(partyRooms[0] != partyRooms[6]);
+    CHECK(hotelListBookings(hotel, 103, bookings, 4) == 1 && bookings[0].occupancy == 4 && bookings[0].extraServices == 1);
+    CHECK(hotelFindGuest(hotel, "Tour Group", NULL, 0) == 5);
+
+    // Around the rooms booked already: the one run of six free rooms on a floor, not the lower rooms with a gap
+    CHECK(hotelReserve(hotel, 103, "Guest", start + 10, 2, 0, 1) == HOTEL_OK);
+    CHECK(hotelReserve(hotel, 110, "Guest", start + 10, 2, 0, 1) == HOTEL_OK);
+    CHECK(hotelReserve(hotel, 115, "Guest", start + 10, 2, 0, 1) == HOTEL_OK);
+    struct HotelGroup six = {"Six Rooms", start + 10, 2, 0, sixFull, 6};
+    CHECK(hotelReserveGroup(hotel, &six, partyRooms) == HOTEL_OK);
+    CHECK(partyRooms[0] == 104 && partyRooms[1] == 105 && partyRooms[5] == 109);
+
+    // All or none: too few rooms, a party larger than any room, and parties of no one book nothing
+    struct HotelGroup crowd = {"Crowd", start + 10, 2, 0, sixFull, 6};
+    for (int g = 0; g < 5; ++g) { // 30 of the 31 rooms left, so a sixth group finds one
+        CHECK(hotelReserveGroup(hotel, &crowd, NULL) == HOTEL_OK);
+    }
+    CHECK(hotelReserveGroup(hotel, &crowd, NULL) == HOTEL_ROOM_UNAVAILABLE);
+    CHECK(hotelFindGuest(hotel, "Crowd", NULL, 0) == 30);
+    struct HotelGroup large = {"Large", start + 20, 1, 0, tooLarge, 2}, none = {"None", start + 20, 1, 0, empty, 2};
+    CHECK(hotelReserveGroup(hotel, &large, NULL) == HOTEL_OVER_CAPACITY);
+    CHECK(hotelReserveGroup(hotel, &none, NULL) == HOTEL_INVALID_STAY);
+    none.parties = parties;
+    none.nights = 0;
+    CHECK(hotelReserveGroup(hotel, &none, NULL) == HOTEL_INVALID_STAY);
+    none.nights = 2;
+    none.checkIn = INT32_MAX - 1; // Would run past the last date
+    CHECK(hotelReserveGroup(hotel, &none, NULL) == HOTEL_INVALID_STAY);
+    CHECK(hotelFindGuest(hotel, "Large", NULL, 0) == 0 && hotelFindGuest(hotel, "None", NULL, 0) == 0);
+    CHECK(checkTotals(hotel));
+
+    // The journal replays a group whole, and drops one whose records were not all written
+    workPath("hotel.snapshot", snapshotPath, sizeof(snapshotPath));
+    workPath("hotel.journal", journalPath, sizeof(journalPath));
+    CHECK(saveSnapshot(hotel, snapshotPath) == 1);
+    CHECK(openJournal(&journal, journalPath, hotel->journalSequence + 1, 0) == 1);
+    hotel->journal = &journal;
+    group.checkIn = start + 40;
+    CHECK(hotelReserveGroup(hotel, &group, NULL) == HOTEL_OK);
+    CHECK(journalSync(&journal) == 1);
+    struct Hotel* recovered = hotelCreate();
+    CHECK(loadSnapshot(recovered, snapshotPath) == 1);
+    CHECK(recoverJournal(recovered, journalPath) == 5);
+    checkSameHotel(hotel, recovered);
+    hotelDestroy(recovered);
+
+    struct stat file;
+    off_t whole = stat(journalPath, &file) == 0 ? file.st_size : 0;
+    group.guestName = "Torn Group";
+    CHECK(hotelReserveGroup(hotel, &group, NULL) == HOTEL_OK); // The same nights, so the five rooms after the first group
+    CHECK(journalSync(&journal) == 1);
+    CHECK(stat(journalPath, &file) == 0 && truncate(journalPath, file.st_size - 1) == 0); // Its last booking cut short
+    recovered = hotelCreate();
+    CHECK(loadSnapshot(recovered, snapshotPath) == 1);
+    CHECK(recoverJournal(recovered, journalPath) == 5);
+    CHECK(hotelFindGuest(recovered, "Tour Group", NULL, 0) == 10 && hotelFindGuest(recovered, "Torn Group", NULL, 0) == 0);
+    CHECK(checkTotals(recovered));
+    CHECK(stat(journalPath, &file) == 0 && file.st_size == whole);
+    hotelDestroy(recovered);
+    hotel->journal = NULL;
+    closeJournal(&journal);
+    hotelDestroy(hotel);
+    remove(snapshotPath);
+    remove(journalPath);
+
+    // Threads racing for the same nights never share a room, and no group is half booked
+    pthread_t threads[TEST_THREADS];
+    struct GroupThread work[TEST_THREADS];
+    int booked = 0;
+    hotel = hotelCreate();
+    hotelAddRoomRange(hotel, 1, 5, 1, 16); // 80 rooms: the 40 groups of two rooms all fit
+    for (int t = 0; t < TEST_THREADS; ++t) {
+        work[t].hotel = hotel;
+        work[t].id = t;
+        work[t].booked = 0;
+        pthread_create(&threads[t], NULL, bookGroups, &work[t]);
+    }
+    for (int t = 0; t < TEST_THREADS; ++t) {
+        pthread_join(threads[t], NULL);
+        booked += work[t].booked;
+    }
+    CHECK(booked == TEST_THREADS * 10);
+    CHECK(countBookedNights(hotel, hotelToday(), hotelToday() + 10) == 2LL * 2 * TEST_THREADS * 10);
+    CHECK(checkTotals(hotel));
+    hotelDestroy(hotel);
+}
+
+// Define what the booking thread of testViews works on
+struct ViewThread {
+    struct Hotel* hotel; // Hotel shared with the reading thread
+    int rounds; // Times every room is booked and cancelled again
+};
+
+// Function run by the booking thread of testViews: book and cancel every room of floor 3, round after round
+static void* churnRooms(void* argument) {
+    struct ViewThread* thread = (struct ViewThread*)argument;
+    for (int round = 0; round < thread->rounds; ++round) {
+        for (int room = 301; room <= 316; ++room) {
+            hotelReserve(thread->hotel, room, "Churn", hotelToday() + room % 7, 2, 0, 1);
+        }
+        for (int room = 301; room <= 316; ++room) {
+            hotelCancel(thread->hotel, room, "Churn", hotelToday() + room % 7);
+        }
+    }
+    return NULL;
+}
+
+// Function to add up what a view reads of rooms 301 to 316, so two reads can be compared
+static uint64_t sumView(struct HotelView* view) {
+    struct HotelBooking bookings[8];
+    uint64_t sum = 0;
+    for (int room = 301; room <= 316; ++room) {
+        int count = hotelViewBookings(view, room, bookings, 8);
+        sum = sum * 31 + (uint64_t)count;
+        for (int b = 0; b < count && b < 8; ++b) {
+            sum = sum * 31 + (uint64_t)bookings[b].checkIn;
+        }
+    }
+    return sum;
+}
 
-    // Test Case 8: Cancel a reservation with a mismatched guest name
-    makeReservation(head, 101, "Alice Brown", 4, 1, 1); // Re-reserve the room
-    cancelReservation(head, 101, "John Doe"); // Should fail
+// Function to test read views: each reads the rooms as they stood when it was opened, whatever is booked,
+// cancelled or added afterwards, and the versions kept for it are freed once it is closed
+static void testViews() {
+    struct Hotel* hotel = hotelCreate();
+    struct HotelBooking bookings[4];
+    struct HotelView* views[HOTEL_MAX_VIEWS];
+    int start = hotelToday() + 3;
+    hotelAddRoom(hotel, 101);
+    hotelAddRoom(hotel, 102);
+    CHECK(hotelReserve(hotel, 101, "Alice", start, 2, 0, 1) == HOTEL_OK);
 
-    // Test Case 9: View all reservations
-    viewReservations(head);
+    struct HotelView* first = hotelOpenView(hotel);
+    CHECK(hotelReserve(hotel, 101, "Bob", start + 5, 1, 0, 2) == HOTEL_OK);
+    CHECK(hotelCancel(hotel, 101, "Alice", start) == HOTEL_OK);
+    CHECK(hotelReserve(hotel, 102, "Carol", start, 1, 1, 3) == HOTEL_OK);
+    CHECK(hotelAddRoom(hotel, 103) == HOTEL_OK && hotelReserve(hotel, 103, "Dan", start, 1, 0, 1) == HOTEL_OK);
+    CHECK(hotelViewBookings(first, 101, bookings, 4) == 1 && strcmp(bookings[0].guestName, "Alice") == 0);
+    CHECK(hotelViewBookings(first, 102, bookings, 4) == 0);
+    CHECK(hotelViewBookings(first, 103, bookings, 4) == -1); // Added after the view was opened
+    CHECK(hotelViewBookings(first, 104, bookings, 4) == -1);
+    struct HotelRoom room;
+    CHECK(hotelViewRoom(first, 101, &room) == 1 && room.roomNumber == 101 && room.bookingCount == 1);
+    CHECK(hotelViewRoom(first, 103, &room) == 0);
+    CHECK(hotel->views.kept == 2); // One copy of each room that changed, however often it did
 
-    // Test Case 10: View details of all rooms
-    viewRoomDetails(head);
+    // Reports through the view pick their rooms as the view has them, page after page
+    struct HotelReportQuery query;
+    struct HotelCursor cursor = {HOTEL_CURSOR_START, 0};
+    int page[4];
+    hotelInitReport(&query);
+    query.filter = HOTEL_REPORT_RESERVED;
+    CHECK(collectReport(hotel, &query, 4, page, 4) == 3); // Now: all three rooms
+    CHECK(hotelViewReport(first, &query, &cursor, page, 4) == 1 && page[0] == 101 && cursor.state == HOTEL_CURSOR_DONE);
+    query.filter = HOTEL_REPORT_VACANT;
+    query.night = start;
+    cursor.state = HOTEL_CURSOR_START;
+    CHECK(hotelViewReport(first, &query, &cursor, page, 4) == 1 && page[0] == 102);
+    query.night = start + 5; // Bob's night, booked after the view was opened
+    cursor.state = HOTEL_CURSOR_START;
+    CHECK(hotelViewReport(first, &query, &cursor, page, 4) == 2 && page[0] == 101 && page[1] == 102);
+    hotelInitReport(&query);
+    query.guestName = "Alice";
+    cursor.state = HOTEL_CURSOR_START;
+    CHECK(hotelViewReport(first, &query, &cursor, page, 4) == 1 && page[0] == 101);
+    query.guestName = "Bob";
+    cursor.state = HOTEL_CURSOR_START;
+    CHECK(hotelViewReport(first, &query, &cursor, page, 4) == 0 && cursor.state == HOTEL_CURSOR_DONE);
+    hotelInitReport(&query);
+    cursor.state = HOTEL_CURSOR_START;
+    CHECK(hotelViewReport(first, &query, &cursor, page, 1) == 1 && page[0] == 101 && cursor.state == HOTEL_CURSOR_MORE);
+    CHECK(hotelAddRoom(hotel, 104) == HOTEL_OK); // Between pages, and not in the view
+    CHECK(hotelViewReport(first, &query, &cursor, page, 1) == 1 && page[0] == 102 && cursor.state == HOTEL_CURSOR_DONE);
+    CHECK(hotelViewReport(first, &query, &cursor, page, 0) == -1);
 
-    freeRooms(head); // Free allocated memory before exiting
-    return 0;
+    struct HotelView* second = hotelOpenView(hotel);
+    CHECK(hotelCancel(hotel, 101, "Bob", start + 5) == HOTEL_OK);
+    CHECK(hotelViewBookings(second, 101, bookings, 4) == 1 && strcmp(bookings[0].guestName, "Bob") == 0 && bookings[0].occupancy == 2);
+    CHECK(hotelViewBookings(second, 102, bookings, 4) == 1 && bookings[0].extraServices == 1);
+    CHECK(hotelViewBookings(second, 103, bookings, 4) == 1);
+    CHECK(hotelViewBookings(first, 101, bookings, 4) == 1 && strcmp(bookings[0].guestName, "Alice") == 0);
+    CHECK(hotelListBookings(hotel, 101, NULL, 0) == 0);
+
+    struct RoomCopy copy;
+    memset(&copy, 0, sizeof(copy));
+    CHECK(viewRoom(first, 101, &copy) == 1 && copy.bookingCount == 1 && copy.stays[0].checkOut == start + 2 && copy.cancellationTime == 0);
+    CHECK(viewRoom(second, 101, &copy) == 1 && copy.bookingCount == 1 && copy.cancellationTime != 0);
+    CHECK(viewRoom(first, 103, &copy) == 0);
+    freeRoomCopy(&copy);
+
+    hotelCloseView(first);
+    CHECK(hotelReserve(hotel, 101, "Erin", start, 1, 0, 1) == HOTEL_OK); // Frees what only the first view read
+    CHECK(hotel->views.kept == 2);
+    CHECK(hotelViewBookings(second, 101, bookings, 4) == 1 && strcmp(bookings[0].guestName, "Bob") == 0);
+    hotelCloseView(second);
+    CHECK(hotel->views.kept == 0); // The last view to close frees the rest
+    CHECK(hotelReserve(hotel, 102, "Fay", start + 9, 1, 0, 1) == HOTEL_OK && hotel->views.kept == 0); // No copies with no view open
+
+    // A view per slot, then no more until one closes
+    for (int v = 0; v < HOTEL_MAX_VIEWS; ++v) {
+        views[v] = hotelOpenView(hotel);
+        CHECK(views[v] != NULL);
+    }
+    CHECK(hotelOpenView(hotel) == NULL);
+    hotelCloseView(views[0]);
+    views[0] = hotelOpenView(hotel);
+    CHECK(views[0] != NULL);
+    for (int v = 0; v < HOTEL_MAX_VIEWS; ++v) {
+        hotelCloseView(views[v]);
+    }
+    CHECK(checkTotals(hotel));
+    hotelDestroy(hotel);
+
+    // A view reads the same while another thread keeps booking and cancelling
+    pthread_t thread;
+    struct ViewThread work = {hotelCreate(), 2000};
+    int same = 1;
+    hotelAddRoomRange(work.hotel, 3, 3, 1, 16);
+    hotelReserve(work.hotel, 305, "Long Stay", hotelToday() + 20, 30, 0, 1);
+    pthread_create(&thread, NULL, churnRooms, &work);
+    for (int round = 0; round < 50; ++round) {
+        struct HotelView* view = hotelOpenView(work.hotel);
+        uint64_t sum = sumView(view);
+        for (int again = 0; again < 5; ++again) {
+            same = same && sumView(view) == sum;
+        }
+        hotelCloseView(view);
+    }
+    pthread_join(thread, NULL);
+    CHECK(same);
+    hotelCloseView(hotelOpenView(work.hotel)); // Sweeps up after a booking that raced the last close
+    CHECK(hotelFindGuest(work.hotel, "Churn", NULL, 0) == 0 && work.hotel->views.kept == 0);
+    CHECK(checkTotals(work.hotel));
+    hotelDestroy(work.hotel);
+}
+
+// Function to fill in a request to a router, for two nights and one person
+static void setRequest(struct HotelRequest* request, int type, int propertyId, int roomNumber, int checkIn, const char* guestName) {
+    memset(request, 0, sizeof(*request));
+    request->type = type;
+    request->propertyId = propertyId;
+    request->roomNumber = roomNumber;
+    request->checkIn = checkIn;
+    request->nights = 2;
+    request->occupancy = 1;
+    request->guestName = guestName;
+}
+
+// Define what one client thread of testRouter works on
+struct RouterThread {
+    struct HotelRouter* router; // Router shared by the threads
+    int id; // Thread number: the thread books room 101 + id of every property
+    int booked; // Bookings that succeeded
+};
+
+// Function run by each client thread: book its own room of every property, all in one run
+static void* routeBookings(void* argument) {
+    struct RouterThread* thread = (struct RouterThread*)argument;
+    struct HotelRouterClient* client = hotelRouterConnect(thread->router);
+    struct HotelRequest requests[TEST_PROPERTIES];
+    for (int p = 0; p < TEST_PROPERTIES; ++p) {
+        setRequest(&requests[p], HOTEL_REQUEST_RESERVE, 1000 + p, 101 + thread->id, hotelToday() + 1, "Router Guest");
+    }
+    hotelRouterRun(client, requests, TEST_PROPERTIES);
+    for (int p = 0; p < TEST_PROPERTIES; ++p) {
+        thread->booked += requests[p].status == HOTEL_OK;
+    }
+    hotelRouterDisconnect(client);
+    return NULL;
+}
+
+// Function to test the property router: requests reach the right property in order, answers come back in
+// place, and clients on several threads share the shards
+static void testRouter() {
+    struct HotelRouter* router = hotelRouterCreate(4);
+    struct HotelRouterClient* client = hotelRouterConnect(router);
+    struct HotelRouterClient* clients[ROUTER_MAX_CLIENTS];
+    struct HotelRequest* requests = (struct HotelRequest*)malloc(TEST_PROPERTIES * 9 * sizeof(struct HotelRequest));
+    struct HotelRequest one[7];
+    int start = hotelToday() + 1, count = 0, answered = 1, shards[4] = {0, 0, 0, 0};
+    CHECK(hotelRouterCreate(0) == NULL && hotelRouterCreate(HOTEL_ROUTER_MAX_SHARDS + 1) == NULL);
+    CHECK(router != NULL && client != NULL);
+
+    // Each property, then its rooms, in one run: far more than a ring holds, in order for each property
+    for (int p = 0; p < TEST_PROPERTIES; ++p) {
+        setRequest(&requests[count++], HOTEL_REQUEST_ADD_PROPERTY, 1000 + p, 0, 0, NULL);
+        for (int r = 0; r < 8; ++r) {
+            setRequest(&requests[count++], HOTEL_REQUEST_ADD_ROOM, 1000 + p, 101 + r, 0, NULL);
+        }
+        shards[hotelRouterShard(router, 1000 + p)]++;
+    }
+    CHECK(hotelRouterRun(client, requests, count) == count);
+    for (int i = 0; i < count; ++i) {
+        answered = answered && requests[i].status == HOTEL_OK;
+    }
+    CHECK(answered);
+    CHECK(shards[0] > 0 && shards[1] > 0 && shards[2] > 0 && shards[3] > 0);
+
+    setRequest(&one[0], HOTEL_REQUEST_ADD_PROPERTY, 1000, 0, 0, NULL);
+    setRequest(&one[1], HOTEL_REQUEST_RESERVE, 5, 101, start, "Lost Guest"); // No such property
+    setRequest(&one[2], HOTEL_REQUEST_RESERVE, 1000, 108, start, "First Guest");
+    setRequest(&one[3], HOTEL_REQUEST_RESERVE, 1000, 108, start + 1, "Second Guest");
+    setRequest(&one[4], HOTEL_REQUEST_FREE_ROOMS, 1000, 0, start, NULL);
+    setRequest(&one[5], HOTEL_REQUEST_CANCEL, 1000, 108, start, "First Guest");
+    setRequest(&one[6], 99, 1000, 0, 0, NULL);
+    CHECK(hotelRouterRun(client, one, 7) == 7);
+    CHECK(one[0].status == HOTEL_PROPERTY_EXISTS && one[1].status == HOTEL_PROPERTY_NOT_FOUND);
+    CHECK(one[2].status == HOTEL_OK && one[3].status == HOTEL_ROOM_UNAVAILABLE);
+    CHECK(one[4].status == HOTEL_OK && one[4].freeRooms == 7 && one[5].status == HOTEL_OK && one[6].status == -1);
+    CHECK(strcmp(hotelStatusName(HOTEL_PROPERTY_NOT_FOUND), "property-not-found") == 0);
+    hotelRouterDisconnect(client);
+
+    // Threads with clients of their own, each booking its own room of every property
+    pthread_t threads[TEST_THREADS];
+    struct RouterThread work[TEST_THREADS];
+    int booked = 0;
+    for (int t = 0; t < TEST_THREADS; ++t) {
+        work[t].router = router;
+        work[t].id = t;
+        work[t].booked = 0;
+        pthread_create(&threads[t], NULL, routeBookings, &work[t]);
+    }
+    for (int t = 0; t < TEST_THREADS; ++t) {
+        pthread_join(threads[t], NULL);
+        booked += work[t].booked;
+    }
+    CHECK(booked == TEST_THREADS * TEST_PROPERTIES);
+    for (int p = 0; p < TEST_PROPERTIES; ++p) {
+        setRequest(&requests[p], HOTEL_REQUEST_FREE_ROOMS, 1000 + p, 0, start, NULL);
+    }
+    client = hotelRouterConnect(router); // A slot given back is used again
+    CHECK(client != NULL && hotelRouterRun(client, requests, TEST_PROPERTIES) == TEST_PROPERTIES);
+    for (int p = 0; p < TEST_PROPERTIES; ++p) {
+        answered = answered && requests[p].freeRooms == 8 - TEST_THREADS;
+    }
+    CHECK(answered);
+    hotelRouterDisconnect(client);
+
+    // Every client slot can be taken, and no more
+    for (count = 0; count < ROUTER_MAX_CLIENTS && (clients[count] = hotelRouterConnect(router)) != NULL; ++count) {
+    }
+    CHECK(count == ROUTER_MAX_CLIENTS && hotelRouterConnect(router) == NULL);
+    hotelRouterDisconnect(clients[7]);
+    CHECK(hotelRouterConnect(router) == clients[7]);
+    free(requests);
+    hotelRouterDestroy(router);
+}
+
+// Function to check whether a line starts with a prefix
+static int startsWith(const char* line, const char* prefix) {
+    return strncmp(line, prefix, strlen(prefix)) == 0;
 }
 
+// Function to test the latency buckets, the operation counts and the Prometheus dump
+static void testMetrics() {
+    struct ThreadMetrics* before = (struct ThreadMetrics*)malloc(sizeof(struct ThreadMetrics));
+    struct ThreadMetrics* after = (struct ThreadMetrics*)malloc(sizeof(struct ThreadMetrics));
+    struct Hotel* hotel = hotelCreate();
+    int start = hotelToday() + 1, booked;
+    char path[128], line[256];
+
+    int ordered = 1, tight = 1;
+    for (uint64_t ns = 0; ns < ((uint64_t)1 << 36); ns = ns * 17 / 16 + 1) { // Every bucket holds its values, and is narrow
+        int bucket = latencyBucket(ns);
+        uint64_t low = bucket == 0 ? 0 : latencyBucketLimit(bucket - 1);
+        ordered = ordered && low <= ns && ns < latencyBucketLimit(bucket);
+        tight = tight && (latencyBucketLimit(bucket) - low) * LATENCY_SUB_BUCKETS <= (low > LATENCY_SUB_BUCKETS ? low : LATENCY_SUB_BUCKETS);
+    }
+    CHECK(ordered && tight);
+    CHECK(latencyBucket((uint64_t)1 << 40) == LATENCY_BUCKETS - 1);
+
+    hotelSetMetricsSampling(1); // Time everything, so the latency counts are exact
+    hotelAddRoom(hotel, 7);
+    collectMetrics(before);
+    CHECK(hotelAddRoom(hotel, 8) == HOTEL_OK);
+    CHECK(hotelAddRoom(hotel, 8) == HOTEL_ROOM_EXISTS);
+    CHECK(hotelReserve(hotel, 7, "Metric Guest", start, 2, 0, 1) == HOTEL_OK);
+    CHECK(hotelReserve(hotel, 7, "Metric Guest", start, 2, 0, 1) == HOTEL_ROOM_UNAVAILABLE);
+    CHECK(hotelReserve(hotel, 9, "Metric Guest", start, 2, 0, 1) == HOTEL_ROOM_NOT_FOUND);
+    CHECK(hotelCancel(hotel, 8, "Metric Guest", start) == HOTEL_BOOKING_NOT_FOUND);
+    CHECK(hotelFindGuest(hotel, "Metric Guest", NULL, 0) == 1);
+    collectMetrics(after);
+    const struct OperationMetrics* reserveBefore = &before->operations[METRIC_RESERVE];
+    const struct OperationMetrics* reserveAfter = &after->operations[METRIC_RESERVE];
+    CHECK(after->operations[METRIC_ADD_ROOM].results[HOTEL_OK] - before->operations[METRIC_ADD_ROOM].results[HOTEL_OK] == 1);
+    CHECK(after->operations[METRIC_ADD_ROOM].results[HOTEL_ROOM_EXISTS] - before->operations[METRIC_ADD_ROOM].results[HOTEL_ROOM_EXISTS] == 1);
+    CHECK(reserveAfter->results[HOTEL_OK] - reserveBefore->results[HOTEL_OK] == 1);
+    CHECK(reserveAfter->results[HOTEL_ROOM_UNAVAILABLE] - reserveBefore->results[HOTEL_ROOM_UNAVAILABLE] == 1);
+    CHECK(reserveAfter->results[HOTEL_ROOM_NOT_FOUND] - reserveBefore->results[HOTEL_ROOM_NOT_FOUND] == 1);
+    CHECK(after->operations[METRIC_CANCEL].results[HOTEL_BOOKING_NOT_FOUND] - before->operations[METRIC_CANCEL].results[HOTEL_BOOKING_NOT_FOUND] == 1);
+    CHECK(after->operations[METRIC_VIEW].results[HOTEL_OK] - before->operations[METRIC_VIEW].results[HOTEL_OK] == 1);
+    uint64_t timed = 0, lookups = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+        timed += reserveAfter->latency[b] - reserveBefore->latency[b];
+    }
+    for (int p = 0; p < PROBE_BUCKETS; ++p) {
+        lookups += after->probes[p] - before->probes[p];
+    }
+    CHECK(timed == 3 && reserveAfter->latencyNanoseconds > reserveBefore->latencyNanoseconds);
+    CHECK(lookups >= 5); // At least one per add, booking and cancellation
+
+    hotelSetMetricsSampling(0); // Off: nothing is counted
+    collectMetrics(before);
+    hotelReserve(hotel, 8, "Metric Guest", start, 2, 0, 1);
+    collectMetrics(after);
+    CHECK(after->operations[METRIC_RESERVE].results[HOTEL_OK] == before->operations[METRIC_RESERVE].results[HOTEL_OK]);
+    hotelSetMetricsSampling(METRICS_SAMPLE_INTERVAL);
+
+    // Threads that have exited hand their blocks on, so however many rounds of threads have run (two here, and
+    // one in testConcurrentBookings) there are never more blocks than threads alive at once
+    runBookingThreads(hotel, 100000, &booked);
+    collectMetrics(before);
+    runBookingThreads(hotel, 200000, &booked);
+    CHECK(collectMetrics(after) <= 1 + TEST_THREADS && after->inUse == 1);
+    CHECK(after->operations[METRIC_RESERVE].results[HOTEL_OK] - before->operations[METRIC_RESERVE].results[HOTEL_OK]
+          == 2 * TEST_THREADS * TEST_THREAD_ROOMS);
+
+    workPath("hotel.prom", path, sizeof(path));
+    CHECK(hotelWriteMetrics(path) == 1);
+    FILE* file = fopen(path, "r");
+    int unavailable = 0, histogram = 0, quantile = 0, probes = 0;
+    while (file != NULL && fgets(line, sizeof(line), file) != NULL) {
+        unavailable += startsWith(line, "hotel_operations_total{operation=\"reserve\",result=\"room-unavailable\"} ");
+        histogram += startsWith(line, "hotel_operation_latency_seconds_bucket{operation=\"cancel\",le=\"+Inf\"} ");
+        quantile += startsWith(line, "hotel_operation_latency_quantile_seconds{operation=\"reserve\",quantile=\"0.99\"} ");
+        probes += startsWith(line, "hotel_room_lookup_probes_count ");
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+    CHECK(unavailable == 1 && histogram == 1 && quantile == 1 && probes == 1);
+    CHECK(hotelWriteMetrics("/nonexistent/hotel.prom") == 0);
+    remove(path);
+
+    hotelDestroy(hotel);
+    free(before);
+    free(after);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        extrDirectory = argv[1];
+    }
+    snprintf(workDirectory, sizeof(workDirectory), "/tmp/hotel_test.XXXXXX");
+    if (mkdtemp(workDirectory) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    CHECK(hotelCoreVersion() == HOTEL_CORE_VERSION);
+
+    testDates();
+    testRooms();
+    testBulkRooms();
+    testReservations();
+    testAvailability();
+    testGuestIndex();
+    testReports();
+    testQuotes();
+    testTotals();
+    testPersistence();
+    testSlidingHorizon();
+    testHistory();
+    testConcurrentBookings();
+    testGroupBookings();
+    testViews();
+    testRouter();
+    testMetrics();
+
+    rmdir(workDirectory);
+    printf("%d checks, %d failed\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
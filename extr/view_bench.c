@@ -0,0 +1,81 @@
+// Size and scan benchmark for the room reports in Hotel_Reservation_System.c
+// Build: gcc -std=c99 -O2 -pthread -o view_bench extr/view_bench.c hotel_core.c
+// Run:   ./view_bench [rooms] [bookings per room]
+// Prints the size of the per-room and per-booking records, the time to make the bookings, and the
+// time of viewReservations and viewRoomDetails paging through the whole hotel with their output sent to
+// /dev/null, and of their first page alone.
+#define main hotelMain // Reuse the engine without its menu
+#include "../Hotel_Reservation_System.c"
+#undef main
+#include "bench_util.h"
+
+#define BENCH_ROUNDS 5 // Each report is timed this many times; the best run is printed
+
+// Function to time the best of BENCH_ROUNDS runs of a report over every room, all pages or the first only (returns seconds)
+static double timeReport(struct Hotel* hotel,
+                         int (*report)(struct Hotel*, struct HotelView*, const struct HotelReportQuery*, struct HotelCursor*),
+                         int allPages) {
+    struct HotelReportQuery query;
+    double best = 1e30;
+    hotelInitReport(&query);
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        struct HotelCursor cursor = {HOTEL_CURSOR_START, 0};
+        double started = nowSeconds();
+        struct HotelView* view = openView(hotel);
+        while (report(hotel, view, &query, &cursor) && allPages) {
+        }
+        closeView(view);
+        flushOutput();
+        double elapsed = nowSeconds() - started;
+        best = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int rooms = argc > 1 ? atoi(argv[1]) : 100000;
+    int perRoom = argc > 2 ? atoi(argv[2]) : 2;
+    struct Hotel hotel;
+    char guestName[32];
+    rooms = rooms < 1 ? 1 : rooms;
+
+    printf("sizeof(struct Room) %zu, sizeof(struct RoomDetails) %zu, sizeof(struct Booking) %zu\n",
+           sizeof(struct Room), sizeof(struct RoomDetails), sizeof(struct Booking));
+    initHotel(&hotel);
+    for (int r = 0; r < rooms; ++r) {
+        insertRoom(&hotel, r);
+    }
+    double started = nowSeconds();
+    for (int r = 0; r < rooms; ++r) {
+        for (int b = 0; b < perRoom; ++b) {
+            snprintf(guestName, sizeof(guestName), "Guest %d", (r * 7 + b) % 5000);
+            reserveRoom(&hotel, r, guestName, hotel.calendarStart + b * 3, 2, b & 1, 1);
+        }
+        if (perRoom > 0 && r % 3 == 0) { // Some rooms get a cancellation time too
+            snprintf(guestName, sizeof(guestName), "Guest %d", (r * 7 + perRoom - 1) % 5000);
+            releaseRoom(&hotel, r, guestName, hotel.calendarStart + (perRoom - 1) * 3);
+        }
+    }
+    double booking = nowSeconds() - started;
+    long long bookings = 0;
+    for (int r = 0; r < hotel.roomCount; ++r) {
+        bookings += hotel.rooms[r].bookingCount;
+    }
+
+    output.descriptor = open("/dev/null", O_WRONLY); // Time the formatting, not the terminal
+    double reservations = timeReport(&hotel, viewReservations, 1);
+    double details = timeReport(&hotel, viewRoomDetails, 1);
+    double reservationsPage = timeReport(&hotel, viewReservations, 0);
+    double detailsPage = timeReport(&hotel, viewRoomDetails, 0);
+    close(output.descriptor);
+    output.descriptor = 1;
+
+    printf("%d rooms, %lld bookings made in %.3f s (%.0f changes/s)\n", rooms, bookings, booking,
+           (rooms * (double)perRoom + (perRoom > 0 ? rooms / 3 : 0)) / booking);
+    printf("viewReservations %8.3f s  (%.0f ns per room)\n", reservations, reservations * 1e9 / rooms);
+    printf("viewRoomDetails  %8.3f s  (%.0f ns per room)\n", details, details * 1e9 / rooms);
+    printf("first page of %d rooms: viewReservations %.1f us, viewRoomDetails %.1f us\n", REPORT_PAGE_ROOMS,
+           reservationsPage * 1e6, detailsPage * 1e6);
+    freeHotel(&hotel);
+    return 0;
+}
@@ -0,0 +1,4796 @@
+// Reservation core of the hotel: rooms, calendars, night bitmaps, the guest index, rate plans, snapshots and the
+// journal, behind the C interface in hotel_core.h (front ends in this tree also reach in through hotel_internal.h)
+#define _POSIX_C_SOURCE 200809L // Expose fileno, fsync and mmap under a strict -std=c99 build
+#include "hotel_internal.h"
+#include <sched.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_AVX2_KERNELS 1 // Compile the AVX2 scan kernels; they are only used if the CPU supports them
+#endif
+#if defined(__SANITIZE_THREAD__)
+#define SCALAR_NIGHT_KERNELS 1 // ThreadSanitizer cannot tell a vector load of relaxed-stored words from a race
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define SCALAR_NIGHT_KERNELS 1
+#endif
+#endif
+
+static const char* hotelStatusNames[] = {"ok", "room-not-found", "room-unavailable", "over-capacity", // By enum HotelStatus
+                                         "booking-not-found", "invalid-stay", "invalid-name", "room-exists",
+                                         "property-not-found", "property-exists"};
+static const char* metricOperationNames[] = {"add_room", "load_rooms", "reserve", "cancel", "view", "reserve_group"}; // By enum MetricOperation
+static struct ThreadMetrics* metricsThreads = NULL; // Metrics block of every thread that has recorded any, newest first
+static int metricsInterval = METRICS_SAMPLE_INTERVAL; // Each thread times one in this many operations; 0 turns metrics off
+static pthread_once_t metricsOnce = PTHREAD_ONCE_INIT; // Guards the creation of metricsKey
+static pthread_key_t metricsKey; // Releases a thread's metrics block when the thread exits
+static __thread struct ThreadMetrics* threadMetrics = NULL; // Metrics block of the calling thread, once it has one
+
+// Function to convert a calendar date to days since 1970-01-01 (proleptic Gregorian)
+int dayFromDate(int year, int month, int day) {
+    year -= month <= 2; // Count January and February as months of the previous year
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// Function to convert days since 1970-01-01 back to a calendar date
+void dateFromDay(int dayNumber, int* year, int* month, int* day) {
+    dayNumber += 719468;
+    int era = (dayNumber >= 0 ? dayNumber : dayNumber - 146096) / 146097;
+    int dayOfEra = dayNumber - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int shiftedMonth = (5 * dayOfYear + 2) / 153; // Months counted from March
+    *day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    *month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    *year = yearOfEra + era * 400 + (*month <= 2);
+}
+
+// Function to parse a YYYY-MM-DD date (returns 1 on success, 0 if the text is not a valid date)
+int parseDate(const char* text, int* dayNumber) {
+    int year, month, day, checkYear, checkMonth, checkDay;
+    if (sscanf(text, "%d-%d-%d", &year, &month, &day) != 3 || month < 1 || month > 12 || day < 1) {
+        return 0;
+    }
+    *dayNumber = dayFromDate(year, month, day);
+    dateFromDay(*dayNumber, &checkYear, &checkMonth, &checkDay); // Rejects dates such as 2026-02-30
+    return checkDay == day && checkMonth == month;
+}
+
+// Function to check that a stay falls within the dates the hotel handles and lasts one to STAY_MAX_NIGHTS nights
+// (so checkIn + nights never overflows)
+int isValidStay(int checkIn, int nights) {
+    return checkIn >= STAY_FIRST_DAY && checkIn <= STAY_LAST_DAY && nights >= 1 && nights <= STAY_MAX_NIGHTS
+        && nights <= STAY_LAST_DAY + 1 - checkIn;
+}
+
+// Function to get the offset of local time from UTC, in seconds, at a given time
+static int64_t utcOffset(int64_t when) {
+    time_t moment = (time_t)when;
+    struct tm local;
+#ifdef _WIN32
+    localtime_s(&local, &moment);
+#else
+    localtime_r(&moment, &local);
+#endif
+    return (int64_t)dayFromDate(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * 86400
+         + local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec - when;
+}
+
+// Function to convert epoch seconds to local seconds (seconds since 1970-01-01 00:00 local time)
+// (localtime_r re-reads the timezone on every call, so each thread keeps the offset of the last block
+// of LOCAL_TIME_BLOCK seconds it converted; a block whose offset differs at its two ends holds a
+// daylight saving change, and is converted exactly instead)
+int64_t localSeconds(int64_t when) {
+    static __thread int64_t cachedBlock = INT64_MIN; // One cache per thread, so no locking is needed
+    static __thread int64_t cachedOffset;
+    int64_t block = (when >= 0 ? when : when - (LOCAL_TIME_BLOCK - 1)) / LOCAL_TIME_BLOCK; // Rounded down
+    if (block != cachedBlock) {
+        int64_t offset = utcOffset(block * LOCAL_TIME_BLOCK);
+        if (utcOffset(block * LOCAL_TIME_BLOCK + LOCAL_TIME_BLOCK - 1) != offset) {
+            return when + utcOffset(when);
+        }
+        cachedBlock = block;
+        cachedOffset = offset;
+    }
+    return when + cachedOffset;
+}
+
+// Function to get the current local date as days since 1970-01-01
+int today() {
+    int64_t local = localSeconds((int64_t)time(NULL));
+    return (int)((local >= 0 ? local : local - 86399) / 86400);
+}
+
+// Function to initialize a room with given room number
+void initRoom(struct Room* room, struct RoomDetails* details, int roomNumber) {
+    room->roomNumber = roomNumber; // Set the room number
+    room->isReserved = 0; // Initialize reservation status to not reserved
+    room->capacity = DEFAULT_ROOM_CAPACITY; // Every room holds the default number of people
+    room->bookingCount = 0; // Start with an empty calendar
+    room->stays = NULL; // The calendar is allocated on the first booking
+    details->bookings = NULL;
+    details->bookingCapacity = 0;
+    details->floor = roomNumber / FLOOR_NUMBERING; // Unless the caller knows better
+    details->cancellationTime = 0; // No cancellation yet
+}
+
+// Function to get the time in nanoseconds from the monotonic clock
+static uint64_t monotonicNanoseconds() {
+    struct timespec clock;
+    clock_gettime(CLOCK_MONOTONIC, &clock);
+    return (uint64_t)clock.tv_sec * 1000000000u + (uint64_t)clock.tv_nsec;
+}
+
+// Function to hand the metrics block of a thread that has exited to the next new thread (its counts stay in)
+static void releaseThreadMetrics(void* block) {
+    __atomic_store_n(&((struct ThreadMetrics*)block)->inUse, 0, __ATOMIC_RELEASE);
+}
+
+// Function to create the key whose destructor releases a thread's metrics block (run once)
+static void createMetricsKey() {
+    pthread_key_create(&metricsKey, releaseThreadMetrics);
+}
+
+// Function to get the calling thread's metrics block, taking over a released one or adding a new one on first
+// use (NULL if metrics are off or there is no memory for a block)
+static struct ThreadMetrics* currentMetrics() {
+    if (__atomic_load_n(&metricsInterval, __ATOMIC_RELAXED) <= 0) {
+        return NULL;
+    }
+    struct ThreadMetrics* metrics = threadMetrics;
+    if (metrics != NULL) {
+        return metrics;
+    }
+    pthread_once(&metricsOnce, createMetricsKey);
+    for (metrics = __atomic_load_n(&metricsThreads, __ATOMIC_ACQUIRE); metrics != NULL; metrics = metrics->next) {
+        int idle = 0;
+        if (__atomic_compare_exchange_n(&metrics->inUse, &idle, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+    if (metrics == NULL) {
+        metrics = (struct ThreadMetrics*)calloc(1, sizeof(struct ThreadMetrics));
+        if (metrics == NULL) {
+            return NULL;
+        }
+        metrics->inUse = 1;
+        metrics->next = __atomic_load_n(&metricsThreads, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&metricsThreads, &metrics->next, metrics, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+    pthread_setspecific(metricsKey, metrics);
+    threadMetrics = metrics;
+    return metrics;
+}
+
+// Function to add to a counter of the calling thread's metrics block (only its thread writes it; readers
+// load it without a lock, so it is stored atomically but needs no read-modify-write)
+static void countMetric(uint64_t* counter, uint64_t amount) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + amount, __ATOMIC_RELAXED);
+}
+
+// Function to find the latency bucket of a duration: exact below LATENCY_SUB_BUCKETS ns, then LATENCY_SUB_BUCKETS
+// buckets to each power of two, like an HDR histogram with one significant hexadecimal digit
+int latencyBucket(uint64_t nanoseconds) {
+    if (nanoseconds < LATENCY_SUB_BUCKETS) {
+        return (int)nanoseconds;
+    }
+    int shift = 63 - __builtin_clzll(nanoseconds) - LATENCY_SUB_BITS;
+    int bucket = shift * LATENCY_SUB_BUCKETS + (int)(nanoseconds >> shift);
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+// Function to get the shortest duration past a latency bucket (everything in the bucket is shorter)
+uint64_t latencyBucketLimit(int bucket) {
+    if (bucket < LATENCY_SUB_BUCKETS) {
+        return (uint64_t)bucket + 1;
+    }
+    int shift = bucket / LATENCY_SUB_BUCKETS - 1;
+    return (uint64_t)(bucket % LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS + 1) << shift;
+}
+
+// Function to start an operation (returns its start time if the calling thread times this one, or 0)
+static uint64_t startOperation() {
+    struct ThreadMetrics* metrics = currentMetrics();
+    int interval = __atomic_load_n(&metricsInterval, __ATOMIC_RELAXED);
+    if (metrics == NULL || (--metrics->untilTimed > 0 && metrics->untilTimed < interval)) { // A shorter interval starts now
+        return 0;
+    }
+    metrics->untilTimed = interval;
+    return monotonicNanoseconds();
+}
+
+// Function to count a finished operation under its result (an enum HotelStatus), and its latency if it was timed
+static void finishOperation(int operation, uint64_t started, int status) {
+    struct ThreadMetrics* metrics = currentMetrics();
+    if (metrics == NULL) {
+        return;
+    }
+    struct OperationMetrics* counts = &metrics->operations[operation];
+    countMetric(&counts->results[status >= 0 && status < METRICS_STATUSES ? status : 0], 1);
+    if (started != 0) {
+        uint64_t elapsed = monotonicNanoseconds() - started;
+        countMetric(&counts->latency[latencyBucket(elapsed)], 1);
+        countMetric(&counts->latencyNanoseconds, elapsed);
+    }
+}
+
+// Function to hash a room number into the index (Fibonacci hashing)
+unsigned int hashRoomNumber(int roomNumber) {
+    unsigned int h = (unsigned int)roomNumber * 2654435761u;
+    return h ^ (h >> 16);
+}
+
+// Function to store a room table position in the index without checking the load factor
+// (a number already in the index keeps its room; callers check with findRoom first)
+static void indexPut(struct RoomIndex* index, int roomNumber, int slot) {
+    unsigned int mask = (unsigned int)index->capacity - 1;
+    unsigned int i = hashRoomNumber(roomNumber) & mask;
+    while (index->slots[i].slot >= 0) { // Probe until an empty or matching slot
+        if (index->slots[i].roomNumber == roomNumber) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+    index->slots[i].roomNumber = roomNumber;
+    __atomic_store_n(&index->slots[i].slot, slot, __ATOMIC_RELEASE); // Lookups of other rooms may be probing past
+    index->count++;
+}
+
+// Function to grow the index until rooms more rooms fit below a load factor of 0.7, rehashing every room once
+static void indexGrow(struct RoomIndex* index, int rooms) {
+    struct IndexSlot* oldSlots = index->slots;
+    int oldCapacity = index->capacity;
+    index->capacity = oldCapacity ? oldCapacity * 2 : INDEX_INITIAL_CAPACITY;
+    while ((int64_t)(index->count + rooms) * 10 > (int64_t)index->capacity * 7) {
+        index->capacity *= 2;
+    }
+    index->slots = (struct IndexSlot*)malloc(index->capacity * sizeof(struct IndexSlot));
+    for (int i = 0; i < index->capacity; ++i) {
+        index->slots[i].slot = -1; // Mark every slot as empty
+    }
+    index->count = 0;
+    for (int i = 0; i < oldCapacity; ++i) {
+        if (oldSlots[i].slot >= 0) {
+            indexPut(index, oldSlots[i].roomNumber, oldSlots[i].slot);
+        }
+    }
+    free(oldSlots);
+}
+
+// Function to look a number up in an index without a lock, counting the slots probed into *probes
+// (returns its slot, or -1 if it is not there)
+static int indexProbe(const struct RoomIndex* index, int roomNumber, int* probes) {
+    unsigned int mask = (unsigned int)index->capacity - 1;
+    unsigned int i = hashRoomNumber(roomNumber) & mask;
+    int slot;
+    *probes = 1;
+    while ((slot = __atomic_load_n(&index->slots[i].slot, __ATOMIC_ACQUIRE)) >= 0) { // An empty slot ends the probe sequence
+        if (index->slots[i].roomNumber == roomNumber) {
+            return slot;
+        }
+        i = (i + 1) & mask;
+        ++*probes;
+    }
+    return -1;
+}
+
+// Function to look a number up in an index without a lock (returns its slot, or -1 if it is not there)
+static int indexFind(const struct RoomIndex* index, int roomNumber) {
+    int probes;
+    return indexProbe(index, roomNumber, &probes);
+}
+
+// Function to initialize an empty name pool (handle 0 is the empty string)
+static void initNamePool(struct NamePool* pool) {
+    pool->chunks = (char**)calloc(NAME_MAX_CHUNKS, sizeof(char*));
+    pool->sizes = (uint32_t*)calloc(NAME_MAX_CHUNKS, sizeof(uint32_t));
+    pool->chunks[0] = (char*)malloc((size_t)1 << NAME_CHUNK_BITS); // Pages are only touched as names fill them
+    pool->chunks[0][0] = '\0';
+    pool->sizes[0] = 1;
+    pool->chunkCount = 1;
+    pool->loadedChunks = 0;
+    pool->bytes = 1;
+}
+
+// Function to free the chunks the name pool allocated
+static void freeNamePool(struct NamePool* pool) {
+    for (int c = pool->loadedChunks; c < pool->chunkCount; ++c) {
+        free(pool->chunks[c]);
+    }
+    free(pool->chunks);
+    free(pool->sizes);
+    pool->chunks = NULL;
+    pool->sizes = NULL;
+    pool->chunkCount = 0;
+}
+
+// Function to get the name a handle stands for
+const char* poolString(const struct NamePool* pool, uint32_t handle) {
+    return pool->chunks[handle >> NAME_CHUNK_BITS] + (handle & ((1u << NAME_CHUNK_BITS) - 1));
+}
+
+// Function to append a name to the pool (returns its handle; the caller checks it is not there already)
+static uint32_t poolAdd(struct NamePool* pool, const char* name, size_t length) {
+    if (length == 0) {
+        return 0;
+    }
+    int chunk = pool->chunkCount - 1;
+    if (pool->sizes[chunk] + length + 1 > (1u << NAME_CHUNK_BITS)) { // Start a new chunk; the old one's tail stays unused
+        if (pool->chunkCount == NAME_MAX_CHUNKS) {
+            fprintf(stderr, "The guest name pool is full.\n");
+            abort();
+        }
+        chunk = pool->chunkCount;
+        pool->chunks[chunk] = (char*)malloc((size_t)1 << NAME_CHUNK_BITS);
+        pool->sizes[chunk] = 0;
+        pool->chunkCount++;
+    }
+    uint32_t offset = pool->sizes[chunk];
+    memcpy(pool->chunks[chunk] + offset, name, length);
+    pool->chunks[chunk][offset + length] = '\0';
+    pool->sizes[chunk] += (uint32_t)length + 1;
+    pool->bytes += length + 1;
+    return (uint32_t)chunk << NAME_CHUNK_BITS | offset;
+}
+
+// Function to fold a character for guest search (ASCII letters compare without case)
+static unsigned char foldChar(char ch) {
+    return ch >= 'A' && ch <= 'Z' ? (unsigned char)(ch - 'A' + 'a') : (unsigned char)ch;
+}
+
+// Function to compare two guest names without case, like strcmp
+static int compareFolded(const char* a, const char* b) {
+    while (*a != '\0' && foldChar(*a) == foldChar(*b)) {
+        a++;
+        b++;
+    }
+    return (int)foldChar(*a) - (int)foldChar(*b);
+}
+
+// Function to hash a guest name exactly as booked (FNV-1a)
+uint32_t hashGuestName(const char* name) {
+    uint32_t hash = 2166136261u;
+    while (*name != '\0') {
+        hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    }
+    return hash;
+}
+
+// Function to list the trigrams of a folded name padded as "  name " (returns how many; trigrams needs MAX_NAME_LENGTH + 2)
+static int guestTrigrams(const char* name, uint32_t* trigrams) {
+    uint32_t window = ((uint32_t)' ' << 8) | ' ';
+    int count = 0;
+    for (const char* cursor = name; ; ++cursor) {
+        unsigned char ch = *cursor != '\0' ? foldChar(*cursor) : ' ';
+        window = ((window << 8) | ch) & 0xffffff;
+        trigrams[count++] = window | (1u << 24); // Never 0, which marks an empty trigram slot
+        if (*cursor == '\0') {
+            return count;
+        }
+    }
+}
+
+// Function to find a trigram's posting list, adding an empty one if create is set (NULL if it has none)
+static struct TrigramSlot* findTrigram(struct GuestIndex* index, uint32_t trigram, int create) {
+    if (create && (index->trigramCount + 1) * 10 > index->trigramCapacity * 7) { // Grow at load factor 0.7
+        struct TrigramSlot* old = index->trigrams;
+        int oldCapacity = index->trigramCapacity;
+        index->trigramCapacity *= 2;
+        index->trigrams = (struct TrigramSlot*)calloc(index->trigramCapacity, sizeof(struct TrigramSlot));
+        for (int i = 0; i < oldCapacity; ++i) {
+            if (old[i].trigram != 0) {
+                unsigned int j = (old[i].trigram * 2654435761u) & (unsigned int)(index->trigramCapacity - 1);
+                while (index->trigrams[j].trigram != 0) {
+                    j = (j + 1) & (unsigned int)(index->trigramCapacity - 1);
+                }
+                index->trigrams[j] = old[i];
+            }
+        }
+        free(old);
+    }
+    unsigned int mask = (unsigned int)index->trigramCapacity - 1;
+    unsigned int i = (trigram * 2654435761u) & mask;
+    while (index->trigrams[i].trigram != trigram) {
+        if (index->trigrams[i].trigram == 0) {
+            if (!create) {
+                return NULL;
+            }
+            index->trigrams[i].trigram = trigram;
+            index->trigramCount++;
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return &index->trigrams[i];
+}
+
+// Function to initialize an empty guest index
+static void initGuestIndex(struct GuestIndex* index) {
+    initNamePool(&index->names);
+    index->guests = NULL;
+    index->guestCount = 0;
+    index->guestCapacity = 0;
+    index->slotCapacity = GUEST_INDEX_INITIAL_CAPACITY;
+    index->slots = (struct GuestSlot*)malloc(index->slotCapacity * sizeof(struct GuestSlot));
+    for (int i = 0; i < index->slotCapacity; ++i) {
+        index->slots[i].guest = -1; // Mark every slot as empty
+    }
+    index->sorted = NULL;
+    index->sortedCount = 0;
+    index->trigramCapacity = GUEST_TRIGRAM_INITIAL_CAPACITY;
+    index->trigramCount = 0;
+    index->trigramGuests = 0;
+    index->trigrams = (struct TrigramSlot*)calloc(index->trigramCapacity, sizeof(struct TrigramSlot));
+    index->scores = NULL;
+    index->touched = NULL;
+    pthread_mutex_init(&index->lock, NULL);
+}
+
+// Function to free everything the guest index holds
+static void freeGuestIndex(struct GuestIndex* index) {
+    for (int i = 0; i < index->guestCount; ++i) {
+        if (index->guests[i].stayCapacity > 1) {
+            free(index->guests[i].list.stays);
+        }
+    }
+    for (int i = 0; i < index->trigramCapacity; ++i) {
+        free(index->trigrams[i].guests);
+    }
+    free(index->guests);
+    free(index->slots);
+    free(index->sorted);
+    free(index->trigrams);
+    free(index->scores);
+    free(index->touched);
+    freeNamePool(&index->names);
+    pthread_mutex_destroy(&index->lock);
+}
+
+// Function to get a guest's booking list, wherever it is held
+static struct GuestStay* guestStays(struct Guest* guest) {
+    return guest->stayCapacity > 1 ? guest->list.stays : &guest->list.stay;
+}
+
+// Function to double a guest slot table, rehashing from the stored hashes without touching the guests
+static void growGuestSlots(struct GuestSlot** slots, int* capacity) {
+    struct GuestSlot* old = *slots;
+    int oldCapacity = *capacity;
+    *capacity *= 2;
+    *slots = (struct GuestSlot*)malloc(*capacity * sizeof(struct GuestSlot));
+    for (int s = 0; s < *capacity; ++s) {
+        (*slots)[s].guest = -1;
+    }
+    unsigned int mask = (unsigned int)*capacity - 1;
+    for (int o = 0; o < oldCapacity; ++o) {
+        if (old[o].guest >= 0) {
+            unsigned int s = old[o].hash & mask;
+            while ((*slots)[s].guest >= 0) {
+                s = (s + 1) & mask;
+            }
+            (*slots)[s] = old[o];
+        }
+    }
+    free(old);
+}
+
+// Function to find a guest by exact name, interning the name if create is set (returns its id, or -1)
+// (a new name is stored in the pool unless handle says where it already is, as for a loaded snapshot)
+static int internGuest(struct GuestIndex* index, const char* name, int create, uint32_t handle) {
+    uint32_t hash = hashGuestName(name);
+    unsigned int mask = (unsigned int)index->slotCapacity - 1;
+    unsigned int i = hash & mask;
+    for (int id; (id = index->slots[i].guest) >= 0; i = (i + 1) & mask) {
+        if (index->slots[i].hash == hash && strcmp(poolString(&index->names, index->guests[id].name), name) == 0) {
+            return id;
+        }
+    }
+    if (!create) {
+        return -1;
+    }
+
+    if (index->guestCount == index->guestCapacity) { // Grow the guest array and search scratch geometrically
+        index->guestCapacity = index->guestCapacity ? index->guestCapacity * 2 : GUEST_INDEX_INITIAL_CAPACITY;
+        index->guests = (struct Guest*)realloc(index->guests, index->guestCapacity * sizeof(struct Guest));
+        index->sorted = (int*)realloc(index->sorted, index->guestCapacity * sizeof(int));
+        free(index->scores);
+        free(index->touched);
+        index->scores = (int*)calloc(index->guestCapacity, sizeof(int));
+        index->touched = (int*)malloc(index->guestCapacity * sizeof(int));
+    }
+    int id = index->guestCount++;
+    struct Guest* guest = &index->guests[id];
+    guest->name = handle != NAME_NONE ? handle : poolAdd(&index->names, name, strlen(name)); // Stored once, never truncated
+    guest->stayCount = 0;
+    guest->stayCapacity = 1; // Room for one booking inline
+    index->slots[i].hash = hash;
+    index->slots[i].guest = id;
+
+    if ((index->guestCount + 1) * 10 > index->slotCapacity * 7) { // Keep the load factor below 0.7
+        growGuestSlots(&index->slots, &index->slotCapacity);
+    }
+    return id;
+}
+
+// Function to record a new booking under its guest's name (returns the handle of the name in the pool;
+// handle is NAME_NONE unless the name is already in the pool there)
+static uint32_t guestIndexAdd(struct GuestIndex* index, const char* name, uint32_t handle, int roomNumber, int checkIn) {
+    pthread_mutex_lock(&index->lock); // Taken inside a room lock, never the other way round
+    int id = internGuest(index, name, 1, handle); // May move the guest array
+    struct Guest* guest = &index->guests[id];
+    if (guest->stayCount == guest->stayCapacity) { // Move to the heap at the second booking, then grow geometrically
+        struct GuestStay* stays = (struct GuestStay*)malloc(guest->stayCapacity * 2 * sizeof(struct GuestStay));
+        memcpy(stays, guestStays(guest), guest->stayCount * sizeof(struct GuestStay));
+        if (guest->stayCapacity > 1) {
+            free(guest->list.stays);
+        }
+        guest->list.stays = stays;
+        guest->stayCapacity *= 2;
+    }
+    struct GuestStay* stay = &guestStays(guest)[guest->stayCount++];
+    stay->roomNumber = roomNumber;
+    stay->checkIn = checkIn;
+    handle = guest->name;
+    pthread_mutex_unlock(&index->lock);
+    return handle;
+}
+
+// Function to drop a cancelled booking from its guest's list (the name stays interned)
+static void guestIndexRemove(struct GuestIndex* index, const char* name, int roomNumber, int checkIn) {
+    pthread_mutex_lock(&index->lock);
+    int id = internGuest(index, name, 0, NAME_NONE);
+    if (id >= 0) {
+        struct Guest* guest = &index->guests[id];
+        struct GuestStay* stays = guestStays(guest);
+        for (int s = 0; s < guest->stayCount; ++s) {
+            if (stays[s].roomNumber == roomNumber && stays[s].checkIn == checkIn) {
+                stays[s] = stays[--guest->stayCount]; // Order does not matter here
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&index->lock);
+}
+
+static __thread const struct GuestIndex* sortingIndex; // Guest index seen by compareGuestIds during qsort
+
+// Function to order guest ids by folded name for qsort
+static int compareGuestIds(const void* a, const void* b) {
+    const struct Guest* guests = sortingIndex->guests;
+    int order = compareFolded(poolString(&sortingIndex->names, guests[*(const int*)a].name),
+                              poolString(&sortingIndex->names, guests[*(const int*)b].name));
+    return order != 0 ? order : *(const int*)a - *(const int*)b;
+}
+
+// Function to bring the sorted name table up to date: guests interned since the last search
+// are sorted on their own and merged in, so a search after a few new names costs O(n), not O(n log n)
+static void sortGuests(struct GuestIndex* index) {
+    int oldCount = index->sortedCount, newCount = index->guestCount - oldCount;
+    if (newCount == 0) {
+        return;
+    }
+    int* added = (int*)malloc(newCount * sizeof(int));
+    for (int i = 0; i < newCount; ++i) {
+        added[i] = oldCount + i; // Ids are handed out in order, so the unsorted ones are the newest
+    }
+    sortingIndex = index;
+    qsort(added, newCount, sizeof(int), compareGuestIds);
+    int a = oldCount - 1, b = newCount - 1;
+    for (int out = index->guestCount - 1; b >= 0; --out) { // Merge from the back, in place
+        if (a >= 0 && compareGuestIds(&index->sorted[a], &added[b]) > 0) {
+            index->sorted[out] = index->sorted[a--];
+        } else {
+            index->sorted[out] = added[b--];
+        }
+    }
+    free(added);
+    index->sortedCount = index->guestCount;
+}
+
+// Function to bring the trigram posting lists up to date with the guests interned since the last
+// fuzzy search (done here rather than on every booking, which would pay for it on the hot path)
+static void indexGuestTrigrams(struct GuestIndex* index) {
+    uint32_t trigrams[MAX_NAME_LENGTH + 2];
+    for (int id = index->trigramGuests; id < index->guestCount; ++id) {
+        int trigramCount = guestTrigrams(poolString(&index->names, index->guests[id].name), trigrams);
+        for (int t = 0; t < trigramCount; ++t) { // Each guest is appended once to each of its trigrams
+            struct TrigramSlot* slot = findTrigram(index, trigrams[t], 1);
+            if (slot->count > 0 && slot->guests[slot->count - 1] == id) {
+                continue; // Trigram repeated within the name
+            }
+            if (slot->count == slot->capacity) {
+                slot->capacity = slot->capacity ? slot->capacity * 2 : 4;
+                slot->guests = (int*)realloc(slot->guests, slot->capacity * sizeof(int));
+            }
+            slot->guests[slot->count++] = id;
+        }
+    }
+    index->trigramGuests = index->guestCount;
+}
+
+// Function to count the edits (insert, delete, substitute) between two names, ignoring case,
+// giving up past limit (returns limit + 1 if there are more)
+static int guestDistance(const char* a, const char* b, int limit) {
+    int lengthA = (int)strlen(a), lengthB = (int)strlen(b);
+    int previous[MAX_NAME_LENGTH + 1], current[MAX_NAME_LENGTH + 1];
+    if (lengthA - lengthB > limit || lengthB - lengthA > limit) {
+        return limit + 1;
+    }
+    for (int j = 0; j <= lengthB; ++j) {
+        previous[j] = j;
+    }
+    for (int i = 1; i <= lengthA; ++i) {
+        int best = current[0] = i;
+        for (int j = 1; j <= lengthB; ++j) {
+            int cost = previous[j - 1] + (foldChar(a[i - 1]) != foldChar(b[j - 1]));
+            cost = previous[j] + 1 < cost ? previous[j] + 1 : cost;
+            cost = current[j - 1] + 1 < cost ? current[j - 1] + 1 : cost;
+            current[j] = cost;
+            best = cost < best ? cost : best;
+        }
+        if (best > limit) { // Every path through this row is already too long
+            return limit + 1;
+        }
+        memcpy(previous, current, (lengthB + 1) * sizeof(int));
+    }
+    return previous[lengthB] <= limit ? previous[lengthB] : limit + 1;
+}
+
+// Function to copy a guest into a search result
+static void copyGuestMatch(const struct GuestIndex* index, const struct Guest* guest, int distance, struct GuestMatch* match) {
+    match->guestName = poolString(&index->names, guest->name);
+    match->bookingCount = guest->stayCount;
+    match->distance = distance;
+}
+
+// Function to order stays by check-in date, then room, for qsort
+static int compareGuestStays(const void* a, const void* b) {
+    const struct GuestStay* x = (const struct GuestStay*)a;
+    const struct GuestStay* y = (const struct GuestStay*)b;
+    return x->checkIn != y->checkIn ? (x->checkIn > y->checkIn) - (x->checkIn < y->checkIn)
+                                    : (x->roomNumber > y->roomNumber) - (x->roomNumber < y->roomNumber);
+}
+
+// Function to find every booking made under exactly this guest name, earliest first
+// (returns how many there are; at most maxStays are copied into stays, which may be NULL)
+int findGuestBookings(struct Hotel* hotel, const char* guestName, struct GuestStay* stays, int maxStays) {
+    struct GuestIndex* index = &hotel->guests;
+    uint64_t started = startOperation();
+    pthread_mutex_lock(&index->lock);
+    int id = internGuest(index, guestName, 0, NAME_NONE);
+    int count = id >= 0 ? index->guests[id].stayCount : 0;
+    if (count > 0 && stays != NULL && maxStays > 0) {
+        if (count <= maxStays) {
+            memcpy(stays, guestStays(&index->guests[id]), count * sizeof(struct GuestStay));
+        } else { // Sort the guest's list in place so the earliest stays are the ones copied
+            qsort(guestStays(&index->guests[id]), count, sizeof(struct GuestStay), compareGuestStays);
+            memcpy(stays, guestStays(&index->guests[id]), maxStays * sizeof(struct GuestStay));
+        }
+    }
+    pthread_mutex_unlock(&index->lock);
+    if (stays != NULL && maxStays > 0) {
+        qsort(stays, count < maxStays ? count : maxStays, sizeof(struct GuestStay), compareGuestStays);
+    }
+    finishOperation(METRIC_VIEW, started, HOTEL_OK);
+    return count;
+}
+
+// Function to find the guests with bookings whose name starts with prefix, ignoring case, in name order
+// (returns how many there are; at most maxMatches are copied into matches)
+int searchGuestPrefix(struct Hotel* hotel, const char* prefix, struct GuestMatch* matches, int maxMatches) {
+    struct GuestIndex* index = &hotel->guests;
+    size_t length = strlen(prefix);
+    int found = 0;
+    uint64_t started = startOperation();
+    pthread_mutex_lock(&index->lock);
+    sortGuests(index);
+    int low = 0, high = index->sortedCount;
+    while (low < high) { // First name not below the prefix
+        int middle = low + (high - low) / 2;
+        const char* name = poolString(&index->names, index->guests[index->sorted[middle]].name);
+        size_t i = 0;
+        while (i < length && name[i] != '\0' && foldChar(name[i]) == foldChar(prefix[i])) {
+            i++;
+        }
+        if (i < length && foldChar(name[i]) < foldChar(prefix[i])) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    for (int s = low; s < index->sortedCount; ++s) { // Matches are contiguous in the sorted table
+        const struct Guest* guest = &index->guests[index->sorted[s]];
+        const char* name = poolString(&index->names, guest->name);
+        size_t i = 0;
+        while (i < length && foldChar(name[i]) == foldChar(prefix[i]) && name[i] != '\0') {
+            i++;
+        }
+        if (i < length) {
+            break;
+        }
+        if (guest->stayCount > 0) { // Guests whose bookings were all cancelled are not shown
+            if (found < maxMatches) {
+                copyGuestMatch(index, guest, 0, &matches[found]);
+            }
+            found++;
+        }
+    }
+    pthread_mutex_unlock(&index->lock);
+    finishOperation(METRIC_VIEW, started, HOTEL_OK);
+    return found;
+}
+
+// Function to find the guests with bookings whose name is within maxDistance edits of text, ignoring case,
+// closest first (returns how many were copied into matches, at most maxMatches)
+// Candidates come from the trigram posting lists: one edit changes at most three of a name's
+// trigrams, so a name sharing fewer than (trigrams in text - 3 * maxDistance) cannot match.
+int searchGuestFuzzy(struct Hotel* hotel, const char* text, int maxDistance, struct GuestMatch* matches, int maxMatches) {
+    struct GuestIndex* index = &hotel->guests;
+    uint32_t trigrams[MAX_NAME_LENGTH + 2];
+    char query[MAX_NAME_LENGTH];
+    uint64_t started = startOperation();
+    strncpy(query, text, MAX_NAME_LENGTH - 1);
+    query[MAX_NAME_LENGTH - 1] = '\0';
+    int trigramCount = guestTrigrams(query, trigrams);
+    for (int i = 1; i < trigramCount; ++i) { // Sort and drop repeats, so each shared trigram counts once
+        uint32_t value = trigrams[i];
+        int j = i - 1;
+        while (j >= 0 && trigrams[j] > value) {
+            trigrams[j + 1] = trigrams[j];
+            j--;
+        }
+        trigrams[j + 1] = value;
+    }
+    int unique = 0;
+    for (int i = 0; i < trigramCount; ++i) {
+        if (unique == 0 || trigrams[unique - 1] != trigrams[i]) {
+            trigrams[unique++] = trigrams[i];
+        }
+    }
+    int needed = unique - 3 * maxDistance > 1 ? unique - 3 * maxDistance : 1;
+
+    int found = 0, touchedCount = 0;
+    pthread_mutex_lock(&index->lock);
+    indexGuestTrigrams(index);
+    for (int t = 0; t < unique; ++t) {
+        const struct TrigramSlot* slot = findTrigram(index, trigrams[t], 0);
+        for (int p = 0; slot != NULL && p < slot->count; ++p) {
+            int id = slot->guests[p];
+            if (index->scores[id]++ == 0) {
+                index->touched[touchedCount++] = id;
+            }
+        }
+    }
+    for (int c = 0; c < touchedCount; ++c) {
+        int id = index->touched[c];
+        const struct Guest* guest = &index->guests[id];
+        int score = index->scores[id];
+        index->scores[id] = 0; // Leave the scratch array clean for the next search
+        if (score < needed || guest->stayCount == 0) {
+            continue;
+        }
+        const char* name = poolString(&index->names, guest->name);
+        int distance = guestDistance(name, query, maxDistance);
+        if (distance > maxDistance) {
+            continue;
+        }
+        int position = found < maxMatches ? found++ : maxMatches; // Insertion into the best maxMatches
+        while (position > 0 && (matches[position - 1].distance > distance
+               || (matches[position - 1].distance == distance && compareFolded(matches[position - 1].guestName, name) > 0))) {
+            if (position < maxMatches) {
+                matches[position] = matches[position - 1];
+            }
+            position--;
+        }
+        if (position < maxMatches) {
+            copyGuestMatch(index, guest, distance, &matches[position]);
+        }
+    }
+    pthread_mutex_unlock(&index->lock);
+    finishOperation(METRIC_VIEW, started, HOTEL_OK);
+    return found;
+}
+
+// Function to find the room type of a room number (rooms in no listed range are type 0)
+int roomType(const struct RatePlan* plan, int roomNumber) {
+    int low = 0, high = plan->rangeCount;
+    while (low < high) { // First range not ending below the room
+        int middle = low + (high - low) / 2;
+        if (plan->ranges[middle].lastRoom < roomNumber) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < plan->rangeCount && plan->ranges[low].firstRoom <= roomNumber ? plan->ranges[low].type : 0;
+}
+
+// Function to tell whether a night is a weekend night (Friday or Saturday; day 0, 1970-01-01, was a Thursday)
+static int isWeekend(int day) {
+    int weekday = ((day + 4) % 7 + 7) % 7; // 0 is Sunday
+    return weekday == 5 || weekday == 6;
+}
+
+// Function to find the season percent of a night (100 outside every season; the last matching season wins)
+static int seasonPercent(const struct RatePlan* plan, int day) {
+    int percent = 100;
+    for (int s = 0; s < plan->seasonCount; ++s) {
+        if (day >= plan->seasons[s].firstDay && day <= plan->seasons[s].lastDay) {
+            percent = plan->seasons[s].percent;
+        }
+    }
+    return percent;
+}
+
+// Function to price one night of a room type rule by rule (the compiled tables hold these, summed)
+int64_t nightRate(const struct RatePlan* plan, int type, int day) {
+    int64_t weekend = isWeekend(day) ? plan->weekendPercent : 100;
+    return plan->typeRates[type] * weekend * seasonPercent(plan, day) / 10000;
+}
+
+// Function to compile a rate plan's rules into its prefix-sum tables, which cover RATE_TABLE_DAYS nights from a year ago
+static void compileRatePlan(struct RatePlan* plan) {
+    plan->firstDay = today() - 366;
+    free(plan->prefix);
+    plan->prefix = (int64_t*)malloc((size_t)plan->typeCount * (RATE_TABLE_DAYS + 1) * sizeof(int64_t));
+    for (int type = 0; type < plan->typeCount; ++type) {
+        int64_t* prefix = &plan->prefix[(size_t)type * (RATE_TABLE_DAYS + 1)];
+        prefix[0] = 0;
+        for (int n = 0; n < RATE_TABLE_DAYS; ++n) {
+            prefix[n + 1] = prefix[n] + nightRate(plan, type, plan->firstDay + n);
+        }
+    }
+}
+
+// Function to set up the default rate plan: every room PRICE_PER_NIGHT, extras EXTRA_SERVICES_COST a night
+void initRatePlan(struct RatePlan* plan) {
+    memset(plan, 0, sizeof(*plan));
+    strcpy(plan->typeNames[0], "standard");
+    plan->typeRates[0] = PRICE_PER_NIGHT;
+    plan->typeCount = 1;
+    plan->weekendPercent = 100;
+    plan->extrasRate = EXTRA_SERVICES_COST;
+    plan->surchargeFrom = 1;
+    compileRatePlan(plan);
+}
+
+// Function to free the tables of a rate plan
+void freeRatePlan(struct RatePlan* plan) {
+    free(plan->prefix);
+    plan->prefix = NULL;
+}
+
+// Function to find a room type by name (returns its index, or -1)
+static int findRateType(const struct RatePlan* plan, const char* name) {
+    for (int type = 0; type < plan->typeCount; ++type) {
+        if (strcmp(plan->typeNames[type], name) == 0) {
+            return type;
+        }
+    }
+    return -1;
+}
+
+// Function to parse one line of a rate file into the plan (returns 0 if it is not understood)
+// Lines, with amounts in PKR and "#" starting a comment:
+//   rate TYPE AMOUNT                  nightly rate of a room type ("standard" is every room not listed)
+//   rooms FIRST LAST TYPE             rooms FIRST to LAST are of TYPE (named by a rate line before)
+//   extras AMOUNT                     extra services, per night
+//   weekend PERCENT                   share of the rate charged for Friday and Saturday nights
+//   season YYYY-MM-DD YYYY-MM-DD PERCENT   share of the rate charged for nights in that range
+//   stay NIGHTS PERCENT               percent off stays of NIGHTS nights or more
+//   surcharge PEOPLE AMOUNT           per night for each person from the PEOPLE-th on
+static int parseRateLine(struct RatePlan* plan, const char* line, int* stayRules, int* stayRuleCount) {
+    char word[16], name[32], first[16], last[16], extra[2];
+    long long amount;
+    int a, b, percent;
+    if (sscanf(line, "%15s", word) != 1) {
+        return 1; // Blank line
+    }
+    if (strcmp(word, "rate") == 0 && sscanf(line, "%*s %15s %lld %1s", name, &amount, extra) == 2) {
+        int type = findRateType(plan, name);
+        if (type < 0 && plan->typeCount < RATE_MAX_TYPES) {
+            type = plan->typeCount++;
+            strcpy(plan->typeNames[type], name);
+        }
+        plan->typeRates[type < 0 ? 0 : type] = amount;
+        return type >= 0 && amount >= 0 && amount <= RATE_MAX_AMOUNT;
+    }
+    if (strcmp(word, "rooms") == 0 && sscanf(line, "%*s %d %d %31s %1s", &a, &b, name, extra) == 3) {
+        int type = findRateType(plan, name), at = plan->rangeCount;
+        if (type < 0 || a > b || plan->rangeCount == RATE_MAX_RULES) {
+            return 0;
+        }
+        while (at > 0 && plan->ranges[at - 1].firstRoom > a) { // Keep the ranges sorted
+            plan->ranges[at] = plan->ranges[at - 1];
+            at--;
+        }
+        plan->ranges[at].firstRoom = a;
+        plan->ranges[at].lastRoom = b;
+        plan->ranges[at].type = type;
+        plan->rangeCount++;
+        return (at == 0 || plan->ranges[at - 1].lastRoom < a) && (at + 1 == plan->rangeCount || plan->ranges[at + 1].firstRoom > b);
+    }
+    if (strcmp(word, "extras") == 0 && sscanf(line, "%*s %lld %1s", &amount, extra) == 1) {
+        plan->extrasRate = amount;
+        return amount >= 0 && amount <= RATE_MAX_AMOUNT;
+    }
+    if (strcmp(word, "weekend") == 0 && sscanf(line, "%*s %d %1s", &percent, extra) == 1) {
+        plan->weekendPercent = percent;
+        return percent >= 0 && percent <= 1000;
+    }
+    if (strcmp(word, "season") == 0 && sscanf(line, "%*s %15s %15s %d %1s", first, last, &percent, extra) == 3) {
+        if (plan->seasonCount == RATE_MAX_RULES || !parseDate(first, &a) || !parseDate(last, &b)) {
+            return 0;
+        }
+        plan->seasons[plan->seasonCount].firstDay = a;
+        plan->seasons[plan->seasonCount].lastDay = b;
+        plan->seasons[plan->seasonCount++].percent = percent;
+        return a <= b && percent >= 0 && percent <= 1000;
+    }
+    if (strcmp(word, "stay") == 0 && sscanf(line, "%*s %d %d %1s", &a, &percent, extra) == 2) {
+        if (*stayRuleCount == RATE_MAX_RULES || a < 1 || percent < 0 || percent > 100) {
+            return 0;
+        }
+        stayRules[2 * *stayRuleCount] = a < RATE_MAX_DISCOUNT_NIGHTS ? a : RATE_MAX_DISCOUNT_NIGHTS;
+        stayRules[2 * (*stayRuleCount)++ + 1] = percent;
+        return 1;
+    }
+    if (strcmp(word, "surcharge") == 0 && sscanf(line, "%*s %d %lld %1s", &a, &amount, extra) == 2) {
+        plan->surchargeFrom = a;
+        plan->surchargeRate = amount;
+        return a >= 1 && amount >= 0 && amount <= RATE_MAX_AMOUNT;
+    }
+    return 0;
+}
+
+// Function to load a rate plan from a rate file and compile it (returns 1 if loaded, 0 if there is
+// no such file, or minus the number of the first line not understood, leaving the plan unchanged)
+int loadRatePlan(struct RatePlan* plan, const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return 0;
+    }
+    struct RatePlan loaded;
+    int stayRules[2 * RATE_MAX_RULES], stayRuleCount = 0;
+    char line[256];
+    int lineNumber = 0, ok = 1;
+    initRatePlan(&loaded);
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        lineNumber++;
+        line[strcspn(line, "#")] = '\0'; // Drop the comment
+        ok = parseRateLine(&loaded, line, stayRules, &stayRuleCount);
+    }
+    fclose(file);
+    if (!ok) {
+        freeRatePlan(&loaded);
+        return -lineNumber;
+    }
+    for (int nights = 1; nights <= RATE_MAX_DISCOUNT_NIGHTS; ++nights) { // The longest rule the stay reaches applies
+        int best = 0;
+        for (int r = 0; r < stayRuleCount; ++r) {
+            if (stayRules[2 * r] <= nights && stayRules[2 * r] >= best) {
+                best = stayRules[2 * r];
+                loaded.discounts[nights] = stayRules[2 * r + 1];
+            }
+        }
+    }
+    compileRatePlan(&loaded); // The rules changed since initRatePlan compiled the defaults
+    freeRatePlan(plan);
+    *plan = loaded;
+    return 1;
+}
+
+// Function to add up the room charges of a stay: two table reads if the tables cover it, otherwise
+// season by season (between season boundaries only the weekend nights differ, so they are counted, not walked)
+int64_t roomCharges(const struct RatePlan* plan, int type, int checkIn, int nights) {
+    int first = checkIn - plan->firstDay;
+    if (first >= 0 && first <= RATE_TABLE_DAYS && nights <= RATE_TABLE_DAYS - first) {
+        const int64_t* prefix = &plan->prefix[(size_t)type * (RATE_TABLE_DAYS + 1)];
+        return prefix[first + nights] - prefix[first];
+    }
+    int64_t sum = 0;
+    int64_t day = checkIn, end = (int64_t)checkIn + (nights > 0 ? nights : 0);
+    while (day < end) {
+        int64_t next = end; // The next season boundary
+        for (int s = 0; s < plan->seasonCount; ++s) {
+            int64_t starts = plan->seasons[s].firstDay, ends = (int64_t)plan->seasons[s].lastDay + 1;
+            next = starts > day && starts < next ? starts : next;
+            next = ends > day && ends < next ? ends : next;
+        }
+        int64_t length = next - day, weekends = length / 7 * 2;
+        for (int64_t d = day + length / 7 * 7; d < next; ++d) { // The odd days past the whole weeks
+            weekends += isWeekend((int)d);
+        }
+        int64_t rate = plan->typeRates[type] * seasonPercent(plan, (int)day);
+        sum += weekends * (rate * plan->weekendPercent / 10000) + (length - weekends) * (rate * 100 / 10000);
+        day = next;
+    }
+    return sum;
+}
+
+// Function to price one stay (returns the total; the parts are stored in quote unless it is NULL)
+int64_t quoteStay(const struct RatePlan* plan, int roomNumber, int checkIn, int nights, int occupancy, int extraServices, struct Quote* quote) {
+    struct Quote parts;
+    int64_t length = nights > 0 ? nights : 0;
+    int64_t people = (int64_t)occupancy - plan->surchargeFrom + 1; // People who pay the surcharge
+    parts.roomCharges = roomCharges(plan, roomType(plan, roomNumber), checkIn, (int)length);
+    parts.extras = length * (extraServices != 0) * plan->extrasRate;
+    parts.surcharge = length * (people > 0 ? people : 0) * plan->surchargeRate;
+    int64_t subtotal = parts.roomCharges + parts.extras + parts.surcharge;
+    parts.discount = subtotal * plan->discounts[length < RATE_MAX_DISCOUNT_NIGHTS ? length : RATE_MAX_DISCOUNT_NIGHTS] / 100;
+    parts.total = subtotal - parts.discount;
+    if (quote != NULL) {
+        *quote = parts;
+    }
+    return parts.total;
+}
+
+// Function to price many stays at once into totals (same totals as quoteStay)
+// (each block of stays is priced in passes: room types and table positions first, then a loop with
+// no branches that adds up every stay from its two prefix sums, then the rare stays the tables miss)
+void quoteStays(const struct RatePlan* plan, const struct QuoteRequest* requests, int count, int64_t* totals) {
+    int from[QUOTE_BLOCK], to[QUOTE_BLOCK], missed[QUOTE_BLOCK];
+    for (int block = 0; block < count; block += QUOTE_BLOCK) {
+        const struct QuoteRequest* request = requests + block;
+        int64_t* total = totals + block;
+        int size = count - block < QUOTE_BLOCK ? count - block : QUOTE_BLOCK, missedCount = 0;
+        for (int i = 0; i < size; ++i) {
+            int first = request[i].checkIn - plan->firstDay;
+            int nights = request[i].nights > 0 ? request[i].nights : 0;
+            int base = roomType(plan, request[i].roomNumber) * (RATE_TABLE_DAYS + 1);
+            if (first >= 0 && first <= RATE_TABLE_DAYS && nights <= RATE_TABLE_DAYS - first) {
+                from[i] = base + first;
+                to[i] = base + first + nights;
+            } else { // Priced 0 below and redone at the end
+                from[i] = to[i] = 0;
+                missed[missedCount++] = i;
+            }
+        }
+        for (int i = 0; i < size; ++i) {
+            int64_t nights = request[i].nights > 0 ? request[i].nights : 0;
+            int64_t people = (int64_t)request[i].occupancy - plan->surchargeFrom + 1;
+            int64_t subtotal = plan->prefix[to[i]] - plan->prefix[from[i]]
+                             + nights * (request[i].extraServices != 0) * plan->extrasRate
+                             + nights * (people > 0 ? people : 0) * plan->surchargeRate;
+            total[i] = subtotal - subtotal * plan->discounts[nights < RATE_MAX_DISCOUNT_NIGHTS ? nights : RATE_MAX_DISCOUNT_NIGHTS] / 100;
+        }
+        for (int m = 0; m < missedCount; ++m) {
+            const struct QuoteRequest* stay = &request[missed[m]];
+            total[missed[m]] = quoteStay(plan, stay->roomNumber, stay->checkIn, stay->nights, stay->occupancy, stay->extraServices, NULL);
+        }
+    }
+}
+
+// Function to initialize an empty booking history (the unpacked events are allocated on the first one)
+static void initHistory(struct BookingHistory* history) {
+    memset(history, 0, sizeof(*history));
+    indexGrow(&history->roomCodes, 0);
+    initNamePool(&history->names);
+    history->guestSlotCapacity = GUEST_INDEX_INITIAL_CAPACITY;
+    history->guestSlots = (struct GuestSlot*)malloc(history->guestSlotCapacity * sizeof(struct GuestSlot));
+    for (int i = 0; i < history->guestSlotCapacity; ++i) {
+        history->guestSlots[i].guest = -1; // Mark every slot as empty
+    }
+    history->file = -1; // Kept in memory until openHistory attaches a file
+    pthread_mutex_init(&history->lock, NULL);
+    pthread_cond_init(&history->handedOff, NULL);
+    pthread_cond_init(&history->sealed, NULL);
+}
+
+// Function to get the history's code for a room number, adding the room to the dictionary if it is new (history lock held)
+static int historyRoomCode(struct BookingHistory* history, int roomNumber) {
+    int code = indexFind(&history->roomCodes, roomNumber);
+    if (code >= 0) {
+        return code;
+    }
+    if (history->roomCount == history->roomCapacity) {
+        history->roomCapacity = history->roomCapacity ? history->roomCapacity * 2 : TABLE_INITIAL_CAPACITY;
+        history->rooms = (int*)realloc(history->rooms, history->roomCapacity * sizeof(int));
+    }
+    if ((int64_t)(history->roomCodes.count + 1) * 10 > (int64_t)history->roomCodes.capacity * 7) {
+        indexGrow(&history->roomCodes, 1);
+    }
+    code = history->roomCount++;
+    history->rooms[code] = roomNumber;
+    indexPut(&history->roomCodes, roomNumber, code);
+    return code;
+}
+
+// Function to get the history's code for a guest name, adding the name to the dictionary if it is new (history lock held)
+static int historyGuestCode(struct BookingHistory* history, const char* name) {
+    uint32_t hash = hashGuestName(name);
+    unsigned int mask = (unsigned int)history->guestSlotCapacity - 1;
+    unsigned int i = hash & mask;
+    for (int code; (code = history->guestSlots[i].guest) >= 0; i = (i + 1) & mask) {
+        if (history->guestSlots[i].hash == hash && strcmp(poolString(&history->names, history->guests[code]), name) == 0) {
+            return code;
+        }
+    }
+    if (history->guestCount == history->guestCapacity) {
+        history->guestCapacity = history->guestCapacity ? history->guestCapacity * 2 : GUEST_INDEX_INITIAL_CAPACITY;
+        history->guests = (uint32_t*)realloc(history->guests, history->guestCapacity * sizeof(uint32_t));
+    }
+    int code = history->guestCount++;
+    history->guests[code] = poolAdd(&history->names, name, strlen(name));
+    history->guestSlots[i].hash = hash;
+    history->guestSlots[i].guest = code;
+    if ((history->guestCount + 1) * 10 > history->guestSlotCapacity * 7) { // Keep the load factor below 0.7
+        growGuestSlots(&history->guestSlots, &history->guestSlotCapacity);
+    }
+    return code;
+}
+
+// Function to pack count events, given column by column, into a block: each column is stored as the difference
+// from its smallest value in as few bits as the largest difference needs, or whole if that is over HISTORY_WIDE_BITS
+static void packHistoryBlock(int64_t* const* columns, int count, struct HistoryBlock* block) {
+    memset(block, 0, sizeof(*block)); // Padding bytes are hashed into the file's checksums, so they must be zero
+    block->count = count;
+    for (int c = 0; c < HISTORY_COLUMNS; ++c) {
+        int64_t low = columns[c][0], high = columns[c][0];
+        for (int i = 1; i < count; ++i) {
+            low = columns[c][i] < low ? columns[c][i] : low;
+            high = columns[c][i] > high ? columns[c][i] : high;
+        }
+        uint64_t span = (uint64_t)high - (uint64_t)low;
+        int width = span == 0 ? 0 : 64 - __builtin_clzll(span);
+        block->widths[c] = (uint8_t)(width > HISTORY_WIDE_BITS ? 64 : width);
+        block->lows[c] = low;
+        block->highs[c] = high;
+        block->offsets[c] = block->size;
+        block->size += ((uint64_t)block->widths[c] * count + 7) / 8 + 8; // Spare bytes for the last unaligned load
+    }
+    block->data = (uint8_t*)calloc(block->size, 1);
+    for (int c = 0; c < HISTORY_COLUMNS; ++c) {
+        uint8_t* packed = block->data + block->offsets[c];
+        int width = block->widths[c];
+        if (width == 64) {
+            memcpy(packed, columns[c], count * sizeof(int64_t));
+            continue;
+        }
+        uint64_t bit = 0;
+        for (int i = 0; i < count && width > 0; ++i, bit += width) {
+            uint64_t word, value = (uint64_t)columns[c][i] - (uint64_t)block->lows[c];
+            memcpy(&word, packed + (bit >> 3), sizeof(word));
+            word |= value << (bit & 7);
+            memcpy(packed + (bit >> 3), &word, sizeof(word));
+        }
+    }
+}
+
+// Function to append a packed block to the history (history lock held)
+static void appendHistoryBlock(struct BookingHistory* history, const struct HistoryBlock* block) {
+    if (history->blockCount == history->blockCapacity) {
+        history->blockCapacity = history->blockCapacity ? history->blockCapacity * 2 : 16;
+        history->blocks = (struct HistoryBlock*)realloc(history->blocks, history->blockCapacity * sizeof(struct HistoryBlock));
+    }
+    history->blocks[history->blockCount++] = *block;
+}
+
+// Function to pack the unpacked events of the history into a new block (history lock held)
+static void sealHistory(struct BookingHistory* history) {
+    struct HistoryBlock block;
+    packHistoryBlock(history->tail, history->tailCount, &block);
+    appendHistoryBlock(history, &block);
+    history->tailCount = 0;
+}
+
+// Function to wait until the sealer has packed the full tail it was handed, if any (history lock held)
+static void waitForSealer(struct BookingHistory* history) {
+    while (history->full[0] != NULL) {
+        pthread_cond_wait(&history->sealed, &history->lock);
+    }
+}
+
+// Function run by the sealer thread: pack each full tail it is handed into a block, without the history lock,
+// so bookings keep recording meanwhile (a full tail is left alone until it is packed, and the next one is only
+// handed over once this one is in the blocks, so the blocks stay in the order the events happened)
+static void* runSealer(void* argument) {
+    struct BookingHistory* history = (struct BookingHistory*)argument;
+    int64_t* columns[HISTORY_COLUMNS];
+    struct HistoryBlock block;
+    pthread_mutex_lock(&history->lock);
+    while (history->full[0] != NULL || !history->stopSealer) { // What was handed over is packed before stopping
+        if (history->full[0] == NULL) {
+            pthread_cond_wait(&history->handedOff, &history->lock);
+            continue;
+        }
+        memcpy(columns, history->full, sizeof(columns));
+        pthread_mutex_unlock(&history->lock);
+        packHistoryBlock(columns, HISTORY_BLOCK_EVENTS, &block);
+        pthread_mutex_lock(&history->lock);
+        appendHistoryBlock(history, &block);
+        memset(history->full, 0, sizeof(history->full));
+        pthread_cond_broadcast(&history->sealed);
+        pthread_mutex_unlock(&history->lock);
+        for (int c = 0; c < HISTORY_COLUMNS; ++c) {
+            free(columns[c]);
+        }
+        pthread_mutex_lock(&history->lock);
+    }
+    pthread_mutex_unlock(&history->lock);
+    return NULL;
+}
+
+// Function to hand the full tail to the sealer thread, starting it the first time, and begin a new tail
+// (history lock held; if the sealer is still busy with the last full tail, wait for it)
+static void handOffTail(struct BookingHistory* history) {
+    waitForSealer(history);
+    if (!history->sealerStarted) {
+        if (pthread_create(&history->sealer, NULL, runSealer, history) != 0) {
+            sealHistory(history); // No thread to spare: pack it here
+            return;
+        }
+        history->sealerStarted = 1;
+    }
+    memcpy(history->full, history->tail, sizeof(history->full));
+    memset(history->tail, 0, sizeof(history->tail)); // The next event allocates a new tail
+    history->tailCount = 0;
+    pthread_cond_signal(&history->handedOff);
+}
+
+// Function to wait until every full tail handed to the sealer is packed into the blocks
+void settleHistory(struct BookingHistory* history) {
+    pthread_mutex_lock(&history->lock);
+    waitForSealer(history);
+    pthread_mutex_unlock(&history->lock);
+}
+
+// Function to append an event to the booking history, handing the unpacked events to the sealer thread to pack
+// into a block once there are HISTORY_BLOCK_EVENTS of them (safe to call from any thread; bookings call it under
+// their room lock)
+void recordHistory(struct BookingHistory* history, int kind, int64_t when, int roomNumber, const char* guestName, int checkIn, int nights, int occupancy, int extraServices, int64_t amount) {
+    pthread_mutex_lock(&history->lock); // Taken inside a room lock, never the other way round
+    if (history->tail[0] == NULL) { // Pages are only touched as events fill them
+        for (int c = 0; c < HISTORY_COLUMNS; ++c) {
+            history->tail[c] = (int64_t*)malloc(HISTORY_BLOCK_EVENTS * sizeof(int64_t));
+        }
+    }
+    int i = history->tailCount++;
+    history->tail[HISTORY_TIME][i] = when;
+    history->tail[HISTORY_KIND][i] = kind;
+    history->tail[HISTORY_ROOM][i] = historyRoomCode(history, roomNumber);
+    history->tail[HISTORY_GUEST][i] = historyGuestCode(history, guestName);
+    history->tail[HISTORY_CHECK_IN][i] = checkIn;
+    history->tail[HISTORY_NIGHTS][i] = nights;
+    history->tail[HISTORY_OCCUPANCY][i] = occupancy;
+    history->tail[HISTORY_EXTRAS][i] = extraServices;
+    history->tail[HISTORY_AMOUNT][i] = amount;
+    __atomic_store_n(&history->events, history->events + 1, __ATOMIC_RELAXED); // Read by hotelHistoryEvents without the lock
+    if (history->tailCount == HISTORY_BLOCK_EVENTS) {
+        handOffTail(history);
+    }
+    pthread_mutex_unlock(&history->lock);
+}
+
+// Function to unpack values of a packed column with plain 64-bit loads
+static void unpackColumnScalar(const uint8_t* data, int width, int64_t low, int first, int count, int64_t* values) {
+    uint64_t mask = ((uint64_t)1 << width) - 1, bit = (uint64_t)first * width;
+    for (int i = 0; i < count; ++i, bit += width) {
+        uint64_t word;
+        memcpy(&word, data + (bit >> 3), sizeof(word)); // One unaligned load holds the whole value
+        values[i] = (int64_t)((uint64_t)low + ((word >> (bit & 7)) & mask));
+    }
+}
+
+#ifdef HAVE_AVX2_KERNELS
+// Function to unpack values of a packed column four at a time with AVX2 (one gather, shift and mask per four)
+__attribute__((target("avx2")))
+static void unpackColumnAvx2(const uint8_t* data, int width, int64_t low, int first, int count, int64_t* values) {
+    const __m256i mask = _mm256_set1_epi64x((long long)(((uint64_t)1 << width) - 1));
+    const __m256i lows = _mm256_set1_epi64x((long long)low);
+    const __m256i sevens = _mm256_set1_epi64x(7);
+    const __m256i step = _mm256_set1_epi64x(4LL * width);
+    long long bit = (long long)first * width;
+    __m256i bits = _mm256_setr_epi64x(bit, bit + width, bit + 2LL * width, bit + 3LL * width);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i words = _mm256_i64gather_epi64((const long long*)data, _mm256_srli_epi64(bits, 3), 1);
+        __m256i packed = _mm256_and_si256(_mm256_srlv_epi64(words, _mm256_and_si256(bits, sevens)), mask);
+        _mm256_storeu_si256((__m256i*)&values[i], _mm256_add_epi64(packed, lows));
+        bits = _mm256_add_epi64(bits, step);
+    }
+    if (i < count) { // Up to three values left over
+        unpackColumnScalar(data, width, low, first + i, count - i, values + i);
+    }
+}
+#endif
+
+// Function to get the history scan kernels for this CPU (AVX2 if available, scalar otherwise)
+const struct HistoryKernels* historyKernels() {
+    static const struct HistoryKernels scalarKernels = { unpackColumnScalar };
+#ifdef HAVE_AVX2_KERNELS
+    static const struct HistoryKernels avx2Kernels = { unpackColumnAvx2 };
+    if (__builtin_cpu_supports("avx2")) {
+        return &avx2Kernels;
+    }
+#endif
+    return &scalarKernels;
+}
+
+// Function to unpack count values of one column of a block, from value first on
+static void unpackColumn(const struct HistoryKernels* kernels, const struct HistoryBlock* block, int column, int first, int count, int64_t* values) {
+    const uint8_t* data = block->data + block->offsets[column];
+    int width = block->widths[column];
+    if (width == 0) {
+        for (int i = 0; i < count; ++i) {
+            values[i] = block->lows[column];
+        }
+    } else if (width == 64) {
+        memcpy(values, data + (size_t)first * sizeof(int64_t), count * sizeof(int64_t));
+    } else {
+        kernels->unpack(data, width, block->lows[column], first, count, values);
+    }
+}
+
+// Define the share of a history summary one thread adds up
+struct HistoryScan {
+    const struct HistoryBlock* blocks; // Blocks to scan
+    int blockCount; // Number of blocks
+    int firstDay; // First check-in day counted
+    int lastDay; // Last check-in day counted
+    const int* monthRows; // Row of each day from firstDay to lastDay
+    int discardRow; // Row the stays outside those days are added to, and never read
+    struct HotelHistoryMonth* rows; // Sums by month of check-in
+};
+
+// Function to add up the blocks of one share of a history summary (run by each scanning thread)
+static void* scanHistory(void* argument) {
+    struct HistoryScan* scan = (struct HistoryScan*)argument;
+    const struct HistoryKernels* kernels = historyKernels();
+    uint64_t span = (uint64_t)(scan->lastDay - scan->firstDay);
+    int64_t kinds[HISTORY_SCAN_CHUNK], checkIns[HISTORY_SCAN_CHUNK], nights[HISTORY_SCAN_CHUNK];
+    int64_t people[HISTORY_SCAN_CHUNK], amounts[HISTORY_SCAN_CHUNK];
+    for (int b = 0; b < scan->blockCount; ++b) {
+        const struct HistoryBlock* block = &scan->blocks[b];
+        if (block->highs[HISTORY_CHECK_IN] < scan->firstDay || block->lows[HISTORY_CHECK_IN] > scan->lastDay) {
+            continue; // No stay of the block checks in during the range
+        }
+        for (int first = 0; first < block->count; first += HISTORY_SCAN_CHUNK) {
+            int count = block->count - first < HISTORY_SCAN_CHUNK ? block->count - first : HISTORY_SCAN_CHUNK;
+            unpackColumn(kernels, block, HISTORY_KIND, first, count, kinds);
+            unpackColumn(kernels, block, HISTORY_CHECK_IN, first, count, checkIns);
+            unpackColumn(kernels, block, HISTORY_NIGHTS, first, count, nights);
+            unpackColumn(kernels, block, HISTORY_OCCUPANCY, first, count, people);
+            unpackColumn(kernels, block, HISTORY_AMOUNT, first, count, amounts);
+            for (int i = 0; i < count; ++i) { // No branches: stays outside the range go to the discarded row
+                uint64_t day = (uint64_t)(checkIns[i] - scan->firstDay);
+                struct HotelHistoryMonth* row = &scan->rows[day <= span ? scan->monthRows[day] : scan->discardRow];
+                int64_t cancelled = kinds[i], sign = 1 - 2 * cancelled;
+                row->bookings += 1 - cancelled;
+                row->cancellations += cancelled;
+                row->roomNights += sign * nights[i];
+                row->guests += sign * people[i];
+                row->revenue += sign * amounts[i];
+                row->cancelledRevenue += cancelled * amounts[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+// Function to sum up the booking history by month of check-in, from the month of firstDay to that of lastDay,
+// on up to threads threads (returns the number of months, or -1 if lastDay is before firstDay or the range is
+// over HISTORY_MAX_MONTHS long; at most maxMonths of them are stored in months). Packed blocks are scanned
+// without the history lock, so bookings carry on; only the unpacked events are packed under it first
+int summarizeHistory(struct Hotel* hotel, int firstDay, int lastDay, int threads, struct HotelHistoryMonth* months, int maxMonths) {
+    struct BookingHistory* history = &hotel->history;
+    int firstYear, firstMonth, lastYear, lastMonth, day;
+    if (lastDay < firstDay) {
+        return -1;
+    }
+    dateFromDay(firstDay, &firstYear, &firstMonth, &day);
+    dateFromDay(lastDay, &lastYear, &lastMonth, &day);
+    int monthCount = (lastYear * 12 + lastMonth) - (firstYear * 12 + firstMonth) + 1;
+    if (monthCount > HISTORY_MAX_MONTHS) {
+        return -1;
+    }
+    uint64_t started = startOperation();
+    int* monthRows = (int*)malloc(((size_t)lastDay - firstDay + 1) * sizeof(int));
+    for (int m = 0, from = firstDay; m < monthCount; ++m) { // Each month's days, clipped to the range
+        int year = firstYear + (firstMonth - 1 + m) / 12, month = (firstMonth - 1 + m) % 12 + 1;
+        int next = month == 12 ? dayFromDate(year + 1, 1, 1) : dayFromDate(year, month + 1, 1);
+        for (; from < next && from <= lastDay; ++from) {
+            monthRows[from - firstDay] = m;
+        }
+    }
+
+    pthread_mutex_lock(&history->lock);
+    waitForSealer(history); // A full tail the sealer is packing is not in the blocks yet
+    int packedCount = history->blockCount, tailCount = history->tailCount;
+    int blockCount = packedCount + (tailCount > 0);
+    struct HistoryBlock* blocks = (struct HistoryBlock*)malloc((blockCount + 1) * sizeof(struct HistoryBlock));
+    if (packedCount > 0) { // Packed blocks never change
+        memcpy(blocks, history->blocks, packedCount * sizeof(struct HistoryBlock));
+    }
+    if (tailCount > 0) { // The newest events, packed into a block of the scan's own
+        packHistoryBlock(history->tail, tailCount, &blocks[packedCount]);
+    }
+    pthread_mutex_unlock(&history->lock);
+
+    threads = threads < 1 ? 1 : threads > HISTORY_MAX_THREADS ? HISTORY_MAX_THREADS : threads;
+    threads = threads > blockCount ? (blockCount > 0 ? blockCount : 1) : threads;
+    struct HistoryScan scans[HISTORY_MAX_THREADS];
+    pthread_t handles[HISTORY_MAX_THREADS];
+    struct HotelHistoryMonth* rows = (struct HotelHistoryMonth*)calloc((size_t)threads * (monthCount + 1), sizeof(struct HotelHistoryMonth));
+    for (int t = 0; t < threads; ++t) { // Each thread adds up its own run of blocks into its own rows
+        scans[t].blocks = blocks + (int64_t)blockCount * t / threads;
+        scans[t].blockCount = (int)((int64_t)blockCount * (t + 1) / threads - (int64_t)blockCount * t / threads);
+        scans[t].firstDay = firstDay;
+        scans[t].lastDay = lastDay;
+        scans[t].monthRows = monthRows;
+        scans[t].discardRow = monthCount;
+        scans[t].rows = rows + (size_t)t * (monthCount + 1);
+        if (t > 0 && pthread_create(&handles[t], NULL, scanHistory, &scans[t]) != 0) {
+            scanHistory(&scans[t]); // No thread to spare: scan this share here
+            scans[t].blockCount = -1;
+        }
+    }
+    scanHistory(&scans[0]);
+    for (int t = 1; t < threads; ++t) {
+        if (scans[t].blockCount >= 0) {
+            pthread_join(handles[t], NULL);
+        }
+        for (int m = 0; m < monthCount; ++m) {
+            rows[m].bookings += scans[t].rows[m].bookings;
+            rows[m].cancellations += scans[t].rows[m].cancellations;
+            rows[m].roomNights += scans[t].rows[m].roomNights;
+            rows[m].guests += scans[t].rows[m].guests;
+            rows[m].revenue += scans[t].rows[m].revenue;
+            rows[m].cancelledRevenue += scans[t].rows[m].cancelledRevenue;
+        }
+    }
+    for (int m = 0; m < monthCount && m < maxMonths; ++m) {
+        months[m] = rows[m];
+        months[m].year = firstYear + (firstMonth - 1 + m) / 12;
+        months[m].month = (firstMonth - 1 + m) % 12 + 1;
+    }
+    if (tailCount > 0) {
+        free(blocks[packedCount].data);
+    }
+    free(rows);
+    free(monthRows);
+    free(blocks);
+    finishOperation(METRIC_VIEW, started, HOTEL_OK);
+    return monthCount;
+}
+
+// Function to initialize an empty hotel
+void initHotel(struct Hotel* hotel) {
+    hotel->rooms = NULL; // No rooms yet; the table is allocated on the first addRoom
+    hotel->details = NULL;
+    hotel->roomCount = 0;
+    hotel->roomCapacity = 0;
+    hotel->index.slots = NULL;
+    hotel->index.capacity = 0;
+    hotel->index.count = 0;
+    indexGrow(&hotel->index, 0); // Allocate the initial index slots
+    memset(&hotel->order, 0, sizeof(hotel->order)); // The room order grows with the table too
+    memset(hotel->stripeTotals, 0, sizeof(hotel->stripeTotals)); // Nothing booked yet
+    memset(hotel->nightTotals, 0, sizeof(hotel->nightTotals));
+    hotel->floors = NULL; // Floors are added with their first room
+    hotel->floorCount = 0;
+    hotel->floorCapacity = 0;
+    hotel->floorIndex.slots = NULL;
+    hotel->floorIndex.capacity = 0;
+    hotel->floorIndex.count = 0;
+    indexGrow(&hotel->floorIndex, 0);
+    hotel->nights = NULL; // The bitmaps grow together with the room table
+    hotel->calendarStart = today(); // Track bookings from the day the hotel opens
+    hotel->snapshot = NULL;
+    hotel->snapshotSize = 0;
+    hotel->journal = NULL; // Not journaled until a journal is attached
+    hotel->journalSequence = 0;
+    pthread_rwlock_init(&hotel->tableLock, NULL);
+    for (int i = 0; i < ROOM_LOCK_STRIPES; ++i) {
+        pthread_mutex_init(&hotel->roomLocks[i].mutex, NULL);
+    }
+    initGuestIndex(&hotel->guests);
+    initHistory(&hotel->history);
+    initRatePlan(&hotel->rates);
+    hotel->versions = NULL; // Grows with the room table
+    memset(&hotel->views, 0, sizeof(hotel->views)); // No view open, and the clock at 0
+    for (int i = 0; i < VIEW_MAX_OPEN; ++i) {
+        hotel->views.views[i].hotel = hotel;
+    }
+}
+
+// Function to get the lock a room number hashes to
+pthread_mutex_t* roomLock(struct Hotel* hotel, int roomNumber) {
+    return &hotel->roomLocks[hashRoomNumber(roomNumber) & (ROOM_LOCK_STRIPES - 1)].mutex;
+}
+
+// Function to take (lock = 1) or release (lock = 0) every room lock, always in the same order
+static void lockAllRooms(struct Hotel* hotel, int lock) {
+    for (int i = 0; i < ROOM_LOCK_STRIPES; ++i) {
+        if (lock) {
+            pthread_mutex_lock(&hotel->roomLocks[i].mutex);
+        } else {
+            pthread_mutex_unlock(&hotel->roomLocks[i].mutex);
+        }
+    }
+}
+
+// Function to find a room by number (returns its table position, or -1 if the hotel has no such room)
+int findRoom(struct Hotel* hotel, int roomNumber) {
+    int probes;
+    int slot = indexProbe(&hotel->index, roomNumber, &probes);
+    struct ThreadMetrics* metrics = currentMetrics();
+    if (metrics != NULL) { // How well the index is doing
+        countMetric(&metrics->probes[probes < PROBE_BUCKETS ? probes - 1 : PROBE_BUCKETS - 1], 1);
+    }
+    return slot;
+}
+
+// Function to find the first stay on a room's calendar that ends after the given day
+// (binary search; returns bookingCount if every stay has ended by then)
+int findStay(const struct Room* room, int day) {
+    int low = 0, high = room->bookingCount;
+    while (low < high) { // Stays never overlap, so check-out days are sorted as well
+        int middle = low + (high - low) / 2;
+        if (room->stays[middle].checkOut > day) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return low;
+}
+
+// Function to check whether a room is free for every night in [checkIn, checkOut)
+int isRoomFree(const struct Room* room, int checkIn, int checkOut) {
+    int next = findStay(room, checkIn);
+    return next == room->bookingCount || room->stays[next].checkIn >= checkOut;
+}
+
+// Function to set (booked = 1) or clear (booked = 0) the bitmap bits of a room for [checkIn, checkOut)
+// (nights outside the tracked horizon are only kept on the calendar; the caller holds the room lock)
+static void markNights(struct Hotel* hotel, int slot, int checkIn, int checkOut, int booked) {
+    int first = checkIn - hotel->calendarStart;
+    int last = checkOut - hotel->calendarStart; // Exclusive
+    first = first < 0 ? 0 : first;
+    last = last > NIGHT_HORIZON ? NIGHT_HORIZON : last;
+    for (int night = first; night < last; ++night) {
+        uint64_t* word = &hotel->nights[(night / 64) * hotel->roomCapacity + slot];
+        uint64_t bit = (uint64_t)1 << (night % 64);
+        __atomic_store_n(word, booked ? (*word | bit) : (*word & ~bit), __ATOMIC_RELAXED); // Scans read without the room lock
+    }
+}
+
+// Function to build the per-word masks selecting the nights [checkIn, checkOut) of the horizon
+// (returns 0 if the range is not entirely inside the horizon)
+int buildNightMasks(const struct Hotel* hotel, int checkIn, int checkOut, uint64_t* masks, int* firstWord, int* lastWord) {
+    int first = checkIn - hotel->calendarStart;
+    int last = checkOut - hotel->calendarStart; // Exclusive
+    if (first < 0 || last > NIGHT_HORIZON || first >= last) {
+        return 0;
+    }
+    *firstWord = first / 64;
+    *lastWord = (last - 1) / 64;
+    for (int w = *firstWord; w <= *lastWord; ++w) {
+        int low = w == *firstWord ? first % 64 : 0; // First selected bit in this word
+        int high = w == *lastWord ? (last - 1) % 64 : 63; // Last selected bit in this word
+        uint64_t upTo = high == 63 ? ~(uint64_t)0 : (((uint64_t)1 << (high + 1)) - 1);
+        masks[w] = upTo & ~(((uint64_t)1 << low) - 1);
+    }
+    return 1;
+}
+
+// Function to find free rooms with plain 64-bit operations
+static void freeRoomsScalar(const uint64_t* nights, int stride, const uint64_t* masks, int firstWord, int lastWord, int roomCount, uint64_t* freeBits) {
+    for (int block = 0; block < roomCount; block += 64) {
+        int end = roomCount - block < 64 ? roomCount - block : 64;
+        uint64_t bits = 0;
+        for (int r = 0; r < end; ++r) {
+            uint64_t busy = 0;
+            for (int w = firstWord; w <= lastWord; ++w) {
+                busy |= __atomic_load_n(&nights[w * stride + block + r], __ATOMIC_RELAXED) & masks[w];
+            }
+            bits |= (uint64_t)(busy == 0) << r;
+        }
+        freeBits[block / 64] = bits;
+    }
+}
+
+// Function to count booked nights with plain 64-bit operations
+static long long bookedNightsScalar(const uint64_t* nights, int stride, const uint64_t* masks, int firstWord, int lastWord, int roomCount) {
+    long long booked = 0;
+    for (int w = firstWord; w <= lastWord; ++w) {
+        const uint64_t* row = &nights[w * stride];
+        for (int r = 0; r < roomCount; ++r) {
+            booked += __builtin_popcountll(__atomic_load_n(&row[r], __ATOMIC_RELAXED) & masks[w]);
+        }
+    }
+    return booked;
+}
+
+#ifdef HAVE_AVX2_KERNELS
+// The AVX2 kernels read the bitmap words with plain vector loads while markNights stores them one at a time,
+// relaxed, under the room lock. Every word is 8-byte aligned and x86 reads each aligned 8-byte element of a
+// vector load whole, so a scan sees every word either before or after a booking changed it, as the scalar
+// kernels' relaxed loads do; a room a scan calls free is checked again under its lock when it is booked.
+// ThreadSanitizer cannot see that, so builds with it use the scalar kernels (SCALAR_NIGHT_KERNELS).
+
+// Function to find free rooms four at a time with AVX2
+__attribute__((target("avx2")))
+static void freeRoomsAvx2(const uint64_t* nights, int stride, const uint64_t* masks, int firstWord, int lastWord, int roomCount, uint64_t* freeBits) {
+    const __m256i zero = _mm256_setzero_si256();
+    for (int block = 0; block < roomCount; block += 64) {
+        int end = roomCount - block < 64 ? roomCount - block : 64;
+        uint64_t bits = 0;
+        int r = 0;
+        for (; r + 4 <= end; r += 4) {
+            __m256i busy = zero;
+            for (int w = firstWord; w <= lastWord; ++w) {
+                __m256i words = _mm256_loadu_si256((const __m256i*)&nights[w * stride + block + r]);
+                busy = _mm256_or_si256(busy, _mm256_and_si256(words, _mm256_set1_epi64x((long long)masks[w])));
+            }
+            __m256i isFree = _mm256_cmpeq_epi64(busy, zero);
+            bits |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(isFree)) << r;
+        }
+        for (; r < end; ++r) { // Up to three rooms left over
+            uint64_t busy = 0;
+            for (int w = firstWord; w <= lastWord; ++w) {
+                busy |= nights[w * stride + block + r] & masks[w];
+            }
+            bits |= (uint64_t)(busy == 0) << r;
+        }
+        freeBits[block / 64] = bits;
+    }
+}
+
+// Function to count booked nights with AVX2 (nibble-table popcount, summed per 64-bit lane)
+__attribute__((target("avx2")))
+static long long bookedNightsAvx2(const uint64_t* nights, int stride, const uint64_t* masks, int firstWord, int lastWord, int roomCount) {
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibbles = _mm256_set1_epi8(0x0f);
+    long long booked = 0;
+    for (int w = firstWord; w <= lastWord; ++w) {
+        const uint64_t* row = &nights[w * stride];
+        __m256i mask = _mm256_set1_epi64x((long long)masks[w]);
+        __m256i sums = _mm256_setzero_si256();
+        int r = 0;
+        for (; r + 4 <= roomCount; r += 4) {
+            __m256i words = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)&row[r]), mask);
+            __m256i low = _mm256_shuffle_epi8(table, _mm256_and_si256(words, lowNibbles));
+            __m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi64(words, 4), lowNibbles));
+            sums = _mm256_add_epi64(sums, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+        }
+        booked += _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1)
+                + _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+        for (; r < roomCount; ++r) {
+            booked += __builtin_popcountll(row[r] & masks[w]);
+        }
+    }
+    return booked;
+}
+#endif
+
+// Function to get the scalar night bitmap kernels, which every CPU can run
+const struct NightKernels* scalarNightKernels() {
+    static const struct NightKernels scalarKernels = { freeRoomsScalar, bookedNightsScalar };
+    return &scalarKernels;
+}
+
+// Function to get the night bitmap kernels for this CPU (AVX2 if available, scalar otherwise, and always scalar
+// under ThreadSanitizer)
+const struct NightKernels* nightKernels() {
+#if defined(HAVE_AVX2_KERNELS) && !defined(SCALAR_NIGHT_KERNELS)
+    static const struct NightKernels avx2Kernels = { freeRoomsAvx2, bookedNightsAvx2 };
+    if (__builtin_cpu_supports("avx2")) {
+        return &avx2Kernels;
+    }
+#endif
+    return scalarNightKernels();
+}
+
+// Function to list the rooms free for [checkIn, checkOut) that hold at least occupancy people
+// (returns the number of such rooms; at most maxRooms of them are stored in roomNumbers)
+int findAvailableRooms(struct Hotel* hotel, int checkIn, int checkOut, int occupancy, int* roomNumbers, int maxRooms) {
+    uint64_t masks[NIGHT_WORDS];
+    int firstWord, lastWord, found = 0;
+    uint64_t started = startOperation();
+    pthread_rwlock_rdlock(&hotel->tableLock); // Keep the table in place; bookings carry on meanwhile
+    if (!buildNightMasks(hotel, checkIn, checkOut, masks, &firstWord, &lastWord)) {
+        for (int i = 0; i < hotel->roomCount; ++i) { // Outside the horizon: one binary search per room
+            const struct Room* room = &hotel->rooms[i];
+            pthread_mutex_t* lock = roomLock(hotel, room->roomNumber);
+            pthread_mutex_lock(lock);
+            int isFree = isRoomFree(room, checkIn, checkOut);
+            pthread_mutex_unlock(lock);
+            if (room->capacity >= occupancy && isFree) {
+                if (found < maxRooms) {
+                    roomNumbers[found] = room->roomNumber;
+                }
+                found++;
+            }
+        }
+    } else { // Inside the horizon: scan the bitmaps without taking any room lock
+        uint64_t freeBits[SCAN_CHUNK_ROOMS / 64];
+        for (int start = 0; start < hotel->roomCount; start += SCAN_CHUNK_ROOMS) { // A chunk at a time, so nothing is allocated
+            int count = hotel->roomCount - start < SCAN_CHUNK_ROOMS ? hotel->roomCount - start : SCAN_CHUNK_ROOMS;
+            nightKernels()->freeRooms(hotel->nights + start, hotel->roomCapacity, masks, firstWord, lastWord, count, freeBits);
+            for (int block = 0; block * 64 < count; ++block) {
+                for (uint64_t bits = freeBits[block]; bits != 0; bits &= bits - 1) { // Visit only the free rooms
+                    const struct Room* room = &hotel->rooms[start + block * 64 + __builtin_ctzll(bits)];
+                    if (room->capacity >= occupancy) {
+                        if (found < maxRooms) {
+                            roomNumbers[found] = room->roomNumber;
+                        }
+                        found++;
+                    }
+                }
+            }
+        }
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    finishOperation(METRIC_VIEW, started, HOTEL_OK);
+    return found;
+}
+
+// Function to count the rooms free for every night in [checkIn, checkOut)
+int countFreeRooms(struct Hotel* hotel, int checkIn, int checkOut) {
+    uint64_t masks[NIGHT_WORDS];
+    int firstWord, lastWord, found = 0;
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    if (!buildNightMasks(hotel, checkIn, checkOut, masks, &firstWord, &lastWord)) {
+        for (int i = 0; i < hotel->roomCount; ++i) { // Outside the horizon: ask each calendar
+            pthread_mutex_t* lock = roomLock(hotel, hotel->rooms[i].roomNumber);
+            pthread_mutex_lock(lock);
+            found += isRoomFree(&hotel->rooms[i], checkIn, checkOut);
+            pthread_mutex_unlock(lock);
+        }
+    } else {
+        uint64_t freeBits[SCAN_CHUNK_ROOMS / 64];
+        for (int start = 0; start < hotel->roomCount; start += SCAN_CHUNK_ROOMS) {
+            int count = hotel->roomCount - start < SCAN_CHUNK_ROOMS ? hotel->roomCount - start : SCAN_CHUNK_ROOMS;
+            nightKernels()->freeRooms(hotel->nights + start, hotel->roomCapacity, masks, firstWord, lastWord, count, freeBits);
+            for (int block = 0; block * 64 < count; ++block) {
+                found += __builtin_popcountll(freeBits[block]);
+            }
+        }
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return found;
+}
+
+// Function to count the booked room-nights of the whole hotel in [from, to)
+long long countBookedNights(struct Hotel* hotel, int from, int to) {
+    uint64_t masks[NIGHT_WORDS];
+    int firstWord, lastWord;
+    long long booked = 0;
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    if (buildNightMasks(hotel, from, to, masks, &firstWord, &lastWord)) {
+        booked = nightKernels()->bookedNights(hotel->nights, hotel->roomCapacity, masks, firstWord, lastWord, hotel->roomCount);
+    } else {
+        for (int i = 0; i < hotel->roomCount; ++i) { // Outside the horizon: add up calendar overlaps
+            const struct Room* room = &hotel->rooms[i];
+            pthread_mutex_t* lock = roomLock(hotel, room->roomNumber);
+            pthread_mutex_lock(lock);
+            for (int b = findStay(room, from); b < room->bookingCount && room->stays[b].checkIn < to; ++b) {
+                int first = room->stays[b].checkIn > from ? room->stays[b].checkIn : from;
+                int last = room->stays[b].checkOut < to ? room->stays[b].checkOut : to;
+                booked += last - first;
+            }
+            pthread_mutex_unlock(lock);
+        }
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return booked;
+}
+
+// Function to resize the room order from oldCapacity to capacity rooms (new table slots are not in order yet)
+static void growRoomOrder(struct RoomOrder* order, int oldCapacity, int capacity) {
+    int oldWords = (oldCapacity + 63) / 64, words = (capacity + 63) / 64;
+    int oldSummary = (oldWords + 63) / 64, summaryWords = (words + 63) / 64;
+    order->slots = (int*)realloc(order->slots, capacity * sizeof(int));
+    order->positions = (int*)realloc(order->positions, capacity * sizeof(int));
+    memset(order->positions + oldCapacity, 0xff, (capacity - oldCapacity) * sizeof(int)); // -1
+    order->reserved = (uint64_t*)realloc(order->reserved, words * sizeof(uint64_t));
+    memset(order->reserved + oldWords, 0, (words - oldWords) * sizeof(uint64_t));
+    order->summary = (uint64_t*)realloc(order->summary, summaryWords * sizeof(uint64_t));
+    memset(order->summary + oldSummary, 0, (summaryWords - oldSummary) * sizeof(uint64_t));
+}
+
+// Function to append a newly added room to the room order if its number is the highest yet
+// (otherwise it waits for the next report to sort it in)
+static void orderRoom(struct Hotel* hotel, int slot) {
+    struct RoomOrder* order = &hotel->order;
+    int count = order->count;
+    if (count == slot && (count == 0 || hotel->rooms[order->slots[count - 1]].roomNumber < hotel->rooms[slot].roomNumber)) {
+        order->slots[count] = slot;
+        order->positions[slot] = count;
+        order->count = count + 1;
+    }
+}
+
+// Function to set (reserved = 1) or clear (reserved = 0) a room's bit in the room order's reserved bitmap
+// (the caller holds the room lock; other rooms may share the word, so it is changed atomically)
+static void markReserved(struct Hotel* hotel, int slot, int reserved) {
+    struct RoomOrder* order = &hotel->order;
+    int position = order->positions[slot];
+    if (position < 0) {
+        return; // Not sorted in yet: the bits are recomputed when it is
+    }
+    uint64_t* word = &order->reserved[position / 64];
+    uint64_t* summary = &order->summary[position / 4096];
+    uint64_t summaryBit = (uint64_t)1 << (position / 64 % 64);
+    if (reserved) {
+        __atomic_fetch_or(word, (uint64_t)1 << (position % 64), __ATOMIC_SEQ_CST);
+        __atomic_fetch_or(summary, summaryBit, __ATOMIC_SEQ_CST);
+    } else if (__atomic_and_fetch(word, ~((uint64_t)1 << (position % 64)), __ATOMIC_SEQ_CST) == 0) {
+        __atomic_fetch_and(summary, ~summaryBit, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(word, __ATOMIC_SEQ_CST) != 0) { // A booking in a neighbouring room got in between
+            __atomic_fetch_or(summary, summaryBit, __ATOMIC_SEQ_CST);
+        }
+    }
+}
+
+// Function to make room for more bookings on a calendar
+static void growCalendar(struct Room* room, struct RoomDetails* details) {
+    int capacity = room->bookingCount * 2 > CALENDAR_INITIAL_CAPACITY ? room->bookingCount * 2 : CALENDAR_INITIAL_CAPACITY;
+    if (details->bookingCapacity == 0) { // Never allocated, or still inside the loaded snapshot: copy it out
+        struct Stay* stays = (struct Stay*)malloc(capacity * sizeof(struct Stay));
+        struct Booking* bookings = (struct Booking*)malloc(capacity * sizeof(struct Booking));
+        if (room->bookingCount > 0) {
+            memcpy(stays, room->stays, room->bookingCount * sizeof(struct Stay));
+            memcpy(bookings, details->bookings, room->bookingCount * sizeof(struct Booking));
+        }
+        room->stays = stays;
+        details->bookings = bookings;
+    } else {
+        room->stays = (struct Stay*)realloc(room->stays, capacity * sizeof(struct Stay));
+        details->bookings = (struct Booking*)realloc(details->bookings, capacity * sizeof(struct Booking));
+    }
+    details->bookingCapacity = capacity;
+}
+
+// Function to find a floor's totals, adding the floor if create is set (returns its position in floors, or -1;
+// adding may move the array, so the caller holds every room lock unless floorNeedsSpace said no)
+static int findFloor(struct Hotel* hotel, int floor, int create) {
+    int position = indexFind(&hotel->floorIndex, floor);
+    if (position >= 0 || !create) {
+        return position;
+    }
+    if (hotel->floorCount == hotel->floorCapacity) {
+        hotel->floorCapacity = hotel->floorCapacity ? hotel->floorCapacity * 2 : FLOOR_INITIAL_CAPACITY;
+        hotel->floors = (struct FloorTotals*)realloc(hotel->floors, hotel->floorCapacity * sizeof(struct FloorTotals));
+    }
+    if ((int64_t)(hotel->floorIndex.count + 1) * 10 > (int64_t)hotel->floorIndex.capacity * 7) {
+        indexGrow(&hotel->floorIndex, 1);
+    }
+    position = hotel->floorCount++;
+    memset(&hotel->floors[position], 0, sizeof(struct FloorTotals));
+    hotel->floors[position].floor = floor;
+    indexPut(&hotel->floorIndex, floor, position);
+    return position;
+}
+
+// Function to check whether adding one more floor would move the floor totals or their index
+static int floorNeedsSpace(const struct Hotel* hotel) {
+    return hotel->floorCount == hotel->floorCapacity || (int64_t)(hotel->floorIndex.count + 1) * 10 > (int64_t)hotel->floorIndex.capacity * 7;
+}
+
+// Function to add to a running total only ever written under one lock (readers load it without the lock)
+static void addToTotal(int64_t* total, int64_t amount) {
+    __atomic_store_n(total, __atomic_load_n(total, __ATOMIC_RELAXED) + amount, __ATOMIC_RELAXED);
+}
+
+// Function to add (sign = 1) or take away (sign = -1) one booking of a room in the running totals of its
+// room lock, its floor and its nights (the caller holds the room lock; floors and nights are shared with
+// rooms under other locks, so those are changed atomically); returns what the booking comes to
+static int64_t countStay(struct Hotel* hotel, int slot, int checkIn, int checkOut, int occupancy, int extraServices, int sign) {
+    int roomNumber = hotel->rooms[slot].roomNumber;
+    int64_t nights = checkOut - checkIn;
+    int64_t revenue = quoteStay(&hotel->rates, roomNumber, checkIn, (int)nights, occupancy, extraServices, NULL);
+    union StripeTotals* stripe = &hotel->stripeTotals[hashRoomNumber(roomNumber) & (ROOM_LOCK_STRIPES - 1)];
+    addToTotal(&stripe->sums.bookings, sign);
+    addToTotal(&stripe->sums.guests, sign * occupancy);
+    addToTotal(&stripe->sums.roomNights, sign * nights);
+    addToTotal(&stripe->sums.revenue, sign * revenue);
+
+    struct HotelTotals* floor = &hotel->floors[findFloor(hotel, hotel->details[slot].floor, 0)].totals;
+    __atomic_fetch_add(&floor->bookings, sign, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&floor->guests, sign * occupancy, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&floor->roomNights, sign * nights, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&floor->revenue, sign * revenue, __ATOMIC_RELAXED);
+
+    int first = checkIn - hotel->calendarStart, last = checkOut - hotel->calendarStart; // Only nights the bitmaps track
+    first = first < 0 ? 0 : first;
+    last = last > NIGHT_HORIZON ? NIGHT_HORIZON : last;
+    for (int night = first; night < last; ++night) {
+        __atomic_fetch_add(&hotel->nightTotals[night].bookedRooms, sign, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&hotel->nightTotals[night].guests, sign * occupancy, __ATOMIC_RELAXED);
+    }
+    if (checkIn - hotel->calendarStart >= 0 && checkIn - hotel->calendarStart < NIGHT_HORIZON) {
+        __atomic_fetch_add(&hotel->nightTotals[checkIn - hotel->calendarStart].arrivals, sign, __ATOMIC_RELAXED);
+    }
+    return revenue;
+}
+
+// Function to count a room in (sign = 1) or out of (sign = -1) the reserved rooms when its first booking
+// comes or its last one goes (the caller holds the room lock)
+static void countReserved(struct Hotel* hotel, int slot, int sign) {
+    int roomNumber = hotel->rooms[slot].roomNumber;
+    addToTotal(&hotel->stripeTotals[hashRoomNumber(roomNumber) & (ROOM_LOCK_STRIPES - 1)].sums.reservedRooms, sign);
+    __atomic_fetch_add(&hotel->floors[findFloor(hotel, hotel->details[slot].floor, 0)].totals.reservedRooms, sign, __ATOMIC_RELAXED);
+}
+
+// Function to find the oldest stamp among the open read views (UINT64_MAX if none is open; a view still being
+// opened shows a stamp no later than its own, so nothing it will read is taken for unneeded)
+static uint64_t oldestView(struct Hotel* hotel) {
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < VIEW_MAX_OPEN; ++i) {
+        uint64_t stamp = __atomic_load_n(&hotel->views.views[i].stamp, __ATOMIC_SEQ_CST);
+        oldest = stamp != 0 && stamp < oldest ? stamp : oldest;
+    }
+    return oldest;
+}
+
+// Function to free the past states of a room that every open view has moved beyond (the caller holds the room lock)
+static void pruneVersions(struct Hotel* hotel, int slot) {
+    uint64_t oldest = oldestView(hotel);
+    struct RoomVersion** link = &hotel->versions[slot].older;
+    while (*link != NULL && (*link)->until >= oldest) { // Newest first, so the rest are older still once one is unneeded
+        link = &(*link)->older;
+    }
+    struct RoomVersion* version = *link;
+    int64_t freed = 0;
+    __atomic_store_n(link, NULL, __ATOMIC_RELAXED);
+    while (version != NULL) {
+        struct RoomVersion* older = version->older;
+        free(version);
+        version = older;
+        freed++;
+    }
+    if (freed > 0) {
+        __atomic_fetch_sub(&hotel->views.kept, freed, __ATOMIC_RELAXED);
+    }
+}
+
+// Function to keep the state of a room that open views may still read, before a booking changes it (the caller
+// holds the room lock; with no view open nothing is copied, and states no view needs any more are freed)
+static void preserveRoom(struct Hotel* hotel, int slot) {
+    struct RoomVersions* versions = &hotel->versions[slot];
+    uint64_t now = __atomic_load_n(&hotel->views.clock, __ATOMIC_SEQ_CST);
+    if (now > versions->changedAt && __atomic_load_n(&hotel->views.open, __ATOMIC_SEQ_CST) > 0) { // A view may be stamped in (changedAt, now]
+        const struct Room* room = &hotel->rooms[slot];
+        int count = room->bookingCount;
+        struct RoomVersion* version = (struct RoomVersion*)malloc(sizeof(struct RoomVersion) + count * (sizeof(struct Booking) + sizeof(struct Stay)));
+        version->since = versions->changedAt;
+        version->until = now;
+        version->bookingCount = count;
+        version->cancellationTime = hotel->details[slot].cancellationTime;
+        version->bookings = (struct Booking*)(version + 1); // Bookings first, as they need the wider alignment
+        version->stays = (struct Stay*)(version->bookings + count);
+        if (count > 0) {
+            memcpy(version->bookings, hotel->details[slot].bookings, count * sizeof(struct Booking));
+            memcpy(version->stays, room->stays, count * sizeof(struct Stay));
+        }
+        version->older = versions->older;
+        __atomic_store_n(&versions->older, version, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&hotel->views.kept, 1, __ATOMIC_RELAXED);
+    }
+    versions->changedAt = now;
+    if (versions->older != NULL) {
+        pruneVersions(hotel, slot);
+    }
+}
+
+// Function to book a room at the given time without printing or journaling anything
+static int reserveRoomAt(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn, int duration, int extraServices, int occupancy, time_t when) {
+    int slot = findRoom(hotel, roomNumber); // Look the room up in the index
+    if (slot < 0) {
+        return HOTEL_ROOM_NOT_FOUND;
+    }
+    if (!isValidStay(checkIn, duration) || occupancy < 1) { // Nobody staying would count minus guests in the totals
+        return HOTEL_INVALID_STAY;
+    }
+    if (strlen(guestName) >= MAX_NAME_LENGTH) { // The pool has no limit, but searches and the journal keep names below this
+        return HOTEL_INVALID_NAME;
+    }
+    struct Room* room = &hotel->rooms[slot];
+    struct RoomDetails* details = &hotel->details[slot];
+    if (occupancy > room->capacity) {
+        return HOTEL_OVER_CAPACITY;
+    }
+    int checkOut = checkIn + duration;
+    int position = findStay(room, checkIn);
+    if (position < room->bookingCount && room->stays[position].checkIn < checkOut) {
+        return HOTEL_ROOM_UNAVAILABLE; // Some night of the stay is already booked
+    }
+
+    preserveRoom(hotel, slot); // Open views keep reading the calendar as it was
+    if (room->bookingCount >= details->bookingCapacity) { // Grow the calendar geometrically
+        growCalendar(room, details);
+    }
+    int later = room->bookingCount - position; // Stays after the new one keep their order
+    memmove(&room->stays[position + 1], &room->stays[position], later * sizeof(struct Stay));
+    memmove(&details->bookings[position + 1], &details->bookings[position], later * sizeof(struct Booking));
+
+    room->stays[position].checkIn = checkIn;
+    room->stays[position].checkOut = checkOut;
+    struct Booking* booking = &details->bookings[position];
+    booking->extraServices = extraServices; // Set the extra services request
+    booking->occupancy = occupancy; // Set the number of people staying
+    booking->reservationTime = (int64_t)when; // Set the reservation time
+    room->bookingCount++;
+    room->isReserved = 1;
+    if (room->bookingCount == 1) {
+        markReserved(hotel, slot, 1); // Keep the reports' bitmap in step too
+        countReserved(hotel, slot, 1);
+    }
+    int64_t amount = countStay(hotel, slot, checkIn, checkOut, occupancy, extraServices, 1); // And the running totals
+    markNights(hotel, slot, checkIn, checkOut, 1); // Keep the night bitmap in step with the calendar
+    booking->guestName = guestIndexAdd(&hotel->guests, guestName, NAME_NONE, roomNumber, checkIn); // And the guest index
+    recordHistory(&hotel->history, HISTORY_RESERVED, (int64_t)when, roomNumber, guestName, checkIn, duration, occupancy, extraServices, amount);
+    return HOTEL_OK;
+}
+
+// Function to remove a guest's booking at the given time without printing or journaling anything
+static int releaseRoomAt(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn, time_t when) {
+    int slot = findRoom(hotel, roomNumber); // Look the room up in the index
+    if (slot < 0) {
+        return HOTEL_ROOM_NOT_FOUND;
+    }
+    struct Room* room = &hotel->rooms[slot];
+    struct RoomDetails* details = &hotel->details[slot];
+    int position = findStay(room, checkIn);
+    if (position == room->bookingCount || room->stays[position].checkIn != checkIn
+        || strcmp(poolString(&hotel->guests.names, details->bookings[position].guestName), guestName) != 0) { // Check if the reservation matches
+        return HOTEL_BOOKING_NOT_FOUND;
+    }
+
+    preserveRoom(hotel, slot);
+    int nights = room->stays[position].checkOut - checkIn;
+    const struct Booking* booking = &details->bookings[position];
+    markNights(hotel, slot, checkIn, room->stays[position].checkOut, 0); // Free the nights in the bitmap
+    int64_t amount = countStay(hotel, slot, checkIn, room->stays[position].checkOut, booking->occupancy, booking->extraServices, -1);
+    recordHistory(&hotel->history, HISTORY_CANCELLED, (int64_t)when, roomNumber, guestName, checkIn, nights, booking->occupancy,
+                  booking->extraServices, amount); // The stay outlives the booking there
+    guestIndexRemove(&hotel->guests, guestName, roomNumber, checkIn);
+    int later = room->bookingCount - position - 1;
+    memmove(&room->stays[position], &room->stays[position + 1], later * sizeof(struct Stay));
+    memmove(&details->bookings[position], &details->bookings[position + 1], later * sizeof(struct Booking));
+    room->bookingCount--;
+    room->isReserved = room->bookingCount > 0;
+    if (room->bookingCount == 0) {
+        markReserved(hotel, slot, 0);
+        countReserved(hotel, slot, -1);
+    }
+    details->cancellationTime = (int64_t)when; // Set the cancellation time
+    return HOTEL_OK;
+}
+
+// Function to make space for rooms more rooms in the table, night bitmaps and index (each grows at most once)
+static void reserveRoomSpace(struct Hotel* hotel, int rooms) {
+    if (hotel->roomCount + rooms > hotel->roomCapacity) { // Grow all arrays geometrically, never per room
+        int oldCapacity = hotel->roomCapacity;
+        hotel->roomCapacity = oldCapacity ? oldCapacity * 2 : TABLE_INITIAL_CAPACITY;
+        while (hotel->roomCapacity < hotel->roomCount + rooms) {
+            hotel->roomCapacity *= 2;
+        }
+        hotel->rooms = (struct Room*)realloc(hotel->rooms, hotel->roomCapacity * sizeof(struct Room));
+        hotel->details = (struct RoomDetails*)realloc(hotel->details, hotel->roomCapacity * sizeof(struct RoomDetails));
+        hotel->versions = (struct RoomVersions*)realloc(hotel->versions, hotel->roomCapacity * sizeof(struct RoomVersions));
+        uint64_t* nights = (uint64_t*)calloc((size_t)NIGHT_WORDS * hotel->roomCapacity, sizeof(uint64_t));
+        for (int w = 0; oldCapacity > 0 && w < NIGHT_WORDS; ++w) { // Re-stride each bitmap row for the new capacity
+            memcpy(&nights[w * hotel->roomCapacity], &hotel->nights[w * oldCapacity], hotel->roomCount * sizeof(uint64_t));
+        }
+        free(hotel->nights);
+        hotel->nights = nights;
+        growRoomOrder(&hotel->order, oldCapacity, hotel->roomCapacity);
+    }
+    if ((int64_t)(hotel->index.count + rooms) * 10 > (int64_t)hotel->index.capacity * 7) { // Keep the load factor below 0.7
+        indexGrow(&hotel->index, rooms);
+    }
+}
+
+// Function to put a new room on a floor in the next table slot (the table has space for it)
+static void placeRoom(struct Hotel* hotel, int roomNumber, int floor) {
+    int slot = hotel->roomCount;
+    initRoom(&hotel->rooms[slot], &hotel->details[slot], roomNumber); // Initialize the room in place
+    hotel->details[slot].floor = floor;
+    hotel->versions[slot].changedAt = __atomic_load_n(&hotel->views.clock, __ATOMIC_SEQ_CST); // Not there for views open now
+    hotel->versions[slot].older = NULL;
+    indexPut(&hotel->index, roomNumber, slot); // Make the room reachable by number
+    orderRoom(hotel, slot);
+    int position = findFloor(hotel, floor, 1); // May move the floors, so found before they are read
+    hotel->floors[position].totals.rooms++;
+    hotel->roomCount++;
+}
+
+// Function to add a room on a floor without logging it, unless its number is taken (the index answers that in one probe)
+static int insertRoomQuietly(struct Hotel* hotel, int roomNumber, int floor) {
+    if (findRoom(hotel, roomNumber) >= 0) {
+        return HOTEL_ROOM_EXISTS;
+    }
+    reserveRoomSpace(hotel, 1);
+    placeRoom(hotel, roomNumber, floor);
+    return HOTEL_OK;
+}
+
+// Function to log a change the hotel has just applied (does nothing if the hotel is not journaled)
+static void logChange(struct Hotel* hotel, int type, int roomNumber, const char* guestName, int checkIn, int duration, int extraServices, int occupancy, time_t when) {
+    if (hotel->journal == NULL) {
+        return;
+    }
+    struct JournalRecord record;
+    memset(&record, 0, sizeof(record)); // Padding bytes are hashed too, so they must be zero
+    record.type = type;
+    record.time = when;
+    record.roomNumber = roomNumber;
+    record.checkIn = checkIn;
+    record.duration = duration;
+    record.extraServices = extraServices;
+    record.occupancy = occupancy;
+    journalAppend(hotel->journal, &record, guestName); // checkpointHotel reads the last sequence back from the journal
+}
+
+// Function to log the bookings of a group as one unit, which recoverJournal replays all or none
+static void logGroup(struct Hotel* hotel, const int* roomNumbers, const int* occupancies, int count, const char* guestName,
+                     int checkIn, int nights, int extraServices, time_t when) {
+    if (hotel->journal == NULL) {
+        return;
+    }
+    struct JournalRecord* records = (struct JournalRecord*)calloc(count + 1, sizeof(struct JournalRecord)); // Padding is hashed too
+    const char** names = (const char**)malloc((count + 1) * sizeof(const char*));
+    records[0].type = JOURNAL_GROUP; // Says how many bookings follow
+    records[0].time = when;
+    records[0].roomNumber = roomNumbers[0];
+    records[0].checkIn = checkIn;
+    records[0].duration = count;
+    names[0] = NULL;
+    for (int r = 0; r < count; ++r) {
+        records[r + 1].type = JOURNAL_RESERVE;
+        records[r + 1].time = when;
+        records[r + 1].roomNumber = roomNumbers[r];
+        records[r + 1].checkIn = checkIn;
+        records[r + 1].duration = nights;
+        records[r + 1].extraServices = extraServices;
+        records[r + 1].occupancy = occupancies[r];
+        names[r + 1] = guestName;
+    }
+    journalAppendRecords(hotel->journal, records, names, count + 1);
+    free(records);
+    free(names);
+}
+
+// Function to add a room to the hotel without printing anything (safe to call from any thread)
+int insertRoom(struct Hotel* hotel, int roomNumber) {
+    uint64_t started = startOperation();
+    pthread_rwlock_wrlock(&hotel->tableLock); // Queries and reports wait; bookings only if the arrays must grow
+    int floor = roomNumber / FLOOR_NUMBERING;
+    int grows = hotel->roomCount == hotel->roomCapacity || (hotel->index.count + 1) * 10 > hotel->index.capacity * 7
+                || (findFloor(hotel, floor, 0) < 0 && floorNeedsSpace(hotel));
+    if (grows) {
+        lockAllRooms(hotel, 1);
+    } else {
+        pthread_mutex_lock(roomLock(hotel, roomNumber)); // A room with the same number may be in use
+    }
+    int status = insertRoomQuietly(hotel, roomNumber, floor);
+    if (status == HOTEL_OK) {
+        logChange(hotel, JOURNAL_ADD_ROOM, roomNumber, NULL, 0, 0, 0, floor, time(NULL));
+    }
+    if (grows) {
+        lockAllRooms(hotel, 0);
+    } else {
+        pthread_mutex_unlock(roomLock(hotel, roomNumber));
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    finishOperation(METRIC_ADD_ROOM, started, status);
+    return status;
+}
+
+// Function to add many rooms at once, skipping numbers the hotel or the list already has (safe to call from
+// any thread; returns the number added). The table, bitmaps and index grow once for the whole list, so
+// loading a property costs one hash probe per room instead of one growth step per doubling. floors gives
+// the floor of each room, or is NULL to number floors by FLOOR_NUMBERING
+int insertRooms(struct Hotel* hotel, const int* roomNumbers, const int* floors, int count) {
+    if (count <= 0) {
+        return 0;
+    }
+    uint64_t started = startOperation();
+    time_t now = time(NULL);
+    int added = 0;
+    pthread_rwlock_wrlock(&hotel->tableLock);
+    lockAllRooms(hotel, 1); // The arrays may move; bookings wait for the whole list
+    int fresh = 0;
+    for (int i = 0; i < count; ++i) { // Grow only for numbers the hotel does not have yet
+        fresh += findRoom(hotel, roomNumbers[i]) < 0;
+    }
+    reserveRoomSpace(hotel, fresh);
+    for (int i = 0; i < count; ++i) {
+        if (findRoom(hotel, roomNumbers[i]) >= 0) { // Already there, or earlier in the list
+            continue;
+        }
+        int floor = floors != NULL ? floors[i] : roomNumbers[i] / FLOOR_NUMBERING;
+        placeRoom(hotel, roomNumbers[i], floor);
+        added++;
+        logChange(hotel, JOURNAL_ADD_ROOM, roomNumbers[i], NULL, 0, 0, 0, floor, now);
+    }
+    lockAllRooms(hotel, 0);
+    pthread_rwlock_unlock(&hotel->tableLock);
+    finishOperation(METRIC_LOAD_ROOMS, started, HOTEL_OK);
+    return added;
+}
+
+// Function to list the rooms of floors firstFloor to lastFloor, numbered firstRoom to lastRoom on each floor
+// (room 7 of floor 12 is 1207, or 12007 if some floor has 100 rooms or more; returns the number of rooms,
+// or -1 if the range is empty, negative or too large, and allocates *roomNumbers for the caller to free)
+int expandRoomRange(int firstFloor, int lastFloor, int firstRoom, int lastRoom, int** roomNumbers) {
+    int64_t multiplier = 100;
+    while (multiplier <= lastRoom) {
+        multiplier *= 10;
+    }
+    int64_t count = ((int64_t)lastFloor - firstFloor + 1) * ((int64_t)lastRoom - firstRoom + 1);
+    if (firstFloor < 0 || firstRoom < 0 || firstFloor > lastFloor || firstRoom > lastRoom || count > ROOM_RANGE_MAX
+        || (int64_t)lastFloor * multiplier + lastRoom > INT32_MAX) {
+        return -1;
+    }
+    int* numbers = (int*)malloc((size_t)count * sizeof(int));
+    int n = 0;
+    for (int floor = firstFloor; floor <= lastFloor; ++floor) {
+        for (int room = firstRoom; room <= lastRoom; ++room) {
+            numbers[n++] = (int)(floor * multiplier + room);
+        }
+    }
+    *roomNumbers = numbers;
+    return n;
+}
+
+// Function to read a room file into the hotel in one insertRooms call (returns 1 if loaded, 0 if there is no
+// such file, or minus the number of the first line not understood, in which case no room is added;
+// *listed gets the number of rooms the file lists, *added those added; the rest were there or listed twice)
+//   room NUMBER                                  one room
+//   rooms FIRST LAST                             rooms FIRST to LAST
+//   floors FIRST LAST rooms FIRST LAST           the same rooms on every floor (see expandRoomRange)
+int loadRoomFile(struct Hotel* hotel, const char* path, int* listed, int* added) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return 0;
+    }
+    char line[256], word[16], extra[2];
+    int lineNumber = 0, ok = 1, count = 0, capacity = 1024, a, b, c, d;
+    int* numbers = (int*)malloc(capacity * sizeof(int));
+    int* floors = (int*)malloc(capacity * sizeof(int)); // Floor of each room, as the line gives it
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        int* range = NULL;
+        int first = 0, last = -1, ranged = 0;
+        lineNumber++;
+        line[strcspn(line, "#")] = '\0'; // Drop the comment
+        if (sscanf(line, "%15s", word) != 1) {
+            continue; // Blank line
+        }
+        if (strcmp(word, "room") == 0 && sscanf(line, "%*s %d %1s", &a, extra) == 1) {
+            first = last = a;
+        } else if (strcmp(word, "rooms") == 0 && sscanf(line, "%*s %d %d %1s", &a, &b, extra) == 2) {
+            first = a;
+            last = b;
+        } else if (strcmp(word, "floors") == 0 && sscanf(line, "%*s %d %d rooms %d %d %1s", &a, &b, &c, &d, extra) == 4) {
+            ranged = expandRoomRange(a, b, c, d, &range);
+        } else {
+            ranged = -1;
+        }
+        int64_t more = ranged != 0 ? ranged : (int64_t)last - first + 1;
+        ok = ranged >= 0 && first >= 0 && (ranged > 0 || last >= first) && count + more <= ROOM_RANGE_MAX;
+        while (ok && count + more > capacity) {
+            capacity *= 2;
+            numbers = (int*)realloc(numbers, capacity * sizeof(int));
+            floors = (int*)realloc(floors, capacity * sizeof(int));
+        }
+        for (int64_t i = 0; ok && i < more; ++i) {
+            numbers[count] = range != NULL ? range[i] : (int)(first + i);
+            floors[count] = range != NULL ? a + (int)(i / (d - c + 1)) : numbers[count] / FLOOR_NUMBERING;
+            count++;
+        }
+        free(range);
+    }
+    fclose(file);
+    if (ok) {
+        *listed = count;
+        *added = insertRooms(hotel, numbers, floors, count);
+    }
+    free(numbers);
+    free(floors);
+    return ok ? 1 : -lineNumber;
+}
+
+// Function to order room numbers for qsort
+static int compareRoomNumbers(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Function to order sort keys (room number in the high half, table slot in the low half) for qsort
+static int compareOrderKeys(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Function to sort every room into the room order and recompute its bitmaps from the calendars
+// (the caller holds the table lock for writing and every room lock)
+static void sortRoomOrder(struct Hotel* hotel) {
+    struct RoomOrder* order = &hotel->order;
+    int words = (hotel->roomCount + 63) / 64;
+    uint64_t* keys = (uint64_t*)malloc((hotel->roomCount + 1) * sizeof(uint64_t));
+    for (int i = 0; i < hotel->roomCount; ++i) { // Flipping the sign bit makes negative numbers sort first
+        keys[i] = (uint64_t)((uint32_t)hotel->rooms[i].roomNumber ^ 0x80000000u) << 32 | (uint32_t)i;
+    }
+    qsort(keys, hotel->roomCount, sizeof(uint64_t), compareOrderKeys);
+    memset(order->reserved, 0, words * sizeof(uint64_t));
+    memset(order->summary, 0, (words + 63) / 64 * sizeof(uint64_t));
+    for (int p = 0; p < hotel->roomCount; ++p) {
+        int slot = (int)(uint32_t)keys[p];
+        order->slots[p] = slot;
+        order->positions[slot] = p;
+        if (hotel->rooms[slot].bookingCount > 0) {
+            order->reserved[p / 64] |= (uint64_t)1 << (p % 64);
+            order->summary[p / 4096] |= (uint64_t)1 << (p / 64 % 64);
+        }
+    }
+    order->count = hotel->roomCount;
+    free(keys);
+}
+
+// Function to find the first position, in the room order or in a sorted list of room numbers, whose room
+// number is at least roomNumber (binary search; returns count if there is none)
+static int searchOrder(const struct Hotel* hotel, const int* roomNumbers, int count, int roomNumber) {
+    int low = 0, high = count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        int number = roomNumbers != NULL ? roomNumbers[middle] : hotel->rooms[hotel->order.slots[middle]].roomNumber;
+        if (number < roomNumber) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Function to step from position towards end (exclusive; step 1 or -1) to the first room in the order whose
+// reserved bit is wanted (1 or 0; -1 for any room), a word of 64 rooms at a time and skipping runs of words
+// without a booking through the summary (returns end if there is none)
+static int nextOrderPosition(const struct RoomOrder* order, int position, int end, int wanted, int step) {
+    while (position != end) {
+        if (wanted < 0) {
+            return position;
+        }
+        int word = position / 64;
+        if (wanted == 1) { // Jump over words the summary says are empty
+            int group = word / 64;
+            uint64_t groups = __atomic_load_n(&order->summary[group], __ATOMIC_SEQ_CST);
+            groups &= step > 0 ? ~(uint64_t)0 << (word % 64) : ~(uint64_t)0 >> (63 - word % 64);
+            while (groups == 0) {
+                group += step;
+                if (step > 0 ? group * 4096 >= end : group < 0 || group * 4096 + 4095 <= end) {
+                    return end;
+                }
+                groups = __atomic_load_n(&order->summary[group], __ATOMIC_SEQ_CST);
+            }
+            int found = group * 64 + (step > 0 ? __builtin_ctzll(groups) : 63 - __builtin_clzll(groups));
+            if (found != word) {
+                word = found;
+                position = step > 0 ? word * 64 : word * 64 + 63;
+                if (step > 0 ? position >= end : position <= end) {
+                    return end;
+                }
+            }
+        }
+        uint64_t bits = __atomic_load_n(&order->reserved[word], __ATOMIC_SEQ_CST);
+        bits = wanted ? bits : ~bits;
+        bits &= step > 0 ? ~(uint64_t)0 << (position % 64) : ~(uint64_t)0 >> (63 - position % 64);
+        if (bits != 0) {
+            int found = word * 64 + (step > 0 ? __builtin_ctzll(bits) : 63 - __builtin_clzll(bits));
+            return (step > 0 ? found < end : found > end) ? found : end;
+        }
+        position = step > 0 ? word * 64 + 64 : word * 64 - 1;
+        if (step > 0 ? position > end : position < end) {
+            position = end;
+        }
+    }
+    return end;
+}
+
+// Function to take the table lock for reading with every room sorted into the room order (rooms added below
+// the highest number since the last report are sorted in first, under the lock for writing)
+static void lockSortedTable(struct Hotel* hotel) {
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    while (hotel->order.count != hotel->roomCount) {
+        pthread_rwlock_unlock(&hotel->tableLock);
+        pthread_rwlock_wrlock(&hotel->tableLock);
+        if (hotel->order.count != hotel->roomCount) { // Not sorted by another caller meanwhile
+            lockAllRooms(hotel, 1);
+            sortRoomOrder(hotel);
+            lockAllRooms(hotel, 0);
+        }
+        pthread_rwlock_unlock(&hotel->tableLock);
+        pthread_rwlock_rdlock(&hotel->tableLock);
+    }
+}
+
+// Function to check a room against the reserved or vacant filter of a report (the caller holds the table lock)
+static int reportMatches(struct Hotel* hotel, int slot, int filter, int night) {
+    if (filter == HOTEL_REPORT_ALL) {
+        return 1;
+    }
+    const struct Room* room = &hotel->rooms[slot];
+    int offset = night - hotel->calendarStart, booked;
+    if (night != HOTEL_ANY_NIGHT && offset >= 0 && offset < NIGHT_HORIZON) { // Inside the horizon: one bitmap bit
+        booked = (int)(__atomic_load_n(&hotel->nights[(offset / 64) * hotel->roomCapacity + slot], __ATOMIC_RELAXED) >> (offset % 64) & 1);
+    } else {
+        pthread_mutex_t* lock = roomLock(hotel, room->roomNumber);
+        pthread_mutex_lock(lock);
+        booked = night == HOTEL_ANY_NIGHT ? room->bookingCount > 0 : !isRoomFree(room, night, night + 1);
+        pthread_mutex_unlock(lock);
+    }
+    return booked == (filter == HOTEL_REPORT_RESERVED);
+}
+
+// Function to find the calendar of a room as a view reads it: the room itself if it has not changed since the
+// view was opened, or else the version kept for the view (the caller holds the room lock; returns 0 if the room
+// was added after the view was opened)
+static int findViewState(struct Hotel* hotel, int slot, uint64_t stamp, int* count, const struct Stay** stays,
+                         const struct Booking** bookings, int64_t* cancellationTime) {
+    const struct RoomVersions* versions = &hotel->versions[slot];
+    if (versions->changedAt < stamp) {
+        *count = hotel->rooms[slot].bookingCount;
+        *stays = hotel->rooms[slot].stays;
+        *bookings = hotel->details[slot].bookings;
+        *cancellationTime = hotel->details[slot].cancellationTime;
+        return 1;
+    }
+    for (const struct RoomVersion* version = versions->older; version != NULL; version = version->older) {
+        if (version->since < stamp && stamp <= version->until) {
+            *count = version->bookingCount;
+            *stays = version->stays;
+            *bookings = version->bookings;
+            *cancellationTime = version->cancellationTime;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function to check a room, as a view reads it, against every condition of a report (the caller holds the table
+// lock; rooms added after the view was opened never match)
+static int viewMatches(struct Hotel* hotel, int slot, uint64_t stamp, const struct HotelReportQuery* query) {
+    const struct Stay* stays;
+    const struct Booking* bookings;
+    int64_t cancellationTime;
+    int count, matches;
+    pthread_mutex_t* lock = roomLock(hotel, hotel->rooms[slot].roomNumber);
+    pthread_mutex_lock(lock);
+    matches = findViewState(hotel, slot, stamp, &count, &stays, &bookings, &cancellationTime);
+    if (matches && query->guestName != NULL) { // Booked under the name at some point on the calendar
+        int b = 0;
+        while (b < count && strcmp(poolString(&hotel->guests.names, bookings[b].guestName), query->guestName) != 0) {
+            b++;
+        }
+        matches = b < count;
+    }
+    if (matches && query->filter != HOTEL_REPORT_ALL) {
+        int booked = count > 0;
+        if (query->night != HOTEL_ANY_NIGHT) { // The first stay ending after the night, as findStay finds it
+            int low = 0, high = count;
+            while (low < high) {
+                int middle = low + (high - low) / 2;
+                if (stays[middle].checkOut > query->night) {
+                    high = middle;
+                } else {
+                    low = middle + 1;
+                }
+            }
+            booked = low < count && stays[low].checkIn <= query->night;
+        }
+        matches = booked == (query->filter == HOTEL_REPORT_RESERVED);
+    }
+    pthread_mutex_unlock(lock);
+    return matches;
+}
+
+// Function to list the distinct rooms a guest has booked, by room number (returns how many, and allocates
+// *roomNumbers for the caller to free)
+static int listGuestRooms(struct Hotel* hotel, const char* guestName, int** roomNumbers) {
+    int count = findGuestBookings(hotel, guestName, NULL, 0);
+    struct GuestStay* stays = (struct GuestStay*)malloc((count + 1) * sizeof(struct GuestStay));
+    count = findGuestBookings(hotel, guestName, stays, count); // May have changed in between
+    int* numbers = (int*)malloc((count + 1) * sizeof(int));
+    for (int i = 0; i < count; ++i) {
+        numbers[i] = stays[i].roomNumber;
+    }
+    free(stays);
+    qsort(numbers, count, sizeof(int), compareRoomNumbers);
+    int distinct = 0;
+    for (int i = 0; i < count; ++i) {
+        if (distinct == 0 || numbers[distinct - 1] != numbers[i]) {
+            numbers[distinct++] = numbers[i];
+        }
+    }
+    *roomNumbers = numbers;
+    return distinct;
+}
+
+// Function to fetch the next page of a report: up to maxRooms numbers of the rooms matching query, in room
+// number order from where cursor stands, moving the cursor past them (returns the number stored). Reserved and
+// vacant rooms are found through the room order's bitmap and a guest's rooms through the guest index, so a
+// page costs about the same however large the hotel is; only a night filter tests each candidate room. Read
+// through a view (view not NULL), the filters look at the rooms as the view has them instead, which means
+// testing every room the page passes over
+static int listReportRooms(struct Hotel* hotel, struct HotelView* view, const struct HotelReportQuery* query,
+                           struct HotelCursor* cursor, int* roomNumbers, int maxRooms) {
+    if (cursor->state == HOTEL_CURSOR_DONE || maxRooms <= 0) {
+        return 0;
+    }
+    uint64_t started = startOperation();
+    int* guestRooms = NULL;
+    int guestRoomCount = query->guestName != NULL && view == NULL ? listGuestRooms(hotel, query->guestName, &guestRooms) : 0;
+
+    lockSortedTable(hotel);
+    int count = guestRooms != NULL ? guestRoomCount : hotel->roomCount;
+    int low = searchOrder(hotel, guestRooms, count, query->firstRoom);
+    int high = query->lastRoom == INT32_MAX ? count : searchOrder(hotel, guestRooms, count, query->lastRoom + 1);
+    if (cursor->state == HOTEL_CURSOR_MORE && !query->descending) { // Carry on after the last room listed
+        int next = cursor->roomNumber == INT32_MAX ? count : searchOrder(hotel, guestRooms, count, cursor->roomNumber + 1);
+        low = next > low ? next : low;
+    } else if (cursor->state == HOTEL_CURSOR_MORE) {
+        int next = searchOrder(hotel, guestRooms, count, cursor->roomNumber);
+        high = next < high ? next : high;
+    }
+
+    // Walk the order from low up (or high down): the bitmap settles the reserved and vacant filters on any
+    // night, so only a guest's rooms and rooms checked on one night need a test of their own
+    high = high < low ? low : high; // Empty once the cursor has passed the last room
+    int step = query->descending ? -1 : 1;
+    int end = query->descending ? low - 1 : high;
+    int wanted = view != NULL ? -1 // The bitmap has the rooms as they are now
+               : query->filter == HOTEL_REPORT_RESERVED ? 1
+               : query->filter == HOTEL_REPORT_VACANT && query->night == HOTEL_ANY_NIGHT ? 0 : -1;
+    int test = guestRooms != NULL || (query->filter != HOTEL_REPORT_ALL && query->night != HOTEL_ANY_NIGHT);
+    int found = 0, more = 0;
+    for (int position = query->descending ? high - 1 : low; position != end; position += step) {
+        if (guestRooms == NULL && (position = nextOrderPosition(&hotel->order, position, end, wanted, step)) == end) {
+            break;
+        }
+        int slot = guestRooms != NULL ? findRoom(hotel, guestRooms[position]) : hotel->order.slots[position];
+        if (view != NULL ? viewMatches(hotel, slot, view->stamp, query)
+                         : !test || reportMatches(hotel, slot, query->filter, query->night)) {
+            if (found == maxRooms) { // One room past the page says whether there is another page
+                more = 1;
+                break;
+            }
+            roomNumbers[found++] = hotel->rooms[slot].roomNumber;
+        }
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    free(guestRooms);
+    cursor->state = more ? HOTEL_CURSOR_MORE : HOTEL_CURSOR_DONE;
+    if (found > 0) {
+        cursor->roomNumber = roomNumbers[found - 1];
+    }
+    finishOperation(METRIC_VIEW, started, HOTEL_OK);
+    return found;
+}
+
+// Function to fetch the next page of a report from the rooms as they stand now (see listReportRooms)
+int reportRooms(struct Hotel* hotel, const struct HotelReportQuery* query, struct HotelCursor* cursor, int* roomNumbers, int maxRooms) {
+    return listReportRooms(hotel, NULL, query, cursor, roomNumbers, maxRooms);
+}
+
+// Function to fetch the next page of a report from the rooms as a view has them: every page of a cursor read
+// through the same view lists the rooms as they stood when it was opened, whatever is booked meanwhile
+int viewReportRooms(struct HotelView* view, const struct HotelReportQuery* query, struct HotelCursor* cursor, int* roomNumbers, int maxRooms) {
+    return listReportRooms(view->hotel, view, query, cursor, roomNumbers, maxRooms);
+}
+
+// Function to book a room for duration nights from checkIn without printing anything (safe to call from any thread)
+int reserveRoom(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn, int duration, int extraServices, int occupancy) {
+    uint64_t started = startOperation();
+    time_t now = time(NULL);
+    pthread_mutex_t* lock = roomLock(hotel, roomNumber);
+    pthread_mutex_lock(lock); // Only bookings for rooms sharing this lock wait for each other
+    int status = reserveRoomAt(hotel, roomNumber, guestName, checkIn, duration, extraServices, occupancy, now);
+    if (status == HOTEL_OK) { // Logged under the lock, so the journal has each room's changes in the order they happened
+        logChange(hotel, JOURNAL_RESERVE, roomNumber, guestName, checkIn, duration, extraServices, occupancy, now);
+    }
+    pthread_mutex_unlock(lock);
+    finishOperation(METRIC_RESERVE, started, status);
+    return status;
+}
+
+// Function to remove a guest's booking starting on checkIn without printing anything (safe to call from any thread)
+int releaseRoom(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn) {
+    uint64_t started = startOperation();
+    time_t now = time(NULL);
+    pthread_mutex_t* lock = roomLock(hotel, roomNumber);
+    pthread_mutex_lock(lock);
+    int status = releaseRoomAt(hotel, roomNumber, guestName, checkIn, now);
+    if (status == HOTEL_OK) {
+        logChange(hotel, JOURNAL_CANCEL, roomNumber, guestName, checkIn, 0, 0, 0, now);
+    }
+    pthread_mutex_unlock(lock);
+    finishOperation(METRIC_CANCEL, started, status);
+    return status;
+}
+
+// Function to open a point-in-time view of the bookings: whatever is booked or cancelled afterwards, the view
+// reads every room as it stands now, without holding up bookings while it does (returns NULL if VIEW_MAX_OPEN
+// views are open; close it with closeView, as bookings keep copies of the rooms they change until then)
+struct HotelView* openView(struct Hotel* hotel) {
+    struct ReadViews* views = &hotel->views;
+    for (int i = 0; i < VIEW_MAX_OPEN; ++i) {
+        int unused = 0;
+        if (__atomic_compare_exchange_n(&views->views[i].inUse, &unused, 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+            struct HotelView* view = &views->views[i];
+            __atomic_fetch_add(&views->open, 1, __ATOMIC_SEQ_CST); // Seen by every booking that sees the new clock
+            __atomic_store_n(&view->stamp, __atomic_load_n(&views->clock, __ATOMIC_SEQ_CST) + 1, __ATOMIC_SEQ_CST); // For oldestView meanwhile
+            __atomic_store_n(&view->stamp, __atomic_add_fetch(&views->clock, 1, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+            return view;
+        }
+    }
+    return NULL;
+}
+
+// Function to free the room versions no open view needs, once the last view is closed
+static void sweepVersions(struct Hotel* hotel) {
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    for (int slot = 0; slot < hotel->roomCount && __atomic_load_n(&hotel->views.kept, __ATOMIC_RELAXED) > 0; ++slot) {
+        if (__atomic_load_n(&hotel->versions[slot].older, __ATOMIC_RELAXED) != NULL) { // Checked again under the lock
+            pthread_mutex_t* lock = roomLock(hotel, hotel->rooms[slot].roomNumber);
+            pthread_mutex_lock(lock);
+            pruneVersions(hotel, slot);
+            pthread_mutex_unlock(lock);
+        }
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+}
+
+// Function to close a view (the room versions kept for it are freed by the next booking of each room, or
+// straight away if no other view is open)
+void closeView(struct HotelView* view) {
+    struct Hotel* hotel = view->hotel;
+    __atomic_store_n(&view->stamp, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&view->inUse, 0, __ATOMIC_SEQ_CST);
+    if (__atomic_sub_fetch(&hotel->views.open, 1, __ATOMIC_SEQ_CST) == 0 && __atomic_load_n(&hotel->views.kept, __ATOMIC_RELAXED) > 0) {
+        sweepVersions(hotel);
+    }
+}
+
+// Function to copy a room as a view reads it (returns 0 if there was no such room when the view was opened)
+int viewRoom(struct HotelView* view, int roomNumber, struct RoomCopy* copy) {
+    struct Hotel* hotel = view->hotel;
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    int slot = findRoom(hotel, roomNumber), found = 0;
+    if (slot >= 0) {
+        const struct Stay* stays;
+        const struct Booking* bookings;
+        pthread_mutex_t* lock = roomLock(hotel, roomNumber);
+        pthread_mutex_lock(lock); // Held only while the calendar is copied
+        found = findViewState(hotel, slot, view->stamp, &copy->bookingCount, &stays, &bookings, &copy->cancellationTime);
+        if (found && copy->bookingCount > copy->bookingCapacity) {
+            copy->bookingCapacity = copy->bookingCount * 2;
+            copy->stays = (struct Stay*)realloc(copy->stays, copy->bookingCapacity * sizeof(struct Stay));
+            copy->bookings = (struct Booking*)realloc(copy->bookings, copy->bookingCapacity * sizeof(struct Booking));
+        }
+        if (found && copy->bookingCount > 0) {
+            memcpy(copy->stays, stays, copy->bookingCount * sizeof(struct Stay));
+            memcpy(copy->bookings, bookings, copy->bookingCount * sizeof(struct Booking));
+        }
+        pthread_mutex_unlock(lock);
+        copy->roomNumber = roomNumber;
+        copy->capacity = hotel->rooms[slot].capacity;
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return found;
+}
+
+// Function to free the arrays of a room copy
+void freeRoomCopy(struct RoomCopy* copy) {
+    free(copy->stays);
+    free(copy->bookings);
+    copy->stays = NULL;
+    copy->bookings = NULL;
+    copy->bookingCapacity = 0;
+}
+
+// Function to pack a group's parties into rooms of capacity people, the largest party first, each into the first
+// room with space left for it (first-fit decreasing: never more than 11/9 of the fewest rooms possible, plus
+// one); roomOf[p] receives the room of party p and loads[r] the people in room r (returns the number of rooms)
+static int packParties(const int* parties, int partyCount, int capacity, int* roomOf, int* loads) {
+    uint64_t* keys = (uint64_t*)malloc(partyCount * sizeof(uint64_t));
+    for (int p = 0; p < partyCount; ++p) { // By the space a party leaves in a room, so the largest comes first
+        keys[p] = (uint64_t)(capacity - parties[p]) << 32 | (uint32_t)p;
+    }
+    qsort(keys, partyCount, sizeof(uint64_t), compareOrderKeys);
+    int rooms = 0;
+    for (int k = 0; k < partyCount; ++k) {
+        int p = (int)(uint32_t)keys[k], r = 0;
+        while (r < rooms && loads[r] + parties[p] > capacity) {
+            r++;
+        }
+        if (r == rooms) {
+            loads[rooms++] = 0;
+        }
+        loads[r] += parties[p];
+        roomOf[p] = r;
+    }
+    free(keys);
+    return rooms;
+}
+
+// Function to list the table slots of the rooms free for every night of [checkIn, checkOut), by room number
+// (the caller holds the table lock, taken by lockSortedTable; freeBits has a bit for every slot, rounded up to
+// whole words; returns how many were stored in slots). Inside the horizon the bitmap kernels find them without
+// any room lock, so a room booked meanwhile may still be listed
+static int findFreeRoomsInOrder(struct Hotel* hotel, int checkIn, int checkOut, uint64_t* freeBits, int* slots) {
+    uint64_t masks[NIGHT_WORDS];
+    int firstWord, lastWord, found = 0;
+    if (!buildNightMasks(hotel, checkIn, checkOut, masks, &firstWord, &lastWord)) {
+        memset(freeBits, 0, (hotel->roomCount + 63) / 64 * sizeof(uint64_t));
+        for (int i = 0; i < hotel->roomCount; ++i) { // Outside the horizon: ask each calendar
+            pthread_mutex_t* lock = roomLock(hotel, hotel->rooms[i].roomNumber);
+            pthread_mutex_lock(lock);
+            freeBits[i / 64] |= (uint64_t)isRoomFree(&hotel->rooms[i], checkIn, checkOut) << (i % 64);
+            pthread_mutex_unlock(lock);
+        }
+    } else {
+        for (int start = 0; start < hotel->roomCount; start += SCAN_CHUNK_ROOMS) {
+            int count = hotel->roomCount - start < SCAN_CHUNK_ROOMS ? hotel->roomCount - start : SCAN_CHUNK_ROOMS;
+            nightKernels()->freeRooms(hotel->nights + start, hotel->roomCapacity, masks, firstWord, lastWord, count,
+                                      freeBits + start / 64);
+        }
+    }
+    for (int position = 0; position < hotel->roomCount; ++position) {
+        int slot = hotel->order.slots[position];
+        if (freeBits[slot / 64] >> (slot % 64) & 1) {
+            slots[found++] = slot;
+        }
+    }
+    return found;
+}
+
+// Function to pick count rooms that follow each other among candidates, slots listed by room number: the run
+// crossing the fewest floors, then spanning the fewest room numbers, then the lowest (returns its first position)
+static int pickGroupRooms(const struct Hotel* hotel, const int* slots, int candidates, int count) {
+    int* changes = (int*)malloc(candidates * sizeof(int)); // changes[i]: floor changes among candidates 0 to i
+    changes[0] = 0;
+    for (int i = 1; i < candidates; ++i) {
+        changes[i] = changes[i - 1] + (hotel->details[slots[i]].floor != hotel->details[slots[i - 1]].floor);
+    }
+    int best = 0;
+    int64_t bestCost = INT64_MAX;
+    for (int i = 0; i + count <= candidates && bestCost > count - 1; ++i) { // count - 1: side by side on one floor
+        int64_t span = (int64_t)hotel->rooms[slots[i + count - 1]].roomNumber - hotel->rooms[slots[i]].roomNumber;
+        int64_t cost = ((int64_t)(changes[i + count - 1] - changes[i]) << 33) + span;
+        if (cost < bestCost) {
+            bestCost = cost;
+            best = i;
+        }
+    }
+    free(changes);
+    return best;
+}
+
+// Function to take (lock = 1) or release (lock = 0) the room locks of some rooms, in the order lockAllRooms uses
+static void lockGroupRooms(struct Hotel* hotel, const int* roomNumbers, int count, int lock) {
+    char taken[ROOM_LOCK_STRIPES];
+    memset(taken, 0, sizeof(taken));
+    for (int r = 0; r < count; ++r) {
+        taken[hashRoomNumber(roomNumbers[r]) & (ROOM_LOCK_STRIPES - 1)] = 1;
+    }
+    for (int i = 0; i < ROOM_LOCK_STRIPES; ++i) {
+        if (taken[i] && lock) {
+            pthread_mutex_lock(&hotel->roomLocks[i].mutex);
+        } else if (taken[i]) {
+            pthread_mutex_unlock(&hotel->roomLocks[i].mutex);
+        }
+    }
+}
+
+// Function to book rooms for a whole group, all of them or none (safe to call from any thread): the parties are
+// packed into as few rooms as first-fit decreasing finds, and the rooms are the free ones next to each other by
+// room number that cross the fewest floors. Every room is booked under the group's name for the same nights,
+// holding the parties packed into it; partyRooms (NULL if not wanted) receives the room of each party.
+// Returns HOTEL_ROOM_UNAVAILABLE if too few rooms are free, HOTEL_OVER_CAPACITY if a party fits in no free
+// room, and HOTEL_INVALID_STAY for no parties, a party of no one, or a stay isValidStay turns down
+int reserveGroup(struct Hotel* hotel, const struct HotelGroup* group, int* partyRooms) {
+    uint64_t started = startOperation();
+    int status = isValidStay(group->checkIn, group->nights) && group->partyCount > 0 ? HOTEL_OK : HOTEL_INVALID_STAY, largestParty = 0;
+    for (int p = 0; p < group->partyCount && status == HOTEL_OK; ++p) {
+        status = group->parties[p] > 0 ? HOTEL_OK : HOTEL_INVALID_STAY;
+        largestParty = group->parties[p] > largestParty ? group->parties[p] : largestParty;
+    }
+    if (status == HOTEL_OK && strlen(group->guestName) >= MAX_NAME_LENGTH) {
+        status = HOTEL_INVALID_NAME;
+    }
+    if (status != HOTEL_OK) {
+        finishOperation(METRIC_RESERVE_GROUP, started, status);
+        return status;
+    }
+
+    time_t now = time(NULL);
+    int checkIn = group->checkIn, checkOut = group->checkIn + group->nights;
+    lockSortedTable(hotel); // Kept until the end, so slots stay put
+    uint64_t* freeBits = (uint64_t*)malloc(((hotel->roomCount + 63) / 64 + 1) * sizeof(uint64_t));
+    int* slots = (int*)malloc((hotel->roomCount + 1) * sizeof(int));
+    int* roomOf = (int*)malloc(group->partyCount * sizeof(int));
+    int* loads = (int*)malloc(group->partyCount * sizeof(int));
+    int* roomNumbers = (int*)malloc(group->partyCount * sizeof(int));
+    status = HOTEL_ROOM_UNAVAILABLE;
+    for (int attempt = 0; attempt < GROUP_RETRIES && status == HOTEL_ROOM_UNAVAILABLE; ++attempt) {
+        int candidates = findFreeRoomsInOrder(hotel, checkIn, checkOut, freeBits, slots), capacity = 0;
+        for (int c = 0; c < candidates; ++c) {
+            capacity = hotel->rooms[slots[c]].capacity > capacity ? hotel->rooms[slots[c]].capacity : capacity;
+        }
+        if (candidates > 0 && largestParty > capacity) {
+            status = HOTEL_OVER_CAPACITY;
+            break;
+        }
+        int rooms = packParties(group->parties, group->partyCount, capacity, roomOf, loads), fullest = 0, kept = 0;
+        for (int r = 0; r < rooms; ++r) {
+            fullest = loads[r] > fullest ? loads[r] : fullest;
+        }
+        for (int c = 0; c < candidates; ++c) { // Rooms too small for the fullest room of the packing are left out
+            if (hotel->rooms[slots[c]].capacity >= fullest) {
+                slots[kept++] = slots[c];
+            }
+        }
+        if (candidates == 0 || kept < rooms) {
+            break;
+        }
+        int first = pickGroupRooms(hotel, slots, kept, rooms), stillFree = 1;
+        for (int r = 0; r < rooms; ++r) {
+            roomNumbers[r] = hotel->rooms[slots[first + r]].roomNumber;
+        }
+        lockGroupRooms(hotel, roomNumbers, rooms, 1);
+        for (int r = 0; r < rooms && stillFree; ++r) { // The bitmaps were read without these locks
+            stillFree = isRoomFree(&hotel->rooms[slots[first + r]], checkIn, checkOut);
+        }
+        if (stillFree) {
+            for (int r = 0; r < rooms; ++r) {
+                reserveRoomAt(hotel, roomNumbers[r], group->guestName, checkIn, group->nights, group->extraServices != 0, loads[r], now);
+            }
+            logGroup(hotel, roomNumbers, loads, rooms, group->guestName, checkIn, group->nights, group->extraServices != 0, now);
+            for (int p = 0; p < group->partyCount && partyRooms != NULL; ++p) {
+                partyRooms[p] = roomNumbers[roomOf[p]];
+            }
+            status = HOTEL_OK;
+        }
+        lockGroupRooms(hotel, roomNumbers, rooms, 0);
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    free(freeBits);
+    free(slots);
+    free(roomOf);
+    free(loads);
+    free(roomNumbers);
+    finishOperation(METRIC_RESERVE_GROUP, started, status);
+    return status;
+}
+
+// Function to move the nights the bitmaps and night totals track forward to start from a later day: each
+// bitmap row and the totals of the nights still tracked move down, and the nights coming into the horizon are
+// filled in from the calendars (nothing else may be using the hotel: it is loading, or checkpointing with every
+// lock held). Without it the horizon would stay where the hotel opened, and a year on every query would miss it
+static void slideCalendar(struct Hotel* hotel, int start) {
+    int shift = start - hotel->calendarStart;
+    if (shift <= 0) {
+        return;
+    }
+    int kept = shift < NIGHT_HORIZON ? NIGHT_HORIZON - shift : 0; // Nights tracked before and after
+    int wordShift = shift / 64, bitShift = shift % 64;
+    for (int slot = 0; slot < hotel->roomCount; ++slot) { // Bits past the horizon are never set, so none come in
+        uint64_t row[NIGHT_WORDS];
+        for (int w = 0; w < NIGHT_WORDS; ++w) {
+            row[w] = hotel->nights[w * hotel->roomCapacity + slot];
+        }
+        for (int w = 0; w < NIGHT_WORDS; ++w) {
+            uint64_t low = w + wordShift < NIGHT_WORDS ? row[w + wordShift] >> bitShift : 0;
+            uint64_t high = bitShift > 0 && w + wordShift + 1 < NIGHT_WORDS ? row[w + wordShift + 1] << (64 - bitShift) : 0;
+            hotel->nights[w * hotel->roomCapacity + slot] = low | high;
+        }
+    }
+    memmove(hotel->nightTotals, hotel->nightTotals + (NIGHT_HORIZON - kept), kept * sizeof(struct HotelNightTotals));
+    memset(hotel->nightTotals + kept, 0, (NIGHT_HORIZON - kept) * sizeof(struct HotelNightTotals));
+    hotel->calendarStart = start;
+
+    int first = start + kept; // First night new to the horizon
+    for (int slot = 0; slot < hotel->roomCount; ++slot) {
+        const struct Room* room = &hotel->rooms[slot];
+        for (int b = findStay(room, first); b < room->bookingCount && room->stays[b].checkIn < start + NIGHT_HORIZON; ++b) {
+            int checkIn = room->stays[b].checkIn, checkOut = room->stays[b].checkOut;
+            int from = checkIn > first ? checkIn : first, to = checkOut < start + NIGHT_HORIZON ? checkOut : start + NIGHT_HORIZON;
+            markNights(hotel, slot, from, to, 1);
+            for (int night = from - start; night < to - start; ++night) {
+                hotel->nightTotals[night].bookedRooms++;
+                hotel->nightTotals[night].guests += hotel->details[slot].bookings[b].occupancy;
+            }
+            hotel->nightTotals[from - start].arrivals += checkIn >= first;
+        }
+    }
+}
+
+// Function to rebuild every running total from the calendars (nothing else may be using the hotel; for a
+// loaded snapshot, and after the rate plan changes what the bookings come to)
+static void recountTotals(struct Hotel* hotel) {
+    memset(hotel->stripeTotals, 0, sizeof(hotel->stripeTotals));
+    memset(hotel->nightTotals, 0, sizeof(hotel->nightTotals));
+    free(hotel->floorIndex.slots);
+    hotel->floorIndex.slots = NULL;
+    hotel->floorIndex.capacity = 0;
+    hotel->floorIndex.count = 0;
+    indexGrow(&hotel->floorIndex, 0);
+    hotel->floorCount = 0;
+    for (int slot = 0; slot < hotel->roomCount; ++slot) {
+        const struct Room* room = &hotel->rooms[slot];
+        const struct RoomDetails* details = &hotel->details[slot];
+        int position = findFloor(hotel, details->floor, 1);
+        hotel->floors[position].totals.rooms++;
+        for (int b = 0; b < room->bookingCount; ++b) {
+            countStay(hotel, slot, room->stays[b].checkIn, room->stays[b].checkOut, details->bookings[b].occupancy,
+                      details->bookings[b].extraServices, 1);
+        }
+        if (room->bookingCount > 0) {
+            countReserved(hotel, slot, 1);
+        }
+    }
+}
+
+// Function to load a rate file into the hotel's rate plan and reprice the running totals by it
+// (returns what loadRatePlan returns)
+int loadHotelRates(struct Hotel* hotel, const char* path) {
+    pthread_rwlock_wrlock(&hotel->tableLock);
+    lockAllRooms(hotel, 1);
+    int loaded = loadRatePlan(&hotel->rates, path);
+    recountTotals(hotel);
+    lockAllRooms(hotel, 0);
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return loaded;
+}
+
+// Function to add one booking to totals counted by a scan
+static void scanStay(struct HotelTotals* totals, int nights, int occupancy, int64_t revenue) {
+    totals->bookings++;
+    totals->guests += occupancy;
+    totals->roomNights += nights;
+    totals->revenue += revenue;
+}
+
+// Function to compare two totals (returns 1 if they are the same)
+static int sameTotals(const struct HotelTotals* a, const struct HotelTotals* b) {
+    return a->rooms == b->rooms && a->reservedRooms == b->reservedRooms && a->bookings == b->bookings
+           && a->guests == b->guests && a->roomNights == b->roomNights && a->revenue == b->revenue;
+}
+
+// Function to check the running totals and the night bitmaps against a scan of every calendar (returns 1 if the
+// hotel, every floor, every night and every room's bitmap row agree; stops all bookings while it scans, so it
+// is for tests and audits, not dashboards)
+int checkTotals(struct Hotel* hotel) {
+    pthread_rwlock_wrlock(&hotel->tableLock);
+    lockAllRooms(hotel, 1);
+    struct HotelTotals hotelScan, kept;
+    struct HotelTotals* floorScan = (struct HotelTotals*)calloc(hotel->floorCount + 1, sizeof(struct HotelTotals));
+    struct HotelNightTotals* nightScan = (struct HotelNightTotals*)calloc(NIGHT_HORIZON, sizeof(struct HotelNightTotals));
+    memset(&hotelScan, 0, sizeof(hotelScan));
+    int ok = 1;
+    for (int slot = 0; slot < hotel->roomCount && ok; ++slot) {
+        const struct Room* room = &hotel->rooms[slot];
+        const struct RoomDetails* details = &hotel->details[slot];
+        int position = findFloor(hotel, details->floor, 0);
+        ok = position >= 0 && hotel->floors[position].floor == details->floor;
+        struct HotelTotals* floor = &floorScan[ok ? position : 0];
+        hotelScan.rooms++;
+        floor->rooms++;
+        hotelScan.reservedRooms += room->bookingCount > 0;
+        floor->reservedRooms += room->bookingCount > 0;
+        uint64_t row[NIGHT_WORDS] = {0};
+        for (int b = 0; b < room->bookingCount; ++b) {
+            int checkIn = room->stays[b].checkIn, checkOut = room->stays[b].checkOut;
+            int occupancy = details->bookings[b].occupancy;
+            int64_t revenue = quoteStay(&hotel->rates, room->roomNumber, checkIn, checkOut - checkIn, occupancy,
+                                        details->bookings[b].extraServices, NULL);
+            scanStay(&hotelScan, checkOut - checkIn, occupancy, revenue);
+            scanStay(floor, checkOut - checkIn, occupancy, revenue);
+            for (int n = 0; n < NIGHT_HORIZON; ++n) { // Night by night, not from the bitmaps the totals mirror
+                int day = hotel->calendarStart + n;
+                nightScan[n].bookedRooms += day >= checkIn && day < checkOut;
+                nightScan[n].guests += day >= checkIn && day < checkOut ? occupancy : 0;
+                nightScan[n].arrivals += day == checkIn;
+                row[n / 64] |= (uint64_t)(day >= checkIn && day < checkOut) << (n % 64);
+            }
+        }
+        for (int w = 0; w < NIGHT_WORDS && ok; ++w) {
+            ok = row[w] == hotel->nights[w * hotel->roomCapacity + slot];
+        }
+    }
+    memset(&kept, 0, sizeof(kept));
+    kept.rooms = hotel->roomCount;
+    for (int i = 0; i < ROOM_LOCK_STRIPES; ++i) {
+        kept.reservedRooms += (int)hotel->stripeTotals[i].sums.reservedRooms;
+        kept.bookings += hotel->stripeTotals[i].sums.bookings;
+        kept.guests += hotel->stripeTotals[i].sums.guests;
+        kept.roomNights += hotel->stripeTotals[i].sums.roomNights;
+        kept.revenue += hotel->stripeTotals[i].sums.revenue;
+    }
+    ok = ok && sameTotals(&hotelScan, &kept);
+    for (int f = 0; f < hotel->floorCount && ok; ++f) {
+        ok = sameTotals(&floorScan[f], &hotel->floors[f].totals) && findFloor(hotel, hotel->floors[f].floor, 0) == f;
+    }
+    for (int n = 0; n < NIGHT_HORIZON && ok; ++n) {
+        ok = memcmp(&nightScan[n], &hotel->nightTotals[n], sizeof(struct HotelNightTotals)) == 0;
+    }
+    free(floorScan);
+    free(nightScan);
+    lockAllRooms(hotel, 0);
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return ok;
+}
+
+// Function to map a whole file read-only with private copy-on-write pages (NULL if it cannot be read)
+static void* mapSnapshot(const char* path, size_t* size) {
+#ifdef _WIN32
+    FILE* file = fopen(path, "rb"); // No mmap: read the file into one block instead
+    if (file == NULL) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void* data = length > 0 ? malloc(length) : NULL;
+    if (data != NULL && fread(data, 1, length, file) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *size = (size_t)length;
+    return data;
+#else
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor < 0) {
+        return NULL;
+    }
+    struct stat status;
+    void* data = NULL;
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+        data = mmap(NULL, (size_t)status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+        data = data == MAP_FAILED ? NULL : data;
+        *size = (size_t)status.st_size;
+    }
+    close(descriptor); // The mapping stays valid after the descriptor is closed
+    return data;
+#endif
+}
+
+// Function to release a mapping made by mapSnapshot
+static void unmapSnapshot(void* data, size_t size) {
+    if (data == NULL) {
+        return;
+    }
+#ifdef _WIN32
+    (void)size;
+    free(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+// Function to free everything the booking history holds and close its file
+static void freeHistory(struct BookingHistory* history) {
+    if (history->sealerStarted) { // Let it pack what it was handed, then end it
+        pthread_mutex_lock(&history->lock);
+        history->stopSealer = 1;
+        pthread_cond_signal(&history->handedOff);
+        pthread_mutex_unlock(&history->lock);
+        pthread_join(history->sealer, NULL);
+    }
+    for (int b = history->loadedBlocks; b < history->blockCount; ++b) { // Loaded blocks are still inside the mapping
+        free(history->blocks[b].data);
+    }
+    free(history->blocks);
+    for (int c = 0; c < HISTORY_COLUMNS; ++c) {
+        free(history->tail[c]);
+    }
+    free(history->rooms);
+    free(history->roomCodes.slots);
+    freeNamePool(&history->names);
+    free(history->guests);
+    free(history->guestSlots);
+    if (history->file >= 0) {
+        close(history->file);
+    }
+    unmapSnapshot(history->mapping, history->mappingSize);
+    pthread_cond_destroy(&history->handedOff);
+    pthread_cond_destroy(&history->sealed);
+    pthread_mutex_destroy(&history->lock);
+}
+
+// Function to free the whole room table and index at once
+void freeHotel(struct Hotel* hotel) {
+    for (int i = 0; i < hotel->roomCount; ++i) { // Calendars are the only per-room allocations
+        if (hotel->details[i].bookingCapacity > 0) { // Calendars still inside the snapshot are not ours to free
+            free(hotel->rooms[i].stays);
+            free(hotel->details[i].bookings);
+        }
+        for (struct RoomVersion* version = hotel->versions[i].older; version != NULL;) { // Kept for views never closed
+            struct RoomVersion* older = version->older;
+            free(version);
+            version = older;
+        }
+    }
+    free(hotel->rooms); // One block for all hot fields
+    free(hotel->details); // One block for all cold fields
+    free(hotel->index.slots); // Release the index together with the rooms
+    free(hotel->nights);
+    free(hotel->order.slots);
+    free(hotel->order.positions);
+    free(hotel->order.reserved);
+    free(hotel->order.summary);
+    memset(&hotel->order, 0, sizeof(hotel->order));
+    free(hotel->floors);
+    free(hotel->floorIndex.slots);
+    hotel->floors = NULL;
+    hotel->floorCount = 0;
+    hotel->floorCapacity = 0;
+    hotel->floorIndex.slots = NULL;
+    hotel->floorIndex.capacity = 0;
+    hotel->floorIndex.count = 0;
+    hotel->rooms = NULL;
+    hotel->nights = NULL;
+    hotel->details = NULL;
+    free(hotel->versions);
+    hotel->versions = NULL;
+    hotel->views.kept = 0;
+    hotel->roomCount = 0;
+    hotel->roomCapacity = 0;
+    hotel->index.slots = NULL;
+    hotel->index.capacity = 0;
+    hotel->index.count = 0;
+    unmapSnapshot(hotel->snapshot, hotel->snapshotSize); // Loaded calendars are gone now
+    hotel->snapshot = NULL;
+    hotel->snapshotSize = 0;
+    pthread_rwlock_destroy(&hotel->tableLock);
+    for (int i = 0; i < ROOM_LOCK_STRIPES; ++i) {
+        pthread_mutex_destroy(&hotel->roomLocks[i].mutex);
+    }
+    freeGuestIndex(&hotel->guests);
+    freeHistory(&hotel->history);
+    freeRatePlan(&hotel->rates);
+}
+
+// Function to round a snapshot offset up to the next section boundary
+static uint64_t alignSection(uint64_t offset) {
+    return (offset + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+// Function to write a block at the given offset of a snapshot, padding the gap before it with zeros
+static int writeSection(FILE* file, uint64_t* position, uint64_t offset, const void* data, size_t size) {
+    static const char padding[SNAPSHOT_ALIGNMENT] = {0};
+    if (fwrite(padding, 1, (size_t)(offset - *position), file) != offset - *position
+        || (size > 0 && fwrite(data, 1, size, file) != size)) {
+        return 0;
+    }
+    *position = offset + size;
+    return 1;
+}
+
+// Function to save the whole hotel to a snapshot file (returns 1 on success)
+// (the file is written next to the old one and renamed over it, so a crash never leaves half a snapshot;
+// the name pool is saved compacted to the names of guests holding bookings, so the names of guests
+// who cancelled do not pile up from one checkpoint to the next, and bookings are saved with new handles)
+int saveSnapshot(struct Hotel* hotel, const char* path) {
+    struct GuestIndex* guests = &hotel->guests;
+    struct NamePool names;
+    struct SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.roomSize = sizeof(struct Room);
+    header.detailsSize = sizeof(struct RoomDetails);
+    header.staySize = sizeof(struct Stay);
+    header.bookingSize = sizeof(struct Booking);
+    header.nightWords = NIGHT_WORDS;
+    header.roomCount = hotel->roomCount;
+    header.indexCapacity = hotel->index.capacity;
+    header.calendarStart = hotel->calendarStart;
+    header.journalSequence = hotel->journalSequence;
+    header.historySize = hotel->history.fileSize; // checkpointHotel appends the history first
+    int mostBookings = 0;
+    for (int i = 0; i < hotel->roomCount; ++i) {
+        header.bookingCount += hotel->rooms[i].bookingCount;
+        mostBookings = hotel->rooms[i].bookingCount > mostBookings ? hotel->rooms[i].bookingCount : mostBookings;
+    }
+    pthread_mutex_lock(&guests->lock); // Held until the bookings are written, so no guest is added meanwhile
+    initNamePool(&names);
+    uint32_t* handles = (uint32_t*)malloc((guests->guestCount + 1) * sizeof(uint32_t)); // Saved handle of each guest
+    for (int id = 0; id < guests->guestCount; ++id) {
+        const char* name = poolString(&guests->names, guests->guests[id].name);
+        handles[id] = guests->guests[id].stayCount > 0 ? poolAdd(&names, name, strlen(name)) : NAME_NONE;
+    }
+    header.nameChunkCount = names.chunkCount;
+    header.roomsOffset = alignSection(sizeof(header));
+    header.detailsOffset = alignSection(header.roomsOffset + (uint64_t)hotel->roomCount * sizeof(struct Room));
+    header.nightsOffset = alignSection(header.detailsOffset + (uint64_t)hotel->roomCount * sizeof(struct RoomDetails));
+    header.indexOffset = alignSection(header.nightsOffset + (uint64_t)NIGHT_WORDS * hotel->roomCount * sizeof(uint64_t));
+    header.staysOffset = alignSection(header.indexOffset + (uint64_t)hotel->index.capacity * sizeof(struct IndexSlot));
+    header.bookingsOffset = alignSection(header.staysOffset + (uint64_t)header.bookingCount * sizeof(struct Stay));
+    header.namesOffset = alignSection(header.bookingsOffset + (uint64_t)header.bookingCount * sizeof(struct Booking));
+    uint64_t* chunkTable = (uint64_t*)malloc(names.chunkCount * 2 * sizeof(uint64_t));
+    uint64_t end = header.namesOffset + (uint64_t)names.chunkCount * 2 * sizeof(uint64_t);
+    for (int c = 0; c < names.chunkCount; ++c) { // Only the used part of each chunk is saved
+        chunkTable[2 * c] = alignSection(end);
+        chunkTable[2 * c + 1] = names.sizes[c];
+        end = chunkTable[2 * c] + names.sizes[c];
+    }
+    header.fileSize = end;
+
+    char temporaryPath[1024];
+    snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", path);
+    FILE* file = fopen(temporaryPath, "wb");
+    struct Booking* scratch = (struct Booking*)malloc((mostBookings + 1) * sizeof(struct Booking));
+    int ok = file != NULL;
+    uint64_t position = 0;
+    ok = ok && writeSection(file, &position, 0, &header, sizeof(header))
+        && writeSection(file, &position, header.roomsOffset, hotel->rooms, hotel->roomCount * sizeof(struct Room))
+        && writeSection(file, &position, header.detailsOffset, hotel->details, hotel->roomCount * sizeof(struct RoomDetails));
+    for (int w = 0; ok && w < NIGHT_WORDS; ++w) { // Rows are packed to roomCount, without the spare capacity
+        ok = writeSection(file, &position, w == 0 ? header.nightsOffset : position,
+                          &hotel->nights[w * hotel->roomCapacity], hotel->roomCount * sizeof(uint64_t));
+    }
+    ok = ok && writeSection(file, &position, header.indexOffset, hotel->index.slots, hotel->index.capacity * sizeof(struct IndexSlot));
+    for (int i = 0; ok && i < hotel->roomCount; ++i) {
+        ok = writeSection(file, &position, i == 0 ? header.staysOffset : position,
+                          hotel->rooms[i].stays, hotel->rooms[i].bookingCount * sizeof(struct Stay));
+    }
+    for (int i = 0; ok && i < hotel->roomCount; ++i) {
+        int count = hotel->rooms[i].bookingCount;
+        for (int b = 0; b < count; ++b) { // Same bookings, with the handles of the compacted pool
+            scratch[b] = hotel->details[i].bookings[b];
+            int id = internGuest(guests, poolString(&guests->names, scratch[b].guestName), 0, NAME_NONE);
+            scratch[b].guestName = handles[id];
+        }
+        ok = writeSection(file, &position, i == 0 ? header.bookingsOffset : position, scratch, count * sizeof(struct Booking));
+    }
+    pthread_mutex_unlock(&guests->lock);
+    ok = ok && writeSection(file, &position, header.namesOffset, chunkTable, names.chunkCount * 2 * sizeof(uint64_t));
+    for (int c = 0; ok && c < names.chunkCount; ++c) {
+        ok = writeSection(file, &position, chunkTable[2 * c], names.chunks[c], names.sizes[c]);
+    }
+    free(handles);
+    free(scratch);
+    free(chunkTable);
+    freeNamePool(&names);
+    if (file == NULL) {
+        return 0;
+    }
+    ok = ok && writeSection(file, &position, header.fileSize, NULL, 0) && fflush(file) == 0;
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(file)) == 0; // Make the data durable before it replaces the old snapshot
+#else
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        remove(temporaryPath);
+        return 0;
+    }
+#ifdef _WIN32
+    remove(path); // rename() does not replace an existing file on Windows
+#endif
+    return rename(temporaryPath, path) == 0;
+}
+
+// Function to load a snapshot into an empty hotel (returns 1 if loaded, 0 if there is no
+// snapshot, -1 if the file is not a snapshot of this build's layout)
+// (sections are copied as whole blocks; calendars are used in place from the mapping)
+int loadSnapshot(struct Hotel* hotel, const char* path) {
+    size_t size = 0;
+    char* data = (char*)mapSnapshot(path, &size);
+    if (data == NULL) {
+        return 0;
+    }
+    const struct SnapshotHeader* header = (const struct SnapshotHeader*)data;
+    if (size < sizeof(*header) || memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+        || header->version != SNAPSHOT_VERSION || header->roomSize != sizeof(struct Room)
+        || header->detailsSize != sizeof(struct RoomDetails) || header->staySize != sizeof(struct Stay)
+        || header->bookingSize != sizeof(struct Booking) || header->nightWords != NIGHT_WORDS
+        || header->fileSize != size || header->roomCount < 0 || header->indexCapacity < INDEX_INITIAL_CAPACITY
+        || (header->indexCapacity & (header->indexCapacity - 1)) != 0 || header->nameChunkCount < 1
+        || header->nameChunkCount > NAME_MAX_CHUNKS || header->namesOffset + (uint64_t)header->nameChunkCount * 16 > size) {
+        unmapSnapshot(data, size);
+        return -1;
+    }
+    const uint64_t* chunkTable = (const uint64_t*)(data + header->namesOffset);
+    int valid = 1;
+    for (int c = 0; c < header->nameChunkCount; ++c) { // Every name must end inside its chunk
+        uint64_t offset = chunkTable[2 * c], length = chunkTable[2 * c + 1];
+        valid = valid && length > 0 && length <= (1u << NAME_CHUNK_BITS) && offset + length <= size && data[offset + length - 1] == '\0';
+    }
+    valid = valid && data[chunkTable[0]] == '\0'; // Handle 0, the empty name
+    const struct Booking* saved = (const struct Booking*)(data + header->bookingsOffset);
+    for (int64_t b = 0; valid && b < header->bookingCount; ++b) { // And every booking must point at one
+        uint32_t chunk = saved[b].guestName >> NAME_CHUNK_BITS;
+        valid = (int)chunk < header->nameChunkCount && (saved[b].guestName & ((1u << NAME_CHUNK_BITS) - 1)) < chunkTable[2 * chunk + 1];
+    }
+    if (!valid) {
+        unmapSnapshot(data, size);
+        return -1;
+    }
+
+    int roomCount = header->roomCount;
+    hotel->roomCount = roomCount;
+    hotel->roomCapacity = roomCount > TABLE_INITIAL_CAPACITY ? roomCount : TABLE_INITIAL_CAPACITY;
+    hotel->rooms = (struct Room*)malloc(hotel->roomCapacity * sizeof(struct Room));
+    hotel->details = (struct RoomDetails*)malloc(hotel->roomCapacity * sizeof(struct RoomDetails));
+    memcpy(hotel->rooms, data + header->roomsOffset, roomCount * sizeof(struct Room));
+    memcpy(hotel->details, data + header->detailsOffset, roomCount * sizeof(struct RoomDetails));
+    free(hotel->versions);
+    hotel->versions = (struct RoomVersions*)calloc(hotel->roomCapacity, sizeof(struct RoomVersions)); // Every room there from the start
+    hotel->nights = (uint64_t*)calloc((size_t)NIGHT_WORDS * hotel->roomCapacity, sizeof(uint64_t));
+    for (int w = 0; w < NIGHT_WORDS; ++w) {
+        memcpy(&hotel->nights[w * hotel->roomCapacity], data + header->nightsOffset + (uint64_t)w * roomCount * sizeof(uint64_t),
+               roomCount * sizeof(uint64_t));
+    }
+    growRoomOrder(&hotel->order, 0, hotel->roomCapacity); // Sorted by the first report
+    hotel->order.count = 0;
+    free(hotel->index.slots); // Replace the empty index with the saved one
+    hotel->index.capacity = header->indexCapacity;
+    hotel->index.count = roomCount;
+    hotel->index.slots = (struct IndexSlot*)malloc(hotel->index.capacity * sizeof(struct IndexSlot));
+    memcpy(hotel->index.slots, data + header->indexOffset, hotel->index.capacity * sizeof(struct IndexSlot));
+    hotel->calendarStart = header->calendarStart;
+    hotel->journalSequence = header->journalSequence; // Older journal records are already included
+    hotel->history.fileSize = header->historySize; // Where openHistory cuts the history file off
+    struct NamePool* names = &hotel->guests.names;
+    free(names->chunks[0]); // The empty pool's own chunk gives way to the saved ones, used in place
+    names->bytes = 0;
+    for (int c = 0; c < header->nameChunkCount; ++c) {
+        names->chunks[c] = data + chunkTable[2 * c];
+        names->sizes[c] = 1u << NAME_CHUNK_BITS; // Counted as full, so new names go to a chunk of their own
+        names->bytes += chunkTable[2 * c + 1];
+    }
+    names->chunkCount = header->nameChunkCount;
+    names->loadedChunks = header->nameChunkCount;
+
+    struct Stay* stays = (struct Stay*)(data + header->staysOffset);
+    struct Booking* bookings = (struct Booking*)(data + header->bookingsOffset);
+    for (int i = 0; i < roomCount; ++i) { // Point each calendar at its slice of the mapping
+        int count = hotel->rooms[i].bookingCount;
+        hotel->rooms[i].stays = count > 0 ? stays : NULL;
+        hotel->details[i].bookings = count > 0 ? bookings : NULL;
+        hotel->details[i].bookingCapacity = 0; // Copied out on the first new booking
+        for (int b = 0; b < count; ++b) { // The guest index is not saved; rebuild it from the calendars
+            guestIndexAdd(&hotel->guests, poolString(names, bookings[b].guestName), bookings[b].guestName,
+                          hotel->rooms[i].roomNumber, stays[b].checkIn);
+        }
+        stays += count;
+        bookings += count;
+    }
+    hotel->snapshot = data;
+    hotel->snapshotSize = size;
+    slideCalendar(hotel, today()); // The bitmaps may have been saved days or years ago
+    recountTotals(hotel); // The totals are not saved either
+    return 1;
+}
+
+// Function to hash a journal record for its checksum (FNV-1a over everything after the checksum, then the name)
+static uint32_t checksumRecord(const struct JournalRecord* record, const char* guestName) {
+    const unsigned char* bytes = (const unsigned char*)record + sizeof(record->checksum);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(*record) - sizeof(record->checksum); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    for (uint32_t i = 0; i < record->nameLength; ++i) {
+        hash = (hash ^ (unsigned char)guestName[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Function to get the bytes a guest name takes after its journal record (zero-padded to a multiple of 8)
+static size_t journalNameSize(uint32_t nameLength) {
+    return (nameLength + 7u) & ~(size_t)7;
+}
+
+// Function to write a whole buffer to a file (returns 1 on success)
+static int writeAll(int descriptor, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(descriptor, data, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return 0;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return 1;
+}
+
+// Function to write a whole buffer to a file and make it durable
+static int writeDurably(int descriptor, const char* data, size_t size) {
+    if (!writeAll(descriptor, data, size)) {
+        return 0;
+    }
+#if defined(_WIN32)
+    return _commit(descriptor) == 0;
+#elif defined(__linux__)
+    return fdatasync(descriptor) == 0; // File size changes are synced too; other metadata is not needed
+#else
+    return fsync(descriptor) == 0;
+#endif
+}
+
+// Function to open the journal for appending (returns 1 on success)
+// (records get sequence numbers from nextSequence on; maxLatencyMicros bounds the group commit delay)
+int openJournal(struct Journal* journal, const char* path, uint64_t nextSequence, long maxLatencyMicros) {
+    memset(journal, 0, sizeof(*journal));
+    journal->descriptor = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (journal->descriptor < 0) {
+        return 0;
+    }
+    if (lseek(journal->descriptor, 0, SEEK_END) == 0) { // New journal: start with the header
+        struct JournalHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+        header.version = JOURNAL_VERSION;
+        header.recordSize = sizeof(struct JournalRecord);
+        if (!writeDurably(journal->descriptor, (const char*)&header, sizeof(header))) {
+            close(journal->descriptor);
+            return 0;
+        }
+    }
+    pthread_mutex_init(&journal->lock, NULL);
+    pthread_cond_init(&journal->flushed, NULL);
+    pthread_cond_init(&journal->joined, NULL);
+    journal->pendingCapacity = JOURNAL_BUFFER_SIZE;
+    journal->pending = (char*)malloc(journal->pendingCapacity);
+    journal->writingCapacity = JOURNAL_BUFFER_SIZE;
+    journal->writing = (char*)malloc(journal->writingCapacity);
+    journal->nextSequence = nextSequence;
+    journal->durableSequence = nextSequence - 1;
+    journal->lastGroupSize = 1;
+    journal->maxLatencyMicros = maxLatencyMicros;
+    return 1;
+}
+
+// Function to append count records and their guest names (NULL entries, or guestNames NULL, for none) to the
+// journal's buffer with consecutive sequence numbers and nothing in between (returns the last one; the records
+// are not durable until a later journalSync returns)
+uint64_t journalAppendRecords(struct Journal* journal, struct JournalRecord* records, const char* const* guestNames, int count) {
+    pthread_mutex_lock(&journal->lock);
+    for (int i = 0; i < count; ++i) {
+        struct JournalRecord* record = &records[i];
+        const char* guestName = guestNames != NULL ? guestNames[i] : NULL;
+        record->nameLength = guestName != NULL ? (uint32_t)strlen(guestName) : 0;
+        size_t nameSize = journalNameSize(record->nameLength);
+        record->sequence = journal->nextSequence++;
+        record->checksum = checksumRecord(record, guestName);
+        while (journal->pendingSize + sizeof(*record) + nameSize > journal->pendingCapacity) {
+            journal->pendingCapacity *= 2;
+            journal->pending = (char*)realloc(journal->pending, journal->pendingCapacity);
+        }
+        memcpy(journal->pending + journal->pendingSize, record, sizeof(*record));
+        journal->pendingSize += sizeof(*record);
+        if (nameSize > 0) {
+            memset(journal->pending + journal->pendingSize + nameSize - 8, 0, 8); // Padding after the name
+            memcpy(journal->pending + journal->pendingSize, guestName, record->nameLength);
+            journal->pendingSize += nameSize;
+        }
+    }
+    uint64_t sequence = journal->nextSequence - 1;
+    pthread_mutex_unlock(&journal->lock);
+    return sequence;
+}
+
+// Function to append a record and its guest name (NULL if it has none) to the journal's buffer
+// (returns its sequence number; the record is not durable until a later journalSync returns)
+uint64_t journalAppend(struct Journal* journal, struct JournalRecord* record, const char* guestName) {
+    return journalAppendRecords(journal, record, &guestName, 1);
+}
+
+// Function to wait until every record appended before this call is on disk (returns 1 on success)
+// (the first waiter becomes the leader; if other writers shared the last sync, it waits up to
+// maxLatencyMicros for as many to join before writing the whole group with one data sync)
+int journalSync(struct Journal* journal) {
+    pthread_mutex_lock(&journal->lock);
+    uint64_t target = journal->nextSequence - 1;
+    journal->waiters++;
+    pthread_cond_signal(&journal->joined);
+    while (journal->durableSequence < target && !journal->failed) {
+        if (journal->flushing) { // A leader is busy; its sync or the next one will cover us
+            pthread_cond_wait(&journal->flushed, &journal->lock);
+            continue;
+        }
+        journal->flushing = 1;
+        if (journal->maxLatencyMicros > 0 && journal->lastGroupSize > 1) { // Writers are busy: gather a group
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += journal->maxLatencyMicros * 1000;
+            deadline.tv_sec += deadline.tv_nsec / 1000000000;
+            deadline.tv_nsec %= 1000000000;
+            while (journal->waiters < journal->lastGroupSize
+                   && pthread_cond_timedwait(&journal->joined, &journal->lock, &deadline) != ETIMEDOUT) {
+            }
+        }
+        char* buffer = journal->pending; // Take the whole pending group, leave an empty buffer behind
+        size_t size = journal->pendingSize;
+        size_t capacity = journal->pendingCapacity;
+        journal->pending = journal->writing;
+        journal->pendingCapacity = journal->writingCapacity;
+        journal->pendingSize = 0;
+        journal->writing = buffer;
+        journal->writingCapacity = capacity;
+        uint64_t groupEnd = journal->nextSequence - 1;
+        int groupSize = journal->waiters;
+
+        pthread_mutex_unlock(&journal->lock); // Other writers keep appending while we sync
+        int ok = writeDurably(journal->descriptor, buffer, size);
+        pthread_mutex_lock(&journal->lock);
+
+        if (ok) {
+            journal->durableSequence = groupEnd;
+        } else {
+            journal->failed = 1;
+        }
+        journal->syncCount++;
+        journal->lastGroupSize = groupSize;
+        journal->flushing = 0;
+        pthread_cond_broadcast(&journal->flushed);
+    }
+    journal->waiters--;
+    int durable = journal->durableSequence >= target;
+    pthread_mutex_unlock(&journal->lock);
+    return durable;
+}
+
+// Function to empty the journal once a snapshot includes everything in it (returns 1 on success)
+int journalReset(struct Journal* journal) {
+    int ok = journalSync(journal);
+    pthread_mutex_lock(&journal->lock);
+    ok = ok && ftruncate(journal->descriptor, sizeof(struct JournalHeader)) == 0
+            && writeDurably(journal->descriptor, NULL, 0); // Appends continue right after the header
+    pthread_mutex_unlock(&journal->lock);
+    return ok;
+}
+
+// Function to close the journal (records not yet synced are written first)
+void closeJournal(struct Journal* journal) {
+    journalSync(journal);
+    close(journal->descriptor);
+    free(journal->pending);
+    free(journal->writing);
+    pthread_mutex_destroy(&journal->lock);
+    pthread_cond_destroy(&journal->flushed);
+    pthread_cond_destroy(&journal->joined);
+}
+
+// Function to apply one journaled change to the hotel
+static void applyJournalRecord(struct Hotel* hotel, const struct JournalRecord* record, const char* guestName) {
+    if (record->type == JOURNAL_ADD_ROOM) {
+        insertRoomQuietly(hotel, record->roomNumber, record->occupancy);
+    } else if (record->type == JOURNAL_RESERVE) {
+        reserveRoomAt(hotel, record->roomNumber, guestName, record->checkIn, record->duration,
+                      record->extraServices, record->occupancy, (time_t)record->time);
+    } else if (record->type == JOURNAL_CANCEL) {
+        releaseRoomAt(hotel, record->roomNumber, guestName, record->checkIn, (time_t)record->time);
+    }
+}
+
+// Function to replay the journal onto the hotel (returns the number of changes applied, or -1 if
+// the file is not a journal of this version); records already in the loaded snapshot are skipped,
+// and a torn record at the end (a crash mid-write) is cut off so new records follow the last good one,
+// together with the rest of its group booking if it belongs to one
+int recoverJournal(struct Hotel* hotel, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    struct JournalHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1) {
+        fclose(file);
+        return 0; // Crashed while creating the journal: nothing was ever committed
+    }
+    if (memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 || header.version != JOURNAL_VERSION
+        || header.recordSize != sizeof(struct JournalRecord)) {
+        fclose(file);
+        return -1;
+    }
+
+    struct Journal* journal = hotel->journal;
+    hotel->journal = NULL; // Replayed changes are already in the journal
+    struct JournalRecord record;
+    char guestName[MAX_NAME_LENGTH + 8]; // A name is never logged at MAX_NAME_LENGTH or more, padding included
+    long validEnd = (long)sizeof(header);
+    uint64_t previous = 0;
+    int applied = 0;
+    struct JournalRecord* group = NULL; // Bookings of a group read so far, applied once the last one is read
+    char (*groupNames)[MAX_NAME_LENGTH] = NULL;
+    int groupSize = 0, groupRead = 0;
+    long groupStart = 0; // Where the group's first record starts
+    while (fread(&record, sizeof(record), 1, file) == 1 && record.nameLength < MAX_NAME_LENGTH
+           && fread(guestName, 1, journalNameSize(record.nameLength), file) == journalNameSize(record.nameLength)
+           && record.checksum == checksumRecord(&record, guestName) && (previous == 0 || record.sequence == previous + 1)) {
+        long recordStart = validEnd;
+        previous = record.sequence;
+        validEnd += (long)(sizeof(record) + journalNameSize(record.nameLength));
+        if (record.sequence <= hotel->journalSequence) {
+            continue; // Already part of the snapshot (a checkpoint never falls inside a group)
+        }
+        guestName[record.nameLength] = '\0';
+        if (record.type == JOURNAL_GROUP) {
+            groupStart = recordStart;
+            groupSize = record.duration > 0 ? record.duration : 0;
+            groupRead = 0;
+            group = (struct JournalRecord*)realloc(group, (groupSize + 1) * sizeof(*group));
+            groupNames = (char (*)[MAX_NAME_LENGTH])realloc(groupNames, (groupSize + 1) * sizeof(*groupNames));
+            continue;
+        }
+        if (groupRead < groupSize) {
+            group[groupRead] = record;
+            memcpy(groupNames[groupRead], guestName, record.nameLength + 1);
+            if (++groupRead < groupSize) {
+                continue;
+            }
+            for (int g = 0; g < groupSize; ++g) {
+                applyJournalRecord(hotel, &group[g], groupNames[g]);
+            }
+            hotel->journalSequence = record.sequence;
+            applied += groupSize;
+            groupSize = 0;
+            continue;
+        }
+        applyJournalRecord(hotel, &record, guestName);
+        hotel->journalSequence = record.sequence;
+        applied++;
+    }
+    if (groupRead < groupSize) { // The crash came in the middle of a group booking: none of it happened
+        validEnd = groupStart;
+    }
+    free(group);
+    free(groupNames);
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fclose(file);
+    hotel->journal = journal;
+    if (fileSize > validEnd) { // Drop the torn tail
+        int descriptor = open(path, O_WRONLY);
+        int ok = descriptor >= 0 && ftruncate(descriptor, validEnd) == 0;
+        if (descriptor >= 0) {
+            close(descriptor);
+        }
+        if (!ok) {
+            return -1;
+        }
+    }
+    return applied;
+}
+
+// Function to continue an FNV-1a hash over more bytes
+static uint32_t hashBytes(uint32_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Function to check the segments of a mapped history file up to end (returns 1 if every one is whole and
+// its checksum matches, and the last one ends exactly at end)
+static int checkHistorySegments(const char* data, uint64_t end) {
+    struct HistoryHeader header;
+    if (end < sizeof(header)) {
+        return 0;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, HISTORY_MAGIC, sizeof(header.magic)) != 0 || header.version != HISTORY_VERSION
+        || header.blockSize != sizeof(struct HistoryBlock)) {
+        return 0;
+    }
+    uint64_t position = sizeof(header);
+    while (position < end) {
+        struct HistorySegment segment;
+        if (end - position < sizeof(segment)) {
+            return 0;
+        }
+        memcpy(&segment, data + position, sizeof(segment));
+        uint64_t left = end - position - sizeof(segment);
+        if (segment.roomCount < 0 || segment.guestCount < 0 || segment.blockCount < 0
+            || (uint64_t)segment.roomCount * sizeof(int32_t) > left
+            || segment.namesSize > left - (uint64_t)segment.roomCount * sizeof(int32_t)) {
+            return 0;
+        }
+        left -= (uint64_t)segment.roomCount * sizeof(int32_t) + segment.namesSize;
+        if ((uint64_t)segment.blockCount * sizeof(struct HistoryBlock) > left
+            || segment.dataSize > left - (uint64_t)segment.blockCount * sizeof(struct HistoryBlock)) {
+            return 0;
+        }
+        uint64_t size = sizeof(segment) + (uint64_t)segment.roomCount * sizeof(int32_t) + segment.namesSize
+                      + (uint64_t)segment.blockCount * sizeof(struct HistoryBlock) + segment.dataSize;
+        if (hashBytes(2166136261u, data + position + sizeof(segment.checksum), size - sizeof(segment.checksum)) != segment.checksum) {
+            return 0;
+        }
+        const char* names = data + position + sizeof(segment) + (uint64_t)segment.roomCount * sizeof(int32_t);
+        int terminators = 0;
+        for (uint64_t i = 0; i < segment.namesSize; ++i) {
+            terminators += names[i] == '\0';
+        }
+        if (terminators != segment.guestCount || (segment.namesSize > 0 && names[segment.namesSize - 1] != '\0')) {
+            return 0;
+        }
+        const char* blocks = names + segment.namesSize;
+        uint64_t dataSize = 0;
+        for (int b = 0; b < segment.blockCount; ++b) { // Every packed column must lie inside its block's data
+            struct HistoryBlock block;
+            memcpy(&block, blocks + (uint64_t)b * sizeof(block), sizeof(block));
+            if (block.count < 1 || block.count > HISTORY_BLOCK_EVENTS || block.size > segment.dataSize - dataSize) {
+                return 0;
+            }
+            for (int c = 0; c < HISTORY_COLUMNS; ++c) {
+                if ((block.widths[c] > HISTORY_WIDE_BITS && block.widths[c] != 64)
+                    || block.offsets[c] + ((uint64_t)block.widths[c] * block.count + 7) / 8 + 8 > block.size) {
+                    return 0;
+                }
+            }
+            dataSize += block.size;
+        }
+        if (dataSize != segment.dataSize) {
+            return 0;
+        }
+        position += size;
+    }
+    return position == end;
+}
+
+// Function to add the segments of a mapped history file, checked by checkHistorySegments, to an empty history
+// (the blocks are used in place from the mapping)
+static void loadHistorySegments(struct BookingHistory* history, char* data, uint64_t end) {
+    uint64_t position = sizeof(struct HistoryHeader);
+    while (position < end) {
+        struct HistorySegment segment;
+        memcpy(&segment, data + position, sizeof(segment));
+        position += sizeof(segment);
+        for (int r = 0; r < segment.roomCount; ++r, position += sizeof(int32_t)) { // Codes come back in the order they were given
+            int32_t roomNumber;
+            memcpy(&roomNumber, data + position, sizeof(roomNumber));
+            historyRoomCode(history, roomNumber);
+        }
+        for (int g = 0; g < segment.guestCount; ++g) {
+            historyGuestCode(history, data + position);
+            position += strlen(data + position) + 1;
+        }
+        if (history->blockCount + segment.blockCount > history->blockCapacity) {
+            history->blockCapacity = history->blockCount + segment.blockCount;
+            history->blocks = (struct HistoryBlock*)realloc(history->blocks, history->blockCapacity * sizeof(struct HistoryBlock));
+        }
+        uint64_t dataPosition = position + (uint64_t)segment.blockCount * sizeof(struct HistoryBlock);
+        for (int b = 0; b < segment.blockCount; ++b, position += sizeof(struct HistoryBlock)) {
+            struct HistoryBlock* block = &history->blocks[history->blockCount++];
+            memcpy(block, data + position, sizeof(*block));
+            block->data = (uint8_t*)data + dataPosition;
+            dataPosition += block->size;
+            history->events += block->count;
+        }
+        position = dataPosition;
+    }
+    history->savedBlocks = history->loadedBlocks = history->blockCount;
+    history->savedRooms = history->roomCount;
+    history->savedGuests = history->guestCount;
+}
+
+// Function to load the history file that goes with the loaded snapshot into the hotel's still empty history and
+// keep the file open for the next checkpoints (returns 1 if the history was loaded, 0 if a new one was started
+// because there is no snapshot, -1 if the file does not go with the snapshot, so a new one was started too; the
+// history's file is -1 if it cannot be opened at all). Segments appended after the snapshot was saved are cut
+// off, as the journal replays their changes
+int openHistory(struct Hotel* hotel, const char* path) {
+    struct BookingHistory* history = &hotel->history;
+    uint64_t end = history->fileSize; // Set by loadSnapshot; 0 without a snapshot
+    size_t size = 0;
+    int loaded = 0;
+    if (end > 0) {
+        char* data = (char*)mapSnapshot(path, &size);
+        loaded = data != NULL && size >= end && checkHistorySegments(data, end) ? 1 : -1;
+        if (loaded > 0) {
+            loadHistorySegments(history, data, end);
+            history->mapping = data;
+            history->mappingSize = size;
+        } else if (data != NULL) {
+            unmapSnapshot(data, size);
+        }
+    }
+    history->fileSize = loaded > 0 ? end : 0;
+    history->file = open(path, O_WRONLY | O_CREAT, 0644);
+    int ok = history->file >= 0 && ftruncate(history->file, (off_t)history->fileSize) == 0;
+    if (ok && history->fileSize == 0) { // New history: start with the header
+        struct HistoryHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, HISTORY_MAGIC, sizeof(header.magic));
+        header.version = HISTORY_VERSION;
+        header.blockSize = sizeof(struct HistoryBlock);
+        ok = writeDurably(history->file, (const char*)&header, sizeof(header));
+        history->fileSize = sizeof(header);
+    }
+    if (!ok && history->file >= 0) {
+        close(history->file);
+        history->file = -1;
+    }
+    return loaded;
+}
+
+// Function to append what the history file lacks as one segment, packing the unpacked events first (returns 1
+// on success, or if the history is only kept in memory); a failed append is cut off again, so the next one
+// follows the last whole segment
+static int saveHistory(struct BookingHistory* history) {
+    if (history->file < 0) {
+        return 1;
+    }
+    pthread_mutex_lock(&history->lock);
+    waitForSealer(history);
+    if (history->tailCount > 0) {
+        sealHistory(history);
+    }
+    struct HistorySegment segment;
+    memset(&segment, 0, sizeof(segment));
+    segment.roomCount = history->roomCount - history->savedRooms;
+    segment.guestCount = history->guestCount - history->savedGuests;
+    segment.blockCount = history->blockCount - history->savedBlocks;
+    if (segment.roomCount == 0 && segment.guestCount == 0 && segment.blockCount == 0) {
+        pthread_mutex_unlock(&history->lock);
+        return 1;
+    }
+    for (int g = history->savedGuests; g < history->guestCount; ++g) {
+        segment.namesSize += strlen(poolString(&history->names, history->guests[g])) + 1;
+    }
+    char* names = (char*)malloc(segment.namesSize + 1);
+    char* name = names;
+    for (int g = history->savedGuests; g < history->guestCount; ++g) {
+        const char* guest = poolString(&history->names, history->guests[g]);
+        size_t length = strlen(guest) + 1;
+        memcpy(name, guest, length);
+        name += length;
+    }
+    struct HistoryBlock* blocks = (struct HistoryBlock*)malloc((segment.blockCount + 1) * sizeof(struct HistoryBlock));
+    memcpy(blocks, &history->blocks[history->savedBlocks], segment.blockCount * sizeof(struct HistoryBlock));
+    for (int b = 0; b < segment.blockCount; ++b) {
+        blocks[b].data = NULL; // Pointers mean nothing in the file
+        segment.dataSize += blocks[b].size;
+    }
+
+    const int32_t* rooms = (const int32_t*)&history->rooms[history->savedRooms];
+    uint32_t hash = hashBytes(2166136261u, (const char*)&segment + sizeof(segment.checksum), sizeof(segment) - sizeof(segment.checksum));
+    hash = hashBytes(hash, rooms, segment.roomCount * sizeof(int32_t));
+    hash = hashBytes(hash, names, segment.namesSize);
+    hash = hashBytes(hash, blocks, segment.blockCount * sizeof(struct HistoryBlock));
+    for (int b = history->savedBlocks; b < history->blockCount; ++b) {
+        hash = hashBytes(hash, history->blocks[b].data, history->blocks[b].size);
+    }
+    segment.checksum = hash;
+    int ok = lseek(history->file, (off_t)history->fileSize, SEEK_SET) >= 0
+             && writeAll(history->file, (const char*)&segment, sizeof(segment))
+             && writeAll(history->file, (const char*)rooms, segment.roomCount * sizeof(int32_t))
+             && writeAll(history->file, names, segment.namesSize)
+             && writeAll(history->file, (const char*)blocks, segment.blockCount * sizeof(struct HistoryBlock));
+    for (int b = history->savedBlocks; ok && b < history->blockCount; ++b) {
+        ok = writeAll(history->file, (const char*)history->blocks[b].data, history->blocks[b].size);
+    }
+    ok = ok && writeDurably(history->file, NULL, 0);
+    if (ok) {
+        history->fileSize += sizeof(segment) + segment.roomCount * sizeof(int32_t) + segment.namesSize
+                           + segment.blockCount * sizeof(struct HistoryBlock) + segment.dataSize;
+        history->savedRooms = history->roomCount;
+        history->savedGuests = history->guestCount;
+        history->savedBlocks = history->blockCount;
+    } else if (ftruncate(history->file, (off_t)history->fileSize) != 0) {
+        close(history->file); // The file can no longer be trusted; keep the history in memory only
+        history->file = -1;
+    }
+    pthread_mutex_unlock(&history->lock);
+    free(names);
+    free(blocks);
+    return ok;
+}
+
+// Function to save a snapshot and empty the journal, whose changes the snapshot now includes
+// (returns 1 on success; if the hotel is not journaled this just saves the snapshot)
+int checkpointHotel(struct Hotel* hotel, const char* snapshotPath) {
+    pthread_rwlock_wrlock(&hotel->tableLock); // Stop every reader and writer so the snapshot is consistent
+    lockAllRooms(hotel, 1);
+    int ok = hotel->journal == NULL || journalSync(hotel->journal);
+    if (ok && hotel->journal != NULL) {
+        pthread_mutex_lock(&hotel->journal->lock);
+        hotel->journalSequence = hotel->journal->nextSequence - 1; // Every logged change is in this snapshot
+        pthread_mutex_unlock(&hotel->journal->lock);
+    }
+    ok = ok && saveHistory(&hotel->history); // Before the snapshot, which records how much of the history goes with it
+    slideCalendar(hotel, today()); // Nights gone by make way for new ones, in memory and in the snapshot
+    ok = ok && saveSnapshot(hotel, snapshotPath);
+    ok = ok && (hotel->journal == NULL || journalReset(hotel->journal));
+    lockAllRooms(hotel, 0);
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return ok;
+}
+
+// Function to add up the metrics of every thread into total (returns the number of thread blocks; the counts
+// of threads still running may be a few operations apart, as nothing stops them while they are read)
+int collectMetrics(struct ThreadMetrics* total) {
+    int blocks = 0;
+    memset(total, 0, sizeof(*total));
+    for (struct ThreadMetrics* metrics = __atomic_load_n(&metricsThreads, __ATOMIC_ACQUIRE); metrics != NULL; metrics = metrics->next) {
+        for (int op = 0; op < METRIC_OPERATIONS; ++op) {
+            const struct OperationMetrics* from = &metrics->operations[op];
+            struct OperationMetrics* to = &total->operations[op];
+            for (int s = 0; s < METRICS_STATUSES; ++s) {
+                to->results[s] += __atomic_load_n(&from->results[s], __ATOMIC_RELAXED);
+            }
+            for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+                to->latency[b] += __atomic_load_n(&from->latency[b], __ATOMIC_RELAXED);
+            }
+            to->latencyNanoseconds += __atomic_load_n(&from->latencyNanoseconds, __ATOMIC_RELAXED);
+        }
+        for (int p = 0; p < PROBE_BUCKETS; ++p) {
+            total->probes[p] += __atomic_load_n(&metrics->probes[p], __ATOMIC_RELAXED);
+        }
+        total->inUse += __atomic_load_n(&metrics->inUse, __ATOMIC_RELAXED);
+        blocks++;
+    }
+    return blocks;
+}
+
+// Function to find the latency below which a fraction of an operation's timed runs fall (the limit of the
+// bucket that holds it, so never below the true value by more than a bucket; 0 if none was timed)
+static uint64_t latencyQuantile(const struct OperationMetrics* operation, uint64_t timed, double fraction) {
+    uint64_t rank = (uint64_t)(fraction * (double)timed + 0.5), seen = 0;
+    rank = rank < 1 ? 1 : rank;
+    for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+        seen += operation->latency[b];
+        if (seen >= rank) {
+            return latencyBucketLimit(b);
+        }
+    }
+    return 0;
+}
+
+// Function to write the metrics of the process in the Prometheus text format (returns 1 unless writing failed)
+//   hotel_operations_total{operation,result}            counter, every operation by enum HotelStatus
+//   hotel_operation_latency_seconds{operation,le}       histogram of the timed operations, le a power of two ns
+//   hotel_operation_latency_quantile_seconds{operation,quantile}   p50, p90, p99 and p99.9 from the fine buckets
+//   hotel_room_lookup_probes{le}                        histogram of index slots probed per room lookup
+int writeMetrics(FILE* file) {
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    struct ThreadMetrics* total = (struct ThreadMetrics*)malloc(sizeof(struct ThreadMetrics));
+    if (total == NULL) {
+        return 0;
+    }
+    int blocks = collectMetrics(total);
+    uint64_t timed[METRIC_OPERATIONS];
+    for (int op = 0; op < METRIC_OPERATIONS; ++op) {
+        timed[op] = 0;
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+            timed[op] += total->operations[op].latency[b];
+        }
+    }
+
+    fprintf(file, "# HELP hotel_operations_total Operations of the reservation core, by result.\n"
+                  "# TYPE hotel_operations_total counter\n");
+    for (int op = 0; op < METRIC_OPERATIONS; ++op) {
+        for (int s = 0; s < METRICS_STATUSES; ++s) {
+            if (s == HOTEL_OK || total->operations[op].results[s] > 0) { // Results an operation never had are left out
+                fprintf(file, "hotel_operations_total{operation=\"%s\",result=\"%s\"} %llu\n", metricOperationNames[op],
+                        hotelStatusNames[s], (unsigned long long)total->operations[op].results[s]);
+            }
+        }
+    }
+    fprintf(file, "# HELP hotel_operation_latency_seconds Latency of the operations timed (each thread times one in hotel_metrics_sample_interval).\n"
+                  "# TYPE hotel_operation_latency_seconds histogram\n");
+    for (int op = 0; op < METRIC_OPERATIONS; ++op) {
+        const struct OperationMetrics* operation = &total->operations[op];
+        uint64_t below = 0;
+        for (int b = 0; b < LATENCY_BUCKETS - 1; ++b) { // The last bucket also holds everything longer
+            uint64_t limit = latencyBucketLimit(b);
+            below += operation->latency[b];
+            if (limit >= 256 && (limit & (limit - 1)) == 0) { // Powers of two from 256 ns: where the fine buckets line up
+                fprintf(file, "hotel_operation_latency_seconds_bucket{operation=\"%s\",le=\"%.9g\"} %llu\n",
+                        metricOperationNames[op], (double)limit / 1e9, (unsigned long long)below);
+            }
+        }
+        fprintf(file, "hotel_operation_latency_seconds_bucket{operation=\"%s\",le=\"+Inf\"} %llu\n"
+                      "hotel_operation_latency_seconds_sum{operation=\"%s\"} %.9f\n"
+                      "hotel_operation_latency_seconds_count{operation=\"%s\"} %llu\n",
+                metricOperationNames[op], (unsigned long long)timed[op], metricOperationNames[op],
+                (double)operation->latencyNanoseconds / 1e9, metricOperationNames[op], (unsigned long long)timed[op]);
+    }
+    fprintf(file, "# HELP hotel_operation_latency_quantile_seconds Latency quantiles of the timed operations, to 1/16.\n"
+                  "# TYPE hotel_operation_latency_quantile_seconds gauge\n");
+    for (int op = 0; op < METRIC_OPERATIONS; ++op) {
+        for (int q = 0; q < 4 && timed[op] > 0; ++q) {
+            fprintf(file, "hotel_operation_latency_quantile_seconds{operation=\"%s\",quantile=\"%g\"} %.9g\n", metricOperationNames[op],
+                    quantiles[q], (double)latencyQuantile(&total->operations[op], timed[op], quantiles[q]) / 1e9);
+        }
+    }
+    uint64_t lookups = 0, probed = 0;
+    fprintf(file, "# HELP hotel_room_lookup_probes Room index slots probed per lookup.\n"
+                  "# TYPE hotel_room_lookup_probes histogram\n");
+    for (int p = 0; p < PROBE_BUCKETS; ++p) {
+        lookups += total->probes[p];
+        probed += total->probes[p] * (uint64_t)(p + 1); // The last bucket counts as PROBE_BUCKETS slots
+        if (p < PROBE_BUCKETS - 1) {
+            fprintf(file, "hotel_room_lookup_probes_bucket{le=\"%d\"} %llu\n", p + 1, (unsigned long long)lookups);
+        }
+    }
+    fprintf(file, "hotel_room_lookup_probes_bucket{le=\"+Inf\"} %llu\n"
+                  "hotel_room_lookup_probes_sum %llu\n"
+                  "hotel_room_lookup_probes_count %llu\n",
+            (unsigned long long)lookups, (unsigned long long)probed, (unsigned long long)lookups);
+    fprintf(file, "# HELP hotel_metrics_sample_interval Each thread times one in this many operations (0: metrics off).\n"
+                  "# TYPE hotel_metrics_sample_interval gauge\n"
+                  "hotel_metrics_sample_interval %d\n"
+                  "# HELP hotel_metrics_threads Threads that have recorded metrics, and of those, the ones still running.\n"
+                  "# TYPE hotel_metrics_threads gauge\n"
+                  "hotel_metrics_threads{state=\"all\"} %d\n"
+                  "hotel_metrics_threads{state=\"running\"} %d\n",
+            __atomic_load_n(&metricsInterval, __ATOMIC_RELAXED), blocks, total->inUse);
+    free(total);
+    return !ferror(file);
+}
+
+// Function to wait after a poll of the router's rings found nothing: spin at first, then give the processor
+// away, and once a worker (mayRest) has been idle a long while, sleep between polls (returns the new idle count)
+static int routerBackoff(int idle, int mayRest) {
+    if (idle >= ROUTER_SPIN_ROUNDS + ROUTER_YIELD_ROUNDS && mayRest) {
+        struct timespec rest = {0, ROUTER_REST_NANOSECONDS};
+        nanosleep(&rest, NULL);
+        return idle;
+    }
+    if (idle >= ROUTER_SPIN_ROUNDS) {
+        sched_yield();
+    }
+    return idle + 1;
+}
+
+// Function to find the shard that owns a property (the same for the life of the router)
+int routerShard(const struct HotelRouter* router, int propertyId) {
+    return (int)(hashRoomNumber(propertyId) % (unsigned int)router->shardCount);
+}
+
+// Function to find a property of a shard, adding it empty if create is set (returns NULL if there is no such
+// property, or if it could not be made; only the shard's worker calls this)
+static struct Hotel* findProperty(struct RouterShard* shard, int propertyId, int create) {
+    int position = indexFind(&shard->propertyIndex, propertyId);
+    if (position >= 0 || !create) {
+        return position >= 0 ? shard->properties[position] : NULL;
+    }
+    struct Hotel* hotel = hotelCreate();
+    if (hotel == NULL) {
+        return NULL;
+    }
+    if (shard->propertyCount == shard->propertyCapacity) {
+        shard->propertyCapacity = shard->propertyCapacity ? shard->propertyCapacity * 2 : FLOOR_INITIAL_CAPACITY;
+        shard->properties = (struct Hotel**)realloc(shard->properties, shard->propertyCapacity * sizeof(struct Hotel*));
+    }
+    if ((int64_t)(shard->propertyIndex.count + 1) * 10 > (int64_t)shard->propertyIndex.capacity * 7) {
+        indexGrow(&shard->propertyIndex, 1);
+    }
+    shard->properties[shard->propertyCount] = hotel;
+    indexPut(&shard->propertyIndex, propertyId, shard->propertyCount++);
+    return hotel;
+}
+
+// Function to answer one request on the worker of the shard owning its property
+static void answerRequest(struct RouterShard* shard, struct HotelRequest* request) {
+    struct Hotel* hotel = findProperty(shard, request->propertyId, 0);
+    request->freeRooms = 0;
+    if (request->type == HOTEL_REQUEST_ADD_PROPERTY) {
+        request->status = hotel != NULL ? HOTEL_PROPERTY_EXISTS : HOTEL_OK;
+        if (hotel == NULL && findProperty(shard, request->propertyId, 1) == NULL) {
+            request->status = -1; // Out of memory
+        }
+        return;
+    }
+    if (hotel == NULL) {
+        request->status = request->type >= HOTEL_REQUEST_ADD_ROOM && request->type <= HOTEL_REQUEST_FREE_ROOMS ? HOTEL_PROPERTY_NOT_FOUND : -1;
+        return;
+    }
+    switch (request->type) {
+        case HOTEL_REQUEST_ADD_ROOM:
+            request->status = insertRoom(hotel, request->roomNumber);
+            break;
+        case HOTEL_REQUEST_RESERVE:
+            request->status = reserveRoom(hotel, request->roomNumber, request->guestName, request->checkIn, request->nights,
+                                          request->extraServices != 0, request->occupancy);
+            break;
+        case HOTEL_REQUEST_CANCEL:
+            request->status = releaseRoom(hotel, request->roomNumber, request->guestName, request->checkIn);
+            break;
+        case HOTEL_REQUEST_FREE_ROOMS:
+            request->status = isValidStay(request->checkIn, request->nights) ? HOTEL_OK : HOTEL_INVALID_STAY;
+            if (request->status == HOTEL_OK) {
+                request->freeRooms = findAvailableRooms(hotel, request->checkIn, request->checkIn + request->nights,
+                                                        request->occupancy, NULL, 0);
+            }
+            break;
+        default:
+            request->status = -1;
+            break;
+    }
+}
+
+// Function run by the worker of each shard: answer whatever the clients have pushed to it, ring by ring, until
+// the router is destroyed. All pushed so far on a ring are answered before its done moves, once
+static void* runShard(void* argument) {
+    struct RouterShard* shard = (struct RouterShard*)argument;
+    struct HotelRouter* router = shard->router;
+    int idle = 0;
+    while (!__atomic_load_n(&router->stopping, __ATOMIC_ACQUIRE)) {
+        int answered = 0, clients = __atomic_load_n(&router->clientCount, __ATOMIC_ACQUIRE);
+        for (int c = 0; c < clients; ++c) {
+            struct RouterRing* rings = __atomic_load_n(&router->clients[c].rings, __ATOMIC_ACQUIRE);
+            if (rings == NULL) {
+                continue;
+            }
+            struct RouterRing* ring = &rings[shard->id];
+            uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE), done = ring->done;
+            if (done == head) {
+                continue;
+            }
+            for (; done != head; ++done) {
+                answerRequest(shard, ring->slots[done % ROUTER_RING_SIZE]);
+            }
+            __atomic_store_n(&ring->done, done, __ATOMIC_RELEASE); // The answers are in place before the client sees this
+            answered = 1;
+        }
+        idle = answered ? 0 : routerBackoff(idle, 1);
+    }
+    return NULL;
+}
+
+// Function to destroy a router: stop its workers and free every property (no client may be running requests;
+// connected clients are freed with it)
+void destroyRouter(struct HotelRouter* router) {
+    __atomic_store_n(&router->stopping, 1, __ATOMIC_RELEASE);
+    for (int s = 0; s < router->shardCount; ++s) {
+        struct RouterShard* shard = &router->shards[s];
+        if (shard->router != NULL) { // Its worker was started
+            pthread_join(shard->worker, NULL);
+        }
+        for (int p = 0; p < shard->propertyCount; ++p) {
+            hotelDestroy(shard->properties[p]);
+        }
+        free(shard->properties);
+        free(shard->propertyIndex.slots);
+    }
+    for (int c = 0; c < ROUTER_MAX_CLIENTS; ++c) {
+        free(router->clients[c].rings);
+    }
+    free(router->shards);
+    free(router);
+}
+
+// Function to create a router with shardCount shards, each owning the properties hashed to it and answering
+// their requests on a thread of its own (returns NULL if shardCount is not from 1 to HOTEL_ROUTER_MAX_SHARDS,
+// or if a thread could not be started)
+struct HotelRouter* createRouter(int shardCount) {
+    if (shardCount < 1 || shardCount > HOTEL_ROUTER_MAX_SHARDS) {
+        return NULL;
+    }
+    struct HotelRouter* router = (struct HotelRouter*)calloc(1, sizeof(struct HotelRouter));
+    router->shards = (struct RouterShard*)calloc(shardCount, sizeof(struct RouterShard));
+    router->shardCount = shardCount;
+    for (int s = 0; s < shardCount; ++s) {
+        struct RouterShard* shard = &router->shards[s];
+        shard->id = s;
+        indexGrow(&shard->propertyIndex, 0);
+        shard->router = router;
+        if (pthread_create(&shard->worker, NULL, runShard, shard) != 0) {
+            shard->router = NULL; // Not started, so not joined
+            destroyRouter(router);
+            return NULL;
+        }
+    }
+    return router;
+}
+
+// Function to connect the calling thread to a router (returns NULL if ROUTER_MAX_CLIENTS are connected already).
+// Each thread sending requests needs a client of its own, as only one thread may push to a ring
+struct HotelRouterClient* connectRouter(struct HotelRouter* router) {
+    for (int c = 0; c < ROUTER_MAX_CLIENTS; ++c) {
+        struct HotelRouterClient* client = &router->clients[c];
+        int unused = 0;
+        if (!__atomic_compare_exchange_n(&client->inUse, &unused, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            continue;
+        }
+        if (client->rings == NULL) { // First use of the slot: nothing pushed, nothing answered
+            client->router = router;
+            __atomic_store_n(&client->rings, (struct RouterRing*)calloc(router->shardCount, sizeof(struct RouterRing)), __ATOMIC_RELEASE);
+        }
+        for (int s = 0; s < router->shardCount; ++s) { // A slot used before has every request answered
+            client->answered[s] = client->rings[s].head;
+        }
+        int count = __atomic_load_n(&router->clientCount, __ATOMIC_RELAXED);
+        while (count <= c && !__atomic_compare_exchange_n(&router->clientCount, &count, c + 1, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+        return client;
+    }
+    return NULL;
+}
+
+// Function to give a client back to its router (every request it ran has been answered, so nothing is lost)
+void disconnectRouter(struct HotelRouterClient* client) {
+    __atomic_store_n(&client->inUse, 0, __ATOMIC_RELEASE);
+}
+
+// Function to run requests through a router: each is pushed to the ring of the shard owning its property,
+// as many in flight at once as the rings hold, so every shard works on them in parallel. Returns once all
+// are answered in place (the number of requests); requests to one property are answered in the order given
+int routeRequests(struct HotelRouterClient* client, struct HotelRequest* requests, int count) {
+    struct HotelRouter* router = client->router;
+    int next = 0, waiting = 1, idle = 0;
+    while (next < count || waiting) {
+        int progressed = 0;
+        for (; next < count; ++next) { // Push until every request is out or a ring is full
+            int shard = routerShard(router, requests[next].propertyId);
+            struct RouterRing* ring = &client->rings[shard];
+            if (ring->head - client->answered[shard] == ROUTER_RING_SIZE) {
+                client->answered[shard] = __atomic_load_n(&ring->done, __ATOMIC_ACQUIRE);
+                if (ring->head - client->answered[shard] == ROUTER_RING_SIZE) {
+                    break;
+                }
+            }
+            ring->slots[ring->head % ROUTER_RING_SIZE] = &requests[next];
+            __atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+            progressed = 1;
+        }
+        waiting = 0;
+        for (int s = 0; s < router->shardCount; ++s) {
+            if (client->answered[s] != client->rings[s].head) {
+                uint64_t done = __atomic_load_n(&client->rings[s].done, __ATOMIC_ACQUIRE);
+                progressed |= done != client->answered[s];
+                client->answered[s] = done;
+                waiting |= done != client->rings[s].head;
+            }
+        }
+        idle = progressed ? 0 : routerBackoff(idle, 0);
+    }
+    return count;
+}
+
+// Function to get the version of the interface this library implements (HOTEL_CORE_VERSION when it was built)
+int hotelCoreVersion() {
+    return HOTEL_CORE_VERSION;
+}
+
+// Function to create an empty hotel, not journaled and priced by the default rate plan (NULL if out of memory)
+struct Hotel* hotelCreate() {
+    struct Hotel* hotel = (struct Hotel*)malloc(sizeof(struct Hotel));
+    if (hotel != NULL) {
+        initHotel(hotel);
+    }
+    return hotel;
+}
+
+// Function to free a hotel made by hotelCreate, closing its journal if one is open (nothing else may be using it;
+// NULL is ignored)
+void hotelDestroy(struct Hotel* hotel) {
+    if (hotel != NULL) {
+        hotelCloseJournal(hotel);
+        freeHotel(hotel);
+        free(hotel);
+    }
+}
+
+// Function to add a room (returns an enum HotelStatus)
+int hotelAddRoom(struct Hotel* hotel, int roomNumber) {
+    return insertRoom(hotel, roomNumber);
+}
+
+// Function to add a list of rooms, skipping numbers already in the hotel or listed twice (returns the number added)
+int hotelAddRooms(struct Hotel* hotel, const int* roomNumbers, int count) {
+    return insertRooms(hotel, roomNumbers, NULL, count);
+}
+
+// Function to add rooms firstRoom to lastRoom on each of floors firstFloor to lastFloor (room 7 of floor 12
+// is 1207, or 12007 with 100 or more rooms a floor; returns the number added, or -1 if the range is not valid)
+int hotelAddRoomRange(struct Hotel* hotel, int firstFloor, int lastFloor, int firstRoom, int lastRoom) {
+    int* roomNumbers = NULL;
+    int count = expandRoomRange(firstFloor, lastFloor, firstRoom, lastRoom, &roomNumbers);
+    if (count < 0) {
+        return -1;
+    }
+    int* floors = (int*)malloc(count * sizeof(int)); // The floors the numbers were made from
+    for (int i = 0; i < count; ++i) {
+        floors[i] = firstFloor + i / (lastRoom - firstRoom + 1);
+    }
+    int added = insertRooms(hotel, roomNumbers, floors, count);
+    free(roomNumbers);
+    free(floors);
+    return added;
+}
+
+// Function to add the rooms listed in a room file (returns 1 if loaded, 0 if there is no such file, or minus
+// the number of the first line not understood, adding nothing; *listed and *added count the rooms)
+int hotelImportRooms(struct Hotel* hotel, const char* path, int* listed, int* added) {
+    return loadRoomFile(hotel, path, listed, added);
+}
+
+// Function to book a room for nights nights from checkIn (returns an enum HotelStatus)
+int hotelReserve(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn, int nights, int extraServices, int occupancy) {
+    return reserveRoom(hotel, roomNumber, guestName, checkIn, nights, extraServices != 0, occupancy);
+}
+
+// Function to cancel a guest's booking of a room starting on checkIn (returns an enum HotelStatus)
+int hotelCancel(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn) {
+    return releaseRoom(hotel, roomNumber, guestName, checkIn);
+}
+
+// Function to book rooms for a whole group, all or none (see reserveGroup; returns an enum HotelStatus)
+int hotelReserveGroup(struct Hotel* hotel, const struct HotelGroup* group, int* partyRooms) {
+    return reserveGroup(hotel, group, partyRooms);
+}
+
+// Function to count the rooms of a hotel
+int hotelRoomCount(struct Hotel* hotel) {
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    int count = hotel->roomCount;
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return count;
+}
+
+// Function to copy out up to maxRooms room numbers, in the order the rooms were added, from the first-th room on
+// (returns the number copied; call again from first + that number to page through a large hotel)
+int hotelListRooms(struct Hotel* hotel, int first, int* roomNumbers, int maxRooms) {
+    int count = 0;
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    for (int i = first < 0 ? 0 : first; i < hotel->roomCount && count < maxRooms; ++i) {
+        roomNumbers[count++] = hotel->rooms[i].roomNumber;
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return count;
+}
+
+// Function to copy out up to maxBookings bookings of a room, by check-in date (returns how many the room has,
+// which may be more than were copied, or -1 if there is no such room)
+int hotelListBookings(struct Hotel* hotel, int roomNumber, struct HotelBooking* bookings, int maxBookings) {
+    uint64_t started = startOperation();
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    int slot = findRoom(hotel, roomNumber), count = -1;
+    if (slot >= 0) {
+        pthread_mutex_t* lock = roomLock(hotel, roomNumber);
+        pthread_mutex_lock(lock);
+        const struct Room* room = &hotel->rooms[slot];
+        const struct RoomDetails* details = &hotel->details[slot];
+        count = room->bookingCount;
+        for (int b = 0; b < count && b < maxBookings; ++b) {
+            bookings[b].checkIn = room->stays[b].checkIn;
+            bookings[b].checkOut = room->stays[b].checkOut;
+            bookings[b].occupancy = details->bookings[b].occupancy;
+            bookings[b].extraServices = details->bookings[b].extraServices;
+            bookings[b].reservationTime = details->bookings[b].reservationTime;
+            bookings[b].guestName = poolString(&hotel->guests.names, details->bookings[b].guestName);
+        }
+        pthread_mutex_unlock(lock);
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    finishOperation(METRIC_VIEW, started, count >= 0 ? HOTEL_OK : HOTEL_ROOM_NOT_FOUND);
+    return count;
+}
+
+// Function to look up a room (returns 1 and fills in room, or 0 if there is no such room)
+int hotelFindRoom(struct Hotel* hotel, int roomNumber, struct HotelRoom* room) {
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    int slot = findRoom(hotel, roomNumber);
+    if (slot >= 0) {
+        pthread_mutex_t* lock = roomLock(hotel, roomNumber);
+        pthread_mutex_lock(lock);
+        room->roomNumber = roomNumber;
+        room->capacity = hotel->rooms[slot].capacity;
+        room->bookingCount = hotel->rooms[slot].bookingCount;
+        room->cancellationTime = hotel->details[slot].cancellationTime;
+        pthread_mutex_unlock(lock);
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return slot >= 0;
+}
+
+// Function to look up the booking of a room starting on checkIn (returns HOTEL_OK and fills in booking,
+// HOTEL_ROOM_NOT_FOUND or HOTEL_BOOKING_NOT_FOUND)
+int hotelFindBooking(struct Hotel* hotel, int roomNumber, int checkIn, struct HotelBooking* booking) {
+    int status = HOTEL_ROOM_NOT_FOUND;
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    int slot = findRoom(hotel, roomNumber);
+    if (slot >= 0) {
+        pthread_mutex_t* lock = roomLock(hotel, roomNumber);
+        pthread_mutex_lock(lock);
+        const struct Room* room = &hotel->rooms[slot];
+        int position = findStay(room, checkIn);
+        status = position < room->bookingCount && room->stays[position].checkIn == checkIn ? HOTEL_OK : HOTEL_BOOKING_NOT_FOUND;
+        if (status == HOTEL_OK) {
+            const struct Booking* found = &hotel->details[slot].bookings[position];
+            booking->checkIn = checkIn;
+            booking->checkOut = room->stays[position].checkOut;
+            booking->occupancy = found->occupancy;
+            booking->extraServices = found->extraServices;
+            booking->reservationTime = found->reservationTime;
+            booking->guestName = poolString(&hotel->guests.names, found->guestName);
+        }
+        pthread_mutex_unlock(lock);
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return status;
+}
+
+// Function to open a point-in-time view of a hotel's bookings (NULL if HOTEL_MAX_VIEWS are open already)
+struct HotelView* hotelOpenView(struct Hotel* hotel) {
+    return openView(hotel);
+}
+
+// Function to close a view opened by hotelOpenView
+void hotelCloseView(struct HotelView* view) {
+    closeView(view);
+}
+
+// Function to look up a room as it stood when the view was opened (returns 1 and fills in room, or 0 if there was
+// no such room then)
+int hotelViewRoom(struct HotelView* view, int roomNumber, struct HotelRoom* room) {
+    struct Hotel* hotel = view->hotel;
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    int slot = findRoom(hotel, roomNumber), found = 0;
+    if (slot >= 0) {
+        const struct Stay* stays;
+        const struct Booking* bookings;
+        pthread_mutex_t* lock = roomLock(hotel, roomNumber);
+        pthread_mutex_lock(lock);
+        found = findViewState(hotel, slot, view->stamp, &room->bookingCount, &stays, &bookings, &room->cancellationTime);
+        pthread_mutex_unlock(lock);
+        room->roomNumber = roomNumber;
+        room->capacity = hotel->rooms[slot].capacity;
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return found;
+}
+
+// Function to copy out up to maxBookings bookings of a room as they stood when the view was opened (returns how
+// many it had then, or -1 if there was no such room)
+int hotelViewBookings(struct HotelView* view, int roomNumber, struct HotelBooking* bookings, int maxBookings) {
+    uint64_t started = startOperation();
+    struct Hotel* hotel = view->hotel;
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    int slot = findRoom(hotel, roomNumber), count = -1;
+    if (slot >= 0) {
+        const struct Stay* stays;
+        const struct Booking* found;
+        int64_t cancellationTime;
+        pthread_mutex_t* lock = roomLock(hotel, roomNumber);
+        pthread_mutex_lock(lock);
+        if (!findViewState(hotel, slot, view->stamp, &count, &stays, &found, &cancellationTime)) {
+            count = -1;
+        }
+        for (int b = 0; b < count && b < maxBookings; ++b) {
+            bookings[b].checkIn = stays[b].checkIn;
+            bookings[b].checkOut = stays[b].checkOut;
+            bookings[b].occupancy = found[b].occupancy;
+            bookings[b].extraServices = found[b].extraServices;
+            bookings[b].reservationTime = found[b].reservationTime;
+            bookings[b].guestName = poolString(&hotel->guests.names, found[b].guestName);
+        }
+        pthread_mutex_unlock(lock);
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    finishOperation(METRIC_VIEW, started, count >= 0 ? HOTEL_OK : HOTEL_ROOM_NOT_FOUND);
+    return count;
+}
+
+// Function to fetch the next page of up to pageSize room numbers of a report as the view has the rooms (as
+// hotelReport, but every page of a cursor read through one view comes from the same point in time; a page
+// tests each room it passes over, so it costs more than hotelReport's when few rooms match)
+int hotelViewReport(struct HotelView* view, const struct HotelReportQuery* query, struct HotelCursor* cursor, int* roomNumbers, int pageSize) {
+    if (query->filter < HOTEL_REPORT_ALL || query->filter > HOTEL_REPORT_VACANT || pageSize <= 0
+        || cursor->state < HOTEL_CURSOR_START || cursor->state > HOTEL_CURSOR_DONE) {
+        return -1;
+    }
+    return viewReportRooms(view, query, cursor, roomNumbers, pageSize);
+}
+
+// Function to find rooms free for nights nights from checkIn that hold occupancy people
+// (returns how many there are; up to maxRooms of their numbers are copied to roomNumbers)
+int hotelFindFreeRooms(struct Hotel* hotel, int checkIn, int nights, int occupancy, int* roomNumbers, int maxRooms) {
+    return isValidStay(checkIn, nights) ? findAvailableRooms(hotel, checkIn, checkIn + nights, occupancy, roomNumbers, maxRooms) : 0;
+}
+
+// Function to find the bookings held under a guest's exact name (returns how many there are; up to maxStays are copied)
+int hotelFindGuest(struct Hotel* hotel, const char* guestName, struct GuestStay* stays, int maxStays) {
+    return findGuestBookings(hotel, guestName, stays, maxStays);
+}
+
+// Function to find the guests whose name starts with prefix, ignoring case (see searchGuestPrefix)
+int hotelSearchGuestPrefix(struct Hotel* hotel, const char* prefix, struct GuestMatch* matches, int maxMatches) {
+    return searchGuestPrefix(hotel, prefix, matches, maxMatches);
+}
+
+// Function to find the guests whose name is within maxDistance typos of text (see searchGuestFuzzy)
+int hotelSearchGuestFuzzy(struct Hotel* hotel, const char* text, int maxDistance, struct GuestMatch* matches, int maxMatches) {
+    return searchGuestFuzzy(hotel, text, maxDistance, matches, maxMatches);
+}
+
+// Function to price stays from a rate file (returns 1 if loaded, 0 if there is no such file, or minus the
+// number of the first line not understood; not safe while other threads use the hotel)
+int hotelLoadRates(struct Hotel* hotel, const char* path) {
+    return loadHotelRates(hotel, path);
+}
+
+// Function to price a stay by the hotel's rate plan (the room need not exist)
+int64_t hotelQuote(struct Hotel* hotel, int roomNumber, int checkIn, int nights, int occupancy, int extraServices) {
+    return quoteStay(&hotel->rates, roomNumber, checkIn, nights, occupancy, extraServices, NULL);
+}
+
+// Function to price a stay by the hotel's rate plan part by part, for a receipt (returns the total, as hotelQuote)
+int64_t hotelQuoteDetails(struct Hotel* hotel, int roomNumber, int checkIn, int nights, int occupancy, int extraServices, struct HotelQuote* quote) {
+    struct Quote parts;
+    quoteStay(&hotel->rates, roomNumber, checkIn, nights, occupancy, extraServices, &parts);
+    quote->firstNight = roomCharges(&hotel->rates, roomType(&hotel->rates, roomNumber), checkIn, 1);
+    quote->roomCharges = parts.roomCharges;
+    quote->extrasRate = hotel->rates.extrasRate;
+    quote->extras = parts.extras;
+    quote->surcharge = parts.surcharge;
+    quote->discount = parts.discount;
+    quote->total = parts.total;
+    return parts.total;
+}
+
+// Function to get today's date, as days since 1970-01-01 in local time
+int hotelToday() {
+    return today();
+}
+
+// Function to parse a YYYY-MM-DD date into days since 1970-01-01 (returns 0 if it is not a valid date)
+int hotelParseDate(const char* text, int* dayNumber) {
+    return parseDate(text, dayNumber);
+}
+
+// Function to format days since 1970-01-01 as YYYY-MM-DD into text (11 bytes with the terminator)
+void hotelFormatDate(int dayNumber, char* text) {
+    int year, month, day;
+    char formatted[32];
+    dateFromDay(dayNumber, &year, &month, &day);
+    snprintf(formatted, sizeof(formatted), "%04d-%02d-%02d", year, month, day);
+    memcpy(text, formatted, 10);
+    text[10] = '\0';
+}
+
+// Function to set a report query to every room, lowest number first
+void hotelInitReport(struct HotelReportQuery* query) {
+    query->filter = HOTEL_REPORT_ALL;
+    query->night = HOTEL_ANY_NIGHT;
+    query->firstRoom = INT32_MIN;
+    query->lastRoom = INT32_MAX;
+    query->guestName = NULL;
+    query->descending = 0;
+}
+
+// Function to fetch the next page of up to pageSize room numbers of a report, by room number from where cursor
+// stands (returns how many were copied, or -1 if the query or page size is not valid; the cursor is then left as
+// it was). A page costs about the same whatever the size of the hotel; rooms added meanwhile show up in later
+// pages if their number is still ahead of the cursor
+int hotelReport(struct Hotel* hotel, const struct HotelReportQuery* query, struct HotelCursor* cursor, int* roomNumbers, int pageSize) {
+    if (query->filter < HOTEL_REPORT_ALL || query->filter > HOTEL_REPORT_VACANT || pageSize <= 0
+        || cursor->state < HOTEL_CURSOR_START || cursor->state > HOTEL_CURSOR_DONE) {
+        return -1;
+    }
+    return reportRooms(hotel, query, cursor, roomNumbers, pageSize);
+}
+
+// Function to read the running totals of the whole hotel (costs the same however many rooms there are;
+// bookings are not stopped, so the parts may be a booking apart while bookings go on)
+void hotelTotals(struct Hotel* hotel, struct HotelTotals* totals) {
+    memset(totals, 0, sizeof(*totals));
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    totals->rooms = hotel->roomCount;
+    for (int i = 0; i < ROOM_LOCK_STRIPES; ++i) {
+        const union StripeTotals* stripe = &hotel->stripeTotals[i];
+        totals->reservedRooms += (int)__atomic_load_n(&stripe->sums.reservedRooms, __ATOMIC_RELAXED);
+        totals->bookings += __atomic_load_n(&stripe->sums.bookings, __ATOMIC_RELAXED);
+        totals->guests += __atomic_load_n(&stripe->sums.guests, __ATOMIC_RELAXED);
+        totals->roomNights += __atomic_load_n(&stripe->sums.roomNights, __ATOMIC_RELAXED);
+        totals->revenue += __atomic_load_n(&stripe->sums.revenue, __ATOMIC_RELAXED);
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+}
+
+// Function to read the running totals of one floor (returns 1, or 0 if no room is on that floor)
+int hotelFloorTotals(struct Hotel* hotel, int floor, struct HotelTotals* totals) {
+    memset(totals, 0, sizeof(*totals));
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    int position = findFloor(hotel, floor, 0);
+    if (position >= 0) {
+        const struct HotelTotals* kept = &hotel->floors[position].totals;
+        totals->rooms = kept->rooms;
+        totals->reservedRooms = __atomic_load_n(&kept->reservedRooms, __ATOMIC_RELAXED);
+        totals->bookings = __atomic_load_n(&kept->bookings, __ATOMIC_RELAXED);
+        totals->guests = __atomic_load_n(&kept->guests, __ATOMIC_RELAXED);
+        totals->roomNights = __atomic_load_n(&kept->roomNights, __ATOMIC_RELAXED);
+        totals->revenue = __atomic_load_n(&kept->revenue, __ATOMIC_RELAXED);
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return position >= 0;
+}
+
+// Function to copy out up to maxFloors floor numbers, lowest first (returns how many floors there are)
+int hotelListFloors(struct Hotel* hotel, int* floors, int maxFloors) {
+    pthread_rwlock_rdlock(&hotel->tableLock);
+    int count = hotel->floorCount;
+    int* sorted = (int*)malloc((count + 1) * sizeof(int));
+    for (int f = 0; f < count; ++f) {
+        sorted[f] = hotel->floors[f].floor;
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    qsort(sorted, count, sizeof(int), compareRoomNumbers);
+    for (int f = 0; f < count && f < maxFloors; ++f) {
+        floors[f] = sorted[f];
+    }
+    free(sorted);
+    return count;
+}
+
+// Function to read the running totals of one night (returns 1, or 0 if the night is outside the nights the
+// hotel tracks, NIGHT_HORIZON nights from the day it was last loaded or checkpointed; totals are then zero)
+int hotelNightTotals(struct Hotel* hotel, int night, struct HotelNightTotals* totals) {
+    memset(totals, 0, sizeof(*totals));
+    pthread_rwlock_rdlock(&hotel->tableLock); // A checkpoint may be sliding the horizon
+    int64_t offset = (int64_t)night - hotel->calendarStart;
+    if (offset >= 0 && offset < NIGHT_HORIZON) {
+        const struct HotelNightTotals* kept = &hotel->nightTotals[offset];
+        totals->bookedRooms = __atomic_load_n(&kept->bookedRooms, __ATOMIC_RELAXED);
+        totals->guests = __atomic_load_n(&kept->guests, __ATOMIC_RELAXED);
+        totals->arrivals = __atomic_load_n(&kept->arrivals, __ATOMIC_RELAXED);
+    }
+    pthread_rwlock_unlock(&hotel->tableLock);
+    return offset >= 0 && offset < NIGHT_HORIZON;
+}
+
+// Function to count the booked room-nights of the whole hotel in [from, to) (from the night bitmaps inside the
+// horizon, from every calendar outside it)
+int64_t hotelBookedNights(struct Hotel* hotel, int from, int to) {
+    return countBookedNights(hotel, from, to);
+}
+
+// Function to check the running totals against a scan of every booking (returns 1 if they agree; stops
+// bookings while it scans)
+int hotelCheckTotals(struct Hotel* hotel) {
+    return checkTotals(hotel);
+}
+
+// Function to have each thread time one operation in every from now on (1 times them all; 0 or less turns
+// the metrics off, and no more operations are counted until they are turned back on)
+void hotelSetMetricsSampling(int every) {
+    __atomic_store_n(&metricsInterval, every > 0 ? every : 0, __ATOMIC_RELAXED);
+}
+
+// Function to write the metrics of the process to a file in the Prometheus text format, for a scraper such as the
+// node exporter's textfile collector (written to a temporary file and renamed, so a reader never sees half of
+// it; returns 1 on success)
+int hotelWriteMetrics(const char* path) {
+    char temporary[1024];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    FILE* file = fopen(temporary, "w");
+    if (file == NULL) {
+        return 0;
+    }
+    int ok = writeMetrics(file);
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temporary, path) != 0) {
+        remove(temporary);
+        return 0;
+    }
+    return 1;
+}
+
+// Function to sum up the booking history by month of check-in (see summarizeHistory)
+int hotelHistorySummary(struct Hotel* hotel, int firstDay, int lastDay, int threads, struct HotelHistoryMonth* months, int maxMonths) {
+    return summarizeHistory(hotel, firstDay, lastDay, threads, months, maxMonths);
+}
+
+// Function to count the reservations and cancellations in the booking history
+int64_t hotelHistoryEvents(struct Hotel* hotel) {
+    return __atomic_load_n(&hotel->history.events, __ATOMIC_RELAXED);
+}
+
+// Function to load a snapshot into a hotel just made by hotelCreate (returns 1 if loaded, 0 if there is no such
+// file, -1 if it is not a snapshot of this build; not safe while other threads use the hotel)
+int hotelLoadSnapshot(struct Hotel* hotel, const char* path) {
+    return loadSnapshot(hotel, path);
+}
+
+// Function to open the booking history that goes with the loaded snapshot, and keep appending to it at each
+// checkpoint (returns 1 if it was loaded, 0 if a new one was started as there is no snapshot, -1 if the file does
+// not go with the snapshot so a new one was started, -2 if it cannot be opened, so the history is not saved;
+// call after hotelLoadSnapshot, not while other threads use the hotel)
+int hotelOpenHistory(struct Hotel* hotel, const char* path) {
+    int opened = openHistory(hotel, path);
+    return hotel->history.file < 0 ? -2 : opened;
+}
+
+// Function to replay a journal onto the loaded snapshot (see recoverJournal; returns the number of changes applied,
+// or -1 if the file is not a journal of this version; not safe while other threads use the hotel)
+int hotelRecoverJournal(struct Hotel* hotel, const char* path) {
+    return recoverJournal(hotel, path);
+}
+
+// Function to log every change from now on to a journal, after the records hotelRecoverJournal replayed (returns 1
+// on success, 0 if it cannot be opened or one is open already; not safe while other threads use the hotel)
+int hotelOpenJournal(struct Hotel* hotel, const char* path) {
+    struct Journal* journal = (struct Journal*)malloc(sizeof(struct Journal));
+    if (hotel->journal != NULL || journal == NULL
+        || !openJournal(journal, path, hotel->journalSequence + 1, JOURNAL_MAX_LATENCY_US)) {
+        free(journal);
+        return 0;
+    }
+    hotel->journal = journal;
+    return 1;
+}
+
+// Function to wait until every change logged so far is on disk (returns 1 once it is, or if the hotel is not
+// journaled; 0 if the journal could not be written, and every later call fails too)
+int hotelSyncJournal(struct Hotel* hotel) {
+    return hotel->journal == NULL || journalSync(hotel->journal);
+}
+
+// Function to save a snapshot and empty the journal, whose changes the snapshot now includes (see checkpointHotel;
+// returns 1 on success)
+int hotelCheckpoint(struct Hotel* hotel, const char* snapshotPath) {
+    return checkpointHotel(hotel, snapshotPath);
+}
+
+// Function to stop journaling, writing out the changes not yet synced (nothing else may be using the hotel; a
+// hotel without a journal is left as it is)
+void hotelCloseJournal(struct Hotel* hotel) {
+    if (hotel->journal != NULL) {
+        closeJournal(hotel->journal);
+        free(hotel->journal);
+        hotel->journal = NULL;
+    }
+}
+
+// Function to create a router over shardCount worker threads (see createRouter; NULL if it could not be made)
+struct HotelRouter* hotelRouterCreate(int shardCount) {
+    return createRouter(shardCount);
+}
+
+// Function to stop a router's workers and free every property behind it (NULL is ignored)
+void hotelRouterDestroy(struct HotelRouter* router) {
+    if (router != NULL) {
+        destroyRouter(router);
+    }
+}
+
+// Function to find the shard, from 0, that owns a property
+int hotelRouterShard(const struct HotelRouter* router, int propertyId) {
+    return routerShard(router, propertyId);
+}
+
+// Function to connect the calling thread to a router (see connectRouter; NULL if too many are connected)
+struct HotelRouterClient* hotelRouterConnect(struct HotelRouter* router) {
+    return connectRouter(router);
+}
+
+// Function to give a client back to its router
+void hotelRouterDisconnect(struct HotelRouterClient* client) {
+    disconnectRouter(client);
+}
+
+// Function to run requests through a router, answering each in place (see routeRequests; returns count)
+int hotelRouterRun(struct HotelRouterClient* client, struct HotelRequest* requests, int count) {
+    return routeRequests(client, requests, count);
+}
+
+// Function to name an enum HotelStatus the way batch mode and the server print it
+const char* hotelStatusName(int status) {
+    return status >= 0 && status < (int)(sizeof(hotelStatusNames) / sizeof(hotelStatusNames[0])) ? hotelStatusNames[status] : "unknown";
+}
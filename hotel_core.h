@@ -0,0 +1,244 @@
+// Reservation core: the C interface shared by every front end of the hotel (the C menu, batch mode and
+// HTTP server in Hotel_Reservation_System.c, and the C++ menu in extr/Hotel_Management_System.cpp
+// through hotel_core.hpp). Link with the hotel_core library built from hotel_core.c.
+//
+// The interface is stable: struct Hotel stays opaque, functions are only ever added, and the structures
+// below only ever gain fields at their end (HOTEL_CORE_VERSION goes up when they do). Every function is
+// safe to call from many threads at once unless its comment says otherwise. Days are counted from
+// 1970-01-01 (see hotelParseDate), and stays run from their check-in night to the night before checkOut.
+#ifndef HOTEL_CORE_H
+#define HOTEL_CORE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOTEL_CORE_VERSION 11 // Version of this interface
+#define HOTEL_MAX_NAME_LENGTH 256 // Longest guest name accepted, with its terminating NUL
+#define HOTEL_ANY_NIGHT INT32_MIN // Report night meaning "no particular night" (version 3)
+#define HOTEL_ROUTER_MAX_SHARDS 64 // Most shards one router runs (version 8)
+#define HOTEL_MAX_VIEWS 64 // Views open on one hotel at once (version 9)
+
+// Result codes of the reservation core (the print functions turn these into messages)
+enum HotelStatus {
+    HOTEL_OK = 0, // Operation succeeded
+    HOTEL_ROOM_NOT_FOUND, // No room with that number
+    HOTEL_ROOM_UNAVAILABLE, // Room already booked for some night of the stay
+    HOTEL_OVER_CAPACITY, // More people than the room holds
+    HOTEL_BOOKING_NOT_FOUND, // No booking for that guest and check-in date
+    HOTEL_INVALID_STAY, // Stay of no nights or no people, longer than ten years, or outside 1970-01-01 to 9999-12-31
+    HOTEL_INVALID_NAME, // Guest name of HOTEL_MAX_NAME_LENGTH characters or more
+    HOTEL_ROOM_EXISTS, // A room with that number was added before (version 2)
+    HOTEL_PROPERTY_NOT_FOUND, // No property with that id behind the router (version 8)
+    HOTEL_PROPERTY_EXISTS // A property with that id was added to the router before (version 8)
+};
+
+// Rooms a report lists (version 3)
+enum HotelReportFilter {
+    HOTEL_REPORT_ALL = 0, // Every room
+    HOTEL_REPORT_RESERVED, // Rooms with a booking (on the query's night, if it names one)
+    HOTEL_REPORT_VACANT // Rooms without one
+};
+
+// Where a paged report stands (version 3)
+enum HotelCursorState {
+    HOTEL_CURSOR_START = 0, // No page fetched yet
+    HOTEL_CURSOR_MORE, // More rooms follow the cursor's room number
+    HOTEL_CURSOR_DONE // The last page has been fetched
+};
+
+// Define one booking as the guest index records it
+struct GuestStay {
+    int roomNumber; // Room booked
+    int checkIn; // First night, as days since 1970-01-01
+};
+
+// Define a room as hotelFindRoom and hotelViewRoom report it (version 10)
+struct HotelRoom {
+    int roomNumber; // Room number
+    int capacity; // Most people the room holds
+    int bookingCount; // Bookings on its calendar
+    int64_t cancellationTime; // Time of its last cancellation, in seconds since the epoch (0 if none)
+};
+
+// Define one guest found by hotelSearchGuestPrefix or hotelSearchGuestFuzzy (version 11)
+struct GuestMatch {
+    const char* guestName; // Name exactly as booked (owned by the hotel, valid until hotelDestroy)
+    int bookingCount; // Number of bookings held under the name
+    int distance; // Edits between the name and the search text (0 for prefix searches)
+};
+
+// Define one booking of a room as hotelListBookings, hotelFindBooking and hotelViewBookings report it
+struct HotelBooking {
+    int checkIn; // First night, as days since 1970-01-01
+    int checkOut; // Departure day (the room is free again that night)
+    int occupancy; // Number of people staying in the room
+    int extraServices; // Extra services (1 if requested, 0 otherwise)
+    int64_t reservationTime; // Time of reservation, in seconds since the epoch
+    const char* guestName; // Guest's name (owned by the hotel, valid until hotelDestroy)
+};
+
+// Define the price of a stay part by part, as a receipt lists it (version 11)
+struct HotelQuote {
+    int64_t firstNight; // Rate of the room for the first night
+    int64_t roomCharges; // Nightly rates of the room over the stay
+    int64_t extrasRate; // Extra services charge per night
+    int64_t extras; // Extra services over the stay (0 unless they were asked for)
+    int64_t surcharge; // Occupancy surcharge
+    int64_t discount; // Length-of-stay discount, taken off the sum of the above
+    int64_t total; // What the guest pays
+};
+
+// Define which rooms a report lists and in which order (hotelInitReport sets "every room, lowest number first";
+// the conditions combine, so a guest and a night list the guest's rooms that are booked that night)
+struct HotelReportQuery {
+    int filter; // enum HotelReportFilter
+    int night; // Night the reserved or vacant filter looks at (HOTEL_ANY_NIGHT: any booking at all)
+    int firstRoom; // Lowest room number listed
+    int lastRoom; // Highest room number listed
+    const char* guestName; // Only rooms booked under this exact guest name (NULL for any guest)
+    int descending; // 1 to list from the highest room number down
+};
+
+// Define a position in a paged report (zeroed before the first page; hotelReport moves it on)
+struct HotelCursor {
+    int state; // enum HotelCursorState
+    int roomNumber; // Last room number listed so far
+};
+
+// Define the running totals of the whole hotel or of one floor, kept up to date by every booking and
+// cancellation, so reading them costs the same however many rooms there are (version 4)
+struct HotelTotals {
+    int rooms; // Rooms
+    int reservedRooms; // Rooms with at least one booking
+    int64_t bookings; // Bookings
+    int64_t guests; // People staying, added up over the bookings
+    int64_t roomNights; // Nights booked, added up over the bookings
+    int64_t revenue; // What the bookings come to under the current rate plan
+};
+
+// Define the running totals of one night (version 4)
+struct HotelNightTotals {
+    int bookedRooms; // Rooms booked for the night
+    int guests; // People staying that night
+    int arrivals; // Bookings checking in that day
+};
+
+// Define what the booking history says about the stays checking in during one month: every reservation ever
+// made for them and every cancellation, so the figures of past months stay after their guests have left (version 6)
+struct HotelHistoryMonth {
+    int year; // Year of the month
+    int month; // Month, 1 to 12
+    int64_t bookings; // Reservations made
+    int64_t cancellations; // Reservations cancelled again
+    int64_t roomNights; // Nights of the reservations not cancelled
+    int64_t guests; // People of the reservations not cancelled, added up
+    int64_t revenue; // What the reservations came to when they were made, less the cancelled ones' revenue
+    int64_t cancelledRevenue; // What the cancelled ones came to when they were cancelled
+};
+
+// Define a group booking: parties of guests packed into as few rooms as they fit in, all staying the same
+// nights under one name (version 7)
+struct HotelGroup {
+    const char* guestName; // Name every room of the group is booked under
+    int checkIn; // First night, as days since 1970-01-01
+    int nights; // Nights of the stay
+    int extraServices; // 1 if every room of the group gets the extra services
+    const int* parties; // People in each party; a party is never split between rooms, though small ones may share
+    int partyCount; // Number of parties
+};
+
+// Requests a router hands to the shard owning their property (version 8)
+enum HotelRequestType {
+    HOTEL_REQUEST_ADD_PROPERTY = 0, // Add an empty property
+    HOTEL_REQUEST_ADD_ROOM, // Add roomNumber to the property, as hotelAddRoom
+    HOTEL_REQUEST_RESERVE, // Book roomNumber, as hotelReserve
+    HOTEL_REQUEST_CANCEL, // Cancel guestName's booking of roomNumber from checkIn, as hotelCancel
+    HOTEL_REQUEST_FREE_ROOMS // Count the rooms free for nights nights from checkIn that hold occupancy people
+};
+
+// Define one request to a property behind a router, and its answer. The caller keeps it, and the name it points
+// to, until hotelRouterRun returns; only the fields its type uses are read (version 8)
+struct HotelRequest {
+    int type; // enum HotelRequestType
+    int propertyId; // Property the request is for (any number)
+    int roomNumber; // Room added, booked or cancelled
+    int checkIn; // First night, as days since 1970-01-01
+    int nights; // Nights of the stay
+    int occupancy; // People staying
+    int extraServices; // 1 if extra services are requested
+    const char* guestName; // Guest booking or cancelling
+    int status; // Answer: an enum HotelStatus, or -1 for an unknown type
+    int freeRooms; // Answer of HOTEL_REQUEST_FREE_ROOMS
+};
+
+struct Hotel; // Opaque: only hotel_core.c and the front ends built with it see inside
+struct HotelRouter; // Opaque: properties sharded over worker threads (version 8)
+struct HotelRouterClient; // Opaque: one thread's connection to a router (version 8)
+struct HotelView; // Opaque: the bookings of a hotel as they stood when it was opened (version 9)
+
+// Function prototypes
+int hotelCoreVersion();
+struct Hotel* hotelCreate();
+void hotelDestroy(struct Hotel* hotel);
+int hotelAddRoom(struct Hotel* hotel, int roomNumber);
+int hotelAddRooms(struct Hotel* hotel, const int* roomNumbers, int count);
+int hotelAddRoomRange(struct Hotel* hotel, int firstFloor, int lastFloor, int firstRoom, int lastRoom);
+int hotelImportRooms(struct Hotel* hotel, const char* path, int* listed, int* added);
+int hotelReserve(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn, int nights, int extraServices, int occupancy);
+int hotelCancel(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn);
+int hotelRoomCount(struct Hotel* hotel);
+int hotelListRooms(struct Hotel* hotel, int first, int* roomNumbers, int maxRooms);
+int hotelListBookings(struct Hotel* hotel, int roomNumber, struct HotelBooking* bookings, int maxBookings);
+int hotelFindRoom(struct Hotel* hotel, int roomNumber, struct HotelRoom* room);
+int hotelFindBooking(struct Hotel* hotel, int roomNumber, int checkIn, struct HotelBooking* booking);
+int hotelFindFreeRooms(struct Hotel* hotel, int checkIn, int nights, int occupancy, int* roomNumbers, int maxRooms);
+int hotelFindGuest(struct Hotel* hotel, const char* guestName, struct GuestStay* stays, int maxStays);
+int hotelSearchGuestPrefix(struct Hotel* hotel, const char* prefix, struct GuestMatch* matches, int maxMatches);
+int hotelSearchGuestFuzzy(struct Hotel* hotel, const char* text, int maxDistance, struct GuestMatch* matches, int maxMatches);
+int hotelLoadRates(struct Hotel* hotel, const char* path);
+int64_t hotelQuote(struct Hotel* hotel, int roomNumber, int checkIn, int nights, int occupancy, int extraServices);
+int64_t hotelQuoteDetails(struct Hotel* hotel, int roomNumber, int checkIn, int nights, int occupancy, int extraServices, struct HotelQuote* quote);
+int hotelToday();
+int hotelParseDate(const char* text, int* dayNumber);
+void hotelFormatDate(int dayNumber, char* text);
+const char* hotelStatusName(int status);
+void hotelInitReport(struct HotelReportQuery* query);
+int hotelReport(struct Hotel* hotel, const struct HotelReportQuery* query, struct HotelCursor* cursor, int* roomNumbers, int pageSize);
+void hotelTotals(struct Hotel* hotel, struct HotelTotals* totals);
+int hotelFloorTotals(struct Hotel* hotel, int floor, struct HotelTotals* totals);
+int hotelListFloors(struct Hotel* hotel, int* floors, int maxFloors);
+int hotelNightTotals(struct Hotel* hotel, int night, struct HotelNightTotals* totals);
+int64_t hotelBookedNights(struct Hotel* hotel, int from, int to);
+int hotelCheckTotals(struct Hotel* hotel);
+void hotelSetMetricsSampling(int every);
+int hotelWriteMetrics(const char* path);
+int hotelHistorySummary(struct Hotel* hotel, int firstDay, int lastDay, int threads, struct HotelHistoryMonth* months, int maxMonths);
+int64_t hotelHistoryEvents(struct Hotel* hotel);
+int hotelReserveGroup(struct Hotel* hotel, const struct HotelGroup* group, int* partyRooms);
+struct HotelRouter* hotelRouterCreate(int shardCount);
+void hotelRouterDestroy(struct HotelRouter* router);
+int hotelRouterShard(const struct HotelRouter* router, int propertyId);
+struct HotelRouterClient* hotelRouterConnect(struct HotelRouter* router);
+void hotelRouterDisconnect(struct HotelRouterClient* client);
+int hotelRouterRun(struct HotelRouterClient* client, struct HotelRequest* requests, int count);
+struct HotelView* hotelOpenView(struct Hotel* hotel);
+void hotelCloseView(struct HotelView* view);
+int hotelViewBookings(struct HotelView* view, int roomNumber, struct HotelBooking* bookings, int maxBookings);
+int hotelViewReport(struct HotelView* view, const struct HotelReportQuery* query, struct HotelCursor* cursor, int* roomNumbers, int pageSize);
+int hotelViewRoom(struct HotelView* view, int roomNumber, struct HotelRoom* room);
+int hotelLoadSnapshot(struct Hotel* hotel, const char* path);
+int hotelOpenHistory(struct Hotel* hotel, const char* path);
+int hotelRecoverJournal(struct Hotel* hotel, const char* path);
+int hotelOpenJournal(struct Hotel* hotel, const char* path);
+int hotelSyncJournal(struct Hotel* hotel);
+int hotelCheckpoint(struct Hotel* hotel, const char* snapshotPath);
+void hotelCloseJournal(struct Hotel* hotel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
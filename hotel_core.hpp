@@ -0,0 +1,257 @@
+// C++ face of the reservation core (hotel_core.h): HotelCore owns one struct Hotel and frees it when it goes,
+// and hands results back in vectors instead of caller-sized arrays. It adds no state of its own, so it is as
+// safe to share between threads as the C interface underneath. A HotelCore can be moved but not copied.
+#ifndef HOTEL_CORE_HPP
+#define HOTEL_CORE_HPP
+
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "hotel_core.h"
+
+// One booking of a room, with the guest's name copied out of the hotel
+struct CoreBooking {
+    int checkIn; // First night, as days since 1970-01-01
+    int checkOut; // Departure day
+    int occupancy;
+    bool extraServices;
+    int64_t reservationTime; // Seconds since the epoch
+    std::string guestName;
+};
+
+// Copies bookings the C interface reported, guest names and all
+inline std::vector<CoreBooking> copyBookings(const std::vector<HotelBooking>& found, int count) {
+    std::vector<CoreBooking> result;
+    for (int b = 0; b < count; ++b) {
+        const HotelBooking& booking = found[b];
+        result.push_back(CoreBooking{booking.checkIn, booking.checkOut, booking.occupancy, booking.extraServices != 0,
+                                     booking.reservationTime, booking.guestName});
+    }
+    return result;
+}
+
+class HotelCore {
+public:
+    HotelCore() : hotel(hotelCreate()) {
+        if (hotel == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+    ~HotelCore() { hotelDestroy(hotel); }
+    HotelCore(const HotelCore&) = delete;
+    HotelCore& operator=(const HotelCore&) = delete;
+    HotelCore(HotelCore&& other) noexcept : hotel(other.hotel) { other.hotel = nullptr; }
+    HotelCore& operator=(HotelCore&& other) noexcept {
+        if (this != &other) {
+            hotelDestroy(hotel);
+            hotel = other.hotel;
+            other.hotel = nullptr;
+        }
+        return *this;
+    }
+
+    struct Hotel* get() const { return hotel; } // For calls the wrapper does not cover
+    int size() const { return hotelRoomCount(hotel); }
+    bool hasRoom(int roomNumber) const { return hotelListBookings(hotel, roomNumber, nullptr, 0) >= 0; }
+
+    HotelStatus addRoom(int roomNumber) { return (HotelStatus)hotelAddRoom(hotel, roomNumber); }
+    // Bulk loading: each returns the number of rooms added (numbers already in the hotel are skipped)
+    int addRooms(const std::vector<int>& roomNumbers) {
+        return roomNumbers.empty() ? 0 : hotelAddRooms(hotel, &roomNumbers[0], (int)roomNumbers.size());
+    }
+    int addRoomRange(int firstFloor, int lastFloor, int firstRoom, int lastRoom) {
+        return hotelAddRoomRange(hotel, firstFloor, lastFloor, firstRoom, lastRoom);
+    }
+    int importRooms(const std::string& path) { // -1 if the file is missing or has a bad line (then nothing is added)
+        int listed = 0, added = 0;
+        return hotelImportRooms(hotel, path.c_str(), &listed, &added) == 1 ? added : -1;
+    }
+    HotelStatus reserve(int roomNumber, const std::string& guestName, int checkIn, int nights, bool extraServices, int occupancy) {
+        return (HotelStatus)hotelReserve(hotel, roomNumber, guestName.c_str(), checkIn, nights, extraServices, occupancy);
+    }
+    HotelStatus cancel(int roomNumber, const std::string& guestName, int checkIn) {
+        return (HotelStatus)hotelCancel(hotel, roomNumber, guestName.c_str(), checkIn);
+    }
+    // Rooms for a whole group, all or none (see hotelReserveGroup); partyRooms receives the room of each party
+    HotelStatus reserveGroup(const std::string& guestName, int checkIn, int nights, bool extraServices,
+                             const std::vector<int>& parties, std::vector<int>* partyRooms = nullptr) {
+        std::vector<int> rooms(parties.size() + 1);
+        HotelGroup group = {guestName.c_str(), checkIn, nights, extraServices, parties.empty() ? nullptr : &parties[0],
+                            (int)parties.size()};
+        HotelStatus status = (HotelStatus)hotelReserveGroup(hotel, &group, &rooms[0]);
+        if (partyRooms != nullptr) {
+            rooms.resize(status == HOTEL_OK ? parties.size() : 0);
+            partyRooms->swap(rooms);
+        }
+        return status;
+    }
+    bool loadRates(const std::string& path) { return hotelLoadRates(hotel, path.c_str()) == 1; }
+    int64_t quote(int roomNumber, int checkIn, int nights, int occupancy, bool extraServices) const {
+        return hotelQuote(hotel, roomNumber, checkIn, nights, occupancy, extraServices);
+    }
+
+    // Room numbers, in the order the rooms were added
+    std::vector<int> rooms() const {
+        std::vector<int> numbers(size());
+        numbers.resize(numbers.empty() ? 0 : hotelListRooms(hotel, 0, &numbers[0], (int)numbers.size()));
+        return numbers;
+    }
+
+    // Bookings of a room by check-in date (none if there is no such room)
+    std::vector<CoreBooking> bookings(int roomNumber) const {
+        std::vector<HotelBooking> found;
+        int count = hotelListBookings(hotel, roomNumber, nullptr, 0);
+        while (count > (int)found.size()) { // Asked again if bookings were added in between
+            found.resize(count);
+            count = hotelListBookings(hotel, roomNumber, &found[0], count);
+        }
+        return copyBookings(found, count);
+    }
+
+    // Bookings held under a guest's exact name, by room and check-in date
+    std::vector<GuestStay> guestBookings(const std::string& guestName) const {
+        std::vector<GuestStay> stays;
+        int count = hotelFindGuest(hotel, guestName.c_str(), nullptr, 0);
+        while (count > (int)stays.size()) {
+            stays.resize(count);
+            count = hotelFindGuest(hotel, guestName.c_str(), &stays[0], count);
+        }
+        stays.resize(count);
+        return stays;
+    }
+
+    // Rooms free for nights nights from checkIn that hold occupancy people
+    std::vector<int> freeRooms(int checkIn, int nights, int occupancy) const {
+        std::vector<int> numbers;
+        int count = hotelFindFreeRooms(hotel, checkIn, nights, occupancy, nullptr, 0);
+        while (count > (int)numbers.size()) {
+            numbers.resize(count);
+            count = hotelFindFreeRooms(hotel, checkIn, nights, occupancy, &numbers[0], count);
+        }
+        numbers.resize(count);
+        return numbers;
+    }
+
+    // The next page of a report: up to pageSize room numbers matching query, by room number from where cursor
+    // stands (start from a zeroed cursor; the page is empty once cursor.state is HOTEL_CURSOR_DONE)
+    std::vector<int> report(const HotelReportQuery& query, HotelCursor& cursor, int pageSize) const {
+        std::vector<int> numbers(pageSize > 0 ? pageSize : 0);
+        int count = numbers.empty() ? 0 : hotelReport(hotel, &query, &cursor, &numbers[0], pageSize);
+        numbers.resize(count > 0 ? count : 0);
+        return numbers;
+    }
+
+    // Running totals of the whole hotel, of one floor (all zero if no room is on it) and of one night
+    HotelTotals totals() const {
+        HotelTotals totals;
+        hotelTotals(hotel, &totals);
+        return totals;
+    }
+    HotelTotals floorTotals(int floor) const {
+        HotelTotals totals;
+        hotelFloorTotals(hotel, floor, &totals);
+        return totals;
+    }
+    HotelNightTotals nightTotals(int night) const {
+        HotelNightTotals totals;
+        hotelNightTotals(hotel, night, &totals);
+        return totals;
+    }
+
+    // Booking history by month of check-in, from the month of firstDay to that of lastDay (empty if the range is
+    // not valid), and the number of reservations and cancellations it holds
+    std::vector<HotelHistoryMonth> history(int firstDay, int lastDay, int threads = 1) const {
+        char first[16], last[16];
+        hotelFormatDate(firstDay, first);
+        hotelFormatDate(lastDay, last);
+        int span = (std::atoi(last) - std::atoi(first)) * 12 + std::atoi(last + 5) - std::atoi(first + 5) + 1;
+        std::vector<HotelHistoryMonth> months(span > 0 && lastDay >= firstDay ? span : 1); // Sized from the dates, so one scan does
+        int count = hotelHistorySummary(hotel, firstDay, lastDay, threads, &months[0], (int)months.size());
+        months.resize(count > 0 ? count : 0);
+        return months;
+    }
+    int64_t historyEvents() const { return hotelHistoryEvents(hotel); }
+
+    // Metrics of every hotel in the process, in the Prometheus text format (see hotelWriteMetrics)
+    static bool writeMetrics(const std::string& path) { return hotelWriteMetrics(path.c_str()) == 1; }
+
+private:
+    struct Hotel* hotel; // nullptr once moved from
+};
+
+// The bookings of a hotel as they stood when the view was made (see hotelOpenView), for reports that must add up
+// while others keep booking; closed when it goes, and not to outlive its HotelCore
+class HotelCoreView {
+public:
+    explicit HotelCoreView(const HotelCore& hotel) : view(hotelOpenView(hotel.get())) {
+        if (view == nullptr) { // HOTEL_MAX_VIEWS are open already; not a lack of memory
+            throw std::runtime_error("hotel views: all HOTEL_MAX_VIEWS in use");
+        }
+    }
+    ~HotelCoreView() { hotelCloseView(view); }
+    HotelCoreView(const HotelCoreView&) = delete;
+    HotelCoreView& operator=(const HotelCoreView&) = delete;
+
+    // Bookings of a room by check-in date (none if there was no such room)
+    std::vector<CoreBooking> bookings(int roomNumber) const {
+        std::vector<HotelBooking> found;
+        int count = hotelViewBookings(view, roomNumber, nullptr, 0);
+        if (count > 0) { // The view does not change, so one call sizes the next
+            found.resize(count);
+            hotelViewBookings(view, roomNumber, &found[0], count);
+        }
+        return copyBookings(found, count);
+    }
+
+    // The next page of a report as the view has the rooms: up to pageSize room numbers matching query, by room
+    // number from where cursor stands (every page read through one view comes from the same point in time)
+    std::vector<int> report(const HotelReportQuery& query, HotelCursor& cursor, int pageSize) const {
+        std::vector<int> numbers(pageSize > 0 ? pageSize : 0);
+        int count = numbers.empty() ? 0 : hotelViewReport(view, &query, &cursor, &numbers[0], pageSize);
+        numbers.resize(count > 0 ? count : 0);
+        return numbers;
+    }
+
+private:
+    struct HotelView* view;
+};
+
+// Properties sharded over worker threads (see hotelRouterCreate), stopped and freed when it goes. Each thread
+// sending requests connects a client of its own and hands it to run()
+class HotelCoreRouter {
+public:
+    explicit HotelCoreRouter(int shards) : router(hotelRouterCreate(checkShards(shards))) {
+        if (router == nullptr) { // The shard count is fine, so a worker thread did not start
+            throw std::runtime_error("hotel router: cannot start the worker threads");
+        }
+    }
+    ~HotelCoreRouter() { hotelRouterDestroy(router); }
+    HotelCoreRouter(const HotelCoreRouter&) = delete;
+    HotelCoreRouter& operator=(const HotelCoreRouter&) = delete;
+
+    struct HotelRouter* get() const { return router; }
+    int shard(int propertyId) const { return hotelRouterShard(router, propertyId); }
+    HotelRouterClient* connect() { return hotelRouterConnect(router); } // nullptr if too many are connected
+    static void disconnect(HotelRouterClient* client) { hotelRouterDisconnect(client); }
+    // Answers every request in place, in order for each property
+    static void run(HotelRouterClient* client, std::vector<HotelRequest>& requests) {
+        if (!requests.empty()) {
+            hotelRouterRun(client, &requests[0], (int)requests.size());
+        }
+    }
+
+private:
+    // Passes on a shard count hotelRouterCreate takes, and throws std::invalid_argument for any other
+    static int checkShards(int shards) {
+        if (shards < 1 || shards > HOTEL_ROUTER_MAX_SHARDS) {
+            throw std::invalid_argument("hotel router: shards must be 1 to HOTEL_ROUTER_MAX_SHARDS");
+        }
+        return shards;
+    }
+
+    struct HotelRouter* router;
+};
+
+#endif
@@ -0,0 +1,673 @@
+// Internals of the reservation core (hotel_core.c), for the front ends and benchmarks kept in this tree
+// Everything here changes with the snapshot format; programs built outside the tree use hotel_core.h alone.
+#ifndef HOTEL_INTERNAL_H
+#define HOTEL_INTERNAL_H
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L // Expose fileno, fsync and mmap under a strict -std=c99 build
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "hotel_core.h"
+
+#define MAX_NAME_LENGTH HOTEL_MAX_NAME_LENGTH // Longest guest name accepted, with its terminating NUL (names are stored in the name pool)
+#define PRICE_PER_NIGHT 5000 // Nightly rate of the default rate plan
+#define EXTRA_SERVICES_COST 1000 // Nightly extra services charge of the default rate plan
+#define RATES_FILE "hotel.rates" // Rate plan read on startup; without one every night costs PRICE_PER_NIGHT
+#define RATE_TABLE_DAYS 1464 // Nights priced from the compiled tables, from a year before the plan is loaded (others are priced rule by rule)
+#define RATE_MAX_TYPES 16 // Room types a rate plan can name
+#define RATE_MAX_RULES 64 // Room ranges, and seasons, a rate plan can list
+#define RATE_MAX_DISCOUNT_NIGHTS 60 // Stays this long or longer all get the same length-of-stay discount
+#define RATE_MAX_AMOUNT 1000000000LL // Largest amount a rate file may give, so a night fits in int64_t many times over
+#define QUOTE_BLOCK 256 // Stays priced per pass of quoteStays
+#define STAY_FIRST_DAY 0 // Earliest check-in accepted: 1970-01-01
+#define STAY_LAST_DAY 2932896 // Last night a stay may cover: 9999-12-31, the last day a YYYY-MM-DD date can name
+#define STAY_MAX_NIGHTS 3660 // Longest stay accepted, about ten years
+#define DEFAULT_ROOM_CAPACITY 4 // Number of people a newly added room holds
+#define INDEX_INITIAL_CAPACITY 64 // Initial number of slots in the room index (must be a power of two)
+#define TABLE_INITIAL_CAPACITY 64 // Initial number of rooms the room table has space for
+#define ROOM_RANGE_MAX (1 << 24) // Most rooms one floor range or room file may list
+#define FLOOR_NUMBERING 100 // A room not added with its floor is on floor roomNumber / FLOOR_NUMBERING
+#define FLOOR_INITIAL_CAPACITY 16 // Initial number of floors the floor totals have space for
+#define CALENDAR_INITIAL_CAPACITY 4 // Initial number of bookings a room calendar has space for
+#define ROOM_LOCK_STRIPES 256 // Locks shared out among the rooms by room number (must be a power of two)
+#define NIGHT_HORIZON 366 // Nights tracked in the night bitmaps, from the day the hotel was last loaded or checkpointed
+#define NIGHT_WORDS ((NIGHT_HORIZON + 63) / 64) // 64-bit words per room in the night bitmaps
+#define SCAN_CHUNK_ROOMS 4096 // Rooms scanned per call of a bitmap kernel (must be a multiple of 64)
+#define GROUP_RETRIES 4 // Times a group booking picks its rooms again if bookings made meanwhile took one of them
+#define GUEST_INDEX_INITIAL_CAPACITY 1024 // Initial slots in the guest name index (must be a power of two)
+#define GUEST_TRIGRAM_INITIAL_CAPACITY 4096 // Initial slots in the guest trigram table (must be a power of two)
+#define GUEST_MAX_DISTANCE 2 // Typos forgiven by a fuzzy guest search
+#define GUEST_MAX_LISTED 20 // Guests or bookings listed by one guest search in the menu
+#define NAME_CHUNK_BITS 20 // Name pool chunks hold 1 << this many bytes; a handle is chunk << NAME_CHUNK_BITS | offset
+#define NAME_MAX_CHUNKS 4096 // Chunks a name pool can hold (4 GB of names, all a 32-bit handle reaches)
+#define NAME_NONE 0xffffffffu // Handle meaning "not in the pool yet" (never handed out)
+#define LOCAL_TIME_BLOCK 3600 // Seconds one cached UTC offset covers (see localSeconds)
+#define SNAPSHOT_FILE "hotel.snapshot" // Where the hotel is saved on exit and loaded on startup
+#define SNAPSHOT_MAGIC "HOTELSNP" // First eight bytes of every snapshot file
+#define SNAPSHOT_VERSION 6 // Bumped whenever the snapshot layout changes
+#define SNAPSHOT_ALIGNMENT 64 // Every section of a snapshot starts on a multiple of this offset
+#define JOURNAL_FILE "hotel.journal" // Changes made since the last snapshot, replayed on startup
+#define JOURNAL_MAGIC "HOTELJNL" // First eight bytes of every journal file
+#define JOURNAL_VERSION 3 // Bumped whenever the journal record layout changes
+#define JOURNAL_MAX_LATENCY_US 1000 // Longest a commit waits for other writers to share its sync
+#define JOURNAL_BUFFER_SIZE 65536 // Initial size of the journal's in-memory record buffers
+#define HISTORY_FILE "hotel.history" // Every reservation and cancellation ever made, appended to at each checkpoint
+#define HISTORY_MAGIC "HOTELHST" // First eight bytes of every history file
+#define HISTORY_VERSION 1 // Bumped whenever the history file layout changes
+#define HISTORY_BLOCK_EVENTS 65536 // Events packed into one block of the booking history
+#define HISTORY_WIDE_BITS 57 // Widest packed value one unaligned 64-bit load always holds; wider columns are stored whole
+#define HISTORY_SCAN_CHUNK 512 // Events a history scan unpacks at a time, so its unpacked columns stay in the L1 cache
+#define HISTORY_MAX_MONTHS 1200 // Months one history summary may span (a hundred years)
+#define HISTORY_MAX_THREADS 64 // Threads one history summary may use
+#define METRICS_FILE "hotel.prom" // Where the front ends write the metrics, in the Prometheus text format
+#define METRICS_SAMPLE_INTERVAL 64 // Each thread times one in this many operations (every one is counted)
+#define METRICS_STATUSES 10 // Results counted per operation: one per enum HotelStatus
+#define LATENCY_SUB_BITS 4 // Latency buckets per power of two are 1 << this many, so a bucket is at most 1/16 wide
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS (LATENCY_SUB_BUCKETS * 33) // Latency buckets, from 0 to 2^36 ns (about 69 s); longer goes in the last
+#define PROBE_BUCKETS 16 // Room index lookups counted by slots probed, 1 to 15 and 16 or more
+#define ROUTER_RING_SIZE 256 // Requests one client can have waiting at one shard (must be a power of two)
+#define ROUTER_MAX_CLIENTS 64 // Clients connected to one router at once
+#define ROUTER_SPIN_ROUNDS 64 // Empty polls before a waiting thread starts giving the processor away
+#define ROUTER_YIELD_ROUNDS 4096 // Empty polls, after those, before an idle worker sleeps between polls
+#define ROUTER_REST_NANOSECONDS 50000 // Sleep of an idle worker between polls (the most a request waits to be seen)
+#define VIEW_MAX_OPEN HOTEL_MAX_VIEWS // Read views open on one hotel at once
+
+// Kinds of change recorded in the journal
+enum JournalRecordType {
+    JOURNAL_ADD_ROOM = 1, // addRoom
+    JOURNAL_RESERVE, // reserveRoom
+    JOURNAL_CANCEL, // releaseRoom
+    JOURNAL_GROUP // reserveGroup: the next duration records are the group's bookings, replayed all or none
+};
+
+// Define the nights a booking occupies: [checkIn, checkOut) as days since 1970-01-01
+struct Stay {
+    int checkIn; // First night of the stay
+    int checkOut; // Departure day (the room is free again that night)
+};
+
+// Define the guest data of a booking
+struct Booking {
+    int64_t reservationTime; // Time of reservation, in seconds since the epoch (turned into local time only to print it)
+    uint32_t guestName; // Guest's name, as a handle into the hotel's name pool (see poolString)
+    int extraServices; // Extra services (1 if requested, 0 otherwise)
+    int occupancy; // Number of people staying in the room
+};
+
+// Define the frequently scanned ("hot") part of a room in the hotel
+struct Room {
+    int roomNumber; // Room number
+    int isReserved; // Reservation status (1 if the room has any booking, 0 otherwise)
+    int capacity; // Maximum number of people staying in the room
+    int bookingCount; // Number of bookings on the room's calendar
+    struct Stay* stays; // Calendar of the room, sorted by check-in and never overlapping
+};
+
+// Define the rarely read ("cold") part of a room, stored in a parallel array
+struct RoomDetails {
+    struct Booking* bookings; // Guest data of each stay, same position as in the calendar
+    int bookingCapacity; // Number of bookings the calendar arrays have space for
+    int floor; // Floor the room is on, for the floor totals
+    int64_t cancellationTime; // Time of the last cancellation, in seconds since the epoch (0 if none)
+};
+
+// Define a slot in the room index
+struct IndexSlot {
+    int roomNumber; // Room number stored in this slot
+    int slot; // Position of the room in the room table (-1 if the slot is empty)
+};
+
+// Define an open-addressing hash index from room number to room table position
+struct RoomIndex {
+    struct IndexSlot* slots; // Slot array, probed linearly
+    int capacity; // Number of slots (always a power of two)
+    int count; // Number of occupied slots
+};
+
+// Define the rooms in room-number order, with a bitmap of the ones that have bookings, so a report visits the
+// rooms it lists rather than the whole table (rooms added below the highest number wait for the next report to
+// sort them in; bookings update the bits under their room lock alone, so every word is changed atomically)
+struct RoomOrder {
+    int* slots; // Table slot of the room at each position, by ascending room number
+    int* positions; // Position of the room in each table slot (-1 until it is sorted in)
+    uint64_t* reserved; // Bit p set if the room at position p has a booking
+    uint64_t* summary; // Bit w set if word w of reserved may have a bit set (never clear while it has one)
+    int count; // Rooms in order; below roomCount until the next report sorts the rest in
+};
+
+// Define an append-only pool of NUL-terminated names in fixed-size chunks; chunks never move and are
+// only freed with the pool, so a handle (chunk << NAME_CHUNK_BITS | offset) can be read without a lock
+struct NamePool {
+    char** chunks; // NAME_MAX_CHUNKS chunk pointers, allocated once so the array never moves either
+    uint32_t* sizes; // Bytes used in each chunk
+    int chunkCount; // Number of chunks in use; names are appended to the last one
+    int loadedChunks; // Chunks from 0 up to this one point into a loaded snapshot and are not freed here
+    uint64_t bytes; // Bytes of names stored, terminators included
+};
+
+// Define a guest: a name interned once, plus the bookings currently held under it
+struct Guest {
+    uint32_t name; // Handle of the name exactly as booked, in the index's name pool
+    int stayCount; // Number of bookings held
+    int stayCapacity; // Number of bookings the list has space for (1: held inline, no allocation)
+    union {
+        struct GuestStay* stays; // Bookings held, in no particular order (stayCapacity > 1)
+        struct GuestStay stay; // The only booking (stayCapacity == 1), as most guests have
+    } list;
+};
+
+// Define a slot of the guest name index
+struct GuestSlot {
+    uint32_t hash; // hashGuestName of the guest, so most mismatches never touch the guest array
+    int guest; // Guest id (-1 if the slot is empty)
+};
+
+// Define the posting list of one name trigram: the guests whose folded name contains it
+struct TrigramSlot {
+    uint32_t trigram; // Three folded characters plus bit 24 (0 if the slot is empty)
+    int count; // Number of guests in the list
+    int capacity; // Number of guests the list has space for
+    int* guests; // Guest ids, in the order the names were interned
+};
+
+// Define the guest index: every name ever booked, interned in a hash table, with a name-ordered
+// table for type-ahead and trigram posting lists for typo-tolerant search (one lock guards it all)
+struct GuestIndex {
+    struct NamePool names; // Each distinct name stored once; bookings hold handles into it
+    struct Guest* guests; // Interned guests; the id of a guest is its position here
+    int guestCount; // Number of interned guests
+    int guestCapacity; // Number of guests the array has space for
+    struct GuestSlot* slots; // Open-addressing hash table of guest ids by exact name
+    int slotCapacity; // Number of slots (always a power of two)
+    int* sorted; // Guest ids ordered by folded name; ids from sortedCount on are not merged in yet
+    int sortedCount; // Number of ids in sorted
+    struct TrigramSlot* trigrams; // Open-addressing hash table of trigram posting lists
+    int trigramCapacity; // Number of trigram slots (always a power of two)
+    int trigramCount; // Number of trigrams in use
+    int trigramGuests; // Guests whose trigrams are in the posting lists (ids below this)
+    int* scores; // Search scratch: trigrams each guest shares with the text (all 0 between searches)
+    int* touched; // Search scratch: guests with a non-zero score
+    pthread_mutex_t lock; // Taken inside a room lock when bookings change, alone by searches
+};
+
+// Define a range of room numbers that are all of one room type
+struct RateRange {
+    int firstRoom; // First room number of the range
+    int lastRoom; // Last room number of the range
+    int type; // Room type, an index into the plan's type tables
+};
+
+// Define a season: nights from firstDay to lastDay cost percent of the usual rate
+struct RateSeason {
+    int firstDay; // First night of the season, as days since 1970-01-01
+    int lastDay; // Last night of the season
+    int percent; // Share of the usual rate charged, in percent
+};
+
+// Define a rate plan: the rules read from a rate file, and the tables compiled from them so that
+// the room charges of any stay are a difference of two prefix sums instead of a loop over its nights
+struct RatePlan {
+    char typeNames[RATE_MAX_TYPES][16]; // Name of each room type (type 0 is "standard", for unlisted rooms)
+    int64_t typeRates[RATE_MAX_TYPES]; // Nightly rate of each room type
+    int typeCount; // Number of room types
+    struct RateRange ranges[RATE_MAX_RULES]; // Room types by room number, sorted by first room, never overlapping
+    int rangeCount; // Number of ranges
+    struct RateSeason seasons[RATE_MAX_RULES]; // Seasonal rates; where seasons overlap the one listed last applies
+    int seasonCount; // Number of seasons
+    int weekendPercent; // Share of the rate charged for Friday and Saturday nights, in percent
+    int64_t extrasRate; // Extra services charge per night
+    int surchargeFrom; // Occupancy from which each further person pays a surcharge
+    int64_t surchargeRate; // Surcharge per extra person per night
+    int discounts[RATE_MAX_DISCOUNT_NIGHTS + 1]; // Percent off the stay by number of nights (the last entry for longer stays)
+    int firstDay; // Night priced by entry 0 of the tables
+    int64_t* prefix; // prefix[type * (RATE_TABLE_DAYS + 1) + n]: room charges of the n nights from firstDay
+};
+
+// Define the price of one stay, part by part
+struct Quote {
+    int64_t roomCharges; // Nightly rates of the room over the stay
+    int64_t extras; // Extra services
+    int64_t surcharge; // Occupancy surcharge
+    int64_t discount; // Length-of-stay discount, taken off the sum of the above
+    int64_t total; // What the guest pays
+};
+
+// Define one stay to be priced by quoteStays
+struct QuoteRequest {
+    int roomNumber; // Room, which decides the room type
+    int checkIn; // First night, as days since 1970-01-01
+    int nights; // Number of nights
+    int occupancy; // Number of people
+    int extraServices; // Extra services requested (1) or not (0)
+};
+
+// Columns of the booking history
+enum HistoryColumn {
+    HISTORY_TIME, // When the event happened, in seconds since the epoch
+    HISTORY_KIND, // enum HistoryKind
+    HISTORY_ROOM, // Room, as a code of the history's room dictionary
+    HISTORY_GUEST, // Guest, as a code of the history's guest dictionary
+    HISTORY_CHECK_IN, // First night of the stay, as days since 1970-01-01
+    HISTORY_NIGHTS, // Nights of the stay
+    HISTORY_OCCUPANCY, // Number of people staying
+    HISTORY_EXTRAS, // Extra services (1 if requested, 0 otherwise)
+    HISTORY_AMOUNT, // What the stay came to under the rate plan of the time
+    HISTORY_COLUMNS // Number of columns
+};
+
+// Kinds of event in the booking history
+enum HistoryKind {
+    HISTORY_RESERVED, // A booking was made
+    HISTORY_CANCELLED // A booking was cancelled (the event repeats the stay it took away)
+};
+
+// Define a block of the booking history: up to HISTORY_BLOCK_EVENTS events, each column bit-packed on its own
+// as the difference from its smallest value in the block, so a scan unpacks only the columns it reads and skips
+// blocks whose check-in dates are all outside its range (written to the history file exactly as it is here)
+struct HistoryBlock {
+    int32_t count; // Events in the block
+    uint8_t widths[HISTORY_COLUMNS]; // Bits per packed value of each column (0 if all are alike, 64 if stored whole)
+    int64_t lows[HISTORY_COLUMNS]; // Smallest value of each column
+    int64_t highs[HISTORY_COLUMNS]; // Largest value of each column
+    uint64_t offsets[HISTORY_COLUMNS]; // Where each packed column starts in data
+    uint64_t size; // Bytes of data, 8 spare bytes after each column included
+    uint8_t* data; // Packed columns (NULL in the file; pointed into the mapped file on load)
+};
+
+// Define the booking history: every reservation and cancellation, in the order they happened. Full blocks are
+// packed and never change; the newest events wait unpacked in tail, and a tail that fills up is packed by a sealer
+// thread, not by the booking that filled it. Rooms and guests are stored as codes of dictionaries that only grow,
+// so the history keeps the names of guests the hotel itself has long forgotten
+struct BookingHistory {
+    struct HistoryBlock* blocks; // Packed blocks, oldest first
+    int blockCount; // Number of blocks
+    int blockCapacity; // Number of blocks the array has space for
+    int64_t* tail[HISTORY_COLUMNS]; // Events not packed yet, column by column (allocated on the first event)
+    int tailCount; // Events in tail
+    int64_t events; // Events recorded, packed or not
+    int* rooms; // Room number of each room code
+    int roomCount; // Number of room codes
+    int roomCapacity; // Number of room codes the array has space for
+    struct RoomIndex roomCodes; // Code of each room number
+    struct NamePool names; // Name of each guest code, stored once
+    uint32_t* guests; // Handle in names of each guest code
+    int guestCount; // Number of guest codes
+    int guestCapacity; // Number of guest codes the array has space for
+    struct GuestSlot* guestSlots; // Open-addressing hash table of guest codes by name
+    int guestSlotCapacity; // Number of slots (always a power of two)
+    int file; // History file, open for appending (-1 if the history is only kept in memory)
+    uint64_t fileSize; // Bytes of the file holding whole segments (the snapshot records it)
+    int savedBlocks; // Blocks already in the file
+    int savedRooms; // Room codes already in the file
+    int savedGuests; // Guest codes already in the file
+    void* mapping; // Mapped history file that loaded blocks point into (NULL if none)
+    size_t mappingSize; // Size of the mapping in bytes
+    int loadedBlocks; // Blocks from 0 up to this one point into the mapping and are not freed here
+    int64_t* full[HISTORY_COLUMNS]; // A full tail handed to the sealer and not packed yet (full[0] is NULL if none)
+    pthread_cond_t handedOff; // Signalled when a full tail is handed to the sealer, or the sealer is to stop
+    pthread_cond_t sealed; // Broadcast when the sealer has packed the full tail into a block
+    pthread_t sealer; // Thread packing full tails into blocks, off the booking path
+    int sealerStarted; // 1 once the sealer runs (the first full tail starts it)
+    int stopSealer; // Set by freeHistory to end the sealer
+    pthread_mutex_t lock; // Taken inside a room lock when bookings change, alone by scans and the sealer
+};
+
+// Define the header at the start of a history file
+struct HistoryHeader {
+    char magic[8]; // HISTORY_MAGIC
+    uint32_t version; // HISTORY_VERSION
+    uint32_t blockSize; // sizeof(struct HistoryBlock)
+};
+
+// Define a segment of a history file, what one checkpoint appended: this header, then the new room numbers
+// (int32_t each), the new guest names (each NUL-terminated), the new blocks and their packed data, in that order
+struct HistorySegment {
+    uint32_t checksum; // FNV-1a hash of everything after this field, to detect a torn append
+    int32_t roomCount; // New room codes
+    int32_t guestCount; // New guest codes
+    int32_t blockCount; // New blocks
+    uint64_t namesSize; // Bytes of guest names
+    uint64_t dataSize; // Bytes of packed data of the new blocks
+};
+
+// Define the scan kernels over packed history columns (scalar or AVX2, picked at runtime)
+struct HistoryKernels {
+    // Unpacks count values of a column from value first on (widths up to HISTORY_WIDE_BITS)
+    void (*unpack)(const uint8_t* data, int width, int64_t low, int first, int count, int64_t* values);
+};
+
+// Define one room lock, padded to a cache line so threads using neighbouring locks never share one
+union RoomLock {
+    pthread_mutex_t mutex; // Guards the calendar, night bitmap bits and index entry of every room hashed to it
+    char padding[64];
+};
+
+// Operations timed and counted by the metrics
+enum MetricOperation {
+    METRIC_ADD_ROOM, // insertRoom
+    METRIC_LOAD_ROOMS, // insertRooms, for a whole list
+    METRIC_RESERVE, // reserveRoom
+    METRIC_CANCEL, // releaseRoom
+    METRIC_VIEW, // Reports, availability and guest searches, and booking lists
+    METRIC_RESERVE_GROUP, // reserveGroup, for a whole group
+    METRIC_OPERATIONS // Number of operations
+};
+
+// Define the metrics of one operation
+struct OperationMetrics {
+    uint64_t results[METRICS_STATUSES]; // Operations finished, by enum HotelStatus
+    uint64_t latency[LATENCY_BUCKETS]; // Timed operations by latency (see latencyBucket)
+    uint64_t latencyNanoseconds; // Time taken by the timed operations together
+};
+
+// Define the metrics one thread has recorded. Only that thread writes them, without locks or atomic
+// read-modify-writes; anyone may read them. The block outlives its thread and goes to the next new one
+struct ThreadMetrics {
+    struct OperationMetrics operations[METRIC_OPERATIONS];
+    uint64_t probes[PROBE_BUCKETS]; // Room index lookups by slots probed (bucket p is p + 1 slots)
+    int inUse; // 1 while a thread owns the block
+    int untilTimed; // Operations until this thread times one again
+    struct ThreadMetrics* next; // Next block of the process
+};
+
+// Define the running totals of the bookings of the rooms under one room lock, padded to a cache line
+// (written only under that lock, read by hotelTotals without it, so the totals of a hotel are the sum of all stripes)
+union StripeTotals {
+    struct {
+        int64_t reservedRooms; // Rooms with at least one booking
+        int64_t bookings; // Bookings
+        int64_t guests; // People staying, added up over the bookings
+        int64_t roomNights; // Nights booked, added up over the bookings
+        int64_t revenue; // What the bookings come to under the current rate plan
+    } sums;
+    char padding[64];
+};
+
+// Define the running totals of one floor (rooms of a floor come under different room locks, so every
+// booking changes them atomically)
+struct FloorTotals {
+    int floor; // Floor number
+    struct HotelTotals totals; // Totals of the rooms on this floor
+};
+
+// Define a past state of a room's calendar, copied by preserveRoom when a booking changes the room while a read
+// view is open, and freed once no open view is stamped inside (since, until]
+struct RoomVersion {
+    uint64_t since; // View clock when this state was made (views stamped after it see it...)
+    uint64_t until; // View clock when it was replaced (...up to views stamped with this)
+    struct RoomVersion* older; // The state before it, if still kept
+    int bookingCount; // Bookings on the calendar
+    int64_t cancellationTime; // Time of the last cancellation then (0 if none)
+    struct Stay* stays; // Calendar, in the same block as the version
+    struct Booking* bookings; // Guest data of each stay, in the same block too
+};
+
+// Define the versions of one room, in a parallel array of their own so the snapshot layout stays as it is
+// (changed only under the room lock, and the array moves only while every room lock is held)
+struct RoomVersions {
+    uint64_t changedAt; // View clock at the last change, or when the room was added (views stamped after it read the room itself)
+    struct RoomVersion* older; // Past states, newest first (NULL unless a view was open when the room changed)
+};
+
+// Define a point-in-time view of the bookings: it reads each room as it stood when the view was opened
+struct HotelView {
+    struct Hotel* hotel; // Hotel the view reads
+    uint64_t stamp; // View clock when it was opened (0 while the slot is free or being claimed)
+    int inUse; // 1 while the slot holds an open view
+};
+
+// Define the read views of a hotel and the clock that orders them against bookings (epoch-based reclamation:
+// a booking copies its room only if a view is open, and a copy lives until no open view's stamp needs it)
+struct ReadViews {
+    uint64_t clock; // Counts the views ever opened; a booking made at clock value c is seen by views stamped above c
+    int open; // Views open now
+    int64_t kept; // Room versions kept for the views
+    struct HotelView views[VIEW_MAX_OPEN]; // View slots, reused after a close
+};
+
+// Define a room as a view read it (the arrays grow as needed and are freed by freeRoomCopy)
+struct RoomCopy {
+    int roomNumber; // Room number
+    int capacity; // Maximum number of people staying in the room
+    int bookingCount; // Bookings on the calendar
+    int bookingCapacity; // Bookings the arrays have space for
+    int64_t cancellationTime; // Time of the last cancellation, in seconds since the epoch (0 if none)
+    struct Stay* stays; // Calendar, sorted by check-in
+    struct Booking* bookings; // Guest data of each stay (names are handles into the hotel's name pool)
+};
+
+// Define a hotel (bookings lock only their room's stripe; adding a room that makes the table or
+// index grow, and checkpoints, take every stripe so nothing can hold a pointer into the old arrays)
+struct Hotel {
+    struct Room* rooms; // Hot room fields, one entry per room in insertion order
+    struct RoomDetails* details; // Cold room fields, same position as in rooms
+    int roomCount; // Number of rooms in the table
+    int roomCapacity; // Number of rooms the table has space for
+    struct RoomIndex index; // Hash index of the rooms by room number
+    struct RoomOrder order; // The rooms by room number, for reports
+    uint64_t* nights; // Booked-night bitmaps, word-major: word w of room slot r is nights[w * roomCapacity + r]
+    int calendarStart; // Day number of the first night tracked in the bitmaps (bit 0 of word 0)
+    void* snapshot; // Mapped snapshot file that loaded calendars still point into (NULL if none)
+    size_t snapshotSize; // Size of the mapped snapshot in bytes
+    struct Journal* journal; // Where every change is logged before it is acknowledged (NULL if none)
+    uint64_t journalSequence; // Sequence number of the last journal record applied to this hotel
+    pthread_rwlock_t tableLock; // Shared by queries and reports, exclusive while a room is added
+    union RoomLock roomLocks[ROOM_LOCK_STRIPES]; // See roomLock()
+    union StripeTotals stripeTotals[ROOM_LOCK_STRIPES]; // Running totals of the rooms under each room lock
+    struct FloorTotals* floors; // Running totals of each floor, in the order the floors were first seen
+    int floorCount; // Number of floors
+    int floorCapacity; // Number of floors the array has space for (it grows only while every room lock is held)
+    struct RoomIndex floorIndex; // Position in floors of each floor number
+    struct HotelNightTotals nightTotals[NIGHT_HORIZON]; // Running totals of each night tracked in the bitmaps
+    struct GuestIndex guests; // Bookings by guest name, kept in step by reserveRoomAt and releaseRoomAt
+    struct BookingHistory history; // Every reservation and cancellation, appended by reserveRoomAt and releaseRoomAt
+    struct RatePlan rates; // Prices of stays (the default plan unless loadRatePlan read a rate file)
+    struct RoomVersions* versions; // Past states of each room kept for read views, same position as in rooms
+    struct ReadViews views; // Open read views (see openView)
+};
+
+// Define one change in the journal (written exactly as it is in memory, followed by nameLength
+// bytes of guest name zero-padded to a multiple of 8, so names of any length are logged whole)
+struct JournalRecord {
+    uint32_t checksum; // FNV-1a hash of every byte after this field and of the name, to detect torn writes
+    uint32_t type; // enum JournalRecordType
+    uint64_t sequence; // Consecutive record number, never reused across checkpoints
+    int64_t time; // When the change was made, in seconds since the epoch
+    int32_t roomNumber; // Room the change applies to
+    int32_t checkIn; // Check-in day of the booking (reserve and cancel)
+    int32_t duration; // Nights of the booking (reserve)
+    int32_t extraServices; // Extra services of the booking (reserve)
+    int32_t occupancy; // People in the booking (reserve), or the floor of the room (add room)
+    uint32_t nameLength; // Bytes in the guest's name, without terminator (reserve and cancel; 0 otherwise)
+};
+
+// Define the header at the start of a journal file
+struct JournalHeader {
+    char magic[8]; // JOURNAL_MAGIC
+    uint32_t version; // JOURNAL_VERSION
+    uint32_t recordSize; // sizeof(struct JournalRecord), the fixed part of each record
+};
+
+// Define an append-only journal shared by all writers (group commit: concurrent writers
+// waiting for durability are served by one write and one data sync, issued by a leader)
+struct Journal {
+    int descriptor; // Journal file, opened for appending
+    pthread_mutex_t lock; // Protects every field below
+    pthread_cond_t flushed; // Broadcast when a group of records has become durable
+    pthread_cond_t joined; // Signalled when a writer starts waiting while the leader gathers a group
+    char* pending; // Records appended but not yet handed to a leader
+    size_t pendingSize; // Bytes used in pending
+    size_t pendingCapacity; // Bytes allocated for pending
+    char* writing; // Buffer a leader is writing out (swapped with pending)
+    size_t writingCapacity; // Bytes allocated for writing
+    uint64_t nextSequence; // Sequence number of the next appended record
+    uint64_t durableSequence; // Every record up to this one is on disk
+    int flushing; // 1 while a leader writes and syncs
+    int waiters; // Writers currently waiting in journalSync
+    int lastGroupSize; // Writers served by the previous sync (1 means nobody to wait for)
+    long maxLatencyMicros; // Longest a leader delays its sync to gather more writers
+    long long syncCount; // Number of data syncs issued
+    int failed; // 1 after a write or sync error; every later commit fails too
+};
+
+// Define the header of a snapshot file; the sections after it hold the in-memory record
+// layout of this build, so a snapshot whose record sizes differ is rejected instead of parsed
+struct SnapshotHeader {
+    char magic[8]; // SNAPSHOT_MAGIC
+    uint32_t version; // SNAPSHOT_VERSION
+    uint32_t roomSize; // sizeof(struct Room)
+    uint32_t detailsSize; // sizeof(struct RoomDetails)
+    uint32_t staySize; // sizeof(struct Stay)
+    uint32_t bookingSize; // sizeof(struct Booking)
+    uint32_t nightWords; // NIGHT_WORDS
+    int32_t roomCount; // Number of rooms
+    int32_t indexCapacity; // Number of slots in the saved room index
+    int32_t calendarStart; // First night tracked in the bitmaps
+    int32_t nameChunkCount; // Number of name pool chunks saved
+    int64_t bookingCount; // Number of bookings over all rooms
+    uint64_t journalSequence; // Last journal record included in this snapshot
+    uint64_t historySize; // Bytes of the history file that go with this snapshot (later segments are cut off)
+    uint64_t roomsOffset; // struct Room[roomCount] (calendar pointers are fixed up on load)
+    uint64_t detailsOffset; // struct RoomDetails[roomCount]
+    uint64_t nightsOffset; // uint64_t[nightWords][roomCount], word-major like the hotel
+    uint64_t indexOffset; // struct IndexSlot[indexCapacity]
+    uint64_t staysOffset; // struct Stay[bookingCount], room by room in table order
+    uint64_t bookingsOffset; // struct Booking[bookingCount], same order as the stays
+    uint64_t namesOffset; // uint64_t[nameChunkCount][2]: offset and size of each name chunk, saved after this table
+    uint64_t fileSize; // Total size of the file, to detect truncation
+};
+
+// Define the scan kernels over the night bitmaps (scalar or AVX2, picked at runtime)
+struct NightKernels {
+    // Sets bit r of freeBits for every room r with no booked night under masks[firstWord..lastWord]
+    void (*freeRooms)(const uint64_t* nights, int stride, const uint64_t* masks, int firstWord, int lastWord, int roomCount, uint64_t* freeBits);
+    // Counts the booked nights of all rooms under masks[firstWord..lastWord]
+    long long (*bookedNights)(const uint64_t* nights, int stride, const uint64_t* masks, int firstWord, int lastWord, int roomCount);
+};
+
+// Define the ring of requests from one client to one shard (single producer, single consumer: only the client
+// writes head and the slots, only the shard's worker writes done, and each index has a cache line of its own)
+struct RouterRing {
+    uint64_t head; // Requests pushed; request i waits in slots[i % ROUTER_RING_SIZE]
+    char headPadding[56];
+    uint64_t done; // Requests the worker has answered, in the order they were pushed
+    char donePadding[56];
+    struct HotelRequest* slots[ROUTER_RING_SIZE]; // The client's own requests, answered in place
+};
+
+// Define one client of a router: a thread with a ring of its own to every shard
+struct HotelRouterClient {
+    struct HotelRouter* router; // Router the client belongs to
+    struct RouterRing* rings; // One ring per shard (NULL until first connected; kept after, as workers poll them)
+    uint64_t answered[HOTEL_ROUTER_MAX_SHARDS]; // Last done the client read from each ring
+    int inUse; // 1 while a thread has the client connected
+    char padding[60]; // Keeps the fields workers poll off the next client's cache lines
+};
+
+// Define a shard: the properties one worker thread owns, which no other thread touches
+struct RouterShard {
+    struct HotelRouter* router; // Router the shard belongs to
+    int id; // Position in the router's shards, and of the shard's ring in every client
+    pthread_t worker; // Thread answering every request for the shard's properties
+    struct Hotel** properties; // Hotel of each property, in the order they were added
+    int propertyCount; // Number of properties
+    int propertyCapacity; // Number of properties the array has space for
+    struct RoomIndex propertyIndex; // Position in properties of each property id
+    char padding[64]; // Keeps one worker's writes off the next shard's cache lines
+};
+
+// Define a router: properties hashed by id to shards, each run by its own worker thread, and reached by
+// clients through rings (no locks anywhere on the way)
+struct HotelRouter {
+    struct RouterShard* shards; // Shards, each with its worker
+    int shardCount; // Number of shards
+    int clientCount; // Client slots ever connected; the workers poll this many
+    int stopping; // Set when the router is destroyed, so the workers return
+    struct HotelRouterClient clients[ROUTER_MAX_CLIENTS]; // Client slots, reused after a disconnect
+};
+
+// Function prototypes
+int dayFromDate(int year, int month, int day);
+void dateFromDay(int dayNumber, int* year, int* month, int* day);
+int parseDate(const char* text, int* dayNumber);
+int isValidStay(int checkIn, int nights);
+int today();
+void initRoom(struct Room* room, struct RoomDetails* details, int roomNumber);
+void initHotel(struct Hotel* hotel);
+int findRoom(struct Hotel* hotel, int roomNumber);
+int findStay(const struct Room* room, int day);
+int isRoomFree(const struct Room* room, int checkIn, int checkOut);
+int findAvailableRooms(struct Hotel* hotel, int checkIn, int checkOut, int occupancy, int* roomNumbers, int maxRooms);
+int countFreeRooms(struct Hotel* hotel, int checkIn, int checkOut);
+long long countBookedNights(struct Hotel* hotel, int from, int to);
+int buildNightMasks(const struct Hotel* hotel, int checkIn, int checkOut, uint64_t* masks, int* firstWord, int* lastWord);
+const struct NightKernels* scalarNightKernels();
+const struct NightKernels* nightKernels();
+int insertRoom(struct Hotel* hotel, int roomNumber);
+int insertRooms(struct Hotel* hotel, const int* roomNumbers, const int* floors, int count);
+int expandRoomRange(int firstFloor, int lastFloor, int firstRoom, int lastRoom, int** roomNumbers);
+int loadRoomFile(struct Hotel* hotel, const char* path, int* listed, int* added);
+int reportRooms(struct Hotel* hotel, const struct HotelReportQuery* query, struct HotelCursor* cursor, int* roomNumbers, int maxRooms);
+int reserveRoom(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn, int duration, int extraServices, int occupancy);
+int releaseRoom(struct Hotel* hotel, int roomNumber, const char* guestName, int checkIn);
+int reserveGroup(struct Hotel* hotel, const struct HotelGroup* group, int* partyRooms);
+struct HotelView* openView(struct Hotel* hotel);
+void closeView(struct HotelView* view);
+int viewRoom(struct HotelView* view, int roomNumber, struct RoomCopy* copy);
+int viewReportRooms(struct HotelView* view, const struct HotelReportQuery* query, struct HotelCursor* cursor, int* roomNumbers, int maxRooms);
+void freeRoomCopy(struct RoomCopy* copy);
+struct HotelRouter* createRouter(int shardCount);
+void destroyRouter(struct HotelRouter* router);
+int routerShard(const struct HotelRouter* router, int propertyId);
+struct HotelRouterClient* connectRouter(struct HotelRouter* router);
+void disconnectRouter(struct HotelRouterClient* client);
+int routeRequests(struct HotelRouterClient* client, struct HotelRequest* requests, int count);
+void freeHotel(struct Hotel* hotel);
+int findGuestBookings(struct Hotel* hotel, const char* guestName, struct GuestStay* stays, int maxStays);
+int searchGuestPrefix(struct Hotel* hotel, const char* prefix, struct GuestMatch* matches, int maxMatches);
+int searchGuestFuzzy(struct Hotel* hotel, const char* text, int maxDistance, struct GuestMatch* matches, int maxMatches);
+int loadRatePlan(struct RatePlan* plan, const char* path);
+int loadHotelRates(struct Hotel* hotel, const char* path);
+int checkTotals(struct Hotel* hotel);
+void settleHistory(struct BookingHistory* history);
+void recordHistory(struct BookingHistory* history, int kind, int64_t when, int roomNumber, const char* guestName, int checkIn, int nights, int occupancy, int extraServices, int64_t amount);
+const struct HistoryKernels* historyKernels();
+int summarizeHistory(struct Hotel* hotel, int firstDay, int lastDay, int threads, struct HotelHistoryMonth* months, int maxMonths);
+int openHistory(struct Hotel* hotel, const char* path);
+int collectMetrics(struct ThreadMetrics* total);
+int latencyBucket(uint64_t nanoseconds);
+uint64_t latencyBucketLimit(int bucket);
+int writeMetrics(FILE* file);
+int64_t quoteStay(const struct RatePlan* plan, int roomNumber, int checkIn, int nights, int occupancy, int extraServices, struct Quote* quote);
+void quoteStays(const struct RatePlan* plan, const struct QuoteRequest* requests, int count, int64_t* totals);
+int saveSnapshot(struct Hotel* hotel, const char* path);
+int loadSnapshot(struct Hotel* hotel, const char* path);
+int openJournal(struct Journal* journal, const char* path, uint64_t nextSequence, long maxLatencyMicros);
+uint64_t journalAppend(struct Journal* journal, struct JournalRecord* record, const char* guestName);
+uint64_t journalAppendRecords(struct Journal* journal, struct JournalRecord* records, const char* const* guestNames, int count);
+int journalSync(struct Journal* journal);
+int journalReset(struct Journal* journal);
+void closeJournal(struct Journal* journal);
+int recoverJournal(struct Hotel* hotel, const char* path);
+int checkpointHotel(struct Hotel* hotel, const char* snapshotPath);
+int64_t localSeconds(int64_t when);
+unsigned int hashRoomNumber(int roomNumber);
+uint32_t hashGuestName(const char* name);
+const char* poolString(const struct NamePool* pool, uint32_t handle);
+pthread_mutex_t* roomLock(struct Hotel* hotel, int roomNumber);
+void initRatePlan(struct RatePlan* plan);
+void freeRatePlan(struct RatePlan* plan);
+int roomType(const struct RatePlan* plan, int roomNumber);
+int64_t nightRate(const struct RatePlan* plan, int type, int day);
+int64_t roomCharges(const struct RatePlan* plan, int type, int checkIn, int nights);
+
+#endif